@@ -0,0 +1,162 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+
+#include "../src/BlockBuffer.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/PageBufferAlt.h"
+#include "../src/BPlusTreeHeaderBufferAlt.h"
+#include "../src/FileSession.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: AlignedLayoutTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/aligned_layout_test.zcb";
+const std::string INDEX_FILE_PATH = "data/aligned_layout_test.idx";
+const uint32_t BLOCK_SIZE = 1024;
+const uint32_t BLOCK_COUNT = 12;
+const uint32_t RECORDS_PER_BLOCK = 8;
+
+/**
+ * @brief Builds a page aligned header with a stale index so the first session builds it
+ * @param alignment Layout alignment
+ * @return The header, header size already set
+ */
+HeaderRecord makeHeader(uint32_t alignment)
+{
+    HeaderRecord header = makeTestHeader(HeaderRecord::ALIGNED_LAYOUT_VERSION, BLOCK_SIZE, INDEX_FILE_PATH,
+                                         BLOCK_COUNT * RECORDS_PER_BLOCK, BLOCK_COUNT, 1);
+    header.setLayoutAlignment(alignment);
+    header.setHeaderSize(header.serialize().size());
+    return header;
+}
+
+/**
+ * @brief Writes a sorted sequence set of BLOCK_COUNT blocks at RBN 1 onwards
+ * @param filePath The blocked file, header already written
+ * @param header Its header
+ * @return True if every block was written
+ */
+bool writeSequenceSet(const std::string& filePath, const HeaderRecord& header)
+{
+    BlockBuffer buffer;
+    RecordBuffer recordBuffer;
+    buffer.setLayoutAlignment(header.getLayoutAlignment());
+    if (!buffer.openFile(filePath, header.getHeaderSize()))
+        return false;
+
+    bool written = true;
+    for (uint32_t rbn = 1; rbn <= BLOCK_COUNT; ++rbn)
+    {
+        std::vector<ZipCodeRecord> records;
+        for (uint32_t i = 0; i < RECORDS_PER_BLOCK; ++i)
+        {
+            uint32_t zip = 10000 + rbn * 100 + i * 2;
+            records.push_back(ZipCodeRecord(zip, 45.5, -94.1, "Aligned " + std::to_string(zip), "MN", "Stearns"));
+        }
+        ActiveBlock block;
+        block.recordCount = RECORDS_PER_BLOCK;
+        block.precedingRBN = rbn - 1;
+        block.succeedingRBN = rbn < BLOCK_COUNT ? rbn + 1 : 0;
+        recordBuffer.packBlock(records, block.data, BLOCK_SIZE);
+        written = buffer.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, header.getHeaderSize(), block) && written;
+    }
+    written = buffer.flush() && written;
+    buffer.closeFile();
+    return written;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Aligned Layout Test: " << filePath << " ===\n\n";
+
+    // Test 1: header padding and round trip
+    std::cout << "--- Test 1: Header ---\n";
+    HeaderBuffer headerBuffer;
+    HeaderRecord header = makeHeader(HeaderRecord::PAGE_ALIGNMENT);
+    check("header padded to a page", header.getHeaderSize() % HeaderRecord::PAGE_ALIGNMENT == 0);
+    check("layout is valid", header.hasValidLayout());
+    headerBuffer.writeHeader(filePath, header);
+
+    HeaderRecord readBack;
+    check("header reads back", headerBuffer.readHeader(filePath, readBack));
+    check("alignment survives the round trip", readBack.getLayoutAlignment() == HeaderRecord::PAGE_ALIGNMENT &&
+          readBack.getHeaderSize() == header.getHeaderSize());
+    std::ifstream raw(filePath, std::ios::binary);
+    raw.seekg(readBack.getStaleFlagOffset());
+    check("stale flag offset unchanged by the new field", raw.get() == 1);
+    raw.close();
+
+    HeaderRecord oddBlocks = makeHeader(HeaderRecord::PAGE_ALIGNMENT);
+    oddBlocks.setBlockSize(3000);
+    check("non power of two block size rejected", !oddBlocks.hasValidLayout());
+    std::cout << "\n";
+
+    // Test 2: buffers hold the file to its layout
+    std::cout << "--- Test 2: Buffers ---\n";
+    check("sequence set written", writeSequenceSet(filePath, header));
+    {
+        BlockBuffer buffer;
+        buffer.setLayoutAlignment(HeaderRecord::PAGE_ALIGNMENT);
+        check("unpadded header refused", !buffer.openFile(filePath, header.getHeaderSize() - 1));
+        check("padded header accepted", buffer.openFile(filePath, header.getHeaderSize()));
+        std::vector<char> image(3000);
+        check("non power of two block refused", !buffer.readBlockImageAtRBN(1, 3000, header.getHeaderSize(), image.data()));
+        buffer.closeFile();
+
+        bool contained = true;
+        for (uint32_t rbn = 1; contained && rbn <= BLOCK_COUNT; ++rbn)
+        {
+            uint64_t offset = header.getHeaderSize() + static_cast<uint64_t>(rbn) * BLOCK_SIZE;
+            if (offset / HeaderRecord::PAGE_ALIGNMENT != (offset + BLOCK_SIZE - 1) / HeaderRecord::PAGE_ALIGNMENT)
+            {
+                check("block " + std::to_string(rbn) + " within one page", false);
+                contained = false;
+            }
+        }
+        check("every block lies within one page", contained);
+
+        PageBufferAlt pages;
+        pages.setLayoutAlignment(HeaderRecord::PAGE_ALIGNMENT);
+        check("page buffer refuses a non power of two page", !pages.open(filePath, 3000, header.getHeaderSize()));
+    }
+    std::cout << "\n";
+
+    // Test 3: a session builds a padded index and serves lookups through both aligned files
+    std::cout << "--- Test 3: Session ---\n";
+    {
+        FileSession session;
+        check("session opens and builds the index", session.open(filePath));
+        uint32_t rbn = 0;
+        check("search through the index", session.getTree().search(10504, rbn) && rbn == 5);
+        ZipCodeRecord record;
+        check("record read through the session", session.getBlockBuffer().readRecordAtRBN(rbn, 10504, BLOCK_SIZE,
+              header.getHeaderSize(), record) && record.getZipCode() == 10504);
+        check("session closes", session.close());
+    }
+
+    BPlusTreeHeaderAlt treeHeader;
+    BPlusTreeHeaderBufferAlt treeHeaderBuffer;
+    check("index header padded to a page", treeHeaderBuffer.readHeader(INDEX_FILE_PATH, treeHeader) &&
+          treeHeader.getHeaderSize() % HeaderRecord::PAGE_ALIGNMENT == 0);
+    check("index marked valid on close", headerBuffer.readHeader(filePath, readBack) && readBack.getStaleFlag() == 0);
+
+    {
+        FileSession session;
+        uint32_t rbn = 0;
+        check("reopened index still finds the last block", session.open(filePath) &&
+              session.getTree().search(10000 + BLOCK_COUNT * 100, rbn) && rbn == BLOCK_COUNT);
+    }
+    std::cout << "\n";
+
+    std::remove(filePath.c_str());
+    std::remove(INDEX_FILE_PATH.c_str());
+
+    return report("aligned layout");
+}
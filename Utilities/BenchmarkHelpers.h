@@ -0,0 +1,110 @@
+#ifndef BENCHMARK_HELPERS_H
+#define BENCHMARK_HELPERS_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <new>
+
+/**
+ * @file BenchmarkHelpers.h
+ * @brief Clock and result lines shared by the standalone benchmark drivers.
+ * @details A driver that defines BENCHMARK_COUNT_ALLOCATIONS before the include also gets a
+ *          global operator new and delete that count every heap allocation of the program.
+ */
+
+typedef std::chrono::steady_clock BenchClock;
+
+const int BENCH_LABEL_WIDTH = 44;
+
+/**
+ * @brief Prints the label, time per operation and operations per second of one result line
+ * @details The line is left open so a driver can append its own columns.
+ * @param label Name of the path measured
+ * @param seconds Elapsed time
+ * @param operations Operations timed
+ * @param unit Name of one operation
+ */
+inline void printThroughput(const std::string& label, double seconds, uint64_t operations, const std::string& unit)
+{
+    double nsPerOperation = operations ? (seconds * 1e9) / operations : 0.0;
+    double perSecond = seconds > 0 ? operations / seconds : 0.0;
+    std::cout << std::left << std::setw(BENCH_LABEL_WIDTH) << label
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nsPerOperation << " ns/" << unit
+              << std::setw(14) << std::setprecision(0) << perSecond << " " << unit << "s/s";
+}
+
+/**
+ * @brief Prints one benchmark result line
+ * @param label Name of the path measured
+ * @param seconds Elapsed time
+ * @param operations Operations timed
+ * @param unit Name of one operation
+ */
+inline void reportThroughput(const std::string& label, double seconds, uint64_t operations, const std::string& unit)
+{
+    printThroughput(label, seconds, operations, unit);
+    std::cout << std::endl;
+}
+
+/**
+ * @brief Prints one benchmark result line with the bytes moved per second
+ * @param label Name of the path measured
+ * @param seconds Elapsed time
+ * @param operations Operations timed
+ * @param unit Name of one operation
+ * @param bytesPerOperation Bytes one operation moves, e.g. the block size
+ */
+inline void reportBandwidth(const std::string& label, double seconds, uint64_t operations, const std::string& unit,
+                            uint32_t bytesPerOperation)
+{
+    printThroughput(label, seconds, operations, unit);
+    double mbPerSec = seconds > 0 ? (operations * static_cast<double>(bytesPerOperation)) / (seconds * 1024.0 * 1024.0) : 0.0;
+    std::cout << std::setw(10) << std::setprecision(1) << mbPerSec << " MB/s" << std::endl;
+}
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+
+// Every heap allocation in the program, the replacements below are defined once per driver
+uint64_t allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif // BENCHMARK_COUNT_ALLOCATIONS
+
+#endif // BENCHMARK_HELPERS_H
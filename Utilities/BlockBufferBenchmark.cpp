@@ -0,0 +1,207 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/Block.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "BenchmarkHelpers.h"
+
+// Usage: BlockBufferBenchmark [file.zcb] [passes]
+const std::string DEFAULT_FILE_PATH = "data/PT2_Randomized.zcb";
+const int DEFAULT_PASSES = 20;
+
+/**
+ * @brief Walks the sequence set once to collect the RBNs in logical order
+ */
+std::vector<uint32_t> collectSequenceSet(BlockBuffer& buffer, const HeaderRecord& header)
+{
+    std::vector<uint32_t> rbns;
+    ActiveBlock block;
+    uint32_t rbn = header.getSequenceSetListRBN();
+    while (rbn != 0 && rbns.size() <= header.getBlockCount())
+    {
+        if (!buffer.loadActiveBlockAtRBN(rbn, header.getBlockSize(), header.getHeaderSize(), block))
+            break;
+        rbns.push_back(rbn);
+        rbn = block.succeedingRBN;
+    }
+    return rbns;
+}
+
+/**
+ * @brief Times the three load paths over every block
+ */
+void benchmarkLoads(const std::string& label, BlockBuffer& buffer, const HeaderRecord& header,
+                    const std::vector<uint32_t>& rbns, int passes)
+{
+    const uint32_t blockSize = header.getBlockSize();
+    const size_t headerSize = header.getHeaderSize();
+    const uint64_t blocks = static_cast<uint64_t>(rbns.size()) * passes;
+    uint64_t checksum = 0;
+
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (uint32_t rbn : rbns)
+        {
+            ActiveBlock block = buffer.loadActiveBlockAtRBN(rbn, blockSize, headerSize);
+            checksum += block.recordCount;
+        }
+    }
+    reportBandwidth(label + " loadActiveBlockAtRBN (by value)",
+                    std::chrono::duration<double>(BenchClock::now() - start).count(), blocks, "block", blockSize);
+
+    ActiveBlock reused;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (uint32_t rbn : rbns)
+        {
+            buffer.loadActiveBlockAtRBN(rbn, blockSize, headerSize, reused);
+            checksum += reused.recordCount;
+        }
+    }
+    reportBandwidth(label + " loadActiveBlockAtRBN (reused)",
+                    std::chrono::duration<double>(BenchClock::now() - start).count(), blocks, "block", blockSize);
+
+    BlockImage image(blockSize);
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (uint32_t rbn : rbns)
+        {
+            buffer.readBlockImageAtRBN(rbn, blockSize, headerSize, image.data());
+            checksum += static_cast<unsigned char>(image.data()[0]);
+        }
+    }
+    reportBandwidth(label + " readBlockImageAtRBN (BlockImage)",
+                    std::chrono::duration<double>(BenchClock::now() - start).count(), blocks, "block", blockSize);
+
+    std::cout << "  (checksum " << checksum << ")" << std::endl;
+}
+
+/**
+ * @brief Times rewriting every block through the ActiveBlock and raw image store paths
+ */
+void benchmarkStores(BlockBuffer& buffer, const HeaderRecord& header,
+                     const std::vector<uint32_t>& rbns, int passes)
+{
+    const uint32_t blockSize = header.getBlockSize();
+    const size_t headerSize = header.getHeaderSize();
+    const uint64_t blocks = static_cast<uint64_t>(rbns.size()) * passes;
+
+    // Snapshot every block so both paths write back identical bytes
+    std::vector<ActiveBlock> snapshots;
+    std::vector<BlockImage> images;
+    for (uint32_t rbn : rbns)
+    {
+        snapshots.push_back(buffer.loadActiveBlockAtRBN(rbn, blockSize, headerSize));
+        images.push_back(BlockImage(blockSize));
+        buffer.readBlockImageAtRBN(rbn, blockSize, headerSize, images.back().data());
+    }
+
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (size_t i = 0; i < rbns.size(); ++i)
+            buffer.writeActiveBlockAtRBN(rbns[i], blockSize, headerSize, snapshots[i]);
+        buffer.flush();
+    }
+    reportBandwidth("store writeActiveBlockAtRBN",
+                    std::chrono::duration<double>(BenchClock::now() - start).count(), blocks, "block", blockSize);
+
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (size_t i = 0; i < rbns.size(); ++i)
+            buffer.writeBlockImageAtRBN(rbns[i], blockSize, headerSize, images[i].data());
+        buffer.flush();
+    }
+    reportBandwidth("store writeBlockImageAtRBN (BlockImage)",
+                    std::chrono::duration<double>(BenchClock::now() - start).count(), blocks, "block", blockSize);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    int passes = argc > 2 ? std::atoi(argv[2]) : DEFAULT_PASSES;
+    if (passes <= 0) passes = DEFAULT_PASSES;
+
+    HeaderBuffer headerBuffer;
+    HeaderRecord header;
+    if (!headerBuffer.readHeader(filePath, header))
+    {
+        std::cerr << "Failed to read header from " << filePath << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== BlockBuffer Benchmark: " << filePath << " ===" << std::endl;
+    std::cout << "Block size " << header.getBlockSize() << ", " << passes << " passes" << std::endl;
+
+    // Direct path: a zero frame cache sends every block to the file
+    {
+        BlockCache uncached(0);
+        BlockBuffer buffer;
+        buffer.attachCache(&uncached);
+        if (!buffer.openFile(filePath, header.getHeaderSize()))
+        {
+            std::cerr << "Failed to open " << filePath << std::endl;
+            return 1;
+        }
+        std::vector<uint32_t> rbns = collectSequenceSet(buffer, header);
+        std::cout << rbns.size() << " blocks in the sequence set\n" << std::endl;
+        benchmarkLoads("direct", buffer, header, rbns, passes);
+        buffer.closeFile();
+    }
+
+    // Cached path: the whole working set fits in the cache
+    {
+        BlockCache cache(header.getBlockCount() + 1);
+        BlockBuffer buffer;
+        buffer.attachCache(&cache);
+        buffer.openFile(filePath, header.getHeaderSize());
+        std::vector<uint32_t> rbns = collectSequenceSet(buffer, header);
+        benchmarkLoads("cached", buffer, header, rbns, passes);
+        buffer.closeFile();
+    }
+
+    // Mapped path
+    {
+        BlockBuffer buffer;
+        buffer.openFileMapped(filePath, header.getHeaderSize(), BlockBuffer::AccessPattern::Sequential);
+        std::vector<uint32_t> rbns = collectSequenceSet(buffer, header);
+        benchmarkLoads("mapped", buffer, header, rbns, passes);
+        buffer.closeFile();
+    }
+
+    // Stores go to a scratch copy so the data file is left untouched
+    std::string copyPath = filePath + ".bench";
+    {
+        std::ifstream src(filePath, std::ios::binary);
+        std::ofstream dst(copyPath, std::ios::binary);
+        dst << src.rdbuf();
+    }
+    {
+        BlockCache uncached(0);
+        BlockBuffer buffer;
+        buffer.attachCache(&uncached);
+        if (buffer.openFile(copyPath, header.getHeaderSize()))
+        {
+            std::vector<uint32_t> rbns = collectSequenceSet(buffer, header);
+            std::cout << std::endl;
+            benchmarkStores(buffer, header, rbns, passes);
+            buffer.closeFile();
+        }
+    }
+    std::remove(copyPath.c_str());
+
+    return 0;
+}
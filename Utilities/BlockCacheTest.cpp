@@ -0,0 +1,308 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/CacheManager.h"
+#include "TestHelpers.h"
+
+// Usage: BlockCacheTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/block_cache_test.zcb";
+const uint32_t BLOCK_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const uint32_t FILE_BLOCKS = 8;
+
+/**
+ * @brief Claims a block, fills its frame and unpins it
+ * @param cache Bound cache
+ * @param rbn Block to claim
+ * @param fill Byte written over the frame
+ * @param dirty True to leave the frame dirty
+ * @return False if no frame could be claimed
+ */
+bool load(BlockCache& cache, uint32_t rbn, char fill, bool dirty)
+{
+    char* frame = cache.claim(rbn);
+    if (frame == nullptr)
+        return false;
+    memset(frame, fill, BLOCK_SIZE);
+    cache.unpin(rbn, dirty);
+    return true;
+}
+
+/**
+ * @brief Looks a block up the way BlockBuffer does, claiming it on a miss
+ * @return False if the block was neither resident nor claimable
+ */
+bool touch(BlockCache& cache, uint32_t rbn)
+{
+    if (cache.pin(rbn) == nullptr)
+        return load(cache, rbn, static_cast<char>(rbn), false);
+    cache.unpin(rbn, false);
+    return true;
+}
+
+/**
+ * @brief Reads one block of the scratch file straight from disk
+ * @return The block bytes, empty if the file is short
+ */
+std::string readFileBlock(const std::string& filePath, uint32_t rbn)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::string bytes(BLOCK_SIZE, '\0');
+    file.seekg(HEADER_SIZE + static_cast<uint64_t>(rbn) * BLOCK_SIZE);
+    if (!file.read(&bytes[0], BLOCK_SIZE))
+        return std::string();
+    return bytes;
+}
+
+/**
+ * @brief Builds a block whose records mark it as written by this test
+ */
+ActiveBlock makeBlock(uint32_t rbn)
+{
+    ActiveBlock block;
+    block.recordCount = 1;
+    block.precedingRBN = rbn == 0 ? 0 : rbn - 1;
+    block.succeedingRBN = rbn + 1 < FILE_BLOCKS ? rbn + 1 : 0;
+    std::string record = std::to_string(50000 + rbn) + ",Cached,IA,Story,42.0,-93.6";
+    uint32_t length = record.length();
+    block.data.insert(block.data.end(), reinterpret_cast<char*>(&length), reinterpret_cast<char*>(&length) + sizeof(length));
+    block.data.insert(block.data.end(), record.begin(), record.end());
+    return block;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Block Cache Test ===\n\n";
+
+    // Test 1: a block referenced since the hand last passed survives one more sweep
+    std::cout << "--- Test 1: CLOCK second chance ---\n";
+    {
+        BlockCache cache(3);
+        cache.bind("clock", BLOCK_SIZE, HEADER_SIZE);
+        load(cache, 0, 'a', false);
+        load(cache, 1, 'b', false);
+        load(cache, 2, 'c', false);
+
+        // Every frame still has its reference, the sweep clears them all and takes the first
+        load(cache, 3, 'd', false);
+        check("the oldest block goes when every frame is referenced", !cache.isResident(0));
+        check("the other blocks stay", cache.isResident(1) && cache.isResident(2) && cache.isResident(3));
+
+        // Block 1 is referenced again, so the hand passes it and takes block 2
+        touch(cache, 1);
+        load(cache, 4, 'e', false);
+        check("a referenced block gets a second chance", cache.isResident(1));
+        check("the unreferenced block after it is evicted", !cache.isResident(2));
+        check("resident blocks never exceed the capacity", cache.getResidentCount() == cache.getCapacity());
+    }
+
+    // Test 2: pins outlast any amount of eviction
+    std::cout << "\n--- Test 2: Pinned frames ---\n";
+    {
+        BlockCache cache(2);
+        cache.bind("pinned", BLOCK_SIZE, HEADER_SIZE);
+        char* pinned = cache.claim(10);
+        check("block claimed and pinned", pinned != nullptr);
+        memset(pinned, 'p', BLOCK_SIZE);
+
+        bool stayed = true;
+        for (uint32_t rbn = 11; rbn < 60; ++rbn)
+        {
+            load(cache, rbn, 'x', false);
+            stayed = cache.isResident(10) && stayed;
+        }
+        check("a pinned block is never evicted", stayed);
+        check("the pinned frame keeps its bytes", cache.peek(10) == pinned && pinned[BLOCK_SIZE - 1] == 'p');
+
+        char* second = cache.claim(60);
+        check("a claim fails when every frame is pinned", second != nullptr && cache.claim(61) == nullptr);
+        cache.unpin(60, false);
+        cache.unpin(10, false);
+        check("an unpinned block may be evicted again", load(cache, 62, 'y', false) && load(cache, 63, 'z', false) &&
+              !cache.isResident(10));
+    }
+
+    // Test 3: dirty victims reach the file through the write back handler, clean ones are dropped
+    std::cout << "\n--- Test 3: Write back on evict ---\n";
+    {
+        BlockCache cache(2);
+        cache.bind("evict", BLOCK_SIZE, HEADER_SIZE);
+        std::map<uint32_t, std::string> written;
+        cache.setWriteBackHandler([&written](uint32_t rbn, const char* image)
+        {
+            written[rbn] = std::string(image, BLOCK_SIZE);
+            return true;
+        });
+
+        load(cache, 20, 'A', true);
+        load(cache, 21, 'B', false);
+        load(cache, 22, 'C', false);
+        check("a dirty victim is written before its frame is reused",
+              !cache.isResident(20) && written.count(20) == 1 && written[20] == std::string(BLOCK_SIZE, 'A'));
+
+        load(cache, 23, 'D', false);
+        check("a clean victim is not written", !cache.isResident(21) && written.count(21) == 0);
+        BlockCache::Stats stats = cache.getStats();
+        check("evictions and dirty evictions are counted", stats.evictions == 2 && stats.dirtyEvictions == 1);
+
+        cache.setWriteBackHandler(BlockCache::WriteBackHandler());
+        load(cache, 24, 'E', true);
+        load(cache, 25, 'F', true);
+        check("without a handler dirty frames are never chosen", cache.claim(26) == nullptr &&
+              cache.isResident(24) && cache.isResident(25));
+    }
+
+    // Test 4: a BlockBuffer flush writes every dirty frame and leaves them clean
+    std::cout << "\n--- Test 4: Write back on flush ---\n";
+    {
+        std::remove(filePath.c_str());
+        {
+            std::ofstream file(filePath, std::ios::binary);
+            std::string zeros(HEADER_SIZE + FILE_BLOCKS * BLOCK_SIZE, '\0');
+            file.write(zeros.data(), zeros.size());
+        }
+
+        BlockCache cache(FILE_BLOCKS);
+        BlockBuffer buffer;
+        buffer.attachCache(&cache);
+        check("scratch file opens", buffer.openFile(filePath, HEADER_SIZE));
+
+        for (uint32_t rbn = 0; rbn < FILE_BLOCKS; rbn += 2)
+            buffer.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE, makeBlock(rbn));
+        std::vector<uint32_t> dirty = cache.getDirtyRBNs();
+        check("written blocks wait dirty in their frames", dirty == std::vector<uint32_t>({0, 2, 4, 6}));
+        check("the file is untouched before the flush", readFileBlock(filePath, 2) == std::string(BLOCK_SIZE, '\0'));
+
+        bool framesMatch = true;
+        std::vector<std::string> frames(FILE_BLOCKS);
+        for (uint32_t rbn : dirty)
+            frames[rbn] = std::string(cache.peek(rbn), BLOCK_SIZE);
+        check("flush succeeds", buffer.flush());
+        for (uint32_t rbn : dirty)
+            framesMatch = readFileBlock(filePath, rbn) == frames[rbn] && framesMatch;
+        check("every dirty frame reaches the file", framesMatch);
+        check("no frame is dirty after the flush", cache.getDirtyRBNs().empty());
+        check("unwritten blocks stay as they were", readFileBlock(filePath, 1) == std::string(BLOCK_SIZE, '\0'));
+        buffer.closeFile();
+        std::remove(filePath.c_str());
+    }
+
+    // Test 5: counters after a known access sequence
+    std::cout << "\n--- Test 5: Hit and miss counts ---\n";
+    {
+        BlockCache cache(2);
+        cache.bind("stats", BLOCK_SIZE, HEADER_SIZE);
+        const uint32_t sequence[] = {1, 1, 2, 2, 3, 1, 3};
+        for (uint32_t rbn : sequence)
+            touch(cache, rbn);
+
+        // 1 miss, 1 hit, 2 miss, 2 hit, 3 miss evicts 1, 1 miss evicts 2, 3 hit
+        BlockCache::Stats stats = cache.getStats();
+        check("hits counted", stats.hits == 3);
+        check("misses counted", stats.misses == 4);
+        check("evictions counted", stats.evictions == 2);
+        check("residency checks do not count", cache.isResident(3) && cache.getStats().hits == 3);
+
+        cache.resetStats();
+        stats = cache.getStats();
+        check("counters reset", stats.hits == 0 && stats.misses == 0 && stats.evictions == 0);
+    }
+
+    // Test 6: files of different block sizes draw from one byte budget
+    std::cout << "\n--- Test 6: Shared budget ---\n";
+    {
+        CacheManager manager(8 * BLOCK_SIZE);
+        uint32_t small = manager.registerFile("small", BLOCK_SIZE, HEADER_SIZE);
+        uint32_t large = manager.registerFile("large", 2 * BLOCK_SIZE, HEADER_SIZE);
+
+        bool claimed = true;
+        bool withinBudget = true;
+        for (uint32_t rbn = 0; rbn < 200; ++rbn)
+        {
+            claimed = manager.claim(small, rbn) != nullptr && claimed;
+            manager.unpin(small, rbn, false);
+            withinBudget = manager.getUsedBytes() <= manager.getByteBudget() && withinBudget;
+            claimed = manager.claim(large, rbn) != nullptr && claimed;
+            manager.unpin(large, rbn, false);
+            withinBudget = manager.getUsedBytes() <= manager.getByteBudget() && withinBudget;
+        }
+        check("every claim finds room", claimed);
+        check("usage never exceeds the budget", withinBudget);
+        check("both files keep blocks resident", manager.getResidentCount(small) > 0 && manager.getResidentCount(large) > 0);
+        check("resident bytes add up to the usage",
+              manager.getResidentCount(small) * BLOCK_SIZE + manager.getResidentCount(large) * 2 * BLOCK_SIZE ==
+              manager.getUsedBytes());
+
+        manager.setByteBudget(3 * BLOCK_SIZE);
+        check("a smaller budget evicts down to it", manager.getUsedBytes() <= 3 * BLOCK_SIZE);
+    }
+
+    // Test 7: an inner index page touched by every lookup outlives the data blocks streaming past it
+    std::cout << "\n--- Test 7: Index priority ---\n";
+    {
+        CacheManager manager(4 * BLOCK_SIZE);
+        uint32_t index = manager.registerFile("index", BLOCK_SIZE, HEADER_SIZE);
+        uint32_t data = manager.registerFile("data", BLOCK_SIZE, HEADER_SIZE);
+        manager.claim(index, 0, CacheManager::Priority::IndexInner);
+        manager.unpin(index, 0, false);
+        manager.claim(index, 1, CacheManager::Priority::Data);
+        manager.unpin(index, 1, false);
+
+        bool innerStayed = true;
+        for (uint32_t rbn = 0; rbn < 200; ++rbn)
+        {
+            // Each lookup reads both pages, then a block no other lookup needs
+            for (uint32_t page = 0; page < 2; ++page)
+            {
+                if (manager.pin(index, page) != nullptr)
+                    manager.unpin(index, page, false);
+            }
+            manager.claim(data, rbn);
+            manager.unpin(data, rbn, false);
+            innerStayed = manager.isResident(index, 0) && innerStayed;
+        }
+        check("the inner page survives the block churn", innerStayed);
+        check("a data priority page read as often does not", !manager.isResident(index, 1));
+        check("the churn evicted data blocks", manager.getStats(data).evictions > 0);
+    }
+
+    // Test 8: counters belong to one file
+    std::cout << "\n--- Test 8: Per file counters ---\n";
+    {
+        CacheManager manager(4 * BLOCK_SIZE);
+        uint32_t first = manager.registerFile("first", BLOCK_SIZE, HEADER_SIZE);
+        uint32_t second = manager.registerFile("second", BLOCK_SIZE, HEADER_SIZE);
+
+        manager.pin(first, 1); // Miss
+        manager.claim(first, 1);
+        manager.unpin(first, 1, false);
+        manager.pin(first, 1); // Hit
+        manager.unpin(first, 1, false);
+        manager.pin(second, 1); // Miss, the block is resident for the other file only
+
+        CacheManager::Stats firstStats = manager.getStats(first);
+        CacheManager::Stats secondStats = manager.getStats(second);
+        check("a file counts only its own lookups", firstStats.hits == 1 && firstStats.misses == 1 &&
+              secondStats.hits == 0 && secondStats.misses == 1);
+
+        manager.resetStats(first);
+        firstStats = manager.getStats(first);
+        secondStats = manager.getStats(second);
+        check("resetStats clears one file", firstStats.hits == 0 && firstStats.misses == 0);
+        check("the other file keeps its counters", secondStats.misses == 1);
+        check("an unknown file reads zero", manager.getStats(99).misses == 0);
+    }
+
+    std::cout << "\n";
+    return report("block cache");
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/BlockFile.h"
+#include "TestHelpers.h"
+
+// Usage: BlockFileTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/block_file_test.zcb";
+const uint32_t BLOCK_SIZE = 4096;
+const uint64_t HEADER_SIZE = 512; // Keeps the blocks off the page boundaries, as an unaligned header does
+const uint32_t BLOCK_COUNT = 64;
+const unsigned THREADS = 4;
+const int ROUNDS = 50;
+
+/**
+ * @brief Fills a buffer with the image a block holds after a given generation of writes
+ * @details The RBN and generation lead the block, the rest is a pattern of both, so a torn or
+ *          misplaced transfer shows up anywhere in the block.
+ */
+void makeImage(uint32_t rbn, uint32_t generation, char* image)
+{
+    memcpy(image, &rbn, sizeof(rbn));
+    memcpy(image + sizeof(rbn), &generation, sizeof(generation));
+    for (uint32_t i = sizeof(rbn) + sizeof(generation); i < BLOCK_SIZE; ++i)
+        image[i] = static_cast<char>(rbn * 31 + generation * 7 + i);
+}
+
+/**
+ * @brief Gets the file offset of a block
+ */
+uint64_t offsetOf(uint32_t rbn)
+{
+    return HEADER_SIZE + static_cast<uint64_t>(rbn) * BLOCK_SIZE;
+}
+
+/**
+ * @brief Reads every block from several threads and compares each to its expected image
+ * @param file Open file
+ * @param generations Expected generation of each block
+ * @return True if every read returned a whole, matching block
+ */
+bool readAllConcurrently(const BlockFile& file, const std::vector<uint32_t>& generations)
+{
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < THREADS; ++t)
+    {
+        readers.emplace_back([&file, &generations, &mismatches, t]()
+        {
+            std::vector<char> actual(BLOCK_SIZE);
+            std::vector<char> expected(BLOCK_SIZE);
+            // Every thread reads every block, starting at a different one
+            for (uint32_t i = 0; i < BLOCK_COUNT; ++i)
+            {
+                uint32_t rbn = (i + t * BLOCK_COUNT / THREADS) % BLOCK_COUNT;
+                makeImage(rbn, generations[rbn], expected.data());
+                if (file.readAt(offsetOf(rbn), actual.data(), BLOCK_SIZE) != static_cast<long long>(BLOCK_SIZE) ||
+                    actual != expected)
+                    mismatches++;
+            }
+        });
+    }
+    for (auto& reader : readers)
+        reader.join();
+    return mismatches == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Block File Test: " << filePath << " ===\n\n";
+
+    std::remove(filePath.c_str());
+    {
+        std::ofstream create(filePath, std::ios::binary);
+        std::string header(HEADER_SIZE, 'H');
+        create.write(header.data(), header.size());
+    }
+
+    BlockFile file;
+    check("scratch file opens", file.open(filePath));
+    if (!file.isOpen())
+        return report("block file");
+
+    // Test 1: threads write disjoint blocks at the same time
+    std::cout << "\n--- Test 1: Concurrent writes ---\n";
+    std::vector<uint32_t> generations(BLOCK_COUNT, 0);
+    std::atomic<int> failedWrites(0);
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < THREADS; ++t)
+    {
+        writers.emplace_back([&file, &failedWrites, t]()
+        {
+            std::vector<char> image(BLOCK_SIZE);
+            for (uint32_t rbn = t; rbn < BLOCK_COUNT; rbn += THREADS)
+            {
+                makeImage(rbn, 0, image.data());
+                if (!file.writeAt(offsetOf(rbn), image.data(), BLOCK_SIZE))
+                    failedWrites++;
+            }
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    check("every write succeeds", failedWrites == 0);
+    check("the file holds every block", file.size() == offsetOf(BLOCK_COUNT));
+
+    std::vector<char> header(HEADER_SIZE);
+    check("the header is untouched", file.readAt(0, header.data(), HEADER_SIZE) == static_cast<long long>(HEADER_SIZE) &&
+          header == std::vector<char>(HEADER_SIZE, 'H'));
+
+    // Test 2: threads read every block at the same time
+    std::cout << "\n--- Test 2: Concurrent reads ---\n";
+    check("every block reads back whole from every thread", readAllConcurrently(file, generations));
+
+    // Test 3: readers of half the blocks run while writers rewrite the other half
+    std::cout << "\n--- Test 3: Reads during writes ---\n";
+    std::atomic<int> mismatches(0);
+    std::atomic<bool> writing(true);
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < THREADS; ++t)
+    {
+        readers.emplace_back([&file, &mismatches, &writing]()
+        {
+            std::vector<char> actual(BLOCK_SIZE);
+            std::vector<char> expected(BLOCK_SIZE);
+            do
+            {
+                for (uint32_t rbn = 0; rbn < BLOCK_COUNT; rbn += 2)
+                {
+                    makeImage(rbn, 0, expected.data());
+                    if (file.readAt(offsetOf(rbn), actual.data(), BLOCK_SIZE) != static_cast<long long>(BLOCK_SIZE) ||
+                        actual != expected)
+                        mismatches++;
+                }
+            } while (writing);
+        });
+    }
+    writers.clear();
+    for (unsigned t = 0; t < THREADS; ++t)
+    {
+        writers.emplace_back([&file, &failedWrites, t]()
+        {
+            std::vector<char> image(BLOCK_SIZE);
+            for (int round = 1; round <= ROUNDS; ++round)
+            {
+                // Odd blocks only, each owned by one writer
+                for (uint32_t rbn = 1 + 2 * t; rbn < BLOCK_COUNT; rbn += 2 * THREADS)
+                {
+                    makeImage(rbn, round, image.data());
+                    if (!file.writeAt(offsetOf(rbn), image.data(), BLOCK_SIZE))
+                        failedWrites++;
+                }
+            }
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    writing = false;
+    for (auto& reader : readers)
+        reader.join();
+    check("every rewrite succeeds", failedWrites == 0);
+    check("blocks nobody writes read back unchanged", mismatches == 0);
+
+    for (uint32_t rbn = 1; rbn < BLOCK_COUNT; rbn += 2)
+        generations[rbn] = ROUNDS;
+    check("every block holds its last write", readAllConcurrently(file, generations));
+
+    // Test 4: a read past the end comes back short rather than failing
+    std::cout << "\n--- Test 4: End of file ---\n";
+    std::vector<char> tail(BLOCK_SIZE);
+    check("a read across the end returns the bytes there",
+          file.readAt(offsetOf(BLOCK_COUNT) - 100, tail.data(), BLOCK_SIZE) == 100);
+    check("a read past the end returns nothing", file.readAt(offsetOf(BLOCK_COUNT) + BLOCK_SIZE, tail.data(), BLOCK_SIZE) == 0);
+
+    file.close();
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("block file");
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+
+#include "../src/Block.h"
+#include "../src/BlockOccupancy.h"
+#include "../src/CSVBuffer.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: BlockOccupancyTest [file.csv]
+const std::string DEFAULT_FILE_PATH = "data/PT2_Randomized.csv";
+const uint32_t BLOCK_SIZE = 1024;
+
+/**
+ * @brief Size of the record the way it used to be measured, by building its text
+ */
+uint32_t textSize(const ZipCodeRecord& record)
+{
+    std::string recordStr = std::to_string(record.getZipCode()) + "," + record.getLocationName() + "," +
+                            std::string(record.getState()) + "," + record.getCounty() + "," +
+                            std::to_string(record.getLatitude()) + "," + std::to_string(record.getLongitude());
+    return 4 + recordStr.length();
+}
+
+/**
+ * @brief Checks that a tracker agrees with the packed, padded block after every move
+ * @details Records are moved one at a time between two blocks, the way borrowing does, and
+ *          each block is repacked and measured by scanning for its padding.
+ */
+bool tracksMoves(RecordBuffer& recordBuffer, const std::vector<ZipCodeRecord>& records)
+{
+    std::vector<ZipCodeRecord> left(records.begin(), records.begin() + records.size() / 2);
+    std::vector<ZipCodeRecord> right(records.begin() + records.size() / 2, records.end());
+    BlockOccupancy leftOccupancy(recordBuffer, left);
+    BlockOccupancy rightOccupancy(recordBuffer, right);
+
+    bool agrees = true;
+    while (!left.empty())
+    {
+        size_t last = left.size() - 1;
+        rightOccupancy.insert(0, left[last], leftOccupancy.erase(last, left[last]));
+        right.insert(right.begin(), left[last]);
+        left.pop_back();
+
+        ActiveBlock leftBlock;
+        ActiveBlock rightBlock;
+        recordBuffer.packBlock(left, leftBlock.data, BLOCK_SIZE * 2);
+        recordBuffer.packBlock(right, rightBlock.data, BLOCK_SIZE * 2);
+        leftBlock.data.resize(BLOCK_SIZE * 2 - BlockOccupancy::METADATA_SIZE, '\xFF');
+        rightBlock.data.resize(BLOCK_SIZE * 2 - BlockOccupancy::METADATA_SIZE, '\xFF');
+        agrees = leftOccupancy.getUsedSize() == leftBlock.getTotalSize() &&
+                 rightOccupancy.getUsedSize() == rightBlock.getTotalSize() && agrees;
+    }
+    return agrees && leftOccupancy.getRecordBytes() == 0 && rightOccupancy.getRecordCount() == records.size();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Block Occupancy Test: " << filePath << " ===\n\n";
+
+    CSVBuffer csvBuffer;
+    if (!csvBuffer.openFile(filePath))
+    {
+        std::cerr << "Failed to open " << filePath << std::endl;
+        return 1;
+    }
+    std::vector<ZipCodeRecord> records;
+    ZipCodeRecord record;
+    while (csvBuffer.getNextRecord(record))
+        records.push_back(record);
+    csvBuffer.closeFile();
+
+    // Test 1: the text size is counted without building the text
+    std::cout << "--- Test 1: Record size ---\n";
+    size_t matching = 0;
+    for (const auto& rec : records)
+        matching += rec.getRecordSize() == textSize(rec) ? 1 : 0;
+    check("getRecordSize matches the built text on all " + std::to_string(records.size()) + " records",
+          matching == records.size());
+    ZipCodeRecord extreme(4294967295u, -89.9999999, 1e20, "", "XX", "");
+    check("wide numbers counted too", extreme.getRecordSize() == textSize(extreme));
+    std::cout << "\n";
+
+    // Test 2: trackers follow records moving between blocks, in every encoding
+    std::cout << "--- Test 2: Moves ---\n";
+    std::mt19937 random(11);
+    const RecordEncoding encodings[] = {RecordEncoding::Text, RecordEncoding::Binary, RecordEncoding::Slotted,
+                                        RecordEncoding::Dictionary, RecordEncoding::SlottedDelta, RecordEncoding::Binary,
+                                        RecordEncoding::Slotted, RecordEncoding::Dictionary, RecordEncoding::SlottedDelta};
+    const char* names[] = {"text", "binary", "slotted", "dictionary", "slotted delta", "micro-degree binary",
+                           "micro-degree slotted", "micro-degree dictionary", "micro-degree slotted delta"};
+    std::vector<ZipCodeRecord> sortedRecords = records; // Delta slots only hold nearby zips, as a real block does
+    std::sort(sortedRecords.begin(), sortedRecords.end(), [](const ZipCodeRecord& a, const ZipCodeRecord& b)
+              {
+                  return a.getZipCode() < b.getZipCode();
+              });
+    for (int e = 0; e < 9; ++e)
+    {
+        const std::vector<ZipCodeRecord>& pool = encodings[e] == RecordEncoding::SlottedDelta ? sortedRecords : records;
+        RecordBuffer recordBuffer;
+        recordBuffer.setEncoding(encodings[e]);
+        recordBuffer.setCoordinateFormat(e > 4 ? CoordinateFormat::MicroDegrees : CoordinateFormat::Degrees);
+        bool agrees = true;
+        for (int trial = 0; trial < 20; ++trial)
+        {
+            size_t start = random() % (pool.size() - 30);
+            std::vector<ZipCodeRecord> sample(pool.begin() + start, pool.begin() + start + 4 + random() % 25);
+            std::sort(sample.begin(), sample.end(), [](const ZipCodeRecord& a, const ZipCodeRecord& b)
+                      {
+                          return a.getZipCode() < b.getZipCode();
+                      });
+            agrees = tracksMoves(recordBuffer, sample) && agrees;
+        }
+        check(std::string(names[e]) + " used size matches the packed block after every move", agrees);
+    }
+
+    RecordBuffer slottedBuffer;
+    slottedBuffer.setEncoding(RecordEncoding::Slotted);
+    BlockOccupancy empty(slottedBuffer);
+    ActiveBlock emptyBlock;
+    emptyBlock.data.assign(BLOCK_SIZE - BlockOccupancy::METADATA_SIZE, '\xFF');
+    check("empty block is metadata only", empty.getUsedSize() == emptyBlock.getTotalSize());
+
+    RecordBuffer deltaBuffer;
+    deltaBuffer.setEncoding(RecordEncoding::SlottedDelta);
+    BlockOccupancy first(deltaBuffer, std::vector<ZipCodeRecord>(1, sortedRecords.front()));
+    const ZipCodeRecord& near = sortedRecords[1];
+    const ZipCodeRecord& far = sortedRecords.back();
+    check("delta slots refuse a zip out of reach", far.getZipCode() - sortedRecords.front().getZipCode() > RecordBuffer::MAX_SLOT_KEY_SPAN &&
+          first.getAddedSize(far, first.measure(far)) == BlockOccupancy::NEVER_FITS &&
+          first.getAddedSize(near, first.measure(near)) == first.measure(near));
+    std::cout << "\n";
+
+    return report("occupancy");
+}
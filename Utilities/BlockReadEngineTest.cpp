@@ -0,0 +1,182 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/BlockFile.h"
+#include "../src/BlockReadEngine.h"
+#include "TestHelpers.h"
+
+// Usage: BlockReadEngineTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/read_engine_test.zcb";
+const uint32_t BLOCK_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const uint32_t BLOCK_COUNT = 96;
+const uint32_t RBN_MARK = 7000; // Added to the RBN in each block's preceding link, so a block names itself
+
+/**
+ * @brief Builds the block stored at an RBN
+ */
+ActiveBlock makeBlock(uint32_t rbn)
+{
+    ActiveBlock block;
+    block.recordCount = 1;
+    block.precedingRBN = RBN_MARK + rbn;
+    block.succeedingRBN = 0;
+    std::string record = std::to_string(60000 + rbn) + ",Engine,IA,Polk,41.6,-93.6";
+    uint32_t length = record.length();
+    block.data.insert(block.data.end(), reinterpret_cast<char*>(&length), reinterpret_cast<char*>(&length) + sizeof(length));
+    block.data.insert(block.data.end(), record.begin(), record.end());
+    return block;
+}
+
+/**
+ * @brief Submits one batch and checks that every request completes once with the block asked for
+ * @param engine Engine under test
+ * @param file Open scratch file
+ * @param rbns Blocks to request, in request order
+ * @param images Image of every block as written
+ * @return True if each request was reported exactly once and read its block
+ */
+bool batchReadsEach(BlockReadEngine& engine, const BlockFile& file, const std::vector<uint32_t>& rbns,
+                    const std::vector<std::string>& images)
+{
+    std::vector<char> buffers(rbns.size() * BLOCK_SIZE);
+    std::vector<BlockReadEngine::Request> requests(rbns.size());
+    for (size_t i = 0; i < rbns.size(); ++i)
+    {
+        requests[i].offset = HEADER_SIZE + static_cast<uint64_t>(rbns[i]) * BLOCK_SIZE;
+        requests[i].dest = buffers.data() + i * BLOCK_SIZE;
+        requests[i].length = BLOCK_SIZE;
+    }
+
+    std::vector<int> reported(rbns.size(), 0);
+    bool complete = engine.submitAndWait(file, requests, [&reported](size_t index) { reported[index]++; });
+    for (size_t i = 0; i < rbns.size(); ++i)
+    {
+        if (reported[i] != 1 || requests[i].result != static_cast<long long>(BLOCK_SIZE) ||
+            std::string(requests[i].dest, BLOCK_SIZE) != images[rbns[i]])
+            return false;
+    }
+    return complete;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Block Read Engine Test: " << filePath << " ===\n\n";
+
+    // Write the blocks through a BlockBuffer so they are in the file's own layout
+    std::remove(filePath.c_str());
+    {
+        std::ofstream create(filePath, std::ios::binary);
+        std::string empty(HEADER_SIZE + BLOCK_COUNT * BLOCK_SIZE, '\0');
+        create.write(empty.data(), empty.size());
+    }
+    {
+        BlockBuffer writer;
+        writer.openFile(filePath, HEADER_SIZE);
+        for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+            writer.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE, makeBlock(rbn));
+        check("scratch blocks written", writer.flush());
+        writer.closeFile();
+    }
+
+    BlockFile file;
+    check("scratch file opens", file.open(filePath, true));
+    std::vector<std::string> images(BLOCK_COUNT);
+    for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+    {
+        images[rbn].resize(BLOCK_SIZE);
+        file.readAt(HEADER_SIZE + static_cast<uint64_t>(rbn) * BLOCK_SIZE, &images[rbn][0], BLOCK_SIZE);
+    }
+
+    // Requests in a shuffled order, one block asked for twice
+    std::vector<uint32_t> rbns;
+    for (uint32_t rbn = 0; rbn < BLOCK_COUNT; rbn += 3)
+        rbns.push_back(rbn);
+    std::mt19937 random(17);
+    std::shuffle(rbns.begin(), rbns.end(), random);
+    rbns.push_back(rbns.front());
+
+    // Test 1: a pool of workers completes every request once
+    std::cout << "\n--- Test 1: Parallel batch ---\n";
+    BlockReadEngine engine(4);
+    check("every request completes once with its block", batchReadsEach(engine, file, rbns, images));
+
+    // Test 2: without workers the calling thread reads the batch itself
+    std::cout << "\n--- Test 2: Inline batch ---\n";
+    BlockReadEngine inlineEngine(0);
+    check("every request completes once with its block", batchReadsEach(inlineEngine, file, rbns, images));
+
+    // Test 3: batches submitted from several threads at once keep their completions apart
+    std::cout << "\n--- Test 3: Concurrent batches ---\n";
+    std::vector<int> results(4, 0);
+    std::vector<std::thread> submitters;
+    for (size_t t = 0; t < results.size(); ++t)
+    {
+        submitters.emplace_back([&, t]()
+        {
+            std::vector<uint32_t> own(rbns);
+            std::rotate(own.begin(), own.begin() + t * 5, own.end());
+            results[t] = batchReadsEach(engine, file, own, images) ? 1 : 0;
+        });
+    }
+    for (auto& submitter : submitters)
+        submitter.join();
+    check("each batch sees only its own completions", std::count(results.begin(), results.end(), 1) == 4);
+
+    // Test 4: a short read is still reported once, and fails the batch
+    std::cout << "\n--- Test 4: Short read ---\n";
+    std::vector<char> buffer(2 * BLOCK_SIZE);
+    std::vector<BlockReadEngine::Request> requests(2);
+    requests[0].offset = HEADER_SIZE;
+    requests[0].dest = buffer.data();
+    requests[0].length = BLOCK_SIZE;
+    requests[1].offset = HEADER_SIZE + static_cast<uint64_t>(BLOCK_COUNT) * BLOCK_SIZE; // Past the end
+    requests[1].dest = buffer.data() + BLOCK_SIZE;
+    requests[1].length = BLOCK_SIZE;
+    int reports = 0;
+    bool complete = engine.submitAndWait(file, requests, [&reports](size_t) { reports++; });
+    check("the batch reports the short read", !complete && requests[1].result == 0);
+    check("both requests are still reported", reports == 2 && requests[0].result == static_cast<long long>(BLOCK_SIZE));
+    file.close();
+
+    // Test 5: a BlockBuffer batch visits cached and cold blocks, each requested RBN once
+    std::cout << "\n--- Test 5: BlockBuffer batch ---\n";
+    {
+        BlockCache cache(8);
+        BlockBuffer buffer;
+        buffer.attachCache(&cache);
+        buffer.openFile(filePath, HEADER_SIZE);
+        for (size_t i = 0; i < 4; ++i)
+            buffer.loadActiveBlockAtRBN(rbns[i * 6], BLOCK_SIZE, HEADER_SIZE); // Some hot, most cold
+
+        std::vector<int> visits(rbns.size(), 0);
+        bool matched = true;
+        bool loaded = buffer.visitActiveBlocksAtRBNs(rbns, BLOCK_SIZE, HEADER_SIZE,
+            [&](size_t index, const ActiveBlock& block)
+            {
+                visits[index]++;
+                matched = block.precedingRBN == RBN_MARK + rbns[index] && block.recordCount == 1 && matched;
+            });
+        check("every block loads", loaded);
+        check("each requested RBN is visited exactly once",
+              std::count(visits.begin(), visits.end(), 1) == static_cast<long>(rbns.size()));
+        check("each visit holds the block asked for", matched);
+        buffer.closeFile();
+    }
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("read engine");
+}
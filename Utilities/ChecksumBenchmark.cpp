@@ -0,0 +1,170 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../src/BlockChecksum.h"
+#include "../src/FileSession.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/ZipCodeRecord.h"
+#include "BenchmarkHelpers.h"
+
+// Usage: ChecksumBenchmark [file.zcb] [lookups]
+// Make a checksummed file with: ZCDUtility convert-blocked data/PT2_Randomized.csv data/PT2_CRC32C.zcb 1024 256 0 crc32c
+const std::string DEFAULT_FILE_PATH = "data/PT2_CRC32C.zcb";
+const int DEFAULT_LOOKUPS = 20000;
+const uint32_t CRC_BLOCK_SIZE = 4096;
+const int CRC_ITERATIONS = 100000;
+
+/**
+ * @brief Times the hardware and table driven CRC32C over one page
+ */
+void benchmarkCrc()
+{
+    std::vector<char> page(CRC_BLOCK_SIZE);
+    for (size_t i = 0; i < page.size(); ++i)
+        page[i] = static_cast<char>(i * 31 + 7);
+
+    uint32_t crc = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < CRC_ITERATIONS; ++i)
+        crc ^= BlockChecksum::crc32c(page.data(), page.size(), static_cast<uint32_t>(i));
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    reportBandwidth(BlockChecksum::isHardwareAccelerated() ? "crc32c (SSE4.2)" : "crc32c (no SSE4.2, table)",
+                    seconds, CRC_ITERATIONS, "page", CRC_BLOCK_SIZE);
+
+    start = BenchClock::now();
+    for (int i = 0; i < CRC_ITERATIONS; ++i)
+        crc ^= BlockChecksum::crc32cPortable(page.data(), page.size(), static_cast<uint32_t>(i));
+    seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    reportBandwidth("crc32c (table)", seconds, CRC_ITERATIONS, "page", CRC_BLOCK_SIZE);
+    std::cout << "  (checksum " << crc << ")\n" << std::endl;
+}
+
+/**
+ * @brief Walks the sequence set once to collect every key
+ */
+std::vector<uint32_t> collectKeys(FileSession& session)
+{
+    const HeaderRecord& header = session.getHeader();
+    std::vector<uint32_t> keys;
+    std::vector<ZipCodeRecord> records;
+    ActiveBlock block;
+    uint32_t rbn = header.getSequenceSetListRBN();
+    uint32_t visited = 0;
+    while (rbn != 0 && visited++ <= header.getBlockCount())
+    {
+        if (!session.getBlockBuffer().loadActiveBlockAtRBN(rbn, header.getBlockSize(), header.getHeaderSize(), block))
+            break;
+        session.getBlockBuffer().unpackBlockAPI(block.data, records);
+        for (const auto& record : records)
+            keys.push_back(record.getZipCode());
+        rbn = block.succeedingRBN;
+    }
+    return keys;
+}
+
+/**
+ * @brief Times index search plus record read for each key under one verify policy
+ * @param label Name of the policy
+ * @param session Open session on a checksummed file
+ * @param keys Keys in lookup order
+ * @param lookups Lookups to time
+ */
+void benchmarkLookups(const std::string& label, FileSession& session, BlockChecksum::VerifyPolicy policy,
+                      const std::vector<uint32_t>& keys, int lookups)
+{
+    const HeaderRecord& header = session.getHeader();
+    session.setVerifyPolicy(policy);
+    BlockBuffer& buffer = session.getBlockBuffer();
+
+    // One untimed pass so every policy starts from the same warm cache
+    uint64_t found = 0;
+    ZipCodeRecord record;
+    for (int i = 0; i < lookups; ++i)
+    {
+        uint32_t rbn = 0;
+        uint32_t key = keys[i % keys.size()];
+        if (session.getTree().search(key, rbn))
+            buffer.readRecordAtRBN(rbn, key, header.getBlockSize(), header.getHeaderSize(), record);
+    }
+
+    buffer.resetChecksumStats();
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < lookups; ++i)
+    {
+        uint32_t rbn = 0;
+        uint32_t key = keys[i % keys.size()];
+        if (session.getTree().search(key, rbn) &&
+            buffer.readRecordAtRBN(rbn, key, header.getBlockSize(), header.getHeaderSize(), record))
+            found++;
+    }
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    BlockChecksum::Stats stats = buffer.getChecksumStats();
+    printThroughput("lookup, verify " + label, seconds, lookups, "lookup");
+    std::cout << std::setw(10) << stats.verified << " blocks verified, " << stats.failures << " failed, "
+              << found << " found" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    int lookups = argc > 2 ? std::atoi(argv[2]) : DEFAULT_LOOKUPS;
+    if (lookups <= 0) lookups = DEFAULT_LOOKUPS;
+
+    std::cout << "=== Checksum Benchmark: " << filePath << " ===\n" << std::endl;
+    benchmarkCrc();
+
+    HeaderBuffer headerBuffer;
+    HeaderRecord header;
+    if (!headerBuffer.readHeader(filePath, header))
+    {
+        std::cerr << "Failed to read header from " << filePath << std::endl;
+        return 1;
+    }
+    if (header.getChecksumType() != HeaderRecord::CHECKSUM_CRC32C)
+    {
+        std::cout << filePath << " has no block checksums, convert it with the crc32c option to time lookups" << std::endl;
+        return 0;
+    }
+
+    // convert-blocked leaves a block index behind, have the session build a B+ tree for this file
+    header.setStaleFlag(1);
+    if (!headerBuffer.rewriteHeader(filePath, header))
+    {
+        std::cerr << "Failed to mark the index stale: " << headerBuffer.getLastError() << std::endl;
+        return 1;
+    }
+
+    FileSession session;
+    if (!session.open(filePath))
+    {
+        std::cerr << "Failed to open " << filePath << ": " << session.getLastError() << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> keys = collectKeys(session);
+    if (keys.empty())
+    {
+        std::cerr << "No records in " << filePath << std::endl;
+        return 1;
+    }
+    std::mt19937 random(42);
+    std::shuffle(keys.begin(), keys.end(), random);
+    std::cout << keys.size() << " keys, " << lookups << " random lookups, block size " << header.getBlockSize()
+              << ", cache budget " << session.getCacheManager().getByteBudget() << " bytes\n" << std::endl;
+
+    benchmarkLookups("never", session, BlockChecksum::VerifyPolicy::Never, keys, lookups);
+    benchmarkLookups("first read", session, BlockChecksum::VerifyPolicy::FirstRead, keys, lookups);
+    benchmarkLookups("always", session, BlockChecksum::VerifyPolicy::Always, keys, lookups);
+
+    session.close();
+    return 0;
+}
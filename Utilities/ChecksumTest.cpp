@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/BlockBuffer.h"
+#include "../src/BlockChecksum.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/FileSession.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: ChecksumTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/checksum_test.zcb";
+const std::string INDEX_FILE_PATH = "data/checksum_test.idx";
+const uint32_t BLOCK_SIZE = 512;
+const uint32_t BLOCK_COUNT = 10;
+const uint32_t RECORDS_PER_BLOCK = 4;
+
+/**
+ * @brief Builds a checksummed header with a stale index so the first session builds it
+ * @return The header, header size already set
+ */
+HeaderRecord makeHeader()
+{
+    HeaderRecord header = makeTestHeader(HeaderRecord::CHECKSUM_VERSION, BLOCK_SIZE, INDEX_FILE_PATH,
+                                         BLOCK_COUNT * RECORDS_PER_BLOCK, BLOCK_COUNT, 1);
+    header.setChecksumType(HeaderRecord::CHECKSUM_CRC32C);
+    header.setHeaderSize(header.serialize().size());
+    return header;
+}
+
+/**
+ * @brief Writes a sorted, checksummed sequence set of BLOCK_COUNT blocks at RBN 1 onwards
+ * @param filePath The blocked file, header already written
+ * @param header Its header
+ * @return True if every block was written
+ */
+bool writeSequenceSet(const std::string& filePath, const HeaderRecord& header)
+{
+    BlockBuffer buffer;
+    RecordBuffer recordBuffer;
+    buffer.setChecksums(true);
+    if (!buffer.openFile(filePath, header.getHeaderSize()))
+        return false;
+
+    bool written = true;
+    for (uint32_t rbn = 1; rbn <= BLOCK_COUNT; ++rbn)
+    {
+        std::vector<ZipCodeRecord> records;
+        for (uint32_t i = 0; i < RECORDS_PER_BLOCK; ++i)
+        {
+            uint32_t zip = 20000 + rbn * 100 + i * 2;
+            records.push_back(ZipCodeRecord(zip, 44.9, -93.2, "Checked " + std::to_string(zip), "MN", "Hennepin"));
+        }
+        ActiveBlock block;
+        block.recordCount = RECORDS_PER_BLOCK;
+        block.precedingRBN = rbn - 1;
+        block.succeedingRBN = rbn < BLOCK_COUNT ? rbn + 1 : 0;
+        recordBuffer.packBlock(records, block.data, buffer.getPayloadSize(BLOCK_SIZE));
+        written = buffer.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, header.getHeaderSize(), block) && written;
+    }
+    written = buffer.flush() && written;
+    buffer.closeFile();
+    return written;
+}
+
+/**
+ * @brief Flips one bit of a block in the file, behind every buffer's back
+ */
+void corruptBlock(const std::string& filePath, const HeaderRecord& header, uint32_t rbn, uint32_t offsetInBlock)
+{
+    std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
+    uint64_t offset = header.getHeaderSize() + static_cast<uint64_t>(rbn) * BLOCK_SIZE + offsetInBlock;
+    file.seekg(offset);
+    char byte = 0;
+    file.get(byte);
+    file.seekp(offset);
+    file.put(static_cast<char>(byte ^ 0x10));
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Checksum Test: " << filePath << " ===\n\n";
+
+    // Test 1: the CRC itself
+    std::cout << "--- Test 1: CRC32C ---\n";
+    const char* sample = "123456789";
+    check("standard check value", BlockChecksum::crc32c(sample, 9) == 0xE3069283);
+    check("hardware and table paths agree", BlockChecksum::crc32c(sample, 9) == BlockChecksum::crc32cPortable(sample, 9));
+    std::vector<char> page(BLOCK_SIZE, 'x');
+    BlockChecksum::stamp(page.data(), page.size());
+    check("stamped page verifies", BlockChecksum::verify(page.data(), page.size()));
+    page[17] ^= 1;
+    check("flipped bit is caught", !BlockChecksum::verify(page.data(), page.size()));
+    std::cout << "  " << (BlockChecksum::isHardwareAccelerated() ? "SSE4.2" : "table") << " path in use\n\n";
+
+    // Test 2: header round trip
+    std::cout << "--- Test 2: Header ---\n";
+    HeaderBuffer headerBuffer;
+    HeaderRecord header = makeHeader();
+    headerBuffer.writeHeader(filePath, header);
+    HeaderRecord readBack;
+    check("header reads back", headerBuffer.readHeader(filePath, readBack));
+    check("checksum type survives the round trip", readBack.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C);
+    std::ifstream raw(filePath, std::ios::binary);
+    raw.seekg(readBack.getStaleFlagOffset());
+    check("stale flag offset unchanged by the new field", raw.get() == 1);
+    raw.close();
+    std::cout << "\n";
+
+    // Test 3: blocks are stamped and checked
+    std::cout << "--- Test 3: Blocks ---\n";
+    check("sequence set written", writeSequenceSet(filePath, header));
+    {
+        BlockBuffer buffer;
+        buffer.setChecksums(true);
+        buffer.openFile(filePath, header.getHeaderSize());
+        std::vector<char> image(BLOCK_SIZE);
+        check("block image carries a valid trailer", buffer.readBlockImageAtRBN(3, BLOCK_SIZE, header.getHeaderSize(), image.data()) &&
+              BlockChecksum::verify(image.data(), BLOCK_SIZE));
+        ZipCodeRecord record;
+        check("records read through a checksummed buffer", buffer.readRecordAtRBN(3, 20302, BLOCK_SIZE,
+              header.getHeaderSize(), record) && record.getZipCode() == 20302);
+
+        // A metadata patch has to restamp the whole block
+        check("link patched", buffer.writePrecedingRBNAtRBN(6, BLOCK_SIZE, header.getHeaderSize(), 5));
+        buffer.flush();
+        buffer.closeFile();
+    }
+    {
+        BlockBuffer buffer;
+        buffer.setChecksums(true);
+        buffer.openFile(filePath, header.getHeaderSize());
+        ActiveBlock block;
+        check("patched block still verifies", buffer.loadActiveBlockAtRBN(6, BLOCK_SIZE, header.getHeaderSize(), block) &&
+              buffer.getChecksumStats().failures == 0 && block.precedingRBN == 5);
+        buffer.closeFile();
+    }
+
+    corruptBlock(filePath, header, 5, 40);
+    {
+        BlockBuffer buffer;
+        buffer.setChecksums(true);
+        buffer.openFile(filePath, header.getHeaderSize());
+        ActiveBlock block;
+        check("corrupt block refused", !buffer.loadActiveBlockAtRBN(5, BLOCK_SIZE, header.getHeaderSize(), block) &&
+              buffer.getLastError() == "Checksum mismatch at RBN 5");
+        check("neighbour still loads", buffer.loadActiveBlockAtRBN(4, BLOCK_SIZE, header.getHeaderSize(), block));
+        buffer.closeFile();
+
+        BlockBuffer trusting;
+        trusting.setChecksums(true);
+        trusting.setVerifyPolicy(BlockChecksum::VerifyPolicy::Never);
+        trusting.openFile(filePath, header.getHeaderSize());
+        check("policy never skips the check", trusting.loadActiveBlockAtRBN(5, BLOCK_SIZE, header.getHeaderSize(), block) &&
+              trusting.getChecksumStats().verified == 0);
+        trusting.closeFile();
+    }
+    corruptBlock(filePath, header, 5, 40);
+    std::cout << "\n";
+
+    // Test 4: a session builds a checksummed index and serves lookups through both files
+    std::cout << "--- Test 4: Session ---\n";
+    {
+        FileSession session;
+        check("session opens and builds the index", session.open(filePath));
+        uint32_t rbn = 0;
+        check("search through the index", session.getTree().search(20704, rbn) && rbn == 7);
+        ZipCodeRecord record;
+        check("record read through the session", session.getBlockBuffer().readRecordAtRBN(rbn, 20704, BLOCK_SIZE,
+              header.getHeaderSize(), record) && record.getZipCode() == 20704);
+        check("session closes", session.close());
+    }
+
+    std::vector<char> indexPage(BLOCK_SIZE);
+    std::ifstream index(INDEX_FILE_PATH, std::ios::binary);
+    index.seekg(0, std::ios::end);
+    uint64_t indexSize = static_cast<uint64_t>(index.tellg());
+    index.seekg(indexSize - BLOCK_SIZE);
+    index.read(indexPage.data(), BLOCK_SIZE);
+    index.close();
+    check("index page carries a valid trailer", BlockChecksum::verify(indexPage.data(), BLOCK_SIZE));
+    std::cout << "\n";
+
+    std::remove(filePath.c_str());
+    std::remove(INDEX_FILE_PATH.c_str());
+
+    return report("checksum");
+}
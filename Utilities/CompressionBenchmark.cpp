@@ -0,0 +1,279 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/BlockCodec.h"
+#include "../src/BlockOccupancy.h"
+#include "../src/CSVBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "BenchmarkHelpers.h"
+#include "TestHelpers.h"
+
+// Usage: CompressionBenchmark [file.csv] [blockSize] [passes]
+const std::string DEFAULT_FILE_PATH = "data/PT2_Randomized.csv";
+const std::string TEMP_FILE_PATH = "data/compression_benchmark.zcb";
+const uint32_t DEFAULT_BLOCK_SIZE = 4096;
+const int DEFAULT_PASSES = 20;
+const size_t TEMP_HEADER_SIZE = 4096;
+const size_t CACHE_FRAMES = 32; // Budget of the end to end runs, in uncompressed blocks
+
+/**
+ * @brief Packs sorted records into padded block images the way convert-blocked fills blocks
+ * @param recordBuffer Buffer set to the encoding under test
+ * @param records Sorted records
+ * @param blockSize Bytes per block
+ * @param payloadSize Bytes of a block usable for metadata and records
+ * @return One image per block, linked in RBN order from RBN 1
+ */
+std::vector<std::vector<char>> packImages(RecordBuffer& recordBuffer, const std::vector<ZipCodeRecord>& records,
+                                          uint32_t blockSize, size_t payloadSize)
+{
+    std::vector<std::vector<ZipCodeRecord>> groups(1);
+    BlockOccupancy occupancy(recordBuffer);
+    for (const auto& record : records)
+    {
+        uint32_t recordSize = occupancy.measure(record);
+        if (occupancy.getUsedSize() + occupancy.getAddedSize(record, recordSize) + 4 * (groups.back().size() + 1) > payloadSize)
+        {
+            groups.push_back(std::vector<ZipCodeRecord>());
+            occupancy.clear();
+        }
+        occupancy.insert(groups.back().size(), record, recordSize);
+        groups.back().push_back(record);
+    }
+
+    std::vector<std::vector<char>> images;
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        std::vector<char> data;
+        recordBuffer.packBlock(groups[i], data, blockSize);
+        uint16_t count = static_cast<uint16_t>(groups[i].size());
+        uint32_t preceding = static_cast<uint32_t>(i);
+        uint32_t succeeding = i + 1 < groups.size() ? static_cast<uint32_t>(i + 2) : 0;
+
+        std::vector<char> image(blockSize, '\xFF');
+        memcpy(image.data(), &count, sizeof(count));
+        memcpy(image.data() + 2, &preceding, sizeof(preceding));
+        memcpy(image.data() + 6, &succeeding, sizeof(succeeding));
+        memcpy(image.data() + BlockCodec::METADATA_SIZE, data.data(), data.size());
+        images.push_back(image);
+    }
+    return images;
+}
+
+/**
+ * @brief Times one codec over every image and checks the images come back unchanged
+ * @return Stored bytes of all the images
+ */
+uint64_t benchmarkCodec(const BlockCodec& codec, const std::vector<std::vector<char>>& images, uint32_t blockSize,
+                        int passes)
+{
+    std::vector<std::vector<char>> stored(images.size(), std::vector<char>(blockSize));
+    std::vector<size_t> storedSizes(images.size());
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (size_t i = 0; i < images.size(); ++i)
+            storedSizes[i] = codec.encodeBlock(images[i].data(), blockSize, 0, stored[i].data());
+    }
+    double encodeSeconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    std::vector<char> image(blockSize);
+    bool intact = true;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (size_t i = 0; i < images.size(); ++i)
+            intact = codec.decodeBlock(stored[i].data(), storedSizes[i], blockSize, 0, image.data()) && intact;
+    }
+    double decodeSeconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    uint64_t storedBytes = 0;
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        codec.decodeBlock(stored[i].data(), storedSizes[i], blockSize, 0, image.data());
+        intact = image == images[i] && intact;
+        storedBytes += storedSizes[i];
+    }
+    reportThroughput("  " + std::string(codec.getName()) + " encode", encodeSeconds, images.size() * passes, "block");
+    reportThroughput("  " + std::string(codec.getName()) + " decode", decodeSeconds, images.size() * passes, "block");
+    check(std::string(codec.getName()) + " round trips every block", intact);
+    return storedBytes;
+}
+
+/**
+ * @brief Checks that damaged stored blocks are refused or decoded within bounds, never crash
+ */
+void checkCorruption(const std::vector<char>& image, uint32_t blockSize)
+{
+    const BlockCodec& lz = *BlockCodec::forType(BlockCodec::Type::LZ);
+    std::vector<char> stored(blockSize);
+    size_t storedSize = lz.encodeBlock(image.data(), blockSize, 0, stored.data());
+    std::vector<char> decoded(blockSize);
+
+    check("lz stores a record block in fewer bytes", storedSize < blockSize);
+    check("cut short body refused", !lz.decodeBlock(stored.data(), storedSize - 1, blockSize, 0, decoded.data()));
+
+    std::vector<char> damaged = stored;
+    uint16_t tooLong = static_cast<uint16_t>(blockSize);
+    memcpy(damaged.data() + BlockCodec::METADATA_SIZE, &tooLong, sizeof(tooLong));
+    check("body length past the block refused", !lz.decodeBlock(damaged.data(), blockSize, blockSize, 0, decoded.data()));
+
+    // Flip every byte of the body in turn; a flip may still decode, but only within the image
+    size_t refused = 0;
+    size_t bodyStart = BlockCodec::METADATA_SIZE + BlockCodec::FRAME_HEADER_SIZE;
+    for (size_t i = bodyStart; i < storedSize; ++i)
+    {
+        damaged = stored;
+        damaged[i] = static_cast<char>(~damaged[i]);
+        refused += lz.decodeBlock(damaged.data(), storedSize, blockSize, 0, decoded.data()) ? 0 : 1;
+    }
+    check("body flips handled, " + std::to_string(refused) + " of " + std::to_string(storedSize - bodyStart) +
+          " refused", true);
+
+    std::vector<char> garbage(blockSize);
+    for (size_t i = 0; i < garbage.size(); ++i)
+        garbage[i] = static_cast<char>(i * 131 + 17);
+    uint16_t garbageLength = static_cast<uint16_t>(blockSize / 2);
+    memcpy(garbage.data() + BlockCodec::METADATA_SIZE, &garbageLength, sizeof(garbageLength));
+    lz.decodeBlock(garbage.data(), garbage.size(), blockSize, 0, decoded.data());
+    check("garbage body handled", true);
+}
+
+/**
+ * @brief Writes the images through a compressed BlockBuffer and reads them back through a small cache
+ * @param images Images to store at RBN 1 onwards
+ * @param blockSize Bytes per block
+ * @param form The cache form under test
+ * @param label Name printed for the run
+ */
+void benchmarkFile(const std::vector<std::vector<char>>& images, uint32_t blockSize, BlockBuffer::CacheForm form,
+                   const std::string& label, int passes)
+{
+    {
+        std::ofstream create(TEMP_FILE_PATH, std::ios::binary | std::ios::trunc);
+        std::vector<char> header(TEMP_HEADER_SIZE, 0);
+        create.write(header.data(), header.size());
+    }
+
+    BlockCache cache(CACHE_FRAMES);
+    BlockBuffer buffer;
+    buffer.setLayoutAlignment(HeaderRecord::PAGE_ALIGNMENT);
+    buffer.setCompression(BlockCodec::Type::LZ);
+    buffer.setCacheForm(form);
+    buffer.attachCache(&cache);
+    if (!buffer.openFile(TEMP_FILE_PATH, TEMP_HEADER_SIZE))
+    {
+        check(label + " file opened", false);
+        return;
+    }
+
+    std::vector<ActiveBlock> blocks(images.size());
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        buffer.imageToActiveBlock(images[i].data(), blockSize, blocks[i]);
+        buffer.writeActiveBlockAtRBN(static_cast<uint32_t>(i + 1), blockSize, TEMP_HEADER_SIZE, blocks[i]);
+    }
+    bool flushed = buffer.flush();
+    buffer.resetCompressionStats();
+
+    ActiveBlock block;
+    bool intact = true;
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            intact = buffer.loadActiveBlockAtRBN(static_cast<uint32_t>(i + 1), blockSize, TEMP_HEADER_SIZE, block) &&
+                     block.recordCount == blocks[i].recordCount && block.data == blocks[i].data && intact;
+        }
+    }
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    BlockCodec::Stats stats = buffer.getCompressionStats();
+    BlockCache::Stats cacheStats = buffer.getCacheStats();
+    reportThroughput("  " + label + " scan", seconds, blocks.size() * passes, "block");
+    std::cout << "    " << cache.getResidentCount() << " blocks resident in " << CACHE_FRAMES << " frames, "
+              << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+              << stats.blocksDecoded << " decoded" << std::endl;
+    check(label + " blocks read back unchanged", flushed && intact);
+    if (form == BlockBuffer::CacheForm::Compressed)
+        check(label + " cache holds more blocks than frames", cache.getResidentCount() > CACHE_FRAMES);
+
+    buffer.closeFile();
+    std::remove(TEMP_FILE_PATH.c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    uint32_t blockSize = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : DEFAULT_BLOCK_SIZE;
+    int passes = argc > 3 ? std::atoi(argv[3]) : DEFAULT_PASSES;
+
+    CSVBuffer csvBuffer;
+    if (!csvBuffer.openFile(filePath))
+    {
+        std::cerr << "Failed to open " << filePath << std::endl;
+        return 1;
+    }
+    std::vector<ZipCodeRecord> records;
+    ZipCodeRecord record;
+    while (csvBuffer.getNextRecord(record))
+        records.push_back(record);
+    csvBuffer.closeFile();
+    std::sort(records.begin(), records.end(), [](const ZipCodeRecord& a, const ZipCodeRecord& b)
+              {
+                  return a.getZipCode() < b.getZipCode();
+              });
+
+    std::cout << "=== Compression Benchmark: " << filePath << " ===" << std::endl;
+    std::cout << records.size() << " records, block size " << blockSize << ", " << passes << " passes\n" << std::endl;
+
+    BlockBuffer framed;
+    framed.setCompression(BlockCodec::Type::LZ);
+    const size_t payloadSize = framed.getPayloadSize(blockSize);
+
+    const RecordEncoding encodings[] = {RecordEncoding::Text, RecordEncoding::Binary, RecordEncoding::Slotted,
+                                        RecordEncoding::Dictionary};
+    const char* names[] = {"text", "binary", "slotted", "dictionary"};
+    std::vector<std::vector<char>> textImages;
+    for (int e = 0; e < 4; ++e)
+    {
+        RecordBuffer recordBuffer;
+        recordBuffer.setEncoding(encodings[e]);
+        std::vector<std::vector<char>> images = packImages(recordBuffer, records, blockSize, payloadSize);
+        if (e == 0)
+            textImages = images;
+
+        std::cout << "--- " << names[e] << ": " << images.size() << " blocks ---" << std::endl;
+        uint64_t logicalBytes = static_cast<uint64_t>(images.size()) * blockSize;
+        benchmarkCodec(*BlockCodec::forType(BlockCodec::Type::None), images, blockSize, passes);
+        uint64_t storedBytes = benchmarkCodec(*BlockCodec::forType(BlockCodec::Type::LZ), images, blockSize, passes);
+        std::cout << "  lz stores " << std::setprecision(1) << (100.0 * storedBytes / logicalBytes)
+                  << "% of the block bytes\n" << std::endl;
+    }
+
+    std::cout << "--- Corrupt input ---" << std::endl;
+    checkCorruption(textImages[textImages.size() / 2], blockSize);
+    std::cout << std::endl;
+
+    std::cout << "--- File, " << CACHE_FRAMES << " frame cache ---" << std::endl;
+    benchmarkFile(textImages, blockSize, BlockBuffer::CacheForm::Decompressed, "decompressed frames", passes);
+    benchmarkFile(textImages, blockSize, BlockBuffer::CacheForm::Compressed, "compressed frames", passes);
+    std::cout << std::endl;
+
+    return report("compression");
+}
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/BlockFile.h"
+#include "../src/PageBufferAlt.h"
+#include "TestHelpers.h"
+
+// Usage: DirectIOTest [scratch file]
+// The scratch file must be on a file system that takes O_DIRECT (not tmpfs) for the direct paths to run
+const std::string DEFAULT_FILE_PATH = "data/direct_io_test.zcb";
+const size_t SECTOR = BlockFile::DIRECT_IO_ALIGNMENT;
+const uint32_t BLOCK_SIZE = 4096;
+const size_t HEADER_SIZE = 4096; // Padded so block 0 starts on a sector
+const uint32_t BLOCK_COUNT = 8;
+
+/**
+ * @brief Creates the scratch file with a header and zeroed blocks
+ */
+void createFile(const std::string& filePath)
+{
+    std::remove(filePath.c_str());
+    std::ofstream file(filePath, std::ios::binary);
+    std::string header(HEADER_SIZE, 'H');
+    std::string blocks(BLOCK_COUNT * BLOCK_SIZE, '\0');
+    file.write(header.data(), header.size());
+    file.write(blocks.data(), blocks.size());
+}
+
+/**
+ * @brief Fills a buffer with a pattern that depends on a seed
+ */
+void fillPattern(char* dest, size_t length, uint32_t seed)
+{
+    for (size_t i = 0; i < length; ++i)
+        dest[i] = static_cast<char>(seed * 13 + i * 7);
+}
+
+/**
+ * @brief Builds the block stored at an RBN
+ */
+ActiveBlock makeBlock(uint32_t rbn)
+{
+    ActiveBlock block;
+    block.recordCount = 1;
+    block.precedingRBN = rbn == 0 ? 0 : rbn - 1;
+    block.succeedingRBN = rbn + 1 < BLOCK_COUNT ? rbn + 1 : 0;
+    std::string record = std::to_string(52000 + rbn) + ",Direct,IA,Johnson,41.6,-91.5";
+    uint32_t length = record.length();
+    block.data.insert(block.data.end(), reinterpret_cast<char*>(&length), reinterpret_cast<char*>(&length) + sizeof(length));
+    block.data.insert(block.data.end(), record.begin(), record.end());
+    return block;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Direct I/O Test: " << filePath << " ===\n\n";
+    createFile(filePath);
+
+    // Test 1: sector aligned transfers go straight to the device
+    std::cout << "--- Test 1: Aligned round trip ---\n";
+    {
+        BlockFile file;
+        check("file opens in direct mode or falls back", file.open(filePath, false, true));
+        std::cout << "  (" << (file.isDirect() ? "direct" : "buffered fallback") << ")\n";
+
+        BlockImage written(2 * SECTOR);
+        fillPattern(written.data(), written.size(), 1);
+        check("the transfer is aligned", BlockFile::isAligned(HEADER_SIZE, written.data(), written.size()));
+        check("aligned write", file.writeAt(HEADER_SIZE, written.data(), written.size()));
+
+        BlockImage read(2 * SECTOR);
+        check("aligned read", file.readAt(HEADER_SIZE, read.data(), read.size()) == static_cast<long long>(read.size()));
+        check("the bytes round trip", memcmp(read.data(), written.data(), written.size()) == 0);
+
+        // Two adjacent blocks gathered into one write
+        BlockImage first(SECTOR), second(SECTOR);
+        fillPattern(first.data(), SECTOR, 2);
+        fillPattern(second.data(), SECTOR, 3);
+        std::vector<BlockFile::WriteSegment> segments = {
+            { HEADER_SIZE + 5 * SECTOR, second.data(), SECTOR },
+            { HEADER_SIZE + 4 * SECTOR, first.data(), SECTOR } };
+        check("batched write", file.writeBatch(segments));
+        check("both segments round trip",
+              file.readAt(HEADER_SIZE + 4 * SECTOR, read.data(), read.size()) == static_cast<long long>(read.size()) &&
+              memcmp(read.data(), first.data(), SECTOR) == 0 && memcmp(read.data() + SECTOR, second.data(), SECTOR) == 0);
+    }
+
+    // Test 2: anything unaligned is bounced, neighbouring bytes in the same sectors survive
+    std::cout << "\n--- Test 2: Unaligned round trip ---\n";
+    {
+        BlockFile file;
+        file.open(filePath, false, true);
+        std::vector<char> before(3 * SECTOR);
+        file.readAt(HEADER_SIZE, before.data(), before.size());
+
+        std::vector<char> patch(SECTOR + 100);
+        fillPattern(patch.data(), patch.size(), 4);
+        const uint64_t offset = HEADER_SIZE + 700;
+        check("unaligned write", file.writeAt(offset, patch.data(), patch.size()));
+
+        std::vector<char> expected(before);
+        std::copy(patch.begin(), patch.end(), expected.begin() + 700);
+        std::vector<char> after(3 * SECTOR);
+        check("read back", file.readAt(HEADER_SIZE, after.data(), after.size()) == static_cast<long long>(after.size()));
+        check("the patch and the bytes around it are right", after == expected);
+
+        std::vector<char> piece(300);
+        check("unaligned read", file.readAt(offset + 1, piece.data(), piece.size()) == 300 &&
+              std::equal(piece.begin(), piece.end(), patch.begin() + 1));
+
+        std::vector<char> header(HEADER_SIZE);
+        check("the header is untouched", file.readAt(0, header.data(), HEADER_SIZE) == static_cast<long long>(HEADER_SIZE) &&
+              header == std::vector<char>(HEADER_SIZE, 'H'));
+    }
+
+    // Test 3: BlockBuffer in direct mode writes blocks a buffered open reads back
+    std::cout << "\n--- Test 3: BlockBuffer round trip ---\n";
+    {
+        BlockBuffer misaligned;
+        check("a header off the sector boundary is refused", !misaligned.openFile(filePath, 512, true));
+
+        BlockBuffer direct;
+        check("direct open", direct.openFile(filePath, HEADER_SIZE, true));
+        for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+            direct.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE, makeBlock(rbn));
+        check("flush", direct.flush());
+        direct.closeFile();
+
+        BlockCache noCache(0);
+        BlockBuffer buffered;
+        buffered.attachCache(&noCache);
+        buffered.openFile(filePath, HEADER_SIZE);
+        bool matched = true;
+        for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+        {
+            ActiveBlock expected = makeBlock(rbn);
+            ActiveBlock block = buffered.loadActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE);
+            matched = block.recordCount == expected.recordCount && block.precedingRBN == expected.precedingRBN &&
+                      block.succeedingRBN == expected.succeedingRBN &&
+                      std::equal(expected.data.begin(), expected.data.end(), block.data.begin()) && matched;
+        }
+        check("every block reads back through a buffered open", matched);
+        buffered.closeFile();
+    }
+
+    // Test 4: PageBufferAlt in direct mode
+    std::cout << "\n--- Test 4: PageBufferAlt round trip ---\n";
+    {
+        PageBufferAlt misaligned;
+        check("an unaligned page size is refused", !misaligned.open(filePath, 512, HEADER_SIZE, true));
+
+        PageBufferAlt direct;
+        check("direct open", direct.open(filePath, BLOCK_SIZE, HEADER_SIZE, true));
+        std::vector<uint8_t> page(BLOCK_SIZE);
+        for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+        {
+            fillPattern(reinterpret_cast<char*>(page.data()), page.size(), 10 + rbn);
+            direct.writeBlock(rbn, page);
+        }
+        check("sync", direct.sync());
+        direct.closeFile();
+
+        PageBufferAlt buffered;
+        buffered.open(filePath, BLOCK_SIZE, HEADER_SIZE);
+        bool matched = true;
+        std::vector<uint8_t> expected(BLOCK_SIZE);
+        for (uint32_t rbn = 0; rbn < BLOCK_COUNT; ++rbn)
+        {
+            fillPattern(reinterpret_cast<char*>(expected.data()), expected.size(), 10 + rbn);
+            matched = buffered.readBlock(rbn, page) && page == expected && matched;
+        }
+        check("every page reads back through a buffered open", matched);
+        buffered.closeFile();
+    }
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("direct I/O");
+}
@@ -0,0 +1,256 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <csignal>
+#include <sys/resource.h>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/FileSession.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: FileSessionTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/file_session_test.zcb";
+const std::string INDEX_FILE_PATH = "data/file_session_test.idx";
+const uint32_t BLOCK_SIZE = 512;
+const uint32_t BLOCK_COUNT = 12;
+const uint32_t RECORDS_PER_BLOCK = 6;
+
+/**
+ * @brief Reads the whole file
+ */
+std::string readFile(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/**
+ * @brief Reads the header as it is on disk
+ */
+HeaderRecord readDiskHeader(const std::string& filePath)
+{
+    HeaderBuffer headerBuffer;
+    HeaderRecord header;
+    headerBuffer.readHeader(filePath, header);
+    return header;
+}
+
+/**
+ * @brief Caps the size files of this process may grow to
+ * @details Writes past the cap fail with EFBIG instead of raising SIGXFSZ.
+ * @param bytes The cap, RLIM_INFINITY to lift it
+ */
+void limitFileSize(rlim_t bytes)
+{
+    signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    limit.rlim_cur = (bytes == RLIM_INFINITY) ? limit.rlim_max : bytes;
+    setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+/**
+ * @brief Gets the zip code stored at a position of the initial sequence set
+ */
+uint32_t zipAt(uint32_t rbn, uint32_t i)
+{
+    return 10000 + rbn * 100 + i * 2;
+}
+
+/**
+ * @brief Writes a header with a stale index and a sorted sequence set at RBN 1 onwards
+ * @return The header, as written
+ */
+HeaderRecord createFile(const std::string& filePath)
+{
+    std::remove(filePath.c_str());
+    std::remove(INDEX_FILE_PATH.c_str());
+    HeaderRecord header = makeTestHeader(HeaderRecord::CHECKSUM_VERSION, BLOCK_SIZE, INDEX_FILE_PATH,
+                                         BLOCK_COUNT * RECORDS_PER_BLOCK, BLOCK_COUNT, 1);
+    header.setHeaderSize(header.serialize().size());
+    HeaderBuffer headerBuffer;
+    headerBuffer.writeHeader(filePath, header);
+
+    BlockBuffer buffer;
+    RecordBuffer recordBuffer;
+    buffer.openFile(filePath, header.getHeaderSize());
+    for (uint32_t rbn = 1; rbn <= BLOCK_COUNT; ++rbn)
+    {
+        std::vector<ZipCodeRecord> records;
+        for (uint32_t i = 0; i < RECORDS_PER_BLOCK; ++i)
+            records.push_back(ZipCodeRecord(zipAt(rbn, i), 44.9, -93.2, "Session", "MN", "Hennepin"));
+        ActiveBlock block;
+        block.recordCount = RECORDS_PER_BLOCK;
+        block.precedingRBN = rbn - 1;
+        block.succeedingRBN = rbn < BLOCK_COUNT ? rbn + 1 : 0;
+        recordBuffer.packBlock(records, block.data, BLOCK_SIZE);
+        buffer.writeActiveBlockAtRBN(rbn, BLOCK_SIZE, header.getHeaderSize(), block);
+    }
+    buffer.flush();
+    buffer.closeFile();
+    return header;
+}
+
+/**
+ * @brief Adds a record through the session to the block its index names
+ * @details Only for zip codes the index still routes right after a split: inside a block's key
+ *          range, or below the first key of the file
+ * @return True if the record was added
+ */
+bool addThroughSession(FileSession& session, uint32_t zipCode)
+{
+    HeaderRecord& header = session.getHeader();
+    uint32_t rbn = 0;
+    if (!session.markModified() || !session.getTree().search(zipCode, rbn))
+        return false;
+    uint32_t availListRBN = header.getAvailableListRBN();
+    uint32_t blockCount = header.getBlockCount();
+    ZipCodeRecord record(zipCode, 45.0, -93.0, "Added", "MN", "Anoka");
+    if (!session.getBlockBuffer().addRecord(rbn, BLOCK_SIZE, availListRBN, record, header.getHeaderSize(), blockCount))
+        return false;
+    header.setAvailableListRBN(availListRBN);
+    header.setBlockCount(blockCount);
+    header.setRecordCount(header.getRecordCount() + 1);
+    return true;
+}
+
+/**
+ * @brief Looks a zip code up through a session's index and sequence set
+ */
+bool findThroughSession(FileSession& session, uint32_t zipCode)
+{
+    uint32_t rbn = 0;
+    ZipCodeRecord record;
+    return session.getTree().search(zipCode, rbn) &&
+           session.getBlockBuffer().readRecordAtRBN(rbn, zipCode, BLOCK_SIZE, session.getHeader().getHeaderSize(), record) &&
+           record.getZipCode() == zipCode;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== File Session Test: " << filePath << " ===\n";
+    const HeaderRecord created = createFile(filePath);
+
+    // Test 1: the first open builds the stale index, close records it as valid
+    std::cout << "\n--- Test 1: First open ---\n";
+    {
+        FileSession session;
+        check("the session opens", session.open(filePath));
+        check("the built index finds a record", findThroughSession(session, zipAt(5, 3)));
+        check("the session closes", session.close());
+        check("the stale flag is cleared on disk", readDiskHeader(filePath).getStaleFlag() == 0);
+    }
+
+    // Test 2: a session that only reads writes nothing
+    std::cout << "\n--- Test 2: Read only session ---\n";
+    std::string data = readFile(filePath);
+    std::string index = readFile(INDEX_FILE_PATH);
+    {
+        FileSession session;
+        session.open(filePath);
+        bool found = true;
+        for (uint32_t rbn = 1; rbn <= BLOCK_COUNT; ++rbn)
+            found = findThroughSession(session, zipAt(rbn, rbn % RECORDS_PER_BLOCK)) && found;
+        check("every block is reached through one open", found);
+        check("the session closes", session.close());
+    }
+    check("the data file is unchanged", readFile(filePath) == data);
+    check("the index file is unchanged", readFile(INDEX_FILE_PATH) == index);
+
+    // Test 3: the header goes to disk once to mark the file stale, then once more on close
+    std::cout << "\n--- Test 3: Modify and close ---\n";
+    const uint64_t records = created.getRecordCount();
+    {
+        FileSession session;
+        session.open(filePath);
+        check("the file is marked stale before the first change", addThroughSession(session, zipAt(3, 1) + 1) &&
+              readDiskHeader(filePath).getStaleFlag() == 1);
+        std::string marked = readFile(filePath).substr(0, created.getHeaderSize());
+        check("further changes", addThroughSession(session, zipAt(7, 1) + 1) &&
+              addThroughSession(session, zipAt(9, 3) + 1));
+        check("the header in memory counts them", session.getHeader().getRecordCount() == records + 3);
+        check("flush", session.flush());
+        check("the header on disk is left alone until close",
+              readFile(filePath).substr(0, created.getHeaderSize()) == marked &&
+              readDiskHeader(filePath).getRecordCount() == records);
+        check("the session closes", session.close());
+    }
+    HeaderRecord closed = readDiskHeader(filePath);
+    check("close writes the final header", closed.getRecordCount() == records + 3 && closed.getStaleFlag() == 0);
+
+    // Test 4: a reopened session trusts the index and sees the changes
+    std::cout << "\n--- Test 4: Reopen ---\n";
+    index = readFile(INDEX_FILE_PATH);
+    {
+        FileSession session;
+        check("the session reopens", session.open(filePath));
+        check("the added records are found", findThroughSession(session, zipAt(3, 1) + 1) &&
+              findThroughSession(session, zipAt(7, 1) + 1) && findThroughSession(session, zipAt(9, 3) + 1));
+        check("the original records are found", findThroughSession(session, zipAt(1, 0)) &&
+              findThroughSession(session, zipAt(BLOCK_COUNT, RECORDS_PER_BLOCK - 1)));
+        session.close();
+    }
+    check("the index was not rebuilt", readFile(INDEX_FILE_PATH) == index);
+
+    // Test 5: a flush that fails leaves the file stale, the next one that succeeds lets close clear it
+    std::cout << "\n--- Test 5: Failed flush ---\n";
+    {
+        FileSession session;
+        session.open(filePath);
+        // Keys below the first block stay in its lower half when it splits, so the index still routes them
+        bool added = true;
+        for (uint32_t i = 1; i <= 2 * RECORDS_PER_BLOCK; ++i)
+            added = addThroughSession(session, zipAt(1, 0) - i) && added;
+        check("records added until the block splits", added && session.getHeader().getBlockCount() > BLOCK_COUNT);
+        const uint64_t onDisk = readFile(filePath).size();
+        const uint64_t blocks = session.getHeader().getBlockCount();
+        check("the new block is only in memory", onDisk < created.getHeaderSize() + (blocks + 1) * BLOCK_SIZE);
+
+        limitFileSize(onDisk);
+        check("flush fails while the file cannot grow", !session.flush());
+        limitFileSize(RLIM_INFINITY);
+        check("the file stays marked stale", readDiskHeader(filePath).getStaleFlag() == 1);
+
+        // The split is not in the index, build it again before closing
+        check("the index is rebuilt once the file can grow", session.rebuildIndex());
+        check("the session closes", session.close());
+        check("the stale flag is cleared on disk", readDiskHeader(filePath).getStaleFlag() == 0);
+        check("a reopened session finds the new records", session.open(filePath) &&
+              findThroughSession(session, zipAt(1, 0) - 1) &&
+              findThroughSession(session, zipAt(1, 0) - 2 * RECORDS_PER_BLOCK));
+        session.close();
+    }
+
+    // Test 6: a close whose flush fails keeps the flag
+    std::cout << "\n--- Test 6: Failed close ---\n";
+    {
+        FileSession session;
+        session.open(filePath);
+        const uint32_t blocks = session.getHeader().getBlockCount();
+        bool added = true;
+        for (uint32_t i = 1; i <= 2 * RECORDS_PER_BLOCK; ++i)
+            added = addThroughSession(session, zipAt(1, 0) - 2 * RECORDS_PER_BLOCK - i) && added;
+        check("records added until the block splits", added && session.getHeader().getBlockCount() > blocks);
+        limitFileSize(readFile(filePath).size());
+        check("close reports the failed flush", !session.close());
+        limitFileSize(RLIM_INFINITY);
+        check("the file stays marked stale", readDiskHeader(filePath).getStaleFlag() == 1);
+    }
+    std::remove(filePath.c_str());
+    std::remove(INDEX_FILE_PATH.c_str());
+
+    std::cout << "\n";
+    return report("file session");
+}
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+
+#include "../src/NodeAlt.h"
+#include "TestHelpers.h"
+
+// Usage: KeyEncodingTest
+const size_t BLOCK_SIZE = 512;
+
+/**
+ * @brief Fills a leaf with sorted keys from base, until it has no room for the next one
+ * @return The keys inserted
+ */
+std::vector<uint32_t> fillLeaf(NodeAlt& leaf, uint32_t base, uint32_t step)
+{
+    std::vector<uint32_t> keys;
+    for (uint32_t key = base; leaf.hasRoomFor(key); key += step)
+    {
+        leaf.insertKeyAt(keys.size(), key);
+        leaf.insertValueAt(keys.size(), key * 2 + 1);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief Checks that page searches agree with a linear scan of the keys, for keys in and around them
+ */
+bool boundsAgree(const NodePage& page, const std::vector<uint32_t>& keys)
+{
+    std::vector<uint32_t> probes = {0, UINT32_MAX};
+    for (uint32_t key : keys)
+    {
+        probes.push_back(key);
+        probes.push_back(key - 1);
+        probes.push_back(key + 1);
+    }
+    for (uint32_t probe : probes)
+    {
+        size_t lower = std::lower_bound(keys.begin(), keys.end(), probe) - keys.begin();
+        size_t upper = std::upper_bound(keys.begin(), keys.end(), probe) - keys.begin();
+        if (page.lowerBound(probe) != lower || page.upperBound(probe) != upper)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    std::cout << "=== Key Encoding Test ===\n\n";
+
+    // Test 1: a frame of reference leaf holds more keys and reads back the same
+    std::cout << "--- Test 1: Leaf round trip ---\n";
+    NodeAlt full(true, BLOCK_SIZE);
+    NodeAlt compact(true, BLOCK_SIZE, KeyEncoding::FrameOfReference);
+    std::vector<uint32_t> fullKeys = fillLeaf(full, 50001, 3);
+    std::vector<uint32_t> keys = fillLeaf(compact, 50001, 3);
+    std::cout << "  " << fullKeys.size() << " full keys, " << keys.size() << " compact keys\n";
+    check("compact leaf holds more keys", keys.size() > fullKeys.size());
+    size_t capacity = NodeAlt::calculateMaxKeys(BLOCK_SIZE, true, KeyEncoding::FrameOfReference, keys.back() - keys.front());
+    size_t widened = NodeAlt::calculateMaxKeys(BLOCK_SIZE, true, KeyEncoding::FrameOfReference, keys.back() + 3 - keys.front());
+    check("fill stops where the next key would widen the page past its capacity",
+          keys.size() <= capacity && keys.size() + 1 > widened);
+
+    compact.setPrevLeafRBN(7);
+    compact.setNextLeafRBN(9);
+    compact.setParentRBN(3);
+    std::vector<uint8_t> data;
+    compact.pack(data);
+    check("page is one block", data.size() == BLOCK_SIZE);
+    NodeAlt unpacked(true, BLOCK_SIZE);
+    bool same = unpacked.unpack(data) && unpacked.getKeyCount() == keys.size() &&
+                unpacked.getKeyEncoding() == KeyEncoding::FrameOfReference &&
+                unpacked.getPrevLeafRBN() == 7 && unpacked.getNextLeafRBN() == 9 && unpacked.getParentRBN() == 3;
+    for (size_t i = 0; same && i < keys.size(); ++i)
+        same = unpacked.getKeyAt(i) == keys[i] && unpacked.getValueAt(i) == keys[i] * 2 + 1;
+    check("keys, values and links unpack", same);
+
+    NodePage page(data);
+    same = page.isValid() && page.isLeaf() && page.getKeyCount() == keys.size();
+    for (size_t i = 0; same && i < keys.size(); ++i)
+        same = page.getKeyAt(i) == keys[i] && page.getValueAt(i) == keys[i] * 2 + 1;
+    check("page reads keys and values in place", same);
+    check("page searches match a linear scan", boundsAgree(page, keys));
+    std::cout << "\n";
+
+    // Test 2: keys further apart need wider offsets
+    std::cout << "--- Test 2: Key width ---\n";
+    check("widths follow the span", NodeAlt::keyWidthFor(0) == 1 && NodeAlt::keyWidthFor(255) == 1 &&
+          NodeAlt::keyWidthFor(256) == 2 && NodeAlt::keyWidthFor(65536) == 3 && NodeAlt::keyWidthFor(UINT32_MAX) == 4);
+    NodeAlt narrow(true, BLOCK_SIZE, KeyEncoding::FrameOfReference);
+    std::vector<uint32_t> narrowKeys = fillLeaf(narrow, 1000, 1);
+    check("a full leaf of close keys has no room for a far one", !narrow.hasRoomFor(narrowKeys.back() + 1) &&
+          !narrow.hasRoomFor(1000000));
+    narrow.removeKeyAt(narrowKeys.size() - 1);
+    narrow.removeValueAt(narrowKeys.size() - 1);
+    check("freeing a slot makes room for a close key, not a far one", narrow.hasRoomFor(narrowKeys.back()) &&
+          !narrow.hasRoomFor(1000000));
+
+    NodeAlt wide(true, BLOCK_SIZE, KeyEncoding::FrameOfReference);
+    std::vector<uint32_t> wideKeys = fillLeaf(wide, 1, 1u << 25);
+    check("keys spanning four bytes hold as many as full keys", wideKeys.size() >= fullKeys.size() - 1);
+    wide.pack(data);
+    NodePage widePage(data);
+    check("wide page searches match a linear scan", widePage.isValid() && boundsAgree(widePage, wideKeys));
+    std::cout << "\n";
+
+    // Test 3: index pages, and full pages read through the same view
+    std::cout << "--- Test 3: Index pages ---\n";
+    std::mt19937 random(5);
+    bool agree = true;
+    for (int encoding = 0; encoding < 2; ++encoding)
+    {
+        for (int trial = 0; trial < 20; ++trial)
+        {
+            NodeAlt index(false, BLOCK_SIZE, encoding == 0 ? KeyEncoding::Full : KeyEncoding::FrameOfReference);
+            std::vector<uint32_t> separators;
+            uint32_t key = random() % 100000;
+            index.insertChildRBN(0, 100);
+            while (separators.size() < 200 && index.hasRoomFor(key))
+            {
+                index.insertKeyAt(separators.size(), key);
+                index.insertChildRBN(separators.size() + 1, 101 + separators.size());
+                separators.push_back(key);
+                key += 1 + random() % (trial * 50 + 1);
+            }
+            index.pack(data);
+            NodePage indexPage(data);
+            agree = indexPage.isValid() && !indexPage.isLeaf() && boundsAgree(indexPage, separators) && agree;
+            for (uint32_t probe : separators)
+                agree = indexPage.getChildRBN(indexPage.upperBound(probe)) ==
+                        index.getChildRBN(index.findChildIndex(probe)) && agree;
+        }
+    }
+    check("index page searches follow the same child as findChildIndex", agree);
+
+    std::vector<uint8_t> fullData;
+    full.pack(fullData);
+    NodePage fullPage(fullData);
+    check("full pages read through the same view", fullPage.isValid() &&
+          fullPage.getKeyEncoding() == KeyEncoding::Full && boundsAgree(fullPage, fullKeys));
+    check("corrupt pages are refused", !NodePage(std::vector<uint8_t>(4, 0)).isValid() &&
+          !NodePage(std::vector<uint8_t>(BLOCK_SIZE, 0xFF)).isValid());
+    std::cout << "\n";
+
+    return report("key encoding");
+}
@@ -0,0 +1,194 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/BlockBuffer.h"
+#include "../src/BlockFile.h"
+#include "../src/Block.h"
+#include "../src/HeaderBuffer.h"
+#include "../src/HeaderRecord.h"
+#include "../src/PageBufferAlt.h"
+#include "../src/SequenceSetIterator.h"
+#include "TestHelpers.h"
+
+// Usage: LargeFileTest [scratch file]
+// The scratch file is sparse, it reports past 8 GiB but only a handful of blocks use disk space.
+const std::string DEFAULT_FILE_PATH = "data/large_file_test.zcb";
+const uint32_t BLOCK_SIZE = 4096;
+const uint64_t GIB = 1024ull * 1024ull * 1024ull;
+const uint64_t LARGE_RECORD_COUNT = 5000000000ull; // Past the old 32 bit limit
+
+/**
+ * @brief Builds the header used by every test
+ * @param version Header version to write
+ * @return The header, record count set past 2^32 for the large file version
+ */
+HeaderRecord makeHeader(uint16_t version)
+{
+    return makeTestHeader(version, BLOCK_SIZE, "data/large_file_test.idx",
+                          version >= HeaderRecord::LARGE_FILE_VERSION ? LARGE_RECORD_COUNT : 40000, 0, 0);
+}
+
+/**
+ * @brief Builds a synthetic block of packed length indicated records
+ * @param rbn Block number, used to make every block's records distinct
+ * @param prec Preceding RBN
+ * @param succ Succeeding RBN
+ * @return The block
+ */
+ActiveBlock makeBlock(uint32_t rbn, uint32_t prec, uint32_t succ)
+{
+    ActiveBlock block;
+    block.recordCount = 0;
+    block.precedingRBN = prec;
+    block.succeedingRBN = succ;
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        std::string record = std::to_string(10000 + (rbn % 80000) + i) + ",Synthetic " + std::to_string(rbn) +
+                             ",MN,Stearns,45.5,-94.1";
+        uint32_t length = record.length();
+        block.data.insert(block.data.end(), reinterpret_cast<char*>(&length), reinterpret_cast<char*>(&length) + sizeof(length));
+        block.data.insert(block.data.end(), record.begin(), record.end());
+        block.recordCount++;
+    }
+    return block;
+}
+
+/**
+ * @brief Walks the chain and compares each block to the synthetic one at that RBN
+ * @param buffer Open buffer
+ * @param expected The RBNs in chain order
+ * @param headerSize Bytes before RBN 0
+ * @return True if the chain matched
+ */
+bool walkMatches(BlockBuffer& buffer, const std::vector<uint32_t>& expected, size_t headerSize)
+{
+    SequenceSetIterator it(buffer, expected.front(), BLOCK_SIZE, headerSize);
+    ActiveBlock block;
+    size_t visited = 0;
+    while (it.next(block))
+    {
+        if (visited >= expected.size() || it.getCurrentRBN() != expected[visited])
+            return false;
+        ActiveBlock reference = makeBlock(expected[visited], 0, 0);
+        if (block.recordCount != reference.recordCount ||
+            memcmp(block.data.data(), reference.data.data(), reference.data.size()) != 0)
+            return false;
+        visited++;
+    }
+    return visited == expected.size();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Large File Test: " << filePath << " ===\n\n";
+
+    // Test 1: header round trips
+    std::cout << "--- Test 1: Header Versions ---\n";
+    HeaderBuffer headerBuffer;
+    HeaderRecord readBack;
+
+    HeaderRecord oldHeader = makeHeader(2);
+    headerBuffer.writeHeader(filePath, oldHeader);
+    check("version 2 header reads back", headerBuffer.readHeader(filePath, readBack));
+    check("version 2 keeps a 32 bit record count", readBack.getRecordCount() == 40000 &&
+          readBack.getBlockCountOffset() == readBack.getRecordCountOffset() + sizeof(uint32_t));
+    check("version 2 stale flag is the last header byte", readBack.getStaleFlagOffset() == readBack.getHeaderSize() - 1);
+
+    HeaderRecord header = makeHeader(HeaderRecord::LARGE_FILE_VERSION);
+    header.setHeaderAlignment(BLOCK_SIZE);
+    header.setHeaderSize(header.serialize().size());
+    headerBuffer.writeHeader(filePath, header);
+    check("version 3 header reads back", headerBuffer.readHeader(filePath, readBack));
+    check("version 3 record count survives past 2^32", readBack.getRecordCount() == LARGE_RECORD_COUNT);
+    check("version 3 padded stale flag offset", readBack.getStaleFlagOffset() == oldHeader.serialize().size() - 1 + sizeof(uint32_t));
+    std::cout << "\n";
+
+    // Test 2: a sparse chain with blocks past 4 GiB and a jump past 8 GiB
+    std::cout << "--- Test 2: Sequence Set Past 4 GiB ---\n";
+    const size_t headerSize = header.getHeaderSize();
+    const uint32_t farRBN = static_cast<uint32_t>(5 * GIB / BLOCK_SIZE);
+    const uint32_t fartherRBN = static_cast<uint32_t>(9 * GIB / BLOCK_SIZE);
+    std::vector<uint32_t> chain;
+    chain.push_back(farRBN);
+    chain.push_back(farRBN + 1);
+    chain.push_back(farRBN + 2);
+    chain.push_back(fartherRBN);
+    chain.push_back(fartherRBN + 1);
+
+    {
+        BlockBuffer buffer;
+        if (!buffer.openFile(filePath, headerSize))
+        {
+            std::cerr << "Failed to open " << filePath << ": " << buffer.getLastError() << std::endl;
+            return 1;
+        }
+        bool written = true;
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            uint32_t prec = i > 0 ? chain[i - 1] : 0;
+            uint32_t succ = i + 1 < chain.size() ? chain[i + 1] : 0;
+            written = buffer.writeActiveBlockAtRBN(chain[i], BLOCK_SIZE, headerSize, makeBlock(chain[i], prec, succ)) && written;
+        }
+        written = buffer.flush() && written;
+        buffer.closeFile();
+        check("blocks written at RBN " + std::to_string(farRBN) + " and " + std::to_string(fartherRBN), written);
+    }
+
+    BlockFile file;
+    check("file size past 8 GiB", file.open(filePath, true) && file.size() > 8 * GIB);
+    file.close();
+
+    {
+        BlockBuffer buffer;
+        buffer.openFile(filePath, headerSize);
+        check("chain walk through reads", walkMatches(buffer, chain, headerSize));
+        ActiveBlock block;
+        check("preceding link past 8 GiB", buffer.loadActiveBlockAtRBN(fartherRBN, BLOCK_SIZE, headerSize, block) &&
+              block.precedingRBN == farRBN + 2);
+        buffer.closeFile();
+    }
+
+    {
+        BlockBuffer buffer;
+        if (buffer.openFileMapped(filePath, headerSize, BlockBuffer::AccessPattern::Sequential))
+        {
+            check("chain walk through the mapping", walkMatches(buffer, chain, headerSize));
+            buffer.closeFile();
+        }
+        else
+        {
+            std::cout << "  [SKIP] mapping unavailable: " << buffer.getLastError() << "\n";
+        }
+    }
+    std::cout << "\n";
+
+    // Test 3: index style page I/O at the far end of the file
+    std::cout << "--- Test 3: Index Pages Past 4 GiB ---\n";
+    {
+        PageBufferAlt pages;
+        check("page buffer opens", pages.open(filePath, BLOCK_SIZE, headerSize));
+        std::vector<uint8_t> page(BLOCK_SIZE);
+        for (size_t i = 0; i < page.size(); ++i)
+            page[i] = static_cast<uint8_t>(i * 7);
+        const uint32_t pageRBN = fartherRBN + 2;
+        check("page written", pages.writeBlock(pageRBN, page) && pages.sync());
+        pages.closeFile();
+
+        PageBufferAlt reopened;
+        std::vector<uint8_t> back;
+        reopened.open(filePath, BLOCK_SIZE, headerSize);
+        check("page reads back", reopened.readBlock(pageRBN, back) && back == page);
+        reopened.closeFile();
+    }
+    std::cout << "\n";
+
+    std::remove(filePath.c_str());
+
+    return report("large file");
+}
@@ -0,0 +1,221 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: MetadataPatchTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/metadata_patch_test.zcb";
+const uint32_t BLOCK_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const uint16_t MIN_BLOCK_SIZE = BLOCK_SIZE / 4;
+const uint32_t BLOCK_COUNT = 4; // RBN 0 is left out of the chain, as the header block is in real files
+const size_t ACTIVE_METADATA = 10; // recordCount(2) + precedingRBN(4) + succeedingRBN(4)
+const size_t AVAIL_METADATA = 6; // recordCount(2) + succeedingRBN(4)
+const size_t PRECEDING_OFFSET = 2;
+
+/**
+ * @brief Reads the whole scratch file
+ */
+std::string readFile(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/**
+ * @brief Gets the file offset of a block
+ */
+size_t offsetOf(uint32_t rbn)
+{
+    return HEADER_SIZE + static_cast<size_t>(rbn) * BLOCK_SIZE;
+}
+
+/**
+ * @brief Checks that two file images differ only inside one byte range
+ * @param start File offset of the range
+ * @param length Bytes in the range
+ * @return True if the sizes match and every byte outside the range is unchanged
+ */
+bool onlyRangeChanged(const std::string& before, const std::string& after, size_t start, size_t length)
+{
+    return before.size() == after.size() && before.compare(0, start, after, 0, start) == 0 &&
+           before.compare(start + length, std::string::npos, after, start + length, std::string::npos) == 0;
+}
+
+/**
+ * @brief Builds a block holding the given zip codes
+ */
+ActiveBlock makeBlock(const std::vector<uint32_t>& zipCodes, uint32_t prec, uint32_t succ)
+{
+    std::vector<ZipCodeRecord> records;
+    for (uint32_t zipCode : zipCodes)
+        records.push_back(ZipCodeRecord(zipCode, 41.6, -93.6, "Patch", "IA", "Story"));
+    ActiveBlock block;
+    block.recordCount = static_cast<uint16_t>(records.size());
+    block.precedingRBN = prec;
+    block.succeedingRBN = succ;
+    RecordBuffer recordBuffer;
+    recordBuffer.packBlock(records, block.data, BLOCK_SIZE);
+    return block;
+}
+
+/**
+ * @brief Writes the chain 1 -> 2 -> 3 with a file header and no free blocks
+ * @details The payload past the records is filled with a pattern, so bytes a full block rewrite
+ *          would replace are told apart from bytes left alone.
+ */
+void createFile(const std::string& filePath)
+{
+    std::remove(filePath.c_str());
+    {
+        std::ofstream create(filePath, std::ios::binary);
+        std::string header(HEADER_SIZE, 'H');
+        std::string blocks(BLOCK_COUNT * BLOCK_SIZE, '\x5A');
+        create.write(header.data(), header.size());
+        create.write(blocks.data(), blocks.size());
+    }
+    BlockCache noCache(0);
+    BlockBuffer buffer;
+    buffer.attachCache(&noCache);
+    buffer.openFile(filePath, HEADER_SIZE);
+    buffer.writeActiveBlockAtRBN(1, BLOCK_SIZE, HEADER_SIZE, makeBlock({ 50010, 50020, 50030 }, 0, 2));
+    buffer.writeActiveBlockAtRBN(2, BLOCK_SIZE, HEADER_SIZE, makeBlock({ 50040 }, 1, 3));
+    buffer.writeActiveBlockAtRBN(3, BLOCK_SIZE, HEADER_SIZE, makeBlock({ 50050, 50060, 50070 }, 2, 0));
+    buffer.closeFile();
+
+    // Give each block a tail the packer did not write
+    std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
+    for (uint32_t rbn = 1; rbn < BLOCK_COUNT; ++rbn)
+    {
+        std::string tail(16, static_cast<char>('a' + rbn));
+        file.seekp(offsetOf(rbn + 1) - tail.size());
+        file.write(tail.data(), tail.size());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Metadata Patch Test: " << filePath << " ===\n";
+
+    BlockCache noCache(0); // Nothing holds a block, every patch goes to the file
+    BlockBuffer buffer;
+    buffer.attachCache(&noCache);
+
+    // Test 1: a preceding link changes four bytes of the file
+    std::cout << "\n--- Test 1: Preceding link ---\n";
+    createFile(filePath);
+    std::string before = readFile(filePath);
+    check("scratch file opens", buffer.openFile(filePath, HEADER_SIZE));
+    check("the link is written", buffer.writePrecedingRBNAtRBN(3, BLOCK_SIZE, HEADER_SIZE, 1));
+    std::string after = readFile(filePath);
+    check("only the link bytes change", onlyRangeChanged(before, after, offsetOf(3) + PRECEDING_OFFSET, sizeof(uint32_t)));
+    ActiveBlock block = buffer.loadActiveBlockAtRBN(3, BLOCK_SIZE, HEADER_SIZE);
+    check("the block reads back with the new link", block.precedingRBN == 1 && block.succeedingRBN == 0 &&
+          block.recordCount == 3);
+
+    // Test 2: the whole active metadata region, nothing past it
+    std::cout << "\n--- Test 2: Active block metadata ---\n";
+    before = after;
+    check("the metadata is written", buffer.writeActiveBlockHeaderAtRBN(2, BLOCK_SIZE, HEADER_SIZE, 1, 3, 1));
+    after = readFile(filePath);
+    check("only the metadata bytes change", onlyRangeChanged(before, after, offsetOf(2), ACTIVE_METADATA));
+    std::vector<ZipCodeRecord> records;
+    block = buffer.loadActiveBlockAtRBN(2, BLOCK_SIZE, HEADER_SIZE);
+    check("the block reads back with its records", block.recordCount == 1 && block.precedingRBN == 3 &&
+          block.succeedingRBN == 1 && buffer.unpackBlockAPI(block.data, records) && records.size() == 1 &&
+          records[0].getZipCode() == 50040);
+
+    // Test 3: turning a block into an avail block keeps its old payload as dead bytes
+    std::cout << "\n--- Test 3: Avail block metadata ---\n";
+    before = after;
+    AvailBlock avail;
+    avail.recordCount = 0;
+    avail.succeedingRBN = 7;
+    check("the metadata is written", buffer.writeAvailBlockHeaderAtRBN(2, BLOCK_SIZE, HEADER_SIZE, avail));
+    after = readFile(filePath);
+    check("only the avail metadata bytes change", onlyRangeChanged(before, after, offsetOf(2), AVAIL_METADATA));
+    AvailBlock loaded = buffer.loadAvailBlockAtRBN(2, BLOCK_SIZE, HEADER_SIZE);
+    check("the avail block reads back", loaded.recordCount == 0 && loaded.succeedingRBN == 7);
+    buffer.closeFile();
+
+    // Test 4: a block cut short by the end of the file is patched without growing it
+    std::cout << "\n--- Test 4: Short last block ---\n";
+    createFile(filePath);
+    before = readFile(filePath).substr(0, offsetOf(BLOCK_COUNT - 1) + BLOCK_SIZE / 2);
+    {
+        std::ofstream truncated(filePath, std::ios::binary | std::ios::trunc);
+        truncated.write(before.data(), before.size());
+    }
+    buffer.openFile(filePath, HEADER_SIZE);
+    check("the link is written", buffer.writePrecedingRBNAtRBN(BLOCK_COUNT - 1, BLOCK_SIZE, HEADER_SIZE, 1));
+    buffer.closeFile();
+    after = readFile(filePath);
+    check("the file keeps its size and only the link changes",
+          onlyRangeChanged(before, after, offsetOf(BLOCK_COUNT - 1) + PRECEDING_OFFSET, sizeof(uint32_t)));
+
+    // Test 5: a resident frame takes the patch, the file sees it at flush
+    std::cout << "\n--- Test 5: Cached block ---\n";
+    createFile(filePath);
+    before = readFile(filePath);
+    {
+        BlockCache cache(BLOCK_COUNT);
+        BlockBuffer cached;
+        cached.attachCache(&cache);
+        cached.openFile(filePath, HEADER_SIZE);
+        cached.loadActiveBlockAtRBN(3, BLOCK_SIZE, HEADER_SIZE);
+        cached.writePrecedingRBNAtRBN(3, BLOCK_SIZE, HEADER_SIZE, 1);
+        check("the frame holds the patch", cache.getDirtyRBNs() == std::vector<uint32_t>({3}) &&
+              readFile(filePath) == before);
+        check("the block reads back with the new link",
+              cached.loadActiveBlockAtRBN(3, BLOCK_SIZE, HEADER_SIZE).precedingRBN == 1);
+        check("flush", cached.flush());
+        after = readFile(filePath);
+        check("only the link bytes change",
+              onlyRangeChanged(before, after, offsetOf(3) + PRECEDING_OFFSET, sizeof(uint32_t)));
+        cached.closeFile();
+    }
+
+    // Test 6: a merge frees a block and relinks its successor with metadata writes only
+    std::cout << "\n--- Test 6: Merge ---\n";
+    createFile(filePath);
+    before = readFile(filePath);
+    buffer.openFile(filePath, HEADER_SIZE);
+    uint32_t availListRBN = 0;
+    buffer.resetMerge();
+    check("the last record of block 2 is removed",
+          buffer.removeRecordAtRBN(2, MIN_BLOCK_SIZE, availListRBN, 50040, BLOCK_SIZE, HEADER_SIZE));
+    check("block 2 merges into block 1 and is freed", buffer.getMergeOccurred() && availListRBN == 2);
+    buffer.closeFile();
+    after = readFile(filePath);
+    check("the freed block keeps its payload",
+          before.compare(offsetOf(2) + AVAIL_METADATA, BLOCK_SIZE - AVAIL_METADATA,
+                         after, offsetOf(2) + AVAIL_METADATA, BLOCK_SIZE - AVAIL_METADATA) == 0);
+    check("the successor changes only its link",
+          before.compare(offsetOf(3), PRECEDING_OFFSET, after, offsetOf(3), PRECEDING_OFFSET) == 0 &&
+          before.compare(offsetOf(3) + PRECEDING_OFFSET + sizeof(uint32_t), std::string::npos,
+                         after, offsetOf(3) + PRECEDING_OFFSET + sizeof(uint32_t), std::string::npos) == 0);
+    buffer.openFile(filePath, HEADER_SIZE);
+    AvailBlock freed = buffer.loadAvailBlockAtRBN(2, BLOCK_SIZE, HEADER_SIZE);
+    block = buffer.loadActiveBlockAtRBN(3, BLOCK_SIZE, HEADER_SIZE);
+    check("the freed block heads the avail list", freed.recordCount == 0 && freed.succeedingRBN == 0);
+    check("the successor links back to block 1", block.precedingRBN == 1 && block.recordCount == 3);
+    buffer.closeFile();
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("metadata patch");
+}
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+
+#include "../src/PageBufferAlt.h"
+#include "TestHelpers.h"
+
+// Usage: PageBufferAltTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/page_buffer_test.idx";
+const size_t PAGE_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const size_t DIRTY_LIMIT = 4;
+
+/**
+ * @brief Builds a page whose bytes depend on its RBN and version
+ */
+std::vector<uint8_t> makePage(uint32_t rbn, uint8_t version)
+{
+    std::vector<uint8_t> page(PAGE_SIZE);
+    for (size_t i = 0; i < PAGE_SIZE; ++i)
+        page[i] = static_cast<uint8_t>(rbn * 17 + version * 5 + i);
+    return page;
+}
+
+/**
+ * @brief Reads one page of the scratch file straight from disk, bypassing the buffer
+ * @return The page, empty if the file ends before it
+ */
+std::vector<uint8_t> readFilePage(const std::string& filePath, uint32_t rbn)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::vector<uint8_t> page(PAGE_SIZE);
+    file.seekg(HEADER_SIZE + static_cast<uint64_t>(rbn) * PAGE_SIZE);
+    if (!file.read(reinterpret_cast<char*>(page.data()), PAGE_SIZE))
+        return std::vector<uint8_t>();
+    return page;
+}
+
+/**
+ * @brief Gets the size of the scratch file on disk
+ */
+uint64_t fileSize(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    return static_cast<uint64_t>(file.tellg());
+}
+
+/**
+ * @brief Creates the scratch file holding only its header
+ */
+void createFile(const std::string& filePath)
+{
+    std::remove(filePath.c_str());
+    std::ofstream file(filePath, std::ios::binary);
+    std::string header(HEADER_SIZE, 'H');
+    file.write(header.data(), header.size());
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== PageBufferAlt Test: " << filePath << " ===\n\n";
+    createFile(filePath);
+
+    PageBufferAlt buffer;
+    buffer.setDirtyPageLimit(DIRTY_LIMIT);
+    check("scratch file opens", buffer.open(filePath, PAGE_SIZE, HEADER_SIZE));
+
+    // Test 1: writes wait as dirty pages until the limit, then go out as one write per run of RBNs
+    std::cout << "\n--- Test 1: Dirty page limit ---\n";
+    buffer.writeBlock(0, makePage(0, 1));
+    buffer.writeBlock(1, makePage(1, 1));
+    buffer.writeBlock(2, makePage(2, 1));
+    check("pages under the limit stay dirty", buffer.getDirtyPageCount() == 3 && buffer.getPhysicalWriteCount() == 0);
+    check("the file is not written yet", fileSize(filePath) == HEADER_SIZE);
+
+    std::vector<uint8_t> page;
+    check("a dirty page reads back before it is written", buffer.readBlock(1, page) && page == makePage(1, 1));
+
+    buffer.writeBlock(5, makePage(5, 1));
+    check("reaching the limit flushes every dirty page", buffer.getDirtyPageCount() == 0);
+    check("adjacent pages share a write", buffer.getPhysicalWriteCount() == 2); // RBN 0-2, then 5
+    bool onDisk = true;
+    for (uint32_t rbn : {0u, 1u, 2u, 5u})
+        onDisk = readFilePage(filePath, rbn) == makePage(rbn, 1) && onDisk;
+    check("the file holds every flushed page", onDisk);
+    check("the gap between runs is left as a hole", readFilePage(filePath, 3) == std::vector<uint8_t>(PAGE_SIZE, 0));
+    check("the file ends after the last page", fileSize(filePath) == HEADER_SIZE + 6 * PAGE_SIZE);
+    std::ifstream raw(filePath, std::ios::binary);
+    std::string header(HEADER_SIZE, '\0');
+    raw.read(&header[0], HEADER_SIZE);
+    check("the header is untouched", header == std::string(HEADER_SIZE, 'H'));
+
+    // Test 2: rewriting a dirty page replaces it, only the last version reaches the file
+    std::cout << "\n--- Test 2: Rewrites before sync ---\n";
+    uint64_t writesBefore = buffer.getPhysicalWriteCount();
+    buffer.writeBlock(3, makePage(3, 1));
+    buffer.writeBlock(3, makePage(3, 2));
+    buffer.writeBlock(3, makePage(3, 3));
+    check("a rewritten page is held once", buffer.getDirtyPageCount() == 1);
+    check("sync succeeds", buffer.sync());
+    check("one write for the page", buffer.getPhysicalWriteCount() == writesBefore + 1);
+    check("the file holds the last version", readFilePage(filePath, 3) == makePage(3, 3));
+
+    // Test 3: no limit means every write goes straight to the file
+    std::cout << "\n--- Test 3: Write through ---\n";
+    buffer.setDirtyPageLimit(0);
+    writesBefore = buffer.getPhysicalWriteCount();
+    buffer.writeBlock(4, makePage(4, 1));
+    check("the page is written at once", buffer.getDirtyPageCount() == 0 &&
+          buffer.getPhysicalWriteCount() == writesBefore + 1 && readFilePage(filePath, 4) == makePage(4, 1));
+
+    // Test 4: closing writes what is left, a reopened buffer reads it from the file
+    std::cout << "\n--- Test 4: Close and reopen ---\n";
+    buffer.setDirtyPageLimit(DIRTY_LIMIT);
+    buffer.writeBlock(6, makePage(6, 1));
+    buffer.writeBlock(0, makePage(0, 2));
+    buffer.closeFile();
+    check("close writes the dirty pages", readFilePage(filePath, 6) == makePage(6, 1) &&
+          readFilePage(filePath, 0) == makePage(0, 2));
+
+    PageBufferAlt reopened;
+    check("the file reopens", reopened.open(filePath, PAGE_SIZE, HEADER_SIZE));
+    bool readBack = true;
+    const uint8_t versions[] = {2, 1, 1, 3, 1, 1, 1};
+    for (uint32_t rbn = 0; rbn < 7; ++rbn)
+        readBack = reopened.readBlock(rbn, page) && page == makePage(rbn, versions[rbn]) && readBack;
+    check("every page reads back at its last version", readBack);
+    check("no errors", !buffer.hasError() && !reopened.hasError());
+    reopened.closeFile();
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("page buffer");
+}
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../src/BlockOccupancy.h"
+#include "../src/CSVBuffer.h"
+#include "../src/RecordBuffer.h"
+#include "../src/RecordView.h"
+#include "../src/ZipCodeRecord.h"
+#define BENCHMARK_COUNT_ALLOCATIONS
+#include "BenchmarkHelpers.h"
+
+// Usage: RecordEncodingBenchmark [file.csv] [blockSize] [passes]
+const std::string DEFAULT_FILE_PATH = "data/PT2_Randomized.csv";
+const uint32_t DEFAULT_BLOCK_SIZE = 1024;
+const int DEFAULT_PASSES = 20;
+const size_t METADATA_SIZE = 10; // count, preceding and succeeding RBN
+
+/**
+ * @brief Packs sorted records into block data the way convert-blocked fills blocks
+ * @param recordBuffer Buffer set to the encoding under test
+ * @param records Sorted records
+ * @param blockSize Bytes per block
+ * @return The data of each block
+ */
+std::vector<std::vector<char>> packBlocks(RecordBuffer& recordBuffer, const std::vector<ZipCodeRecord>& records,
+                                          uint32_t blockSize)
+{
+    std::vector<std::vector<char>> blocks;
+    std::vector<ZipCodeRecord> current;
+    BlockOccupancy occupancy(recordBuffer);
+    for (const auto& record : records)
+    {
+        uint32_t recordSize = occupancy.measure(record);
+        if (occupancy.getUsedSize() + occupancy.getAddedSize(record, recordSize) + 4 * (current.size() + 1) > blockSize)
+        {
+            blocks.push_back(std::vector<char>());
+            recordBuffer.packBlock(current, blocks.back(), blockSize);
+            current.clear();
+            occupancy.clear();
+        }
+        occupancy.insert(current.size(), record, recordSize);
+        current.push_back(record);
+    }
+    if (!current.empty())
+    {
+        blocks.push_back(std::vector<char>());
+        recordBuffer.packBlock(current, blocks.back(), blockSize);
+    }
+
+    // Blocks on disk are padded to size, the decoder has to stop at the padding
+    for (auto& block : blocks)
+        block.resize(blockSize - METADATA_SIZE, '\xFF');
+    return blocks;
+}
+
+/**
+ * @brief Checks that every record comes back out of the blocks as it went in
+ * @details The text encoding keeps six decimals of each coordinate, so coordinates are
+ *          compared to that precision; the binary encodings keep them exactly.
+ */
+bool roundTrips(RecordBuffer& recordBuffer, const std::vector<std::vector<char>>& blocks,
+                const std::vector<ZipCodeRecord>& records, double tolerance)
+{
+    size_t next = 0;
+    std::vector<ZipCodeRecord> unpacked;
+    for (const auto& block : blocks)
+    {
+        recordBuffer.unpackBlock(block, unpacked);
+        for (const auto& record : unpacked)
+        {
+            if (next >= records.size())
+                return false;
+            const ZipCodeRecord& expected = records[next++];
+            if (record.getZipCode() != expected.getZipCode() ||
+                record.getLocationName() != expected.getLocationName() ||
+                std::strcmp(record.getState(), expected.getState()) != 0 ||
+                record.getCounty() != expected.getCounty() ||
+                std::abs(record.getLatitude() - expected.getLatitude()) > tolerance ||
+                std::abs(record.getLongitude() - expected.getLongitude()) > tolerance)
+                return false;
+        }
+    }
+    return next == records.size();
+}
+
+/**
+ * @brief Times unpacking every block and finding single records in one encoding
+ */
+void benchmarkEncoding(const std::string& label, RecordEncoding encoding, const std::vector<ZipCodeRecord>& records,
+                       uint32_t blockSize, int passes, CoordinateFormat coordinates = CoordinateFormat::Degrees)
+{
+    RecordBuffer recordBuffer;
+    recordBuffer.setEncoding(encoding);
+    recordBuffer.setCoordinateFormat(coordinates);
+    std::vector<std::vector<char>> blocks = packBlocks(recordBuffer, records, blockSize);
+    double tolerance = encoding == RecordEncoding::Text ? 1e-6 : 0.0;
+    std::cout << label << ": " << blocks.size() << " blocks of " << blockSize << " bytes, "
+              << std::fixed << std::setprecision(1) << static_cast<double>(records.size()) / blocks.size() << " records per block, round trip "
+              << (roundTrips(recordBuffer, blocks, records, tolerance) ? "ok" : "FAILED") << std::endl;
+
+    // Full scan, every record decoded
+    std::vector<ZipCodeRecord> unpacked;
+    uint64_t decoded = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& block : blocks)
+        {
+            recordBuffer.unpackBlock(block, unpacked);
+            decoded += unpacked.size();
+        }
+    }
+    reportThroughput("  unpack " + label, std::chrono::duration<double>(BenchClock::now() - start).count(), decoded, "record");
+
+    // Full scan that only needs zip and coordinates, records viewed in place
+    RecordView view;
+    double checksum = 0.0;
+    uint64_t viewed = 0;
+    uint64_t allocationsBefore = allocations;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& block : blocks)
+        {
+            BlockRecordIterator views(block, encoding, coordinates);
+            while (views.next(view))
+            {
+                checksum += view.getZipCode() + view.getLatitude() - view.getLongitude();
+                ++viewed;
+            }
+        }
+    }
+    reportThroughput("  view " + label, std::chrono::duration<double>(BenchClock::now() - start).count(), viewed, "record");
+    std::cout << "  " << allocations - allocationsBefore << " allocations while viewing (checksum "
+              << std::setprecision(1) << checksum << ")" << std::endl;
+
+    // Point lookup, one record out of its block, blocks in random order
+    std::vector<std::pair<size_t, uint32_t>> lookups;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        recordBuffer.unpackBlock(blocks[i], unpacked);
+        for (const auto& record : unpacked)
+            lookups.push_back(std::make_pair(i, record.getZipCode()));
+    }
+    std::mt19937 random(42);
+    std::shuffle(lookups.begin(), lookups.end(), random);
+
+    uint64_t found = 0;
+    ZipCodeRecord record;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& lookup : lookups)
+            found += recordBuffer.findRecord(blocks[lookup.first], lookup.second, record) ? 1 : 0;
+    }
+    reportThroughput("  find " + label, std::chrono::duration<double>(BenchClock::now() - start).count(),
+                     lookups.size() * static_cast<uint64_t>(passes), "lookup");
+    if (found != lookups.size() * static_cast<uint64_t>(passes))
+        std::cout << "  " << lookups.size() * passes - found << " lookups missed" << std::endl;
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    uint32_t blockSize = argc > 2 ? std::atoi(argv[2]) : DEFAULT_BLOCK_SIZE;
+    int passes = argc > 3 ? std::atoi(argv[3]) : DEFAULT_PASSES;
+    if (blockSize <= METADATA_SIZE) blockSize = DEFAULT_BLOCK_SIZE;
+    if (passes <= 0) passes = DEFAULT_PASSES;
+
+    CSVBuffer csvBuffer;
+    if (!csvBuffer.openFile(filePath))
+    {
+        std::cerr << "Failed to open " << filePath << std::endl;
+        return 1;
+    }
+    std::vector<ZipCodeRecord> records;
+    ZipCodeRecord record;
+    while (csvBuffer.getNextRecord(record))
+        records.push_back(record);
+    csvBuffer.closeFile();
+    std::sort(records.begin(), records.end(), [](const ZipCodeRecord& a, const ZipCodeRecord& b)
+              {
+                  return a.getZipCode() < b.getZipCode();
+              });
+
+    std::cout << "=== Record Encoding Benchmark: " << filePath << ", " << records.size() << " records, "
+              << passes << " passes ===\n" << std::endl;
+    benchmarkEncoding("text", RecordEncoding::Text, records, blockSize, passes);
+    benchmarkEncoding("binary", RecordEncoding::Binary, records, blockSize, passes);
+    benchmarkEncoding("slotted", RecordEncoding::Slotted, records, blockSize, passes);
+    benchmarkEncoding("slotted delta", RecordEncoding::SlottedDelta, records, blockSize, passes);
+    benchmarkEncoding("dictionary", RecordEncoding::Dictionary, records, blockSize, passes);
+    benchmarkEncoding("binary micro", RecordEncoding::Binary, records, blockSize, passes, CoordinateFormat::MicroDegrees);
+    benchmarkEncoding("slotted micro", RecordEncoding::Slotted, records, blockSize, passes, CoordinateFormat::MicroDegrees);
+    benchmarkEncoding("slotted delta micro", RecordEncoding::SlottedDelta, records, blockSize, passes,
+                      CoordinateFormat::MicroDegrees);
+    benchmarkEncoding("dictionary micro", RecordEncoding::Dictionary, records, blockSize, passes,
+                      CoordinateFormat::MicroDegrees);
+    return 0;
+}
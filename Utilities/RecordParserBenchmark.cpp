@@ -0,0 +1,224 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#include "../src/CSVBuffer.h"
+#include "../src/RecordParser.h"
+#include "../src/RecordView.h"
+#include "../src/ZipCodeRecord.h"
+#define BENCHMARK_COUNT_ALLOCATIONS
+#include "BenchmarkHelpers.h"
+#include "TestHelpers.h"
+
+// Usage: RecordParserBenchmark [file.csv] [passes]
+const std::string DEFAULT_FILE_PATH = "data/PT2_Randomized.csv";
+const int DEFAULT_PASSES = 20;
+
+/**
+ * @brief Prints one benchmark result line with its allocations per record
+ */
+void reportAllocations(const std::string& label, double seconds, uint64_t records, uint64_t allocated)
+{
+    printThroughput(label, seconds, records, "record");
+    std::cout << std::setw(10) << std::setprecision(2) << (records ? static_cast<double>(allocated) / records : 0.0)
+              << " allocs/record" << std::endl;
+}
+
+/**
+ * @brief The parser this replaced: getline into strings, trim, then validate and convert through exceptions
+ */
+bool legacyParse(const std::string& line, ZipCodeRecord& record)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ','))
+    {
+        field.erase(field.begin(), std::find_if(field.begin(), field.end(), [](unsigned char ch) { return !std::isspace(ch); }));
+        field.erase(std::find_if(field.rbegin(), field.rend(), [](unsigned char ch) { return !std::isspace(ch); }).base(), field.end());
+        fields.push_back(field);
+    }
+    if (fields.size() != 6 || fields[0].empty() || fields[4].empty() || fields[5].empty() || fields[2].size() != 2)
+        return false;
+    try
+    {
+        long zip = std::stol(fields[0]);
+        std::stod(fields[4]);
+        std::stod(fields[5]);
+        if (zip < 0 || zip > 4294967295)
+            return false;
+        record = ZipCodeRecord(static_cast<uint32_t>(std::stoul(fields[0])), std::stod(fields[4]), std::stod(fields[5]),
+                               fields[1], fields[2], fields[3]);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the data lines of a CSV file, header rows skipped the way CSVBuffer skips them
+ */
+std::vector<std::string> readLines(const std::string& filePath)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(filePath);
+    std::string line;
+    bool inData = false;
+    while (std::getline(file, line))
+    {
+        inData = inData || (!line.empty() && std::isdigit(static_cast<unsigned char>(line[0])));
+        if (inData && !line.empty())
+            lines.push_back(line);
+    }
+    return lines;
+}
+
+/**
+ * @brief Checks the new parser against the old one on every line, and its errors on bad lines
+ */
+void checkParser(const std::vector<std::string>& lines)
+{
+    std::cout << "--- Checks (" << (RecordParser::isVectorized() ? "SSE2" : "memchr") << " comma scan) ---\n";
+    size_t matching = 0;
+    for (const auto& line : lines)
+    {
+        ZipCodeRecord expected;
+        ZipCodeRecord parsed;
+        bool oldParsed = legacyParse(line, expected);
+        bool newParsed = RecordParser::parse(line.data(), line.size(), parsed) == RecordParser::Error::None;
+        if (oldParsed == newParsed && (!oldParsed ||
+            (parsed.getZipCode() == expected.getZipCode() && parsed.getLatitude() == expected.getLatitude() &&
+             parsed.getLongitude() == expected.getLongitude() && parsed.getLocationName() == expected.getLocationName() &&
+             std::strcmp(parsed.getState(), expected.getState()) == 0 && parsed.getCounty() == expected.getCounty())))
+            ++matching;
+    }
+    check("same records as the old parser on all " + std::to_string(lines.size()) + " lines", matching == lines.size());
+
+    double value = 0.0;
+    const char* numbers[] = {"44.977753", "-93.265011", "0.1", "-155.7258", "+7.25", ".5", "1e-3", "123456789012345678901.5"};
+    bool allExact = true;
+    for (const char* text : numbers)
+    {
+        allExact = RecordParser::parseDouble(FieldView(text, std::strlen(text)), value) &&
+                   value == std::strtod(text, nullptr) && allExact;
+    }
+    check("numbers round like strtod", allExact);
+
+    struct BadLine
+    {
+        const char* text;
+        RecordParser::Error error;
+    };
+    const BadLine badLines[] =
+    {
+        {"55455,Minneapolis,MN,Hennepin,44.97", RecordParser::Error::FieldCount},
+        {"55455,Minneapolis,MN,Hennepin,44.97,-93.26,extra", RecordParser::Error::FieldCount},
+        {"55455,Minneapolis,MN,Hennepin,44.97,-93.26,,", RecordParser::Error::FieldCount},
+        {"55455,Minneapolis,MN,Hennepin,44.97,,", RecordParser::Error::Longitude},
+        {"5545x,Minneapolis,MN,Hennepin,44.97,-93.26", RecordParser::Error::ZipCode},
+        {"99999999999,Minneapolis,MN,Hennepin,44.97,-93.26", RecordParser::Error::ZipCode},
+        {"55455,Minneapolis,MN,Hennepin,north,-93.26", RecordParser::Error::Latitude},
+        {"55455,Minneapolis,MN,Hennepin,44.97,-93.2.6", RecordParser::Error::Longitude},
+        {"55455,Minneapolis,Minnesota,Hennepin,44.97,-93.26", RecordParser::Error::State}
+    };
+    bool allReported = true;
+    ZipCodeRecord record;
+    for (const auto& bad : badLines)
+        allReported = RecordParser::parse(bad.text, std::strlen(bad.text), record) == bad.error && allReported;
+    check("bad lines report their error", allReported);
+
+    const char* padded = " 55455 , Minneapolis ,MN, Hennepin\t,44.97,-93.26\r";
+    RecordView view;
+    check("fields trimmed in place", RecordParser::parse(padded, std::strlen(padded), view) == RecordParser::Error::None &&
+          view.getZipCode() == 55455 && view.getLocationName() == "Minneapolis" && view.getCounty() == "Hennepin" &&
+          view.getLongitude() == -93.26);
+    std::cout << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    int passes = argc > 2 ? std::atoi(argv[2]) : DEFAULT_PASSES;
+    if (passes <= 0) passes = DEFAULT_PASSES;
+
+    std::vector<std::string> lines = readLines(filePath);
+    if (lines.empty())
+    {
+        std::cerr << "No records in " << filePath << std::endl;
+        return 1;
+    }
+    std::cout << "=== Record Parser Benchmark: " << filePath << ", " << lines.size() << " records, "
+              << passes << " passes ===\n\n";
+    checkParser(lines);
+
+    std::cout << "--- Throughput ---\n";
+    uint64_t records = lines.size() * static_cast<uint64_t>(passes);
+    uint64_t zipSum = 0;
+
+    // Old path: stringstream split, string fields, stol/stod twice under try/catch
+    ZipCodeRecord record;
+    uint64_t allocationsBefore = allocations;
+    BenchClock::time_point start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& line : lines)
+            zipSum += legacyParse(line, record) ? record.getZipCode() : 0;
+    }
+    reportAllocations("stringstream + stod", std::chrono::duration<double>(BenchClock::now() - start).count(), records,
+                      allocations - allocationsBefore);
+
+    // New path into an owning record, the strings are the only allocations left
+    allocationsBefore = allocations;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& line : lines)
+            zipSum += RecordParser::parse(line.data(), line.size(), record) == RecordParser::Error::None ? record.getZipCode() : 0;
+    }
+    reportAllocations("RecordParser to record", std::chrono::duration<double>(BenchClock::now() - start).count(), records,
+                      allocations - allocationsBefore);
+
+    // New path into a view, nothing copied
+    RecordView view;
+    allocationsBefore = allocations;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& line : lines)
+            zipSum += RecordParser::parse(line.data(), line.size(), view) == RecordParser::Error::None ? view.getZipCode() : 0;
+    }
+    reportAllocations("RecordParser to view", std::chrono::duration<double>(BenchClock::now() - start).count(), records,
+                      allocations - allocationsBefore);
+
+    // Whole file through CSVBuffer, reading included
+    uint64_t read = 0;
+    allocationsBefore = allocations;
+    start = BenchClock::now();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        CSVBuffer csvBuffer;
+        csvBuffer.openFile(filePath);
+        while (csvBuffer.getNextRecord(record))
+        {
+            zipSum += record.getZipCode();
+            ++read;
+        }
+        if (csvBuffer.hasError())
+            std::cout << "  " << csvBuffer.getLastError() << std::endl;
+    }
+    reportAllocations("CSVBuffer file read", std::chrono::duration<double>(BenchClock::now() - start).count(), read,
+                      allocations - allocationsBefore);
+    std::cout << "  (zip checksum " << zipSum << ")\n\n";
+
+    return report("parser");
+}
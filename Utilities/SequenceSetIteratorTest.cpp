@@ -0,0 +1,159 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/SequenceSetIterator.h"
+#include "TestHelpers.h"
+
+// Usage: SequenceSetIteratorTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/iterator_test.zcb";
+const uint32_t BLOCK_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const uint32_t BLOCK_COUNT = 80; // RBN 0 is left out of the chain, as the header block is in real files
+
+/**
+ * @brief Builds a chain block whose record names its RBN and version
+ */
+ActiveBlock makeBlock(uint32_t rbn, uint32_t prec, uint32_t succ, int version)
+{
+    ActiveBlock block;
+    block.recordCount = 1;
+    block.precedingRBN = prec;
+    block.succeedingRBN = succ;
+    std::string record = std::to_string(70000 + rbn) + ",Chain v" + std::to_string(version) + ",IA,Linn,42.0,-91.6";
+    uint32_t length = record.length();
+    block.data.insert(block.data.end(), reinterpret_cast<char*>(&length), reinterpret_cast<char*>(&length) + sizeof(length));
+    block.data.insert(block.data.end(), record.begin(), record.end());
+    return block;
+}
+
+/**
+ * @brief Writes the chain in the given logical order
+ */
+void writeChain(BlockBuffer& buffer, const std::vector<uint32_t>& order)
+{
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        uint32_t prec = i == 0 ? 0 : order[i - 1];
+        uint32_t succ = i + 1 == order.size() ? 0 : order[i + 1];
+        buffer.writeActiveBlockAtRBN(order[i], BLOCK_SIZE, HEADER_SIZE, makeBlock(order[i], prec, succ, 1));
+    }
+}
+
+/**
+ * @brief Walks the chain one loadActiveBlockAtRBN at a time
+ * @param rbns [OUT] RBNs in chain order
+ * @param blocks [OUT] Block data in chain order
+ */
+void plainWalk(BlockBuffer& buffer, uint32_t head, std::vector<uint32_t>& rbns, std::vector<std::vector<char>>& blocks)
+{
+    rbns.clear();
+    blocks.clear();
+    for (uint32_t rbn = head; rbn != 0 && rbns.size() <= BLOCK_COUNT; )
+    {
+        ActiveBlock block = buffer.loadActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE);
+        rbns.push_back(rbn);
+        blocks.push_back(block.data);
+        rbn = block.succeedingRBN;
+    }
+}
+
+/**
+ * @brief Walks the chain with the readahead iterator and compares it to the plain walk
+ * @return True if the RBNs and block data came back in the same order
+ */
+bool iteratorMatches(BlockBuffer& buffer, uint32_t head, uint32_t readAhead, const std::vector<uint32_t>& rbns,
+                     const std::vector<std::vector<char>>& blocks, SequenceScanStats& stats)
+{
+    SequenceSetIterator it(buffer, head, BLOCK_SIZE, HEADER_SIZE, readAhead);
+    ActiveBlock block;
+    size_t visited = 0;
+    while (it.next(block))
+    {
+        if (visited >= rbns.size() || it.getCurrentRBN() != rbns[visited] || block.data != blocks[visited])
+            return false;
+        ++visited;
+    }
+    stats = it.getStats();
+    return visited == rbns.size();
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Sequence Set Iterator Test: " << filePath << " ===\n\n";
+
+    std::remove(filePath.c_str());
+    {
+        std::ofstream create(filePath, std::ios::binary);
+        std::string empty(HEADER_SIZE + (BLOCK_COUNT + 1) * BLOCK_SIZE, '\0');
+        create.write(empty.data(), empty.size());
+    }
+
+    // A converted prefix in physical order, then blocks scattered by splits
+    std::vector<uint32_t> order;
+    for (uint32_t rbn = 1; rbn <= BLOCK_COUNT / 2; ++rbn)
+        order.push_back(rbn);
+    std::vector<uint32_t> scattered;
+    for (uint32_t rbn = BLOCK_COUNT / 2 + 1; rbn <= BLOCK_COUNT; ++rbn)
+        scattered.push_back(rbn);
+    std::mt19937 random(23);
+    std::shuffle(scattered.begin(), scattered.end(), random);
+    order.insert(order.end(), scattered.begin(), scattered.end());
+
+    BlockCache cache(0); // Every block comes from the file
+    BlockBuffer buffer;
+    buffer.attachCache(&cache);
+    check("scratch file opens", buffer.openFile(filePath, HEADER_SIZE));
+    writeChain(buffer, order);
+    buffer.flush();
+
+    std::vector<uint32_t> rbns;
+    std::vector<std::vector<char>> blocks;
+    plainWalk(buffer, order.front(), rbns, blocks);
+    check("the plain walk follows the written chain", rbns == order);
+
+    // Test 1: every window size gives the plain walk's order and bytes
+    std::cout << "\n--- Test 1: Same order as a plain walk ---\n";
+    for (uint32_t readAhead : {1u, 4u, 16u, 128u})
+    {
+        SequenceScanStats stats;
+        check("readahead " + std::to_string(readAhead) + " visits the chain in order",
+              iteratorMatches(buffer, order.front(), readAhead, rbns, blocks, stats));
+        if (readAhead == 16)
+        {
+            check("the physical prefix is served by readahead", stats.prefetchHits > 0 &&
+                  stats.physicalReads < stats.blocksVisited);
+            check("the scattered tail shows in the order ratio", stats.inPhysicalOrder + 1 >= BLOCK_COUNT / 2 &&
+                  stats.inPhysicalOrder < BLOCK_COUNT - 1);
+        }
+    }
+
+    // Test 2: blocks waiting in cache frames are returned current, not as the window read them
+    std::cout << "\n--- Test 2: Unflushed blocks ---\n";
+    BlockCache frames(BLOCK_COUNT);
+    buffer.attachCache(&frames);
+    uint32_t changed = order[BLOCK_COUNT / 4];
+    ActiveBlock current = buffer.loadActiveBlockAtRBN(changed, BLOCK_SIZE, HEADER_SIZE);
+    buffer.writeActiveBlockAtRBN(changed, BLOCK_SIZE, HEADER_SIZE,
+                                 makeBlock(changed, current.precedingRBN, current.succeedingRBN, 2));
+    check("the new version waits in its frame", frames.getDirtyRBNs() == std::vector<uint32_t>({changed}));
+    plainWalk(buffer, order.front(), rbns, blocks);
+    SequenceScanStats stats;
+    check("the iterator sees the unflushed version", iteratorMatches(buffer, order.front(), 16, rbns, blocks, stats));
+
+    buffer.closeFile();
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("iterator");
+}
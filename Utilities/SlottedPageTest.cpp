@@ -0,0 +1,236 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+
+#include "../src/Block.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: SlottedPageTest
+const uint32_t BLOCK_SIZE = 512;
+const size_t METADATA_SIZE = 10; // count, preceding and succeeding RBN
+
+/**
+ * @brief Makes a record with names whose length varies with the zip
+ */
+ZipCodeRecord makeRecord(uint32_t zip)
+{
+    return ZipCodeRecord(zip, 40.0 + (zip % 100) / 10.0, -90.0 - (zip % 70) / 10.0,
+                         "Town" + std::string(zip % 13, 'x'), "IA", "County" + std::string(zip % 7, 'y'));
+}
+
+/**
+ * @brief Checks that unpacked records match the expected zips in order
+ */
+bool sameZips(const std::vector<ZipCodeRecord>& records, const std::vector<uint32_t>& zips)
+{
+    if (records.size() != zips.size())
+        return false;
+    for (size_t i = 0; i < zips.size(); ++i)
+    {
+        if (records[i].getZipCode() != zips[i] || records[i].getLocationName() != makeRecord(zips[i]).getLocationName())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that the block reads like one straight from the file: used bytes, then 0xFF padding
+ */
+bool paddedAfter(const std::vector<char>& data, size_t used)
+{
+    for (size_t i = used; i < data.size(); ++i)
+    {
+        if (data[i] != '\xFF')
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    std::cout << "=== Slotted Page Test ===\n\n";
+    RecordBuffer recordBuffer;
+    recordBuffer.setEncoding(RecordEncoding::Slotted);
+
+    // Test 1: pack, unpack and find
+    std::cout << "--- Test 1: Pack and find ---\n";
+    std::vector<ZipCodeRecord> records;
+    std::vector<uint32_t> zips;
+    for (uint32_t zip = 50010; zip < 50090; zip += 11)
+    {
+        records.push_back(makeRecord(zip));
+        zips.push_back(zip);
+    }
+    std::vector<char> data;
+    check("records pack", recordBuffer.packBlock(records, data, BLOCK_SIZE));
+    size_t encoded = 2;
+    for (const auto& record : records)
+        encoded += recordBuffer.getEncodedSize(record);
+    check("encoded sizes add up to the packed size", encoded == data.size());
+
+    data.resize(BLOCK_SIZE - METADATA_SIZE, '\xFF');
+    std::vector<ZipCodeRecord> unpacked;
+    check("records unpack in key order", recordBuffer.unpackBlock(data, unpacked) && sameZips(unpacked, zips));
+
+    bool allFound = true;
+    ZipCodeRecord record;
+    for (uint32_t zip : zips)
+        allFound = recordBuffer.findRecord(data, zip, record) && record.getZipCode() == zip && allFound;
+    check("every zip found by the directory", allFound);
+    check("missing zips not found", !recordBuffer.findRecord(data, 50012, record) &&
+          !recordBuffer.findRecord(data, 1, record) && !recordBuffer.findRecord(data, 99999, record));
+
+    ActiveBlock block;
+    block.data = data;
+    check("padding detection sees the used bytes", block.getTotalSize() == METADATA_SIZE + encoded);
+    std::cout << "\n";
+
+    // Test 2: in place inserts, in random order, until the block is full
+    std::cout << "--- Test 2: Insert in place ---\n";
+    std::vector<uint32_t> pending;
+    for (uint32_t zip = 60000; zip < 60200; zip += 3)
+        pending.push_back(zip);
+    std::mt19937 random(7);
+    std::shuffle(pending.begin(), pending.end(), random);
+
+    std::vector<char> slotted(BLOCK_SIZE - METADATA_SIZE, '\xFF'); // An empty block as read from the file
+    std::vector<uint32_t> inserted;
+    bool inOrder = true;
+    for (uint32_t zip : pending)
+    {
+        if (!recordBuffer.insertRecord(slotted, makeRecord(zip), BLOCK_SIZE))
+            break;
+        inserted.push_back(zip);
+        std::sort(inserted.begin(), inserted.end());
+        inOrder = recordBuffer.unpackBlock(slotted, unpacked) && sameZips(unpacked, inserted) && inOrder;
+    }
+    std::cout << "  " << inserted.size() << " records fit\n";
+    check("block stays sorted after every insert", inOrder && inserted.size() > 1);
+    check("block size unchanged", slotted.size() == BLOCK_SIZE - METADATA_SIZE);
+
+    size_t used = 2;
+    for (uint32_t zip : inserted)
+        used += recordBuffer.getEncodedSize(makeRecord(zip));
+    check("insert refused once full", used + recordBuffer.getEncodedSize(makeRecord(60001)) + METADATA_SIZE > BLOCK_SIZE);
+    check("padding kept after the used bytes", paddedAfter(slotted, used));
+
+    std::vector<char> repacked;
+    std::vector<ZipCodeRecord> sortedRecords;
+    for (uint32_t zip : inserted)
+        sortedRecords.push_back(makeRecord(zip));
+    recordBuffer.packBlock(sortedRecords, repacked, BLOCK_SIZE);
+    check("same used size as a full repack", repacked.size() == used);
+
+    recordBuffer.insertRecord(slotted, makeRecord(inserted[0]), BLOCK_SIZE + 100);
+    check("equal keys insert after the first", recordBuffer.unpackBlock(slotted, unpacked) &&
+          unpacked.size() == inserted.size() + 1 && unpacked[0].getZipCode() == unpacked[1].getZipCode());
+    recordBuffer.removeRecord(slotted, inserted[0]);
+    std::cout << "\n";
+
+    // Test 3: in place removes, in random order, down to empty
+    std::cout << "--- Test 3: Remove in place ---\n";
+    std::vector<uint32_t> remaining = inserted;
+    std::shuffle(inserted.begin(), inserted.end(), random);
+    bool removedInOrder = true;
+    for (uint32_t zip : inserted)
+    {
+        removedInOrder = recordBuffer.removeRecord(slotted, zip) && removedInOrder;
+        remaining.erase(std::find(remaining.begin(), remaining.end(), zip));
+        removedInOrder = recordBuffer.unpackBlock(slotted, unpacked) && sameZips(unpacked, remaining) && removedInOrder;
+        if (!remaining.empty())
+            removedInOrder = recordBuffer.findRecord(slotted, remaining[remaining.size() / 2], record) && removedInOrder;
+    }
+    check("block stays sorted and searchable after every remove", removedInOrder);
+    check("missing zip not removed", !recordBuffer.removeRecord(slotted, 12345));
+    check("empty block is directory only, then padding", paddedAfter(slotted, 2) && slotted[0] == 0 && slotted[1] == 0);
+    std::cout << "\n";
+
+    // Test 4: Text and Binary records shift in place too, Dictionary leaves edits to a repack
+    std::cout << "--- Test 4: Other encodings ---\n";
+    RecordEncoding sequential[] = {RecordEncoding::Text, RecordEncoding::Binary};
+    for (RecordEncoding encoding : sequential)
+    {
+        std::string name = encoding == RecordEncoding::Text ? "text" : "binary";
+        RecordBuffer sequentialBuffer;
+        sequentialBuffer.setEncoding(encoding);
+        std::vector<char> shifted(BLOCK_SIZE - METADATA_SIZE, '\xFF');
+        std::vector<uint32_t> held;
+        bool sorted = true;
+        for (uint32_t zip : pending)
+        {
+            if (!sequentialBuffer.insertRecord(shifted, makeRecord(zip), BLOCK_SIZE))
+                break;
+            held.insert(std::upper_bound(held.begin(), held.end(), zip), zip);
+            sorted = sequentialBuffer.unpackBlock(shifted, unpacked) && sameZips(unpacked, held) && sorted;
+        }
+        check(name + " blocks stay sorted after every insert", sorted && held.size() > 1);
+
+        std::vector<ZipCodeRecord> heldRecords;
+        for (uint32_t zip : held)
+            heldRecords.push_back(makeRecord(zip));
+        sequentialBuffer.packBlock(heldRecords, repacked, BLOCK_SIZE * 2);
+        check(name + " inserts leave the bytes of a full repack, then padding",
+              std::equal(repacked.begin(), repacked.end(), shifted.begin()) && paddedAfter(shifted, repacked.size()) &&
+              METADATA_SIZE + repacked.size() + sequentialBuffer.getEncodedSize(makeRecord(60001)) > BLOCK_SIZE);
+
+        std::vector<uint32_t> order = held;
+        std::shuffle(order.begin(), order.end(), random);
+        for (uint32_t zip : order)
+        {
+            sorted = sequentialBuffer.removeRecord(shifted, zip) && sorted;
+            held.erase(std::find(held.begin(), held.end(), zip));
+            sorted = sequentialBuffer.unpackBlock(shifted, unpacked) && sameZips(unpacked, held) && sorted;
+        }
+        check(name + " blocks stay sorted after every remove, down to padding", sorted && paddedAfter(shifted, 0));
+        check(name + " missing zip not removed", !sequentialBuffer.removeRecord(shifted, 12345));
+    }
+
+    RecordBuffer dictionaryBuffer;
+    dictionaryBuffer.setEncoding(RecordEncoding::Dictionary);
+    std::vector<char> dictionary;
+    dictionaryBuffer.packBlock(records, dictionary, BLOCK_SIZE);
+    check("dictionary blocks refuse in place insert", !dictionaryBuffer.insertRecord(dictionary, makeRecord(50000), BLOCK_SIZE));
+    check("dictionary blocks refuse in place remove", !dictionaryBuffer.removeRecord(dictionary, zips[0]));
+    std::cout << "\n";
+
+    // Test 5: delta slots keep the same records in less directory, and rebase as the first zip changes
+    std::cout << "--- Test 5: Delta slots ---\n";
+    RecordBuffer deltaBuffer;
+    deltaBuffer.setEncoding(RecordEncoding::SlottedDelta);
+    std::vector<char> delta;
+    check("records pack", deltaBuffer.packBlock(records, delta, BLOCK_SIZE));
+    check("two bytes a record smaller, four more for the base",
+          delta.size() + 2 * records.size() == encoded + 4 &&
+          deltaBuffer.getEncodedSize(records[0]) + 2 == recordBuffer.getEncodedSize(records[0]));
+    delta.resize(BLOCK_SIZE - METADATA_SIZE, '\xFF');
+    allFound = deltaBuffer.unpackBlock(delta, unpacked) && sameZips(unpacked, zips);
+    for (uint32_t zip : zips)
+        allFound = deltaBuffer.findRecord(delta, zip, record) && record.getZipCode() == zip && allFound;
+    check("records unpack and are found", allFound && !deltaBuffer.findRecord(delta, 50012, record));
+
+    std::vector<uint32_t> held = zips;
+    bool rebased = deltaBuffer.insertRecord(delta, makeRecord(50001), BLOCK_SIZE);
+    held.insert(held.begin(), 50001);
+    rebased = deltaBuffer.unpackBlock(delta, unpacked) && sameZips(unpacked, held) && rebased;
+    rebased = deltaBuffer.removeRecord(delta, 50001) && deltaBuffer.removeRecord(delta, zips[0]) && rebased;
+    held.erase(held.begin(), held.begin() + 2);
+    rebased = deltaBuffer.unpackBlock(delta, unpacked) && sameZips(unpacked, held) && rebased;
+    check("inserting below the base and removing the first slot rebase the directory", rebased);
+
+    std::vector<char> spread(BLOCK_SIZE - METADATA_SIZE, '\xFF');
+    uint32_t reach = 30000 + RecordBuffer::MAX_SLOT_KEY_SPAN;
+    check("a zip at the edge of the span fits", deltaBuffer.insertRecord(spread, makeRecord(30000), BLOCK_SIZE) &&
+          deltaBuffer.insertRecord(spread, makeRecord(reach), BLOCK_SIZE) && deltaBuffer.findRecord(spread, reach, record));
+    check("zips past it are refused", !deltaBuffer.insertRecord(spread, makeRecord(reach + 1), BLOCK_SIZE) &&
+          !deltaBuffer.insertRecord(spread, makeRecord(29999), BLOCK_SIZE));
+    std::vector<ZipCodeRecord> wide = {makeRecord(10), makeRecord(10 + RecordBuffer::MAX_SLOT_KEY_SPAN + 1)};
+    check("a block spanning too far does not pack", !deltaBuffer.packBlock(wide, delta, BLOCK_SIZE));
+    std::cout << "\n";
+
+    return report("slotted page");
+}
@@ -0,0 +1,95 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../src/HeaderRecord.h"
+
+/**
+ * @file TestHelpers.h
+ * @brief Pass/fail reporting and a header fixture shared by the standalone test drivers.
+ * @details Each driver is its own program, so the failure count is per driver.
+ */
+
+/**
+ * @brief Gets the number of failed checks so far
+ * @return Reference to the count
+ */
+inline int& failureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+
+/**
+ * @brief Prints one check result and counts failures
+ * @param label What was checked
+ * @param passed Result of the check
+ */
+inline void check(const std::string& label, bool passed)
+{
+    std::cout << "  " << (passed ? "[PASS] " : "[FAIL] ") << label << "\n";
+    if (!passed)
+        failureCount()++;
+}
+
+/**
+ * @brief Prints the summary line of a driver
+ * @param subject What the driver checks, e.g. "checksum"
+ * @return Exit code for main, 0 if every check passed
+ */
+inline int report(const std::string& subject)
+{
+    if (failureCount() == 0)
+        std::cout << "All " << subject << " checks passed.\n";
+    else
+        std::cout << failureCount() << " " << subject << " check(s) failed.\n";
+    return failureCount() == 0 ? 0 : 1;
+}
+
+/**
+ * @brief Builds a blocked file header with the six zip code fields and a stale index
+ * @details Callers set any version specific fields, then the header size.
+ * @param version Header version
+ * @param blockSize Block size, the minimum is a quarter of it
+ * @param indexFile Index file name
+ * @param recordCount Records in the file
+ * @param blockCount Blocks in the file
+ * @param sequenceSetRBN First block of the sequence set, 0 for none
+ * @return The header, header size 0
+ */
+inline HeaderRecord makeTestHeader(uint16_t version, uint32_t blockSize, const std::string& indexFile,
+                                   uint64_t recordCount, uint32_t blockCount, uint32_t sequenceSetRBN)
+{
+    HeaderRecord header;
+    header.setFileStructureType("ZIPC");
+    header.setVersion(version);
+    header.setHeaderSize(0);
+    header.setSizeFormatType(0);
+    header.setBlockSize(blockSize);
+    header.setMinBlockSize(blockSize / 4);
+    header.setIndexFileName(indexFile);
+    header.setIndexFileSchemaInfo("Primary Key: Zipcode");
+    header.setRecordCount(recordCount);
+    header.setBlockCount(blockCount);
+
+    std::vector<FieldDef> fields;
+    fields.push_back({"zipcode", 1});
+    fields.push_back({"location", 3});
+    fields.push_back({"state", 4});
+    fields.push_back({"county", 3});
+    fields.push_back({"latitude", 2});
+    fields.push_back({"longitude", 2});
+    header.setFields(fields);
+    header.setFieldCount(fields.size());
+    header.setPrimaryKeyField(0);
+    header.setAvailableListRBN(0);
+    header.setSequenceSetListRBN(sequenceSetRBN);
+    header.setStaleFlag(1);
+    return header;
+}
+
+#endif // TEST_HELPERS_H
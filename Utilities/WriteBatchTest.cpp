@@ -0,0 +1,222 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+#include "../src/Block.h"
+#include "../src/BlockBuffer.h"
+#include "../src/BlockCache.h"
+#include "../src/BlockCodec.h"
+#include "../src/RecordBuffer.h"
+#include "../src/ZipCodeRecord.h"
+#include "TestHelpers.h"
+
+// Usage: WriteBatchTest [scratch file]
+const std::string DEFAULT_FILE_PATH = "data/write_batch_test.zcb";
+const uint32_t BLOCK_SIZE = 512;
+const size_t HEADER_SIZE = 512;
+const uint16_t MIN_BLOCK_SIZE = BLOCK_SIZE / 4;
+const uint32_t HEAD_RBN = 1; // RBN 0 is left out of the chain, as the header block is in real files
+const int ADDS = 300;
+const int REMOVES = 280;
+
+/**
+ * @brief What one run of the add/remove script did
+ */
+struct ScriptResult
+{
+    int operations = 0; // Adds and removes that succeeded
+    int splits = 0;
+    int merges = 0;
+    int extraSubmissions = 0; // Operations that took more than one write submission
+    std::string image; // The whole file after the last operation
+};
+
+/**
+ * @brief Reads the whole scratch file
+ */
+std::string readFile(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/**
+ * @brief Finds the block a zip code belongs in by walking the chain
+ * @return The first block whose highest key is not below the zip code, else the last block
+ */
+uint32_t findBlockFor(BlockBuffer& buffer, uint32_t zipCode)
+{
+    std::vector<ZipCodeRecord> records;
+    uint32_t rbn = HEAD_RBN;
+    while (true)
+    {
+        ActiveBlock block = buffer.loadActiveBlockAtRBN(rbn, BLOCK_SIZE, HEADER_SIZE);
+        buffer.unpackBlockAPI(block.data, records);
+        if (block.succeedingRBN == 0 || (!records.empty() && records.back().getZipCode() >= zipCode))
+            return rbn;
+        rbn = block.succeedingRBN;
+    }
+}
+
+/**
+ * @brief How the scratch file stores its blocks
+ */
+struct FileFormat
+{
+    RecordEncoding encoding;
+    bool compressed; // LZ frames on a page aligned layout
+    bool checksums; // CRC32C trailers
+};
+
+/**
+ * @brief Builds a one block sequence set, then adds and removes records through the given cache
+ * @param filePath Scratch file, recreated
+ * @param format How blocks are stored
+ * @param frames Cache frames, 0 sends every change through a write batch
+ * @return Counts of the run and the resulting file, slack blanked in compressed files
+ */
+ScriptResult runScript(const std::string& filePath, const FileFormat& format, size_t frames)
+{
+    ScriptResult result;
+    std::remove(filePath.c_str());
+    {
+        std::ofstream create(filePath, std::ios::binary);
+        std::string empty(HEADER_SIZE + (HEAD_RBN + 1) * BLOCK_SIZE, '\0');
+        create.write(empty.data(), empty.size());
+    }
+
+    BlockCache cache(frames);
+    BlockBuffer buffer;
+    buffer.setRecordEncoding(format.encoding);
+    buffer.setChecksums(format.checksums);
+    if (format.compressed)
+    {
+        buffer.setCompression(BlockCodec::Type::LZ);
+        buffer.setLayoutAlignment(BLOCK_SIZE);
+    }
+    buffer.attachCache(&cache);
+    if (!buffer.openFile(filePath, HEADER_SIZE))
+        return result;
+
+    RecordBuffer recordBuffer;
+    recordBuffer.setEncoding(format.encoding);
+    ActiveBlock head;
+    head.recordCount = 1;
+    head.precedingRBN = 0;
+    head.succeedingRBN = 0;
+    std::vector<ZipCodeRecord> seed = { ZipCodeRecord(50000, 41.6, -93.6, "Seed", "IA", "Polk") };
+    recordBuffer.packBlock(seed, head.data, buffer.getPayloadSize(BLOCK_SIZE));
+    buffer.writeActiveBlockAtRBN(HEAD_RBN, BLOCK_SIZE, HEADER_SIZE, head);
+
+    uint32_t availListRBN = 0;
+    uint32_t blockCount = HEAD_RBN + 1;
+    std::vector<uint32_t> added;
+    std::mt19937 random(41);
+    for (int i = 0; i < ADDS + REMOVES; ++i)
+    {
+        const bool adding = i < ADDS;
+        uint32_t zipCode;
+        if (adding)
+            zipCode = 1000 + random() % 98000;
+        else
+        {
+            size_t pick = random() % added.size();
+            zipCode = added[pick];
+            added.erase(added.begin() + pick);
+        }
+        const uint32_t rbn = findBlockFor(buffer, zipCode);
+
+        buffer.resetSplit();
+        buffer.resetMerge();
+        const uint64_t before = buffer.getWriteSubmissionCount();
+        bool done;
+        if (adding)
+        {
+            ZipCodeRecord record(zipCode, 40.0 + zipCode % 9, -90.0 - zipCode % 13, "Town" + std::to_string(i),
+                                 "IA", "County" + std::to_string(zipCode % 17));
+            done = buffer.addRecord(rbn, BLOCK_SIZE, availListRBN, record, HEADER_SIZE, blockCount);
+            if (done)
+                added.push_back(zipCode);
+        }
+        else
+            done = buffer.removeRecordAtRBN(rbn, MIN_BLOCK_SIZE, availListRBN, zipCode, BLOCK_SIZE, HEADER_SIZE);
+
+        if (!done)
+            continue;
+        result.operations++;
+        result.splits += buffer.getSplitOccurred() ? 1 : 0;
+        result.merges += buffer.getMergeOccurred() ? 1 : 0;
+        if (buffer.getWriteSubmissionCount() - before > 1)
+            result.extraSubmissions++;
+    }
+
+    buffer.flush();
+    buffer.closeFile();
+    result.image = readFile(filePath);
+
+    // Slack past a frame holds whatever longer version was written last, it is never read
+    for (size_t offset = HEADER_SIZE; format.compressed && offset + BLOCK_SIZE <= result.image.size(); offset += BLOCK_SIZE)
+    {
+        size_t stored = BlockCodec::getStoredSize(&result.image[offset], BLOCK_SIZE);
+        std::fill(result.image.begin() + offset + stored, result.image.begin() + offset + BLOCK_SIZE, '\0');
+    }
+    return result;
+}
+
+/**
+ * @brief Runs the script without cache frames and again through a single frame, then compares
+ * @details With no frames every split and merge goes out as one write batch, with one frame each
+ *          block reaches the file on its own as the frame is evicted.
+ */
+void checkFormat(const std::string& filePath, const FileFormat& format)
+{
+    ScriptResult batched = runScript(filePath, format, 0);
+    ScriptResult unbatched = runScript(filePath, format, 1);
+
+    check("every operation ran", batched.operations == ADDS + REMOVES);
+    check("the script splits and merges blocks", batched.splits > 0 && batched.merges > 0);
+    std::cout << "  (" << batched.splits << " splits, " << batched.merges << " merges)\n";
+    check("each add and remove is one write submission", batched.extraSubmissions == 0);
+    check("both runs make the same changes", batched.operations == unbatched.operations &&
+          batched.splits == unbatched.splits && batched.merges == unbatched.merges);
+    check("the file is byte-identical to the unbatched one", !batched.image.empty() &&
+          batched.image == unbatched.image);
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+    std::cout << "=== Write Batch Test: " << filePath << " ===\n";
+
+    // Test 1: blocks rewritten in place
+    std::cout << "\n--- Test 1: Text blocks ---\n";
+    checkFormat(filePath, { RecordEncoding::Text, false, false });
+
+    // Test 2: blocks with a slot directory
+    std::cout << "\n--- Test 2: Slotted blocks ---\n";
+    checkFormat(filePath, { RecordEncoding::Slotted, false, false });
+
+    // Test 3: blocks repacked on every change
+    std::cout << "\n--- Test 3: Dictionary blocks ---\n";
+    checkFormat(filePath, { RecordEncoding::Dictionary, false, false });
+
+    // Test 4: link patches held in their stored form
+    std::cout << "\n--- Test 4: Compressed blocks ---\n";
+    checkFormat(filePath, { RecordEncoding::Text, true, false });
+
+    // Test 5: link patches restamp the whole block
+    std::cout << "\n--- Test 5: Checksummed blocks ---\n";
+    checkFormat(filePath, { RecordEncoding::Text, false, true });
+    std::remove(filePath.c_str());
+
+    std::cout << "\n";
+    return report("write batch");
+}
@@ -12,6 +12,7 @@
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <iomanip>
 #include <algorithm>
 
 void printUsage(const char* programName)
@@ -20,9 +21,18 @@ void printUsage(const char* programName)
               << "  Convert CSV to ZCD:\n"
               << "    " << programName << " convert <input.csv> <output.zcd>\n\n"
               << "  Convert CSV to Blocked Sequence Set:\n"
-              << "    " << programName << " convert-blocked <input.csv> <output.zcb> [blockSize] [minBlockSize]\n"
+              << "    " << programName << " convert-blocked <input.csv> <output.zcb> [blockSize] [minBlockSize] [alignment] [options...]\n"
               << "    blockSize: block size in bytes (default: 1024)\n"
-              << "    minBlockSize: minimum block size (default: 256)\n\n"
+              << "    minBlockSize: minimum block size (default: 256)\n"
+              << "    alignment: pad the header to this page/sector size and require a power of two\n"
+              << "               blockSize, 'page' for " << HeaderRecord::PAGE_ALIGNMENT << ", 0 for the packed layout (default)\n"
+              << "    options: 'crc32c' to end every block and index page in a CRC32C trailer (default: none)\n"
+              << "             'binary' to store records in the binary encoding (default: CSV text)\n"
+              << "             'slotted' for binary records behind a sorted slot directory\n"
+              << "             'slotted-delta' for a slot directory keyed by 16-bit offsets from each block's first zip\n"
+              << "             'dictionary' for binary records sharing a per-block state and county dictionary\n"
+              << "             'lz' to store every sequence set block LZ compressed (default: uncompressed)\n"
+              << "             'microdegrees' to store binary record coordinates as int32 micro-degrees (default: doubles)\n\n"
               << "  Read ZCD file:\n"
               << "    " << programName << " read <input.zcd> [count]\n"
               << "    count: number of records to display (default: 5)\n\n"
@@ -32,12 +42,23 @@ void printUsage(const char* programName)
               << "    " << programName << " verify <input.csv> <input.zcd>\n\n"
               << "  Search using index (no full scan):\n"
               << "    " << programName << " zcd-search <input.zcd> <zipcode_data.idx> <zip> [<zip> ...]\n\n"
+              << "  Convert CSV to Blocked Sequence Set with a B+ Tree index:\n"
+              << "    " << programName << " convert-b+tree <input.csv> <bplus_tree.idx> <output.zcb> [compact-keys]\n"
+              << "    compact-keys: store node keys as offsets from the node's smallest key (default: full uint32 keys)\n\n"
               << "  Create B+ Tree index from Block Index:\n"
             << "    " << programName << " bplus-from-block-index <block_index.idx> <bplus_tree.idx> <input.zcb>\n\n"
               << "Examples:\n"
               << "  " << programName << " convert PT2_CSV.csv output.zcd\n"
               << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb\n"
               << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 2048 512\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 4096 1024 page\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 4096 1024 page crc32c\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 1024 256 0 binary\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 1024 256 0 slotted\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 1024 256 0 slotted-delta\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 1024 256 0 dictionary\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 4096 1024 page binary lz\n"
+              << "  " << programName << " convert-blocked PT2_CSV.csv output.zcb 1024 256 0 slotted microdegrees\n"
               << "  " << programName << " read output.zcd 10\n"
               << "  " << programName << " header output.zcd\n"
               << "  " << programName << " verify PT2_CSV.csv output.zcd\n"
@@ -90,8 +111,7 @@ bool convertCSVtoZCD(const std::string& inFile, const std::string& outFile)
     
     out.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
     
-    size_t recordCountOffset = 4 + 2 + 4 + 1 + 4 + 1 + 2 + 2 +
-                                header.getIndexFileName().length() + header.getIndexFileSchemaInfo().length();
+    size_t recordCountOffset = header.getRecordCountOffset();
     
     if (!csvBuffer.openFile(inFile)) 
     {
@@ -143,7 +163,7 @@ bool convertCSVtoZCD(const std::string& inFile, const std::string& outFile)
         
         std::fstream zcdFile(outFile, std::ios::binary | std::ios::in | std::ios::out);
         uint8_t validFlag = 1;
-        size_t flagOffset = header.getHeaderSize() - 1;
+        size_t flagOffset = header.getStaleFlagOffset();
         
         zcdFile.seekp(flagOffset);
         zcdFile.write(reinterpret_cast<char*>(&validFlag), sizeof(uint8_t));
@@ -159,8 +179,23 @@ bool convertCSVtoZCD(const std::string& inFile, const std::string& outFile)
 }
 
 bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::string& zcbFile, 
-                                    uint32_t blockSize = 1024, uint16_t minBlockSize = 256)
+                                    uint32_t blockSize = 1024, uint16_t minBlockSize = 256,
+                                    uint32_t layoutAlignment = 0, bool checksums = false,
+                                    RecordEncoding encoding = RecordEncoding::Text,
+                                    BlockCodec::Type compression = BlockCodec::Type::None,
+                                    CoordinateFormat coordinates = CoordinateFormat::Degrees)
 {
+    if(layoutAlignment > 1 && (!HeaderRecord::isPowerOfTwo(layoutAlignment) || !HeaderRecord::isPowerOfTwo(blockSize)))
+    {
+        std::cerr << "Error: the page aligned layout needs a power of two alignment and block size" << std::endl;
+        return false;
+    }
+    if(coordinates == CoordinateFormat::MicroDegrees && encoding == RecordEncoding::Text)
+    {
+        std::cerr << "Error: micro-degree coordinates need the binary, slotted or dictionary encoding" << std::endl;
+        return false;
+    }
+
     CSVBuffer csvBuffer;
     if(!csvBuffer.openFile(csvFile))
     {
@@ -190,9 +225,34 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
     HeaderRecord header;
 
     header.setFileStructureType("ZIPC");
-    header.setVersion(2);
+    if(encoding == RecordEncoding::SlottedDelta)
+        header.setVersion(HeaderRecord::SLOTTED_DELTA_VERSION);
+    else if(coordinates == CoordinateFormat::MicroDegrees)
+        header.setVersion(HeaderRecord::FIXED_POINT_VERSION);
+    else if(compression != BlockCodec::Type::None)
+        header.setVersion(HeaderRecord::COMPRESSION_VERSION);
+    else if(encoding == RecordEncoding::Dictionary)
+        header.setVersion(HeaderRecord::DICTIONARY_VERSION);
+    else if(encoding != RecordEncoding::Text)
+        header.setVersion(HeaderRecord::BINARY_RECORD_VERSION);
+    else if(checksums)
+        header.setVersion(HeaderRecord::CHECKSUM_VERSION);
+    else
+        header.setVersion(layoutAlignment > 1 ? HeaderRecord::ALIGNED_LAYOUT_VERSION : HeaderRecord::LARGE_FILE_VERSION);
+    header.setLayoutAlignment(layoutAlignment); // Pads the header so every block starts on a page boundary
+    header.setChecksumType(checksums ? HeaderRecord::CHECKSUM_CRC32C : HeaderRecord::CHECKSUM_NONE);
+    header.setCompressionType(static_cast<uint8_t>(compression));
+    header.setCoordinateFormat(coordinates == CoordinateFormat::MicroDegrees ? HeaderRecord::COORDINATES_MICRODEGREES
+                                                                             : HeaderRecord::COORDINATES_DEGREES);
     header.setHeaderSize(0); // Set In Serialization Process
-    header.setSizeFormatType(0);
+    if(encoding == RecordEncoding::Dictionary)
+        header.setSizeFormatType(HeaderRecord::SIZE_FORMAT_DICTIONARY);
+    else if(encoding == RecordEncoding::Slotted)
+        header.setSizeFormatType(HeaderRecord::SIZE_FORMAT_SLOTTED);
+    else if(encoding == RecordEncoding::SlottedDelta)
+        header.setSizeFormatType(HeaderRecord::SIZE_FORMAT_SLOTTED_DELTA);
+    else
+        header.setSizeFormatType(encoding == RecordEncoding::Binary ? HeaderRecord::SIZE_FORMAT_BINARY : HeaderRecord::SIZE_FORMAT_ASCII);
     header.setBlockSize(blockSize);
     header.setMinBlockSize(minBlockSize);
     header.setIndexFileName("data/zipcode_data.idx"); // Placeholder
@@ -228,30 +288,35 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
     out.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
     out.close();
     
-    size_t blockCountOffset = 4 + 2 + 4 + 1 + 4 + 2 + 2 + 
-                         header.getIndexFileName().length() + 
-                         2 + header.getIndexFileSchemaInfo().length() + 
-                         sizeof(uint32_t);
+    size_t blockCountOffset = header.getBlockCountOffset();
     
     std::cout << "Converting " << csvFile << " to " << zcbFile << "..." << std::endl;
 
     RecordBuffer recordBuffer;
     BlockBuffer blockBuffer;
+    blockBuffer.setLayoutAlignment(header.getLayoutAlignment());
+    blockBuffer.setChecksums(checksums);
+    blockBuffer.setCompression(compression);
+    recordBuffer.setEncoding(encoding);
+    recordBuffer.setCoordinateFormat(coordinates);
 
     if(!blockBuffer.openFile(zcbFile, header.getHeaderSize()))
     {
         std::cerr << "Failed to open block buffer." << std::endl;    
     }
+    const size_t blockCapacity = blockBuffer.getPayloadSize(blockSize); // Room left by the checksum trailer and frame
 
     uint32_t currentRBN = 1;
     uint32_t blockCount = 0;
     std::vector<ZipCodeRecord> currentBlockRecords;
-    size_t currentSize = 10;  // metadata
+    BlockOccupancy occupancy(recordBuffer); // Metadata, records and any dictionary entries they share
 
     for(const auto& rec : allRecords)
     {
         // Check if adding this record would overflow
-        if (currentSize + rec.getRecordSize() + 4 > blockSize)
+        uint32_t recordSize = occupancy.measure(rec); // Measured once per record
+        size_t slack = 4 * (currentBlockRecords.size() + 1);
+        if (occupancy.getUsedSize() + occupancy.getAddedSize(rec, recordSize) + slack > blockCapacity)
         {
             // Write current block
             ActiveBlock block;
@@ -265,12 +330,12 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
             ++blockCount;
             ++currentRBN;
             currentBlockRecords.clear();
-            currentSize = 10;  // Reset to metadata size
+            occupancy.clear();
         }
       
         // Add record to current block
+        occupancy.insert(currentBlockRecords.size(), rec, recordSize);
         currentBlockRecords.push_back(rec);
-        currentSize += rec.getRecordSize() + 4;
     }
 
     // Write final block
@@ -287,7 +352,14 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
         ++blockCount;
     }
 
-    blockBuffer.closeFile();
+    blockBuffer.closeFile(); // Flushes the blocks still cached, so the stats below count every block
+    if(compression != BlockCodec::Type::None)
+    {
+        BlockCodec::Stats stats = blockBuffer.getCompressionStats();
+        std::cout << "Compressed " << stats.blocksEncoded << " blocks to " << std::fixed << std::setprecision(1)
+                  << stats.getRatio() * 100.0 << "% of their size (" << stats.rawBlocks << " stored raw)."
+                  << std::defaultfloat << std::endl;
+    }
 
     std::fstream updateFile(zcbFile, std::ios::binary | std::ios::in | std::ios::out);
     updateFile.seekp(blockCountOffset);
@@ -296,7 +368,7 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
 
     BlockIndexFile index;
     if(index.createIndexFromBlockedFile(zcbFile, blockSize, header.getHeaderSize(), 
-                                        header.getSequenceSetListRBN()))
+                                        header.getSequenceSetListRBN(), checksums, encoding, compression, coordinates))
     {
         std::cout << "Index Succesfully Created. Now Writing Index." << std::endl;
         if(index.write(header.getIndexFileName()))
@@ -304,7 +376,7 @@ bool convertCSVToBlockedSequenceSet(const std::string& csvFile, const std::strin
             std::cout << "Index Successfully Written" << std::endl;
             std::fstream outFile(zcbFile, std::ios::binary | std::ios::in | std::ios::out);
             uint8_t staleFlag = 0;
-            size_t flagOffset = header.getHeaderSize() - 1;
+            size_t flagOffset = header.getStaleFlagOffset();
             
             outFile.seekp(flagOffset);
             outFile.write(reinterpret_cast<char*>(&staleFlag), sizeof(uint8_t));
@@ -352,7 +424,7 @@ bool convertCSVToBlockedSequenceNoIndex(const std::string& csvFile, const std::s
     HeaderRecord header;
 
     header.setFileStructureType("ZIPC");
-    header.setVersion(2);
+    header.setVersion(HeaderRecord::LARGE_FILE_VERSION);
     header.setHeaderSize(0); // Set In Serialization Process
     header.setSizeFormatType(0);
     header.setBlockSize(blockSize);
@@ -390,10 +462,7 @@ bool convertCSVToBlockedSequenceNoIndex(const std::string& csvFile, const std::s
     out.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
     out.close();
     
-    size_t blockCountOffset = 4 + 2 + 4 + 1 + 4 + 2 + 2 + 
-                         header.getIndexFileName().length() + 
-                         2 + header.getIndexFileSchemaInfo().length() + 
-                         sizeof(uint32_t);
+    size_t blockCountOffset = header.getBlockCountOffset();
     
     std::cout << "Converting " << csvFile << " to " << zcbFile << "..." << std::endl;
 
@@ -413,7 +482,8 @@ bool convertCSVToBlockedSequenceNoIndex(const std::string& csvFile, const std::s
     for(const auto& rec : allRecords)
     {
         // Check if adding this record would overflow
-        if (currentSize + rec.getRecordSize() + 4 > blockSize)
+        uint32_t recordSize = rec.getRecordSize(); // Measured once per record
+        if (currentSize + recordSize + 4 > blockSize)
         {
             // Write current block
             ActiveBlock block;
@@ -432,7 +502,7 @@ bool convertCSVToBlockedSequenceNoIndex(const std::string& csvFile, const std::s
       
         // Add record to current block
         currentBlockRecords.push_back(rec);
-        currentSize += rec.getRecordSize() + 4;
+        currentSize += recordSize + 4;
     }
 
     // Write final block
@@ -459,7 +529,8 @@ bool convertCSVToBlockedSequenceNoIndex(const std::string& csvFile, const std::s
     return true;
 }
 
-bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std::string& zcbFile)
+bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std::string& zcbFile,
+                                          KeyEncoding keyEncoding = KeyEncoding::Full)
 {
     HeaderBuffer seqHeaderBuffer;
     HeaderRecord seqHeader;
@@ -476,6 +547,11 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std:
 
     BlockBuffer blockBuffer;
     RecordBuffer recordBuffer;
+    blockBuffer.setLayoutAlignment(seqHeader.getLayoutAlignment());
+    blockBuffer.setChecksums(seqHeader.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C);
+    blockBuffer.setCompression(BlockCodec::typeOf(seqHeader));
+    recordBuffer.setEncoding(RecordBuffer::encodingOf(seqHeader));
+    recordBuffer.setCoordinateFormat(RecordBuffer::coordinateFormatOf(seqHeader));
 
     if(!blockBuffer.openFile(zcbFile, seqHeader.getHeaderSize()))
     {
@@ -511,6 +587,7 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std:
     treeHeader.setBlockSize(seqHeader.getBlockSize());
     treeHeader.setHeight(0);
     treeHeader.setRootIndexRBN(0);
+    treeHeader.setHeaderAlignment(seqHeader.getLayoutAlignment()); // Index pages follow the data layout
 
     std::ofstream out(idxFile, std::ios::binary);
     if (!out.is_open())
@@ -532,6 +609,7 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std:
         std::cerr << "Failed To Open B+ Tree." << std::endl;
         return false;
     }
+    tree.setKeyEncoding(keyEncoding);
 
     if(!tree.buildFromSequenceSet())
     {
@@ -544,7 +622,7 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std:
 
     std::fstream seqFile(zcbFile, std::ios::binary | std::ios::in | std::ios::out);
     uint8_t staleFlag = 0;
-    size_t flagOffset = seqHeader.getHeaderSize() - 1;
+    size_t flagOffset = seqHeader.getStaleFlagOffset();
 
     seqFile.seekp(flagOffset);
     seqFile.write(reinterpret_cast<char*>(&staleFlag), sizeof(uint8_t));
@@ -553,7 +631,8 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string& idxFile, const std:
     return true; 
 }
 
-bool convertBlockedSequenceSetToBPlusTree(const std::string csvFile, const std::string& idxFile, const std::string& zcbFile)
+bool convertBlockedSequenceSetToBPlusTree(const std::string csvFile, const std::string& idxFile, const std::string& zcbFile,
+                                          KeyEncoding keyEncoding = KeyEncoding::Full)
 {
     if(!convertCSVToBlockedSequenceNoIndex(csvFile, zcbFile))
     {
@@ -561,7 +640,7 @@ bool convertBlockedSequenceSetToBPlusTree(const std::string csvFile, const std::
         return false;
     }
 
-    if(!convertBlockedSequenceSetToBPlusTree(idxFile, zcbFile))
+    if(!convertBlockedSequenceSetToBPlusTree(idxFile, zcbFile, keyEncoding))
     {
         std::cerr << "Failed To Convert Blocked Sequence Set To B+ Tree." << std::endl;
         return false;
@@ -628,7 +707,15 @@ bool displayHeader(const std::string& inFile)
     std::cout << "File Structure Type: " << std::string(header.getFileStructureType(), 4) << "\n";
     std::cout << "Version: " << header.getVersion() << "\n";
     std::cout << "Header Size: " << header.getHeaderSize() << " bytes\n";
-    std::cout << "Size Format Type: " << (int)header.getSizeFormatType() << " (0=ASCII, 1=Binary)\n";
+    if (header.isAlignedLayout())
+        std::cout << "Layout Alignment: " << header.getLayoutAlignment() << " bytes\n";
+    if (header.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C)
+        std::cout << "Block Checksum: CRC32C\n";
+    if (header.getCompressionType() == HeaderRecord::COMPRESSION_LZ)
+        std::cout << "Block Compression: LZ\n";
+    if (RecordBuffer::coordinateFormatOf(header) == CoordinateFormat::MicroDegrees)
+        std::cout << "Coordinates: int32 micro-degrees\n";
+    std::cout << "Size Format Type: " << (int)header.getSizeFormatType() << " (0=ASCII, 1=Binary, 2=Slotted, 3=Dictionary, 4=Slotted delta)\n";
     std::cout << "Index File: " << header.getIndexFileName() << "\n";
     std::cout << "Has Valid Index: " << (header.getStaleFlag() ? "Yes" : "No") << "\n";
     std::cout << "Record Count: " << header.getRecordCount() << "\n";
@@ -691,7 +778,39 @@ int main(int argc, char* argv[])
         }
         uint32_t blockSize = (argc >= 5) ? std::atoi(argv[4]) : 1024;
         uint16_t minBlockSize = (argc >= 6) ? std::atoi(argv[5]) : 256;
-        return convertCSVToBlockedSequenceSet(argv[2], argv[3], blockSize, minBlockSize) ? 0 : 1;
+        uint32_t layoutAlignment = 0;
+        if (argc >= 7)
+            layoutAlignment = std::string(argv[6]) == "page" ? HeaderRecord::PAGE_ALIGNMENT : std::atoi(argv[6]);
+        bool checksums = false;
+        RecordEncoding encoding = RecordEncoding::Text;
+        BlockCodec::Type compression = BlockCodec::Type::None;
+        CoordinateFormat coordinates = CoordinateFormat::Degrees;
+        for (int i = 7; i < argc; ++i)
+        {
+            std::string option = argv[i];
+            if (option == "crc32c")
+                checksums = true;
+            else if (option == "binary")
+                encoding = RecordEncoding::Binary;
+            else if (option == "slotted")
+                encoding = RecordEncoding::Slotted;
+            else if (option == "slotted-delta")
+                encoding = RecordEncoding::SlottedDelta;
+            else if (option == "dictionary")
+                encoding = RecordEncoding::Dictionary;
+            else if (option == "lz")
+                compression = BlockCodec::Type::LZ;
+            else if (option == "microdegrees")
+                coordinates = CoordinateFormat::MicroDegrees;
+            else
+            {
+                std::cerr << "Error: unknown option '" << option
+                          << "', expected crc32c, binary, slotted, slotted-delta, dictionary, lz or microdegrees\n";
+                return 1;
+            }
+        }
+        return convertCSVToBlockedSequenceSet(argv[2], argv[3], blockSize, minBlockSize, layoutAlignment,
+                                              checksums, encoding, compression, coordinates) ? 0 : 1;
     }
     else if (command == "read") 
     {
@@ -714,12 +833,22 @@ int main(int argc, char* argv[])
     }
     else if (command == "convert-b+tree")
     {
-        if (argc != 5) {
+        if (argc != 5 && argc != 6) {
             std::cerr << "Error: convert-bplus-tree requires csv input, index output, and blocked sequence set output filenames\n";
             printUsage(argv[0]);
             return 1;
         }
-        return convertBlockedSequenceSetToBPlusTree(argv[2], argv[3], argv[4]) ? 0 : 1;
+        KeyEncoding keyEncoding = KeyEncoding::Full;
+        if (argc == 6)
+        {
+            if (std::string(argv[5]) != "compact-keys")
+            {
+                std::cerr << "Error: unknown option '" << argv[5] << "', expected compact-keys\n";
+                return 1;
+            }
+            keyEncoding = KeyEncoding::FrameOfReference;
+        }
+        return convertBlockedSequenceSetToBPlusTree(argv[2], argv[3], argv[4], keyEncoding) ? 0 : 1;
     }
     else if (command == "verify") 
     {
@@ -1,9 +1,8 @@
 #include "../src/CSVBuffer.h"
 #include "../src/ZipCodeRecord.h"
 #include "../src/HeaderRecord.h"
-#include "../src/HeaderBuffer.h"
 #include "../src/BPlusTreeAlt.h"
-#include "../src/BPlusTreeHeaderAlt.h"
+#include "../src/RecordView.h"
 #include "ZipSearchApp.h"
 #include <iostream>
 #include <sstream>
@@ -22,6 +21,8 @@ const std::string PHYSICAL_DUMP_ARG = "-PD";
 const std::string LOGICAL_DUMP_ARG = "-LD";
 const std::string PRINT_ARG = "-PR";
 const std::string RANGE_QUERY_ARG = "-RQ";
+const std::string CACHE_STATS_ARG = "-CS";
+const std::string VERIFY_POLICY_ARG = "-VP";
 
 
 // uint32_t zipCode; // 5-digit zip code
@@ -32,39 +33,17 @@ const std::string RANGE_QUERY_ARG = "-RQ";
 // double longitude; // Longitude coordinate  
 
 ZipSearchApp::ZipSearchApp(){
-
 }
 
 ZipSearchApp::ZipSearchApp(const std::string& file){
-    fileName = file;
-    fileLoaded = true;
-    HeaderRecord header;
-    HeaderBuffer headerBuffer;
-
-    if (!headerBuffer.readHeader(fileName, header))
-    {
-        std::cerr << "Failed to read header from " << fileName << std::endl;
-    }
-    if (!indexHandler(header))
-    {
-        std::cerr << "Failed to handle index for " << fileName << std::endl;
-    }
-    
+    setDataFile(file);
 }
 
 bool ZipSearchApp::setDataFile(const std::string& file){
-    fileName = file;
-    fileLoaded = true;
-    HeaderRecord header;
-    HeaderBuffer headerBuffer;
-    if (!headerBuffer.readHeader(fileName, header))
+    //**opens the file and its index once, every later operation reuses them */
+    if (!session.open(file))
     {
-        std::cerr << "Failed to read header from " << fileName << std::endl;
-        return false;
-    }
-    if (!indexHandler(header))
-    {
-        std::cerr << "Failed to handle index for " << fileName << std::endl;
+        std::cerr << "Failed to open " << file << ": " << session.getLastError() << std::endl;
         return false;
     }
     return true;
@@ -83,48 +62,33 @@ bool ZipSearchApp::process(int argc, char* argv[]){
     // Physical Dump: -PD
     // Print B+ Tree: -PR
     // Range Query: -RQ 12345 12350
-    HeaderRecord header;
-    HeaderBuffer headerBuffer;
-    uint32_t headerSize;
-    uint32_t blockSize;
-    uint32_t sequenceSetHead;
-    uint32_t availListHead;
-    uint32_t blockCount;
-    //**if file is loaded, read header and set variables*/
-    if(fileLoaded){
-        if (!headerBuffer.readHeader(fileName, header)) {
-                std::cerr << "Failed to read header from " << fileName << std::endl;
-                return false;
-            }
-            if(!indexHandler(header)){ 
-                std::cerr << "Failed to handle index for " << fileName << std::endl;
-                return false;
-            }
-            headerSize = header.getHeaderSize();
-            blockSize = header.getBlockSize();
-            sequenceSetHead = header.getSequenceSetListRBN();
-            availListHead = header.getAvailableListRBN();
-            blockCount = header.getBlockCount();
-    }
-    BlockBuffer blockBuffer;
+    // Cache Stats: -CS
+    // Checksum Verify Policy: -VP always|first|never
     for (int i = 1; i < argc; ++i) {
         try {
             if(argv[i] == FILE_ARG){
-                fileName = argv[++i];
-                if (!headerBuffer.readHeader(fileName, header)) {
-                    std::cerr << "Failed to read header from " << fileName << std::endl;
+                if(!setDataFile(argv[++i])){
                     return false;
                 }
-                if(!indexHandler(header)){ 
-                    std::cerr << "Failed to handle index for " << fileName << std::endl;
+                std::cout << "Loaded file: " << session.getFileName() << std::endl;
+            }
+            else if(argv[i] == VERIFY_POLICY_ARG){
+                //**only files converted with checksums carry trailers to verify */
+                std::string policy = argv[++i];
+                if(policy == "always")
+                    session.setVerifyPolicy(BlockChecksum::VerifyPolicy::Always);
+                else if(policy == "first")
+                    session.setVerifyPolicy(BlockChecksum::VerifyPolicy::FirstRead);
+                else if(policy == "never")
+                    session.setVerifyPolicy(BlockChecksum::VerifyPolicy::Never);
+                else{
+                    std::cerr << "Unknown verify policy: " << policy << " (always, first or never)" << std::endl;
                     return false;
                 }
-                headerSize = header.getHeaderSize();
-                blockSize = header.getBlockSize();
-                sequenceSetHead = header.getSequenceSetListRBN();
-                availListHead = header.getAvailableListRBN();
-                blockCount = header.getBlockCount();
-                std::cout << "Loaded file: " << fileName << std::endl;
+            }
+            else if(!session.isOpen()){
+                std::cerr << "No file loaded, " << argv[i] << " needs " << FILE_ARG << " first" << std::endl;
+                return false;
             }
             else if(argv[i] == ADD_ARG){
                 uint32_t zip = std::stoul(argv[++i]);
@@ -136,7 +100,7 @@ bool ZipSearchApp::process(int argc, char* argv[]){
                 ZipCodeRecord newRecord(zip, latitude, longitude, locationName, state, county);
                 
                 //add the new record to the blocked file if possible
-                if(!add(newRecord, header)){
+                if(!add(newRecord)){
                     std::cerr << "Failed to add zip code: " << zip << std::endl;
                     continue;
                 }
@@ -147,35 +111,16 @@ bool ZipSearchApp::process(int argc, char* argv[]){
                 ZipCodeRecord outRecord;
 
                 //**searches for a zip code in the blocked file */
-                if(!search(zip, blockSize, headerSize, outRecord)){
+                if(!search(zip, outRecord)){
                     std::cout << "Zip code " << zip << " not found in block." << std::endl;
                     continue;
                 }
                 std::cout << "Found: " << outRecord << std::endl;
             }
             else if(argv[i] == CREATE_INDEX_ARG){
-                //rebuild B+ tree index
-                BPlusTreeHeaderAlt treeHeader;
-                treeHeader.setBlockedFileName(fileName);
-                treeHeader.setBlockSize(blockSize);
-                treeHeader.setHeight(0);
-                treeHeader.setRootIndexRBN(0);
-                
-
-                std::ofstream out(header.getIndexFileName(), std::ios::binary);
-                if (!out.is_open())
-                {
-                    std::cerr << "Error: Cannot create index file: " << header.getIndexFileName() << std::endl;
-                    return false;
-                }
-
-                auto headerData = treeHeader.serialize();
-                treeHeader.setHeaderSize(headerData.size());
-
-                out.write(reinterpret_cast<char *>(headerData.data()), headerData.size());
-                out.close();
-                if(!bPlusTree.buildFromSequenceSet()){
-                    std::cerr << "Failed to build B+ tree index." << std::endl;
+                //rebuild B+ tree index, pending blocks and pages of the old tree are written first
+                if(!session.rebuildIndex()){
+                    std::cerr << "Failed to build B+ tree index: " << session.getLastError() << std::endl;
                     return false;
                 }
                 std::cout << "B+ tree index successfully built." << std::endl;
@@ -184,7 +129,7 @@ bool ZipSearchApp::process(int argc, char* argv[]){
                 uint32_t zip = std::stoul(argv[++i]);
 
                 //**removes the zips to the blocked file */
-                if(!remove(zip, header)){
+                if(!remove(zip)){
                     std::cerr << "Failed to remove zip code: " << zip << std::endl;
                     continue;
                 }
@@ -194,37 +139,69 @@ bool ZipSearchApp::process(int argc, char* argv[]){
                 std::string outFile = argv[++i]; //get out file name
                 std::ofstream out(outFile, std::ios::out);    
                 
-                if(!blockBuffer.openFile(fileName, headerSize)){
-                    std::cerr << "Failed to open block buffer\n";
+                //**dumps walk the file, write pending blocks first */
+                const HeaderRecord& header = session.getHeader();
+                BlockBuffer& blockBuffer = session.getBlockBuffer();
+                if(!session.flush()){
+                    std::cerr << "Failed to flush block buffer\n";
                     continue;
                 }
-                blockBuffer.dumpLogicalOrder(out, sequenceSetHead, availListHead, blockSize, headerSize);
+                blockBuffer.dumpLogicalOrder(out, header.getSequenceSetListRBN(), header.getAvailableListRBN(),
+                                             header.getBlockSize(), header.getHeaderSize());
                 std::cout << "Logical dump written to: " << outFile << std::endl;
+                SequenceScanStats scan = blockBuffer.getLastScanStats();
+                std::cout << "Logical order matched physical order for " << scan.inPhysicalOrder << " of "
+                          << (scan.blocksVisited > 0 ? scan.blocksVisited - 1 : 0) << " chain steps ("
+                          << (100.0 * scan.getPhysicalOrderRatio()) << "%)" << std::endl;
                 out.close();
-                blockBuffer.closeFile();
             }
             else if(argv[i] == PHYSICAL_DUMP_ARG){
                 std::string outFile = argv[++i]; //get out file name
                 std::ofstream out(outFile, std::ios::out);    
                 
-                if(!blockBuffer.openFile(fileName, headerSize)){
-                    std::cerr << "Failed to open block buffer\n";
+                const HeaderRecord& header = session.getHeader();
+                if(!session.flush()){
+                    std::cerr << "Failed to flush block buffer\n";
                     continue;
                 }
-                blockBuffer.dumpPhysicalOrder(out, sequenceSetHead, availListHead, blockCount, blockSize, headerSize);
+                session.getBlockBuffer().dumpPhysicalOrder(out, header.getSequenceSetListRBN(), header.getAvailableListRBN(),
+                                                           header.getBlockCount(), header.getBlockSize(), header.getHeaderSize());
                 std::cout << "Physical dump written to: " << outFile << std::endl;
                 out.close();
-                blockBuffer.closeFile();
             }
             else if(argv[i] == PRINT_ARG){
-                bPlusTree.printTree();
+                session.getTree().printTree();
+            }
+            else if(argv[i] == CACHE_STATS_ARG){
+                BlockCache& blockCache = session.getBlockCache();
+                BlockCache::Stats stats = blockCache.getStats();
+                uint64_t lookups = stats.hits + stats.misses;
+                std::cout << "Block cache: " << blockCache.getResidentCount() << "/" << blockCache.getCapacity()
+                          << " frames, " << stats.hits << " hits, " << stats.misses << " misses";
+                if(lookups > 0)
+                    std::cout << " (" << (100.0 * stats.hits / lookups) << "% hit rate)";
+                std::cout << ", " << stats.evictions << " evictions (" << stats.dirtyEvictions << " dirty)" << std::endl;
+                session.getCacheManager().printOccupancy(std::cout);
+                if(session.getBlockBuffer().hasChecksums()){
+                    BlockChecksum::Stats checks = session.getBlockBuffer().getChecksumStats();
+                    std::cout << "Block checksums: " << checks.verified << " verified, "
+                              << checks.failures << " failed" << std::endl;
+                }
+                if(session.getBlockBuffer().getCompression() != BlockCodec::Type::None){
+                    BlockCodec::Stats packed = session.getBlockBuffer().getCompressionStats();
+                    std::cout << "Block compression: " << (100.0 * packed.getRatio()) << "% stored size, "
+                              << packed.blocksEncoded << " encoded (" << packed.rawBlocks << " raw), "
+                              << packed.blocksDecoded << " decoded, "
+                              << (session.getBlockBuffer().hasCompressedCache() ? "compressed" : "decompressed")
+                              << " cache frames" << std::endl;
+                }
             }
             else if(argv[i] == RANGE_QUERY_ARG){
                 uint32_t zipStart = std::stoul(argv[++i]);
                 uint32_t zipEnd = std::stoul(argv[++i]);
                 
                 std::vector<ZipCodeRecord> outRecords;
-                if(!rangeQuery(zipStart, zipEnd, blockSize, headerSize, outRecords)){
+                if(!rangeQuery(zipStart, zipEnd, outRecords)){
                     std::cerr << "Failed to perform range query from " << zipStart << " to " << zipEnd << std::endl;
                     continue;
                 }
@@ -253,38 +230,27 @@ bool ZipSearchApp::process(int argc, char* argv[]){
 }
 
 
-bool ZipSearchApp::search(uint32_t zip, uint32_t blockSize, uint32_t headerSize, ZipCodeRecord& outRecord){
+bool ZipSearchApp::search(uint32_t zip, ZipCodeRecord& outRecord){
     //**searches for a zip code in the blocked file */
     uint32_t rbn;
-    if (!bPlusTree.search(zip, rbn)) {
+    if (!session.getTree().search(zip, rbn)) {
         std::cout << "Zip code " << zip << " not found." << std::endl;
         return false;
     }
 
-    
-
-
-    //**searches for a zip code in the blocked file */
-    BlockBuffer blockBuffer;
-    ZipCodeRecord record;
-
-    if (blockBuffer.openFile(fileName, headerSize) && 
-        blockBuffer.readRecordAtRBN(rbn, zip, blockSize, headerSize, record)) {
-        outRecord = record;
-    } else {
-        return false;
-    }
-    blockBuffer.closeFile();
-    return true;
-    
+    //**reads the record from the session's open sequence set */
+    const HeaderRecord& header = session.getHeader();
+    return session.getBlockBuffer().readRecordAtRBN(rbn, zip, header.getBlockSize(), header.getHeaderSize(), outRecord);
 }
 
-bool ZipSearchApp::add(const ZipCodeRecord zip, HeaderRecord& header){
-    BlockBuffer blockBuffer;
-    if(!blockBuffer.openFile(fileName, header.getHeaderSize()))
+bool ZipSearchApp::add(const ZipCodeRecord zip){
+    HeaderRecord& header = session.getHeader();
+    BlockBuffer& blockBuffer = session.getBlockBuffer();
+    BPlusTreeAlt& bPlusTree = session.getTree();
+    if(!session.markModified())
     {
-        std::cerr << "Failed to open block buffer\n";
-        return 1;
+        std::cerr << "Failed to mark file as modified: " << session.getLastError() << std::endl;
+        return false;
     }
 
     uint32_t blockCount = header.getBlockCount();
@@ -305,6 +271,11 @@ bool ZipSearchApp::add(const ZipCodeRecord zip, HeaderRecord& header){
         return false;
     }
 
+    //**a split may have taken a block from the avail list or grown the file */
+    header.setBlockCount(blockCount);
+    header.setAvailableListRBN(availListRBN);
+    header.setRecordCount(header.getRecordCount() + 1);
+
     if(blockBuffer.getSplitOccurred())
     {
         SplitInfo splitInfo = blockBuffer.getLastSplitInfo();
@@ -320,28 +291,34 @@ bool ZipSearchApp::add(const ZipCodeRecord zip, HeaderRecord& header){
             return false;
         }
     } 
-    blockBuffer.closeFile();
     return true;
 }
 
 
 
-bool ZipSearchApp::remove(uint32_t zip, HeaderRecord& header){
+bool ZipSearchApp::remove(uint32_t zip){
     
     //**checks if the zip code exists in the blocked file */
+    HeaderRecord& header = session.getHeader();
     ZipCodeRecord record;
     uint32_t blockSize = header.getBlockSize();
     uint32_t headerSize = header.getHeaderSize();
-    if (!search(zip, blockSize, headerSize, record)) {
+    if (!search(zip, record)) {
         return false;
     }
 
     //**removes the zips to the blocked file */
 
-    BlockBuffer blockBuffer;
+    BlockBuffer& blockBuffer = session.getBlockBuffer();
+    BPlusTreeAlt& bPlusTree = session.getTree();
     RecordBuffer recordBuffer;
-    blockBuffer.openFile(fileName, headerSize);
-
+    recordBuffer.setEncoding(blockBuffer.getRecordEncoding());
+    recordBuffer.setCoordinateFormat(blockBuffer.getCoordinateFormat());
+    if(!session.markModified())
+    {
+        std::cerr << "Failed to mark file as modified: " << session.getLastError() << std::endl;
+        return false;
+    }
 
     blockBuffer.resetMerge();
     uint32_t rbn;
@@ -433,93 +410,32 @@ bool ZipSearchApp::remove(uint32_t zip, HeaderRecord& header){
     {
         header.setAvailableListRBN(availListRBN);
     }
-    blockBuffer.closeFile();
+    header.setRecordCount(header.getRecordCount() - 1);
     return true;
 }
 
-bool ZipSearchApp::rangeQuery(uint32_t zipStart, uint32_t zipEnd, uint32_t blockSize, uint32_t headerSize, std::vector<ZipCodeRecord>& outRecords){
-    std::vector<uint32_t> rbns = bPlusTree.searchRange(zipStart, zipEnd);
-    BlockBuffer blockBuffer;
-    if(!blockBuffer.openFile(fileName,  headerSize)){
-        std::cerr << "Failed to open block buffer\n";
-        return false;
-    }
-    RecordBuffer recordBuffer;
-    for(auto rbn : rbns){
-        ActiveBlock block = blockBuffer.loadActiveBlockAtRBN(rbn, blockSize, headerSize);
-        std::vector<ZipCodeRecord> recordsInBlock;
-        recordBuffer.unpackBlock(block.data, recordsInBlock);
-        for(const auto& record : recordsInBlock){
-            if(record.getZipCode() >= zipStart && record.getZipCode() <= zipEnd){
-                outRecords.push_back(record);
+bool ZipSearchApp::rangeQuery(uint32_t zipStart, uint32_t zipEnd, std::vector<ZipCodeRecord>& outRecords){
+    std::vector<uint32_t> rbns = session.getTree().searchRange(zipStart, zipEnd);
+    const HeaderRecord& header = session.getHeader();
+    BlockBuffer& blockBuffer = session.getBlockBuffer();
+    //**all block reads are submitted at once, each block is viewed as its read completes */
+    const RecordEncoding encoding = blockBuffer.getRecordEncoding();
+    const CoordinateFormat coordinates = blockBuffer.getCoordinateFormat();
+    std::vector<std::vector<ZipCodeRecord>> recordsByBlock(rbns.size());
+    blockBuffer.visitActiveBlocksAtRBNs(rbns, header.getBlockSize(), header.getHeaderSize(),
+        [&](size_t index, const ActiveBlock& block){
+            //**only records inside the range are copied out of the block */
+            BlockRecordIterator recordsInBlock(block.data, encoding, coordinates);
+            RecordView record;
+            while(recordsInBlock.next(record)){
+                if(record.getZipCode() >= zipStart && record.getZipCode() <= zipEnd){
+                    recordsByBlock[index].push_back(record.toRecord());
+                }
             }
-        }
+        });
+    //**completion order is arbitrary, emit in key order */
+    for(const auto& records : recordsByBlock){
+        outRecords.insert(outRecords.end(), records.begin(), records.end());
     }
-    blockBuffer.closeFile();
     return true;
 }
-
-
-bool ZipSearchApp::indexHandler(const HeaderRecord& header){
-    const uint32_t blockSize = header.getBlockSize();
-    const uint32_t headerSize = header.getHeaderSize();
-    const uint32_t blockCount = header.getBlockCount();
-    const std::string indexFileName = header.getIndexFileName();
-    const uint32_t sequenceSetListRBN = header.getSequenceSetListRBN();
-    const bool staleFlag = header.getStaleFlag();
-
-    BPlusTreeHeaderBufferAlt bPlusTreeHeaderBuffer;
-    
-    
-    
-    if(staleFlag){
-        
-        //create index file header
-
-        BPlusTreeHeaderAlt treeHeader;
-        treeHeader.setBlockedFileName(fileName);
-        treeHeader.setBlockSize(blockSize);
-        treeHeader.setHeight(0);
-        treeHeader.setRootIndexRBN(0);
-
-        std::ofstream out(indexFileName, std::ios::binary);
-        if (!out.is_open())
-        {
-            std::cerr << "Error: Cannot create index file: " << indexFileName << std::endl;
-            return false;
-        }
-    
-        auto headerData = treeHeader.serialize();
-        treeHeader.setHeaderSize(headerData.size());
-
-        out.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
-        out.close();
-
-
-        //create B+ tree from index file
-
-        
-
-        if(!bPlusTree.open(indexFileName, fileName))
-        {
-            std::cerr << "Failed To Open B+ Tree." << std::endl;
-            return false;
-        }
-
-        if(!bPlusTree.buildFromSequenceSet())
-        {
-            std::cerr << "Failed To Build B+ Tree From Sequence Set." << std::endl;
-            return false;
-        }
-        
-    }
-    else{
-        if(!bPlusTree.open(indexFileName, fileName))
-        {
-            std::cerr << "Failed To Open B+ Tree." << std::endl;
-            return false;
-        }
-    }
-    return true;
-}
-
@@ -6,6 +6,7 @@
 #include "../src/CSVBuffer.h"
 #include "../src/ZipCodeRecord.h"
 #include "../src/BlockBuffer.h"
+#include "../src/FileSession.h"
 #include "../src/Block.h"
 #include <iostream>
 #include <fstream>
@@ -35,33 +36,28 @@ public:
    
     
 private:
-    std::string fileName;
-    BPlusTreeAlt bPlusTree;
-    bool fileLoaded = false;
-
-
-    bool indexHandler(const HeaderRecord& header);
+    FileSession session; // The open blocked file, index and header, shared by every operation
 
      /**
      * @brief searches for a zip code in the blocked file
      * @param zip the zip code to search for
      * @return true if the zip code was found, false otherwise
      */
-    bool search(uint32_t zip, uint32_t blockSize, uint32_t headerSize, ZipCodeRecord& outRecord);
+    bool search(uint32_t zip, ZipCodeRecord& outRecord);
 
     /**
      * @brief adds a zip code to the blocked file
      * @param zip the zip code to add
      * @return true if the zip code was added successfully, false otherwise
      */
-    bool add(const ZipCodeRecord zip, HeaderRecord& header);
+    bool add(const ZipCodeRecord zip);
 
     /**
      * @brief removes a zip code from the blocked file
      * @param zip the zip code to remove
      * @return true if the zip code was removed successfully, false otherwise
      */
-    bool remove(uint32_t zip, HeaderRecord& header);
+    bool remove(uint32_t zip);
 
     /**
      * @brief performs a range query for zip codes in the blocked file
@@ -70,6 +66,6 @@ private:
      * @param outRecords vector to store the resulting zip code records
      * @return true if the range query was successful, false otherwise
      */
-    bool rangeQuery(uint32_t zipStart, uint32_t zipEnd, uint32_t blockSize, uint32_t headerSize, std::vector<ZipCodeRecord>& outRecords);
+    bool rangeQuery(uint32_t zipStart, uint32_t zipEnd, std::vector<ZipCodeRecord>& outRecords);
 };
 #endif
\ No newline at end of file
@@ -2,7 +2,7 @@
 set -euo pipefail
 
 CXX=g++
-CXXFLAGS="-std=c++11 -I src"
+CXXFLAGS="-std=c++11 -pthread -I src"
 
 BIN_ZIPSEARCH=./ZipSearch
 BIN_ADD=./AddTest
@@ -1,6 +1,10 @@
 #include "BPlusTreeAlt.h"
+#include "SequenceSetIterator.h"
+#include "RecordView.h"
 
-BPlusTreeAlt::BPlusTreeAlt() : isOpen(false), errorState(false), errorMessage("") 
+BPlusTreeAlt::BPlusTreeAlt() : isOpen(false), errorState(false), headerDirty(false), errorMessage(""),
+                               sequenceHeaderSize(0), blockSize(0), nodeSize(0),
+                               keyEncoding(KeyEncoding::Full)
 {
 }
 
@@ -12,7 +16,8 @@ BPlusTreeAlt::~BPlusTreeAlt()
     }
 }
 
-bool BPlusTreeAlt::open(const std::string& inIndexFileName, const std::string& inSequenceSetFilename)
+bool BPlusTreeAlt::open(const std::string& inIndexFileName, const std::string& inSequenceSetFilename,
+                        const bool directIO)
 {
     HeaderBuffer headerBuffer;
     BPlusTreeHeaderBufferAlt bPlusTreeHeaderBuffer;
@@ -34,20 +39,72 @@ bool BPlusTreeAlt::open(const std::string& inIndexFileName, const std::string& i
         return false;
     }
 
+    // An aligned sequence set gets an index padded the same way, hold both to it
+    sequenceSetBuffer.setLayoutAlignment(sequenceHeader.getLayoutAlignment());
+    indexPageBuffer.setLayoutAlignment(sequenceHeader.getLayoutAlignment());
+
+    // A checksummed sequence set ends every data block and index page in a CRC32C trailer
+    const bool checksums = sequenceHeader.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C;
+    sequenceSetBuffer.setChecksums(checksums);
+    indexPageBuffer.setChecksums(checksums);
+    sequenceSetBuffer.setRecordEncoding(RecordBuffer::encodingOf(sequenceHeader));
+    sequenceSetBuffer.setCoordinateFormat(RecordBuffer::coordinateFormatOf(sequenceHeader));
+
+    // Only sequence set blocks are compressed, index pages stay as they are. The cache form is
+    // chosen the same way as any other buffer on the file so they agree on the shared frames
+    sequenceSetBuffer.setCompression(BlockCodec::typeOf(sequenceHeader));
+    sequenceSetBuffer.setCacheForm(BlockBuffer::CacheForm::Auto,
+                                   static_cast<uint64_t>(sequenceHeader.getBlockCount()) * sequenceHeader.getBlockSize());
+
     // Open index page buffer
-    if (!indexPageBuffer.open(indexFilename, treeHeader.getBlockSize(), treeHeader.getHeaderSize())) 
+    if (!indexPageBuffer.open(indexFilename, treeHeader.getBlockSize(), treeHeader.getHeaderSize(), directIO)) 
     {
-        setError("Failed to open index page buffer");
+        setError("Failed to open index page buffer: " + indexPageBuffer.getLastError());
         return false;
     }
 
     sequenceHeaderSize = sequenceHeader.getHeaderSize();
     blockSize = sequenceHeader.getBlockSize();
+    nodeSize = checksums ? blockSize - BlockChecksum::TRAILER_SIZE : blockSize;
+    headerDirty = false;
     isOpen = true;
 
+    // Every page of a built tree shares the root's key layout
+    std::vector<uint8_t> rootPage;
+    if (treeHeader.getRootIndexRBN() != 0 && readPage(treeHeader.getRootIndexRBN(), rootPage))
+    {
+        NodePage root(rootPage);
+        if (root.isValid())
+            keyEncoding = root.getKeyEncoding();
+    }
+
     return true;
 }
 
+void BPlusTreeAlt::attachCache(CacheManager* manager)
+{
+    indexPageBuffer.attachCache(manager);
+    sequenceSetBuffer.attachCache(nullptr);
+    sequenceSetCache.reset(manager != nullptr ? new BlockCache(*manager) : nullptr);
+    sequenceSetBuffer.attachCache(sequenceSetCache.get());
+}
+
+void BPlusTreeAlt::setVerifyPolicy(BlockChecksum::VerifyPolicy policy)
+{
+    indexPageBuffer.setVerifyPolicy(policy);
+    sequenceSetBuffer.setVerifyPolicy(policy);
+}
+
+void BPlusTreeAlt::setKeyEncoding(KeyEncoding encoding)
+{
+    keyEncoding = encoding;
+}
+
+KeyEncoding BPlusTreeAlt::getKeyEncoding() const
+{
+    return keyEncoding;
+}
+
 bool BPlusTreeAlt::isFileOpen() const
 {
     return isOpen;
@@ -75,11 +132,26 @@ void BPlusTreeAlt::close()
     
     BPlusTreeHeaderBufferAlt headerBuffer;
     headerBuffer.writeHeader(indexPageBuffer.getFileStream(), treeHeader);
+    headerDirty = false;
     
     indexPageBuffer.closeFile();
     isOpen = false;
 }
 
+bool BPlusTreeAlt::sync()
+{
+    if (!isOpen)
+        return false;
+
+    if (headerDirty)
+    {
+        BPlusTreeHeaderBufferAlt headerBuffer;
+        headerBuffer.writeHeader(indexPageBuffer.getFileStream(), treeHeader);
+        headerDirty = false;
+    }
+    return indexPageBuffer.sync();
+}
+
 void BPlusTreeAlt::setError(const std::string& message)
 {
     errorState = true;
@@ -89,12 +161,12 @@ void BPlusTreeAlt::setError(const std::string& message)
 NodeAlt* BPlusTreeAlt::loadNode(uint32_t rbn)
 {
     std::vector<uint8_t> buffer;
-    if(!indexPageBuffer.readBlock(rbn, buffer))
+    if(!readPage(rbn, buffer))
     {
         return nullptr;
     }
     
-    NodeAlt* node = new NodeAlt(false, blockSize);
+    NodeAlt* node = new NodeAlt(false, nodeSize);
     
     if(!node->unpack(buffer))
     {
@@ -102,11 +174,28 @@ NodeAlt* BPlusTreeAlt::loadNode(uint32_t rbn)
         return nullptr;
     }
     
-    node->setMaxKeys(NodeAlt::calculateMaxKeys(blockSize, node->isLeafNode() == 1));
+    node->setMaxKeys(NodeAlt::calculateMaxKeys(nodeSize, node->isLeafNode() == 1));
+    // A page written under another encoding converts when the node is written back
+    node->setKeyEncoding(keyEncoding);
     
     return node;
 }
 
+bool BPlusTreeAlt::readPage(uint32_t rbn, std::vector<uint8_t>& page)
+{
+    if(!indexPageBuffer.readBlock(rbn, page) || page.empty())
+    {
+        return false;
+    }
+
+    // Every search passes through the inner nodes, keep them resident ahead of leaves and data
+    if((page[0] & 1) == 0)
+    {
+        indexPageBuffer.setPagePriority(rbn, CacheManager::Priority::IndexInner);
+    }
+    return true;
+}
+
 bool BPlusTreeAlt::writeNode(uint32_t rbn, const NodeAlt& node)
 {
     std::vector<uint8_t> data;
@@ -137,23 +226,17 @@ bool BPlusTreeAlt::search(uint32_t key, uint32_t& outValue)
         return false;
     // Find RBN For Leaf
     uint32_t leafRBN = findLeafRBN(key);
-    // Load Leaf Node
-    NodeAlt* leaf = loadNode(leafRBN);
-    // Check For NULL
-    if(leaf == nullptr)
+    // Read Leaf Page
+    std::vector<uint8_t> buffer;
+    if(!readPage(leafRBN, buffer))
         return false;
-    for(size_t i = 0; i < leaf->getKeyCount(); ++i)
-    {
-        // Find Block Containing Key
-        if(key <= leaf->getKeyAt(i))
-        {
-            outValue = leaf->getValueAt(i);
-            delete leaf;
-            return true;
-        }   
-    }
-    delete leaf;
-    return false;
+    NodePage leaf(buffer);
+    // Find Block Containing Key, the first key not below it
+    size_t index = leaf.lowerBound(key);
+    if(index >= leaf.getKeyCount())
+        return false;
+    outValue = leaf.getValueAt(index);
+    return true;
 }
 
 bool BPlusTreeAlt::keyExistsInIndex(uint32_t key)
@@ -162,28 +245,14 @@ bool BPlusTreeAlt::keyExistsInIndex(uint32_t key)
         return false;
         
     uint32_t leafRBN = findLeafRBN(key);
-    NodeAlt* leaf = loadNode(leafRBN);
-    
-    if(leaf == nullptr)
+    std::vector<uint8_t> buffer;
+    if(!readPage(leafRBN, buffer))
         return false;
         
     // Search for match
-    for(size_t i = 0; i < leaf->getKeyCount(); ++i)
-    {
-        if(leaf->getKeyAt(i) == key)  
-        {
-            delete leaf;
-            return true;
-        }
-        
-        if(leaf->getKeyAt(i) > key)  
-        {
-            break;
-        }
-    }
-    
-    delete leaf;
-    return false;
+    NodePage leaf(buffer);
+    size_t index = leaf.lowerBound(key);
+    return index < leaf.getKeyCount() && leaf.getKeyAt(index) == key;
 }
 
 uint32_t BPlusTreeAlt::findLeafRBN(uint32_t key)
@@ -193,28 +262,30 @@ uint32_t BPlusTreeAlt::findLeafRBN(uint32_t key)
     uint32_t maxHeight = treeHeader.getHeight() + 5;
     size_t safetyCount = 0;
 
+    // One page buffer for the whole descent, each level is searched in place
+    std::vector<uint8_t> buffer;
     while(safetyCount < maxHeight)
     {
-        NodeAlt* node = loadNode(currentRBN);
-        
-        if (node == nullptr)
+        if (!readPage(currentRBN, buffer))
         {
             setError("Failed to load node at RBN: " + std::to_string(currentRBN));
             return 0;
         }
+        NodePage node(buffer);
+        if (!node.isValid())
+        {
+            setError("Corrupt node at RBN: " + std::to_string(currentRBN));
+            return 0;
+        }
 
         // Appropriate leaf node found
-        if(node->isLeafNode() == 1)
+        if(node.isLeaf())
         {
-            uint32_t result = currentRBN;
-            delete node;
-            return result;
+            return currentRBN;
         }
         
         // Find child node to descend to
-        size_t childIndex = node->findChildIndex(key);
-        currentRBN = node->getChildRBN(childIndex);
-        delete node;
+        currentRBN = node.getChildRBN(node.upperBound(key));
         
         ++safetyCount;
     }
@@ -230,23 +301,16 @@ uint32_t BPlusTreeAlt::findInsertionBlock(uint32_t key)
 
     uint32_t leafRBN = findLeafRBN(key);
 
-    NodeAlt* leaf = loadNode(leafRBN);
-    if(leaf == nullptr)
+    std::vector<uint8_t> buffer;
+    if(!readPage(leafRBN, buffer))
         return 0;
 
-    for(size_t i = 0; i < leaf->getKeyCount(); ++i)
-    {
-        if(key <= leaf->getKeyAt(i))
-        {
-            uint32_t blockRBN = leaf->getValueAt(i);
-            delete leaf;
-            return blockRBN;
-        }
-    }
-
-    uint32_t blockRBN = leaf->getValueAt(leaf->getKeyCount() - 1);
-    delete leaf;
-    return blockRBN;
+    // The first block whose highest key is not below the key, else the last block of the leaf
+    NodePage leaf(buffer);
+    size_t index = leaf.lowerBound(key);
+    if(index < leaf.getKeyCount())
+        return leaf.getValueAt(index);
+    return leaf.getKeyCount() > 0 ? leaf.getValueAt(leaf.getKeyCount() - 1) : 0;
 }
 
 bool BPlusTreeAlt::buildFromSequenceSet()
@@ -257,7 +321,9 @@ bool BPlusTreeAlt::buildFromSequenceSet()
         return false;
     }
 
-    if(!sequenceSetBuffer.openFile(sequenceSetFilename, sequenceHeader.getHeaderSize()))
+    // Read-only walk of the whole chain, map it and let the kernel read ahead
+    if(!sequenceSetBuffer.openFileMapped(sequenceSetFilename, sequenceHeader.getHeaderSize(),
+                                         BlockBuffer::AccessPattern::Sequential))
     {
         setError("Failed to open sequenceSetFile");
         return false;
@@ -265,22 +331,27 @@ bool BPlusTreeAlt::buildFromSequenceSet()
     // Create index entry vector
     std::vector<IndexEntry> entries;
     // Start at root of sequence set
-    uint32_t currentRBN = sequenceHeader.getSequenceSetListRBN();
-    while(currentRBN != 0)
+    SequenceSetIterator chain(sequenceSetBuffer, sequenceHeader.getSequenceSetListRBN(),
+                              blockSize, sequenceHeaderSize);
+    ActiveBlock block;
+    RecordView record;
+    while(chain.next(block))
     {
-        // Start reading the sequence set
-        ActiveBlock block = sequenceSetBuffer.loadActiveBlockAtRBN(currentRBN, blockSize, sequenceHeaderSize);
-        std::vector<ZipCodeRecord> records;
-        // Unpack records with the exposed record buffer
-        sequenceSetBuffer.unpackBlockAPI(block.data, records);
+        // Start reading the sequence set, reusing the same block storage each time
+        uint32_t currentRBN = chain.getCurrentRBN();
+        // Only the zips are needed, view the records in place
+        BlockRecordIterator records(block.data, sequenceSetBuffer.getRecordEncoding(),
+                                    sequenceSetBuffer.getCoordinateFormat());
+        bool hasRecords = false;
+        while(records.next(record))
+            hasRecords = true;
         // Get the highest key in each block
-        if(!records.empty())
+        if(hasRecords)
         {
-            uint32_t highestKey = records.back().getZipCode();
+            uint32_t highestKey = record.getZipCode();
             IndexEntry entry = {highestKey, currentRBN};
             entries.push_back(entry);
         }
-        currentRBN = block.succeedingRBN;
     }
     sequenceSetBuffer.closeFile();
     // Start building the tree from the index entries
@@ -317,18 +388,20 @@ std::vector<uint32_t> BPlusTreeAlt::buildLeafLevel(const std::vector<IndexEntry>
 {
     // Create leaf rbn vector
     std::vector<uint32_t> leafRBNs;
-    size_t maxKeys = NodeAlt::calculateMaxKeys(blockSize, true);
     // For each entry in entries
-    for (size_t i = 0; i < entries.size(); i += maxKeys)
+    size_t i = 0;
+    while (i < entries.size())
     {
         // Create empty leaf node
-        NodeAlt leaf(true, blockSize);
-        // From j to max keys insert key and value to distribute keys properly
-        for(size_t j = 0; j < maxKeys && (i + j) < entries.size(); ++j)
+        NodeAlt leaf(true, nodeSize, keyEncoding);
+        // Fill the leaf while the next key fits, a count under Full and a page size under FrameOfReference
+        size_t j = 0;
+        for(; (i + j) < entries.size() && leaf.hasRoomFor(entries[i + j].key); ++j)
         {
             leaf.insertKeyAt(j, entries[i + j].key);
             leaf.insertValueAt(j, entries[i + j].blockRBN);
         }
+        i += j;
         // Update prev rbn
         if(!leafRBNs.empty())
             leaf.setPrevLeafRBN(leafRBNs.back());
@@ -360,27 +433,31 @@ std::vector<uint32_t> BPlusTreeAlt::buildIndexLevel(const std::vector<uint32_t>&
 {
     // Create parent rbn vector
     std::vector<uint32_t> parentRBNs;
-    // Calculate max keys per node
-    size_t maxKeys = NodeAlt::calculateMaxKeys(blockSize, false);
-    // For i in childRBN size increment by max keys + 1
-    for(size_t i = 0; i < childRBNs.size(); i += (maxKeys + 1))
+    // For i in childRBN size increment by the children each node took
+    size_t i = 0;
+    while(i < childRBNs.size())
     {
         // Create empty index node
-        NodeAlt indexNode(false, blockSize);
+        NodeAlt indexNode(false, nodeSize, keyEncoding);
         // Insert child rbn to first index at i
         indexNode.insertChildRBN(0, childRBNs[i]);
         // Start at second index
-        for(size_t j = 1; j <= maxKeys && (i + j) < childRBNs.size(); ++j)
+        size_t j = 1;
+        for(; (i + j) < childRBNs.size(); ++j)
         {
             // Load child node from file
             NodeAlt* childNode = loadNode(childRBNs[i + j - 1]);
             // Get promote key from child node
             uint32_t childPromoteKey = childNode->getKeyAt(childNode->getKeyCount() - 1);
             delete childNode;
+            // Stop once the separator no longer fits
+            if(!indexNode.hasRoomFor(childPromoteKey))
+                break;
             // Insert seperator key into it's correct up and adjacent position
             indexNode.insertKeyAt(j - 1, childPromoteKey);
             indexNode.insertChildRBN(j, childRBNs[i + j]);
         }
+        i += j;
         // Allocate new parent block
         uint32_t parentRBN = allocateTreeBlock();
         // Write the newly created block
@@ -433,16 +510,13 @@ bool BPlusTreeAlt::insert(uint32_t key, uint32_t blockRBN)
     uint32_t newSplitKey = 0;
     uint32_t newRightChildRBN = 0;
 
-    // Prepare to rewrite header
-    BPlusTreeHeaderBufferAlt headerBuffer;
-
     // Handle emptry tree
     if (treeHeader.getRootIndexRBN() == 0)
     {
         // Allocate new block
         uint32_t newRBN = allocateTreeBlock(); 
         // Create leaf node
-        NodeAlt* newRoot = new NodeAlt(true, treeHeader.getBlockSize());
+        NodeAlt* newRoot = new NodeAlt(true, treeHeader.getBlockSize(), keyEncoding);
         
         if (newRoot == nullptr)
         {
@@ -471,17 +545,18 @@ bool BPlusTreeAlt::insert(uint32_t key, uint32_t blockRBN)
         // newPromotedKey is the key to insert into the new root/parent
         bool splitOccurred = insertRecursive(oldRootRBN, key, blockRBN, newRightChildRBN,newSplitKey);
 
-        // Insert worked update header
+        // Insert worked, header is written on sync or close
         if (!splitOccurred)
         {
-            return headerBuffer.writeHeader(indexPageBuffer.getFileStream(), treeHeader);
+            headerDirty = true;
+            return true;
         }
         
         // Split occurred
         // Allocate new node
         uint32_t newRootRBN = allocateTreeBlock();
         // Create new index node
-        NodeAlt* newRoot = new NodeAlt(false, treeHeader.getBlockSize());
+        NodeAlt* newRoot = new NodeAlt(false, treeHeader.getBlockSize(), keyEncoding);
 
         if (newRoot == nullptr)
         {
@@ -507,8 +582,9 @@ bool BPlusTreeAlt::insert(uint32_t key, uint32_t blockRBN)
         delete newRoot;
     }
 
-    // Rewrite header
-    return headerBuffer.writeHeader(indexPageBuffer.getFileStream(), treeHeader);
+    // Header is rewritten once on sync or close instead of after every insert
+    headerDirty = true;
+    return true;
 }
 
 uint32_t BPlusTreeAlt::splitNode(uint32_t nodeRBN, uint32_t& promotedKey)
@@ -523,7 +599,7 @@ uint32_t BPlusTreeAlt::splitNode(uint32_t nodeRBN, uint32_t& promotedKey)
     // Allocate new node for split
     uint32_t newRBN = allocateTreeBlock();
     // Create new node for split
-    NodeAlt* newNode = new NodeAlt(node->isLeafNode() == 1, blockSize);
+    NodeAlt* newNode = new NodeAlt(node->isLeafNode() == 1, nodeSize, keyEncoding);
     // Get the split index 
     size_t splitIndex = (node->getKeyCount() + 1) / 2;
     // If leaf node
@@ -611,7 +687,7 @@ bool BPlusTreeAlt::insertRecursive(uint32_t nodeRBN, uint32_t key, uint32_t valu
     if(node->isLeafNode() == 1)
     {
         // Room to insert
-        if(!node->isFull())
+        if(node->hasRoomFor(key))
         {
             insertIntoLeaf(node, key, value);
             writeNode(nodeRBN, *node);
@@ -658,7 +734,7 @@ bool BPlusTreeAlt::insertRecursive(uint32_t nodeRBN, uint32_t key, uint32_t valu
         // Load original node
         node = loadNode(nodeRBN);
         // If not full after split instert
-        if(!node->isFull())
+        if(node->hasRoomFor(childPromotedKey))
         {
             insertIntoIndex(node, childPromotedKey, newGrandChildRBN);
             writeNode(nodeRBN, *node);
@@ -881,7 +957,7 @@ bool BPlusTreeAlt::mergeWithSibling(uint32_t nodeRBN, uint32_t parentRBN, size_t
         // Get start index of values
         // size_t startIndex = node->getKeyCount();
         // Chceck right sibling loaded and there is room in the node
-        if(rightSibling != nullptr && (node->getKeyCount() + rightSibling->getKeyCount()) <= node->getMaxKeys())
+        if(rightSibling != nullptr && node->canMergeWith(*rightSibling))
         {   // Merge keys and values
             for(size_t i = 0; i < rightSibling->getKeyCount(); ++i)
             {
@@ -941,7 +1017,7 @@ bool BPlusTreeAlt::mergeWithSibling(uint32_t nodeRBN, uint32_t parentRBN, size_t
             // Get start index
             //size_t leftStartIndex = leftSibling->getKeyCount();
             // If left sibling not null and has room to merge
-            if(leftSibling != nullptr && (node->getKeyCount() + leftSibling->getKeyCount()) <= node->getMaxKeys())
+            if(leftSibling != nullptr && leftSibling->canMergeWith(*node))
             {   // Move data from node to left sibling
                 for(size_t i = 0; i < node->getKeyCount(); ++i)
                 {
@@ -1000,7 +1076,7 @@ bool BPlusTreeAlt::mergeWithSibling(uint32_t nodeRBN, uint32_t parentRBN, size_t
                 uint32_t separatorKey = parent->getKeyAt(indexInParent);
 
                 // Check if room for adjacent keys and separator key
-                if(rightSibling != nullptr && node->getKeyCount() + rightSibling->getKeyCount() + 1 <= node->getMaxKeys())
+                if(rightSibling != nullptr && node->canMergeWith(*rightSibling, 1, separatorKey))
                 {
                     // Add separator key to the node at the end of keys
                     node->insertKeyAt(node->getKeyCount(), separatorKey);
@@ -1045,7 +1121,7 @@ bool BPlusTreeAlt::mergeWithSibling(uint32_t nodeRBN, uint32_t parentRBN, size_t
                 // Get separator key
                 uint32_t separatorKey = parent->getKeyAt(indexInParent - 1);
                 // If left sibling is valid and there is room to merge
-                if(leftSibling != nullptr && node->getKeyCount() + leftSibling->getKeyCount() + 1 <= node->getMaxKeys())
+                if(leftSibling != nullptr && leftSibling->canMergeWith(*node, 1, separatorKey))
                 {
                     // Insert separator key
                     leftSibling->insertKeyAt(leftSibling->getKeyCount(), separatorKey);
@@ -1143,36 +1219,25 @@ bool BPlusTreeAlt::mergeWithSibling(uint32_t nodeRBN, uint32_t parentRBN, size_t
 
 uint32_t BPlusTreeAlt::searchRecursive(uint32_t nodeRBN, uint32_t key)
 {
-    // Load node
-    NodeAlt* node = loadNode(nodeRBN);
-    if(node == nullptr)
+    // Read node page
+    std::vector<uint8_t> buffer;
+    if(!readPage(nodeRBN, buffer))
     {
         setError("Failed to load root node in searchRecursive.");
         return 0;
     }
+    NodePage node(buffer);
 
-    size_t i = 0;
     // Find starting index for key
-    while(i < node->getKeyCount() && key > node->getKeyAt(i))
-    {
-        ++i;
-    }
+    size_t i = node.lowerBound(key);
     // If leaf node return the RBN the key resides in
-    if(node->isLeafNode() == 1)
+    if(node.isLeaf())
     {
-        uint32_t resultRBN = 0;
-        if(i < node->getKeyCount() && node->getKeyAt(i) == key)
-        {
-            resultRBN = nodeRBN;
-        }
-       delete node;
-       return resultRBN;
+        return (i < node.getKeyCount() && node.getKeyAt(i) == key) ? nodeRBN : 0;
     }
     else
     {   // If index node is found get the next RBN
-        uint32_t nextRBN = node->getChildRBN(i);
-        // Clean
-        delete node;
+        uint32_t nextRBN = node.getChildRBN(i);
         // Verify it is a valid next RBN
         if(nextRBN == 0)
         {
@@ -1397,32 +1462,23 @@ std::vector<uint32_t> BPlusTreeAlt::searchRange(const uint32_t keyStart, const u
 
 uint32_t BPlusTreeAlt::rangeSearch(uint32_t nodeRBN, uint32_t key)
 {
-    // Load initial node
-    NodeAlt* node = loadNode(nodeRBN);
-    if(node == nullptr)
+    // Read initial node page
+    std::vector<uint8_t> buffer;
+    if(!readPage(nodeRBN, buffer))
     {
         setError("Failed to load root node in searchRecursive.");
         return 0;
     }
+    NodePage node(buffer);
 
-    size_t i = 0;
-    // Find start index
-    while(i < node->getKeyCount() && key > node->getKeyAt(i))
-    {
-        ++i;
-    }
     // If leaf node starting point found
-    if(node->isLeafNode() == 1)
+    if(node.isLeaf())
     {
-        uint32_t resultRBN = nodeRBN;
-        delete node;
-        return resultRBN;
+        return nodeRBN;
     }
     else
-    {   // Move onto next child rbn
-        uint32_t nextRBN = node->getChildRBN(i);
-        // Clean
-        delete node;
+    {   // Move onto next child rbn, under the first key not below the start
+        uint32_t nextRBN = node.getChildRBN(node.lowerBound(key));
         // If end is reached exit
         if(nextRBN == 0)
         {
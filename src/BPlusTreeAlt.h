@@ -6,10 +6,12 @@
 #include "BPlusTreeHeaderBufferAlt.h"
 #include "NodeAlt.h"
 #include "PageBufferAlt.h"
+#include "CacheManager.h"
 #include <string>
 #include <cstdint>
 #include <iostream>
 #include <vector>
+#include <memory>
 
 // Structure representing a b plus tree index entry.
 struct IndexEntry
@@ -39,9 +41,37 @@ public:
      * @brief Opens the index file and sequence set file while setting up all necessary buffers and dependencies.
      * @param indexFileName The name of the index file that will be created or updated.
      * @param sequenceSetFilename The name of the sequence set file the index was or will be built from.
+     * @param directIO True to read and write index pages bypassing the kernel page cache. The index
+     *                 header and block size must be padded to BlockFile::DIRECT_IO_ALIGNMENT.
      * @return True if the files were opened successfully and all buffers were initialized.
      */
-    bool open(const std::string& indexFileName, const std::string& sequenceSetFilename);
+    bool open(const std::string& indexFileName, const std::string& sequenceSetFilename,
+              const bool directIO = false);
+    /**
+     * @brief Puts the index pages and sequence set blocks under one shared memory budget.
+     * @details Inner nodes are cached at IndexInner priority so they stay resident while leaves
+     *          and data blocks cycle through the rest of the budget. May be called before or after open.
+     * @param manager The manager, owned by the caller and outliving the tree. nullptr detaches.
+     */
+    void attachCache(CacheManager* manager);
+    /**
+     * @brief Chooses which reads of a checksummed index and sequence set check the CRC32C trailer.
+     * @details Applies to both buffers. Has no effect on files without checksums.
+     * @param policy The verify policy, FirstRead by default.
+     */
+    void setVerifyPolicy(BlockChecksum::VerifyPolicy policy);
+    /**
+     * @brief Chooses how nodes the tree writes store their keys.
+     * @details FrameOfReference packs keys as offsets from the smallest key of each node, so more
+     *          entries fit a page and large trees need fewer levels. Set it before buildFromSequenceSet.
+     *          Opening a tree that has a root takes the encoding of the root page.
+     * @param encoding The key encoding, Full by default.
+     */
+    void setKeyEncoding(KeyEncoding encoding);
+    /**
+     * @brief Gets how nodes the tree writes store their keys.
+     */
+    KeyEncoding getKeyEncoding() const;
     /**
      * @brief Checks if the B+ tree index file is open.
      * @return True if the file is open.
@@ -136,12 +166,19 @@ public:
      */
     void close();
 
+    /**
+     * @brief Writes the tree header and every dirty index page without closing.
+     * @return True if successful.
+     */
+    bool sync();
+
     //void convertIndexToBPlusTree(const std::vector<BlockIndexFile::IndexEntry>& indexEntries, const std::string& bPlusTreeFileName, uint32_t blockSize);
 
 private:
     bool isOpen; // Is the B+ tree file open (redundant with PageBufferAlt?)
     bool errorState; // Error state flag
     bool isStale; // Indicates if the B+ tree is stale
+    bool headerDirty; // Tree header changed since it was last written
 
     std::string errorMessage; // Stores the last error encountered.
     std::string sequenceSetFilename;
@@ -151,11 +188,22 @@ private:
     BPlusTreeHeaderAlt treeHeader; // Stored for necessary index realted metadata
     HeaderRecord sequenceHeader; // Stored for necessary sequence set related metadata
 
+    std::unique_ptr<BlockCache> sequenceSetCache; // View of the shared manager, declared first so it outlives sequenceSetBuffer
     PageBufferAlt indexPageBuffer; // Buffer for index file pages
     BlockBuffer sequenceSetBuffer; // Buffer for sequence set blocks
 
     uint32_t sequenceHeaderSize; // Cahced header size for convenience
     uint32_t blockSize; // Cahced block size for convenience
+    uint32_t nodeSize; // Bytes of a page a node may fill, blockSize less any checksum trailer
+    KeyEncoding keyEncoding; // Layout of the keys in the nodes the tree writes
+
+    /**
+     * @brief Reads the page of a node without unpacking it, for searches that use a NodePage view.
+     * @param rbn The B+ tree rbn of the node.
+     * @param page [OUT] The packed page.
+     * @return False if the page could not be read.
+     */
+    bool readPage(uint32_t rbn, std::vector<uint8_t>& page);
 
     /**
      * @brief Given a valid node rbn this function loads an active node from the B+ tree file.
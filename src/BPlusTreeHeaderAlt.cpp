@@ -2,7 +2,7 @@
 #include <cstring>
 
 BPlusTreeHeaderAlt::BPlusTreeHeaderAlt() : blockedFileName(""), height(0), rootIndexRBN(0),
-    headerSize(0), indexStartRBN(0), indexBlockCount(0), blockSize(0)
+    headerSize(0), indexStartRBN(0), indexBlockCount(0), blockSize(0), headerAlignment(1)
 {
 }
 
@@ -20,6 +20,16 @@ void BPlusTreeHeaderAlt::setHeaderSize(const uint32_t inHeaderSize)
     this->headerSize = inHeaderSize;
 }
 
+void BPlusTreeHeaderAlt::setHeaderAlignment(const uint32_t alignment)
+{
+    this->headerAlignment = alignment == 0 ? 1 : alignment;
+}
+
+uint32_t BPlusTreeHeaderAlt::getHeaderAlignment() const
+{
+    return headerAlignment;
+}
+
 void BPlusTreeHeaderAlt::setHeight(const uint32_t inHeight)
 {
     this->height = inHeight;
@@ -119,6 +129,9 @@ std::vector<uint8_t> BPlusTreeHeaderAlt::serialize()
     data.insert(data.end(), reinterpret_cast<const uint8_t*>(&blockSize),
                 reinterpret_cast<const uint8_t*>(&blockSize) + sizeof(blockSize));
 
+    // Pad so the first index block starts on an aligned offset
+    data.resize((data.size() + headerAlignment - 1) / headerAlignment * headerAlignment, 0);
+
      // Calculate Header Size
     uint32_t trueHeaderSize = data.size();
     memcpy(&data[headerSizePos], &trueHeaderSize, sizeof(trueHeaderSize));
@@ -164,5 +177,9 @@ BPlusTreeHeaderAlt BPlusTreeHeaderAlt::deserialize(const uint8_t* data)
     memcpy(&bHeader.blockSize, data + offset, sizeof(uint32_t));
     offset += sizeof(uint32_t);
 
+    // Anything past the fields is padding, keep it so a rewrite doesn't move the blocks
+    if (bHeader.headerSize > offset)
+        bHeader.headerAlignment = bHeader.headerSize;
+
     return bHeader;
 }
\ No newline at end of file
@@ -81,6 +81,19 @@ public:
      * @returns the size of the header
      */
     uint32_t getHeaderSize() const;
+    /**
+     * @brief Set Header Alignment
+     * @details Serialize pads the header up to a multiple of alignment so the first index block
+     *          starts on an aligned offset for direct I/O. A padded header read back keeps its size.
+     * @param alignment the alignment in bytes, 0 or 1 for no padding
+     */
+    void setHeaderAlignment(const uint32_t alignment);
+    /**
+     * @brief Get Header Alignment
+     * @details Gets the alignment the header is padded to
+     * @returns the header alignment in bytes
+     */
+    uint32_t getHeaderAlignment() const;
 
     /**
      * @brief Set Index Start RBN
@@ -131,6 +144,7 @@ private:
     uint32_t indexStartRBN; // First RBN used for index blocks
     uint32_t indexBlockCount; // Number of index blocks allocated
     uint32_t blockSize; // Block size (must match sequence set)
+    uint32_t headerAlignment; // Serialized size is padded to a multiple of this, not stored
 };
 
 #endif // BPLUSTREEHEADERALT_H
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "stdint.h"
 #include <vector>
 #include <cstddef>
+#include <cstring>
+#include <algorithm>
 
 struct ActiveBlock
 {
@@ -13,16 +15,19 @@ struct ActiveBlock
     std::vector<char> data; // Raw Block Data
     size_t getTotalSize() const 
     {
-        // Find first padding byte (0xFF)
+        // Find first padding byte (0xFF), skipping whole words of padding at a time.
+        // Callers that change records should track sizes with a BlockOccupancy instead.
         size_t actualDataSize = data.size();
-        for(size_t i = data.size(); i > 0; --i)
-         {
-            if(data[i-1] != '\xFF') 
-            {
-                actualDataSize = i;
+        while(actualDataSize >= sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, &data[actualDataSize - sizeof(uint64_t)], sizeof(word));
+            if(word != UINT64_MAX)
                 break;
-            }
+            actualDataSize -= sizeof(uint64_t);
         }
+        while(actualDataSize > 0 && data[actualDataSize - 1] == '\xFF')
+            --actualDataSize;
         return 10 + actualDataSize;  // Metadata + actual data (no padding)
     }
 };
@@ -38,4 +43,71 @@ struct AvailBlock
     }
 };
 
+/**
+ * @brief Reusable, aligned buffer holding one raw block image as it appears on disk.
+ * @details Allocate once and pass to BlockBuffer::readBlockImageAtRBN / writeBlockImageAtRBN
+ *          for every block, so loading or storing a block does not touch the heap.
+ */
+class BlockImage
+{
+public:
+    static const size_t DEFAULT_ALIGNMENT = 4096; // Page alignment, also satisfies O_DIRECT
+
+    explicit BlockImage(size_t size = 0, size_t alignment = DEFAULT_ALIGNMENT)
+        : storage(), offset(0), length(0), alignment(alignment == 0 ? 1 : alignment)
+    {
+        resize(size);
+    }
+
+    // Copies need their own aligned window, the storage address changes
+    BlockImage(const BlockImage& other)
+        : storage(), offset(0), length(0), alignment(other.alignment)
+    {
+        resize(other.length);
+        std::copy(other.data(), other.data() + other.length, data());
+    }
+
+    BlockImage& operator=(const BlockImage& other)
+    {
+        if (this != &other)
+        {
+            alignment = other.alignment;
+            storage.clear();
+            resize(other.length);
+            std::copy(other.data(), other.data() + other.length, data());
+        }
+        return *this;
+    }
+
+    // Moving the vector keeps its heap buffer, so the offset stays valid
+    BlockImage(BlockImage&& other) = default;
+    BlockImage& operator=(BlockImage&& other) = default;
+
+    /**
+     * @brief Resizes the image. Only reallocates when growing past the current capacity.
+     * @param size New size in bytes.
+     */
+    void resize(size_t size)
+    {
+        if (size + alignment - 1 > storage.size())
+        {
+            storage.assign(size + alignment - 1, 0);
+            size_t address = reinterpret_cast<size_t>(storage.data());
+            offset = (alignment - address % alignment) % alignment;
+        }
+        length = size;
+    }
+
+    char* data() { return storage.data() + offset; }
+    const char* data() const { return storage.data() + offset; }
+    size_t size() const { return length; }
+    size_t getAlignment() const { return alignment; }
+
+private:
+    std::vector<char> storage; // Over-allocated so an aligned window of length bytes fits
+    size_t offset; // Start of the aligned window inside storage
+    size_t length; // Usable bytes
+    size_t alignment; // Alignment of data()
+};
+
 #endif
\ No newline at end of file
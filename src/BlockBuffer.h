@@ -7,7 +7,15 @@
 #include <fstream>
 #include <algorithm>
 #include "RecordBuffer.h"
+#include "BlockOccupancy.h"
 #include "ZipCodeRecord.h"
+#include "BlockCache.h"
+#include "BlockFile.h"
+#include "BlockReadEngine.h"
+#include "BlockChecksum.h"
+#include "BlockCodec.h"
+#include <functional>
+#include <map>
 
 struct SplitInfo
 {
@@ -25,9 +33,46 @@ struct MergeInfo
     uint32_t mergedBlockHighestKey = 0;
 };
 
+struct SequenceScanStats
+{
+    uint64_t blocksVisited = 0; // Blocks returned by the walk
+    uint64_t physicalReads = 0; // Read calls issued, each covering a run of adjacent blocks
+    uint64_t prefetchHits = 0; // Blocks served from an earlier readahead window
+    uint64_t inPhysicalOrder = 0; // Steps where succeedingRBN was the next physical block
+
+    /**
+     * @brief Fraction of chain steps that moved to the physically next block.
+     * @return 1.0 for a freshly converted file, lower as splits scatter the chain.
+     */
+    double getPhysicalOrderRatio() const
+    {
+        return blocksVisited > 1 ? static_cast<double>(inPhysicalOrder) / (blocksVisited - 1) : 1.0;
+    }
+};
+
 class BlockBuffer
 {
     public:
+        /**
+         * @brief Access hint passed to madvise for a memory mapped file.
+         */
+        enum class AccessPattern
+        {
+            Normal, // No hint
+            Sequential, // Walking the sequence set, read ahead aggressively
+            Random // Point lookups, don't read ahead
+        };
+
+        /**
+         * @brief What the cache frames of a compressed file hold.
+         */
+        enum class CacheForm
+        {
+            Decompressed, // Block images, decoded once when they come from the file
+            Compressed, // Stored forms in frames cut to size, decoded on every access
+            Auto // Compressed when the file is larger than the cache budget
+        };
+
         /**
          * @brief Default constructor
          */
@@ -39,10 +84,192 @@ class BlockBuffer
 
         /**
          * @brief Open file for reading
+         * @details In direct mode block transfers bypass the kernel page cache, so the block cache
+         *          is the only copy of hot blocks; give it a budget that fits the working set. The
+         *          header must be padded to BlockFile::DIRECT_IO_ALIGNMENT and the block size should
+         *          be a multiple of it, other block sizes work but every transfer is bounced.
          * @param filename [IN] Path to block file
+         * @param headerSize The size of the file header
+         * @param directIO True to bypass the kernel page cache where supported
          * @return True if file opened successfully
          */
-        bool openFile(const std::string& filename, const size_t headerSize);
+        bool openFile(const std::string& filename, const size_t headerSize, const bool directIO = false);
+
+        /**
+         * @brief Checks if block transfers bypass the kernel page cache
+         * @return True if opened in direct mode and the file system supports it
+         */
+        bool isDirectIO() const;
+
+        /**
+         * @brief Requires the page aligned layout of HeaderRecord::ALIGNED_LAYOUT_VERSION files
+         * @details Opening then fails for a header size that is not a multiple of the alignment, and
+         *          block transfers fail for block sizes that are not powers of two, so every block
+         *          lies within one page. Call before openFile, usually with the header's
+         *          getLayoutAlignment().
+         * @param alignment Page or sector size in bytes, 0 to accept any layout
+         */
+        void setLayoutAlignment(const uint32_t alignment);
+
+        /**
+         * @brief Gets the required layout alignment
+         * @return Alignment in bytes, 0 if any layout is accepted
+         */
+        uint32_t getLayoutAlignment() const;
+
+        /**
+         * @brief Reserves a CRC32C trailer at the end of every block
+         * @details For files whose header has HeaderRecord::CHECKSUM_CRC32C. Every block written is
+         *          stamped, reads are checked as the verify policy says, and records only fill
+         *          getPayloadSize(blockSize) bytes. Call before the first block transfer.
+         * @param enabled True for checksummed files
+         */
+        void setChecksums(const bool enabled);
+
+        /**
+         * @brief Checks if blocks carry a checksum trailer
+         * @return True if setChecksums(true) was called
+         */
+        bool hasChecksums() const;
+
+        /**
+         * @brief Chooses which reads check the trailer
+         * @details FirstRead, the default, checks a block when it is read from the file into the
+         *          cache and trusts the frame afterwards. A mapped file or a read that bypasses the
+         *          cache has nothing to remember, so every such read counts as a first read.
+         * @param policy The verify policy
+         */
+        void setVerifyPolicy(const BlockChecksum::VerifyPolicy policy);
+
+        /**
+         * @brief Gets the verify policy
+         * @return The policy in use
+         */
+        BlockChecksum::VerifyPolicy getVerifyPolicy() const;
+
+        /**
+         * @brief Gets the checksum counters
+         * @return Copy of the counters
+         */
+        BlockChecksum::Stats getChecksumStats() const;
+
+        /**
+         * @brief Resets the checksum counters
+         */
+        void resetChecksumStats();
+
+        /**
+         * @brief Compresses blocks with a codec on their way to the file
+         * @details For files whose header has HeaderRecord::COMPRESSION_LZ. Blocks are stored in the
+         *          BlockCodec frame and records only fill getPayloadSize(blockSize) bytes. With
+         *          BlockCodec::Type::None blocks are stored exactly as they are packed. Call before
+         *          the first block transfer.
+         * @param type The codec
+         * @return False for an unknown codec, which leaves compression off
+         */
+        bool setCompression(const BlockCodec::Type type);
+
+        /**
+         * @brief Gets the codec blocks are stored with
+         * @return BlockCodec::Type::None if compression is off
+         */
+        BlockCodec::Type getCompression() const;
+
+        /**
+         * @brief Chooses what the cache frames of a compressed file hold
+         * @details Compressed frames fit more blocks in the same budget but decode a block on every
+         *          access; Auto picks them only when the file would not fit decompressed. The form
+         *          is kept per file by the cache, so buffers sharing a cache share it too. Takes
+         *          effect at the next block transfer and is ignored without compression.
+         * @param form The frame form
+         * @param fileBytes Block bytes of the file, used by Auto
+         */
+        void setCacheForm(const CacheForm form, const uint64_t fileBytes = 0);
+
+        /**
+         * @brief Checks if the cache frames currently hold stored forms
+         * @return True once a compressed file has bound the cache with compressed frames
+         */
+        bool hasCompressedCache() const;
+
+        /**
+         * @brief Gets the compression counters
+         * @return Copy of the counters
+         */
+        BlockCodec::Stats getCompressionStats() const;
+
+        /**
+         * @brief Resets the compression counters
+         */
+        void resetCompressionStats();
+
+        /**
+         * @brief Gets the bytes of a block available to metadata and records
+         * @param blockSize The size of blocks in the file
+         * @return blockSize less the checksum trailer and the compression frame, if any
+         */
+        size_t getPayloadSize(const uint32_t blockSize) const;
+
+        /**
+         * @brief Selects how records are encoded in block data
+         * @details Use RecordBuffer::encodingOf(header). Blocks of one file all share the
+         *          encoding, so set it before the first block is packed or unpacked.
+         * @param encoding Text or Binary
+         */
+        void setRecordEncoding(const RecordEncoding encoding);
+
+        /**
+         * @brief Gets the record encoding
+         * @return The encoding in use
+         */
+        RecordEncoding getRecordEncoding() const;
+
+        /**
+         * @brief Selects how binary records store their coordinates
+         * @details Use RecordBuffer::coordinateFormatOf(header), set alongside the record encoding.
+         * @param coordinates Degrees or MicroDegrees
+         */
+        void setCoordinateFormat(const CoordinateFormat coordinates);
+
+        /**
+         * @brief Gets the coordinate format
+         * @return The format in use
+         */
+        CoordinateFormat getCoordinateFormat() const;
+
+        /**
+         * @brief Open file read-only by memory mapping it
+         * @details Blocks are served straight from the mapping, no seek or read per block.
+         *          Writes fail while mapped. Falls back to openFile where mmap is unavailable.
+         * @param filename [IN] Path to block file
+         * @param headerSize The size of the file header
+         * @param pattern Access hint for the mapping
+         * @return True if file opened successfully
+         */
+        bool openFileMapped(const std::string& filename, const size_t headerSize,
+                            const AccessPattern pattern = AccessPattern::Normal);
+
+        /**
+         * @brief Checks if the file is open as a read-only mapping
+         * @return True if memory mapped
+         */
+        bool isMapped() const;
+
+        /**
+         * @brief Changes the access hint of a mapped file
+         * @param pattern The new access hint
+         * @return True if the hint was applied
+         */
+        bool adviseAccessPattern(const AccessPattern pattern);
+
+        /**
+         * @brief Gets a pointer to a whole block inside the mapping
+         * @param rbn The RBN of the block
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @return Pointer to blockSize bytes, or nullptr if not mapped, out of range or compressed
+         */
+        const char* mapBlockAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize) const;
 
         /**
          * @brief Check if there is more data in the file
@@ -86,6 +313,47 @@ class BlockBuffer
         bool writeAvailBlockAtRBN(const uint32_t rbn, const uint32_t blockSize,
                                    const size_t headerSize, const AvailBlock& block);
 
+        /**
+         * @brief Rewrites only the 10 byte metadata region of an active block
+         * @details The payload is neither read nor rewritten. A cached copy is patched in place,
+         *          otherwise just the metadata bytes go to the file.
+         * @param rbn The RBN of the block to update
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param recordCount New record count
+         * @param precedingRBN New preceding link
+         * @param succeedingRBN New succeeding link
+         * @return True if the update was written
+         */
+        bool writeActiveBlockHeaderAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                         const uint16_t recordCount, const uint32_t precedingRBN,
+                                         const uint32_t succeedingRBN);
+
+        /**
+         * @brief Rewrites only the precedingRBN link of an active block
+         * @details Used to relink a neighbour after a split or merge without loading it.
+         * @param rbn The RBN of the block to update
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param precedingRBN New preceding link
+         * @return True if the update was written
+         */
+        bool writePrecedingRBNAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                    const uint32_t precedingRBN);
+
+        /**
+         * @brief Rewrites only the 6 byte metadata region of an available block
+         * @details The rest of the block keeps whatever it held before, readers of avail blocks
+         *          only look at the metadata.
+         * @param rbn The RBN of the block to update
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param block The AvailBlock whose recordCount and succeedingRBN are written
+         * @return True if the update was written
+         */
+        bool writeAvailBlockHeaderAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                        const AvailBlock& block);
+
         /**
          * @brief Attempts to remove a ZipCodeRecord from a block at a specific RBN
          * @details Finds the correct block by RBN and removes the record if found
@@ -136,13 +404,58 @@ class BlockBuffer
          * @brief getter for memory offset.
          * @return memory offset.
          */
-        size_t getMemoryOffset();
+        uint64_t getMemoryOffset();
 
         /**
          * @brief Close the currently opened file.
+         * @details Dirty cached blocks are written back before the file is closed.
          */
         void closeFile();
 
+        /**
+         * @brief Writes every dirty cached block back to the file.
+         * @details All dirty blocks go out in one batch, physically adjacent ones with a single call.
+         * @return True if all dirty blocks were written.
+         */
+        bool flush();
+
+        /**
+         * @brief Starts holding blocks that bypass the cache until commitWriteBatch.
+         * @details Blocks that get a cache frame are written back on flush as usual. Blocks written
+         *          through the scratch image (no free frame, or a zero capacity cache) are kept and
+         *          submitted together, so a split or merge writes its two or three blocks at once.
+         *          Batches nest, only the outermost commit writes.
+         */
+        void beginWriteBatch();
+
+        /**
+         * @brief Ends a write batch, submitting the held blocks when it is the outermost one.
+         * @return True if every held block was written.
+         */
+        bool commitWriteBatch();
+
+        /**
+         * @brief Shares a block cache between several BlockBuffers.
+         * @details The cache keeps its frames while it stays bound to the same file, so hot blocks
+         *          survive across buffers that are opened and closed per operation. Passing nullptr
+         *          returns to the buffer's own cache. Any dirty blocks are flushed before switching.
+         * @param sharedCache The cache to use, owned by the caller and outliving this buffer.
+         */
+        void attachCache(BlockCache* sharedCache);
+
+        /**
+         * @brief Gets the hit/miss counters of the cache in use.
+         * @return Copy of the cache counters.
+         */
+        BlockCache::Stats getCacheStats() const;
+
+        /**
+         * @brief Gets the number of writes submitted to the file since construction.
+         * @details A single block, a metadata patch and a whole write batch each count once.
+         * @return Write submission count.
+         */
+        uint64_t getWriteSubmissionCount() const;
+
         /**
          * @brief Dumps the physical order of blocks in the file to standard output.
          * @param out [IN] Output stream to write to.
@@ -198,6 +511,88 @@ class BlockBuffer
          */
         ActiveBlock loadActiveBlockAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize);
 
+        /**
+         * @brief Loads an active block from the RBN into an existing block
+         * @details Reuses the capacity of outBlock.data, so a block reused across calls
+         *          costs no heap allocation per load.
+         * @param rbn The RBN of the block to load
+         * @param outBlock [OUT] The block to populate
+         * @return True if the block was loaded
+         */
+        bool loadActiveBlockAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                  ActiveBlock& outBlock);
+
+        /**
+         * @brief Called for each block of a batched load.
+         * @param index Position of the block's RBN in the requested list.
+         * @param block The loaded block, only valid during the call.
+         */
+        typedef std::function<void(size_t index, const ActiveBlock& block)> BlockVisitor;
+
+        /**
+         * @brief Loads a list of active blocks with every cold read submitted at once
+         * @details Blocks already cached or mapped are visited first, the rest are read in parallel
+         *          by the shared BlockReadEngine and visited as they complete, so the visitor sees
+         *          blocks in completion order. Use index to restore the requested order.
+         * @param rbns The RBNs to load
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param visitor Called on this thread once per block that was loaded
+         * @return True if every block was loaded
+         */
+        bool visitActiveBlocksAtRBNs(const std::vector<uint32_t>& rbns, const uint32_t blockSize,
+                                     const size_t headerSize, const BlockVisitor& visitor);
+
+        /**
+         * @brief Reads a run of physically adjacent blocks with a single read
+         * @details Cached frames override the file, so blocks not yet flushed are returned current.
+         *          Compressed blocks are decoded in place.
+         * @param firstRBN The RBN of the first block in the run
+         * @param count The number of blocks to read
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param dest [OUT] Buffer of at least count * blockSize bytes
+         * @return Number of blocks read, fewer than count at the end of the file
+         */
+        uint32_t readBlockRunAtRBN(const uint32_t firstRBN, const uint32_t count, const uint32_t blockSize,
+                                   const size_t headerSize, char* dest);
+
+        /**
+         * @brief Unpacks a raw block image into an ActiveBlock, reusing its data capacity
+         * @param image Raw block of blockSize bytes
+         * @param blockSize The size of blocks in the file
+         * @param block [OUT] The block to populate
+         */
+        void imageToActiveBlock(const char* image, const uint32_t blockSize, ActiveBlock& block) const;
+
+        /**
+         * @brief Gets the readahead statistics of the last dumpLogicalOrder walk
+         * @return Copy of the scan statistics
+         */
+        SequenceScanStats getLastScanStats() const;
+
+        /**
+         * @brief Copies the raw block image at the RBN into a caller buffer
+         * @param rbn The RBN of the block to read
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param image [OUT] Buffer of at least blockSize bytes
+         * @return True if the block was read
+         */
+        bool readBlockImageAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                 char* image);
+
+        /**
+         * @brief Stores a raw block image from a caller buffer at the RBN
+         * @param rbn The RBN of the block to write
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param image [IN] Buffer of blockSize bytes, already laid out and padded
+         * @return True if the block was written
+         */
+        bool writeBlockImageAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                  const char* image);
+
         /**
          * @brief Loads an available block from the RBN
          * @details Creates a local AvailBlock to populate with data from the specified RBN in the file
@@ -215,7 +610,8 @@ class BlockBuffer
     private:
         uint32_t recordsProcessed; // Number of records processed from input stream
         uint32_t blocksProcessed; // Number of blocks processed from input stream
-        std::fstream blockFile; // Input file stream
+        BlockFile blockFile; // Positional (pread/pwrite) file handle
+        uint64_t fileOffset; // Byte offset just past the last block transferred
         std::string lastError; // Last Error Message
         bool errorState; // Has the Buffer encountered a critical error
         bool mergeOccurred; // Tracks if a merge occurred during last remove operation. Likely temporary
@@ -224,6 +620,241 @@ class BlockBuffer
 
         SplitInfo lastSplit;
         MergeInfo mergeInfo;
+        SequenceScanStats lastScanStats;
+
+        std::string fileName; // Path of the open file, used to bind the cache
+        BlockCache ownCache; // Cache used when no shared cache is attached
+        BlockCache* cache; // Cache in use, either ownCache or a shared one
+        bool writeBackInstalled; // This buffer's handler writes the cache's evicted dirty blocks
+        BlockImage scratch; // Block image used when the cache has no free frame
+        BlockImage batchImages; // Landing area for batched reads, reused between batches
+        const char* mappedData; // Read-only mapping of the whole file, nullptr when not mapped
+        size_t mappedSize; // Length of the mapping in bytes
+        uint32_t layoutAlignment; // Page boundary blocks must not straddle, 0 for any layout
+        uint32_t trailerSize; // Checksum bytes at the end of each block, 0 without checksums
+        BlockChecksum::VerifyPolicy verifyPolicy; // Which reads check the trailer
+        BlockChecksum::Stats checksumStats; // Trailers checked and failed
+        const BlockCodec* codec; // Codec of the stored blocks, nullptr when stored as packed
+        CacheForm cacheForm; // Requested form of the cache frames
+        uint64_t cacheFormFileBytes; // File size Auto compares with the cache budget
+        BlockCodec::Stats compressionStats; // Blocks encoded and decoded
+        BlockImage storedImage; // Stored form of a block on its way to or from the file
+
+        /**
+         * @brief An uncached block image held by an open write batch.
+         * @details A metadata patch of a block nobody else holds is kept the same way, with only
+         *          the patched bytes in image. Whole images are exactly blockSize long.
+         */
+        struct PendingWrite
+        {
+            uint64_t offset; // Absolute file offset of the block, or of the patch
+            BlockImage image; // The block as it will be written, or the patched bytes
+            BlockImage stored; // Its stored form, compressed files only
+            size_t storedLength; // Bytes of stored in use
+        };
+
+        int writeBatchDepth; // Open beginWriteBatch calls
+        std::map<uint32_t, PendingWrite> pendingWrites; // RBN -> held image, newer than the file
+        uint64_t writeSubmissions; // Writes submitted to blockFile, a batch counts once
+
+        /**
+         * @brief Checks if the file is open through either the stream or the mapping
+         * @return True if open
+         */
+        bool isOpen() const;
+
+        /**
+         * @brief Gets a read-only block image from the mapping or the cache
+         * @details Release with releaseBlock(rbn, blockSize, headerSize, cached, false).
+         * @return Pointer to blockSize bytes, or nullptr on error.
+         */
+        const char* fetchBlock(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                               bool& cached);
+
+        /**
+         * @brief Checks a block size against the required layout, setting the error if it breaks it.
+         * @return True if no layout is required or the block size is a power of two.
+         */
+        bool checkLayout(const uint32_t blockSize);
+
+        /**
+         * @brief Checks if reads from the file or the mapping have to check the trailer.
+         * @return True with checksums on and a policy other than Never.
+         */
+        bool verifiesReads() const;
+
+        /**
+         * @brief Checks a block against its trailer, counting the result.
+         * @details Sets the error on a mismatch.
+         * @return True if the trailer matches.
+         */
+        bool verifyImage(const uint32_t rbn, const char* image, const uint32_t blockSize);
+
+        /**
+         * @brief Writes the trailer of a block image, if the file has checksums.
+         * @details A compressed file's frame reserve is filled first, so the trailer covers what
+         *          decoding gives back.
+         */
+        void stampImage(char* image, const uint32_t blockSize) const;
+
+        /**
+         * @brief Checks if the cache frames of the bound file hold stored forms.
+         */
+        bool usesCompressedFrames() const;
+
+        /**
+         * @brief Resolves the requested cache form for the bound file and applies it.
+         */
+        void applyCacheForm(const uint32_t blockSize);
+
+        /**
+         * @brief Builds the stored form of a block image, counting it.
+         * @return Stored size.
+         */
+        size_t encodeImage(const char* image, const uint32_t blockSize, char* stored);
+
+        /**
+         * @brief Rebuilds a block image from its stored form, counting it.
+         * @details Sets the error if the stored block does not decode.
+         * @param available Bytes readable at stored.
+         * @return True if decoded.
+         */
+        bool decodeImage(const uint32_t rbn, const char* stored, const size_t available,
+                         const uint32_t blockSize, char* image);
+
+        /**
+         * @brief Pins a block of a file whose frames hold stored forms.
+         * @details The block is decoded into the scratch image, the frame keeps the stored form.
+         *          Same contract as pinBlock.
+         */
+        char* pinCompressedBlock(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                                 const bool loadFromFile, bool& cached);
+
+        /**
+         * @brief Encodes the scratch image into the pinned compressed frame of a block.
+         * @details A frame that cannot grow to the new stored size is unpinned and discarded.
+         * @return True if the frame holds the block, false if the caller must write it itself.
+         */
+        bool storeCompressedFrame(const uint32_t rbn, const uint32_t blockSize);
+
+        /**
+         * @brief Removes this buffer's write back handler from the cache, if it installed one.
+         */
+        void releaseWriteBack();
+
+        /**
+         * @brief Gets a block image, from the cache if possible.
+         * @details The image is pinned until releaseBlock is called.
+         * @param rbn The RBN of the block.
+         * @param blockSize The size of blocks in the file.
+         * @param headerSize The size of the file header.
+         * @param loadFromFile True to fill the image from the file on a miss, false if the caller
+         *                     overwrites the whole image.
+         * @param cached [OUT] True if the image is a cache frame, false if it is the scratch image.
+         * @return Pointer to blockSize bytes, or nullptr on error.
+         */
+        char* pinBlock(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                       const bool loadFromFile, bool& cached);
+
+        /**
+         * @brief Releases an image returned by pinBlock.
+         * @details Dirty cache frames are written back later, a dirty scratch image immediately.
+         * @param rbn The RBN of the block.
+         * @param blockSize The size of blocks in the file.
+         * @param headerSize The size of the file header.
+         * @param cached Value returned by pinBlock.
+         * @param dirty True if the image was modified.
+         * @return True if successful.
+         */
+        bool releaseBlock(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                          const bool cached, const bool dirty);
+
+        /**
+         * @brief Reads a whole block image from the file.
+         * @details A short read at the end of the file is padded with 0xFF.
+         * @return True if at least the block metadata was read.
+         */
+        bool readBlockFromFile(const uint32_t rbn, const uint32_t blockSize,
+                               const size_t headerSize, char* image);
+
+        /**
+         * @brief Reads the stored form of a block from the file.
+         * @param stored [OUT] blockSize bytes.
+         * @return Bytes read, or -1 with the error set if not even the metadata was there.
+         */
+        long long readStoredBlock(const uint32_t rbn, const uint32_t blockSize,
+                                  const size_t headerSize, char* stored);
+
+        /**
+         * @brief Writes a whole block image to the file, compressed if the file is.
+         * @return True if successful.
+         */
+        bool writeBlockToFile(const uint32_t rbn, const uint32_t blockSize,
+                              const size_t headerSize, const char* image);
+
+        /**
+         * @brief Writes the stored form of a block to the file.
+         * @param length Stored size, blockSize for an uncompressed file.
+         * @return True if successful.
+         */
+        bool writeStoredBlock(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                              const char* stored, const size_t length);
+
+        /**
+         * @brief Frees the whole pages of a block slot past its stored form.
+         * @details Only for page aligned layouts, where the pages belong to the block alone.
+         * @param offset Absolute file offset of the block.
+         * @param length Stored size.
+         */
+        void releaseSlack(const uint64_t offset, const size_t length, const uint32_t blockSize);
+
+        /**
+         * @brief Overwrites a few bytes of a block without touching the rest of it
+         * @details Patches the cache frame or the batched image when one holds the block, otherwise
+         *          writes only those bytes to the file.
+         * @param rbn The RBN of the block
+         * @param blockSize The size of blocks in the file
+         * @param headerSize The size of the file header
+         * @param offsetInBlock Byte position of the patch inside the block
+         * @param bytes The new bytes
+         * @param length Number of bytes, offsetInBlock + length must fit in the block
+         * @return True if the patch was applied
+         */
+        bool patchBlockAtRBN(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                             const size_t offsetInBlock, const char* bytes, const size_t length);
+
+        /**
+         * @brief Holds a metadata patch in the open write batch instead of writing it
+         * @details Widens a patch already held for the block, unless the two would leave a gap.
+         * @return True if held, false if the caller has to write the bytes itself
+         */
+        bool holdPatch(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                       const size_t offsetInBlock, const char* bytes, const size_t length);
+
+        /**
+         * @brief Copies a patch held by the write batch over an image of the block read from the file
+         * @param image Decoded image of the block, blockSize bytes
+         */
+        void applyHeldPatch(const uint32_t rbn, const uint32_t blockSize, const size_t headerSize,
+                            char* image) const;
+
+        /**
+         * @brief Describes every block held by the write batch as a write segment
+         * @return One segment per held block or patch, pointing into pendingWrites
+         */
+        std::vector<BlockFile::WriteSegment> getPendingSegments() const;
+
+        /**
+         * @brief addRecord without the surrounding write batch
+         */
+        bool addRecordToBlock(const uint32_t rbn, const uint32_t blockSize, uint32_t& availListRBN,
+                              const ZipCodeRecord& record, const size_t headerSize, uint32_t& blockCount);
+
+        /**
+         * @brief removeRecordAtRBN without the surrounding write batch
+         */
+        bool removeRecordFromBlock(const uint32_t rbn, const uint16_t minBlockSize, uint32_t& availListRBN,
+                                   const uint32_t zipCode, const uint32_t blockSize, const size_t headerSize);
 
         /**
          * @brief Allocates a new block at the end of the file
@@ -249,15 +880,39 @@ class BlockBuffer
          */
         void setError(const std::string& message); 
 
+        /**
+         * @brief Inserts a record into a loaded block in key order, after any equal keys
+         * @details The occupancy decides whether it fits, then the bytes of the block shift in place.
+         *          Dictionary blocks are repacked, since a new state or county string moves every record.
+         * @param block [IN,OUT] The block, its record count follows
+         * @param records [IN,OUT] The block's records in key order
+         * @param occupancy [IN,OUT] The block's occupancy
+         * @param record [IN] Record to insert
+         * @param blockSize The size of blocks in the file
+         * @return False if the record does not fit, the block is left as it was
+         */
+        bool insertIntoBlock(ActiveBlock& block, std::vector<ZipCodeRecord>& records, BlockOccupancy& occupancy,
+                             const ZipCodeRecord& record, const uint32_t blockSize);
+
+        /**
+         * @brief Removes a record from a loaded block, see insertIntoBlock
+         * @param index Position of the record, the first of its zip code if repeated
+         * @return False if the block does not hold the record
+         */
+        bool removeFromBlock(ActiveBlock& block, std::vector<ZipCodeRecord>& records, BlockOccupancy& occupancy,
+                             const size_t index, const uint32_t blockSize);
+
         bool tryBorrowFromPreceding(ActiveBlock& block, ActiveBlock& precedingBlock,
                            std::vector<ZipCodeRecord>& records,
                            std::vector<ZipCodeRecord>& precedingRecords,
+                           BlockOccupancy& occupancy, BlockOccupancy& precedingOccupancy,
                            const uint32_t blockSize, const uint16_t minBlockSize,
                            const size_t headerSize, const uint32_t rbn);
 
         bool tryBorrowFromSucceeding(ActiveBlock& block, ActiveBlock& succeedingBlock,
                                     std::vector<ZipCodeRecord>& records,
                                     std::vector<ZipCodeRecord>& succeedingRecords,
+                                    BlockOccupancy& occupancy, BlockOccupancy& succeedingOccupancy,
                                     const uint32_t blockSize, const uint16_t minBlockSize,
                                     const size_t headerSize, const uint32_t rbn);
 };
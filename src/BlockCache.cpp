@@ -0,0 +1,170 @@
+#include "BlockCache.h"
+
+BlockCache::BlockCache(size_t capacity)
+    : capacity(capacity), ownManager(0), manager(&ownManager), priority(CacheManager::Priority::Data),
+      fileId(CacheManager::NO_FILE), bound(false)
+{
+}
+
+BlockCache::BlockCache(CacheManager& shared, CacheManager::Priority priority)
+    : capacity(0), ownManager(0), manager(&shared), priority(priority),
+      fileId(CacheManager::NO_FILE), bound(false)
+{
+}
+
+BlockCache::~BlockCache()
+{
+    if (bound)
+        manager->setWriteBackHandler(fileId, WriteBackHandler());
+}
+
+void BlockCache::bind(const std::string& filename, uint32_t blockSize, size_t headerSize)
+{
+    if (isBoundTo(filename, blockSize, headerSize))
+        return; // Same file layout, keep the warm frames
+
+    if (manager == &ownManager)
+    {
+        clear();
+        fileId = ownManager.registerFile(filename, blockSize, headerSize);
+        ownManager.setByteBudget(static_cast<uint64_t>(capacity) * blockSize);
+    }
+    else
+    {
+        if (bound)
+            manager->setWriteBackHandler(fileId, WriteBackHandler());
+        fileId = manager->registerFile(filename, blockSize, headerSize);
+    }
+    bound = true;
+}
+
+bool BlockCache::isBoundTo(const std::string& filename, uint32_t blockSize, size_t headerSize) const
+{
+    return bound && manager->isRegisteredAs(fileId, filename, blockSize, headerSize);
+}
+
+void BlockCache::clear()
+{
+    if (bound)
+    {
+        manager->setWriteBackHandler(fileId, WriteBackHandler());
+        manager->dropFile(fileId);
+    }
+    bound = false;
+}
+
+void BlockCache::setWriteBackHandler(const WriteBackHandler& handler)
+{
+    if (bound)
+        manager->setWriteBackHandler(fileId, handler);
+}
+
+char* BlockCache::pin(uint32_t rbn)
+{
+    return bound ? manager->pin(fileId, rbn) : nullptr;
+}
+
+bool BlockCache::isResident(uint32_t rbn) const
+{
+    return bound && manager->isResident(fileId, rbn);
+}
+
+char* BlockCache::claim(uint32_t rbn)
+{
+    return bound ? manager->claim(fileId, rbn, priority) : nullptr;
+}
+
+char* BlockCache::resize(uint32_t rbn, size_t bytes)
+{
+    return bound ? manager->resize(fileId, rbn, bytes) : nullptr;
+}
+
+void BlockCache::unpin(uint32_t rbn, bool dirty)
+{
+    if (bound)
+        manager->unpin(fileId, rbn, dirty);
+}
+
+void BlockCache::discard(uint32_t rbn)
+{
+    if (bound)
+        manager->discard(fileId, rbn);
+}
+
+std::vector<uint32_t> BlockCache::getDirtyRBNs() const
+{
+    return bound ? manager->getDirtyRBNs(fileId) : std::vector<uint32_t>();
+}
+
+const char* BlockCache::peek(uint32_t rbn) const
+{
+    return bound ? manager->peek(fileId, rbn) : nullptr;
+}
+
+void BlockCache::markClean(uint32_t rbn)
+{
+    if (bound)
+        manager->markClean(fileId, rbn);
+}
+
+BlockCache::Stats BlockCache::getStats() const
+{
+    return manager->getStats(fileId);
+}
+
+void BlockCache::resetStats()
+{
+    manager->resetStats(fileId);
+}
+
+size_t BlockCache::getCapacity() const
+{
+    if (manager == &ownManager)
+        return capacity;
+    uint32_t blockSize = getBlockSize();
+    return blockSize == 0 ? 0 : static_cast<size_t>(manager->getByteBudget() / blockSize);
+}
+
+uint32_t BlockCache::getBlockSize() const
+{
+    return bound ? manager->getBlockSize(fileId) : 0;
+}
+
+size_t BlockCache::getHeaderSize() const
+{
+    return bound ? manager->getHeaderSize(fileId) : 0;
+}
+
+void BlockCache::setCapacity(size_t capacity)
+{
+    if (manager != &ownManager)
+        return;
+
+    this->capacity = capacity;
+    if (bound)
+    {
+        ownManager.dropFile(fileId);
+        ownManager.setByteBudget(static_cast<uint64_t>(capacity) * getBlockSize());
+    }
+}
+
+void BlockCache::setCompressedFrames(bool compressed)
+{
+    if (bound)
+        manager->setCompressedFrames(fileId, compressed);
+}
+
+bool BlockCache::hasCompressedFrames() const
+{
+    return bound && manager->hasCompressedFrames(fileId);
+}
+
+size_t BlockCache::getResidentCount() const
+{
+    return bound ? manager->getResidentCount(fileId) : 0;
+}
+
+CacheManager& BlockCache::getManager()
+{
+    return *manager;
+}
@@ -0,0 +1,223 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include "stdint.h"
+#include "Block.h"
+#include "CacheManager.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/**
+ * @file BlockCache.h
+ * @author Group 2
+ * @brief Buffer pool view for the sequence set blocks of one file
+ * @version 0.2
+ * @date 2026-10-17
+ */
+
+/**
+ * @class BlockCache
+ * @brief Block sized frames with pin/unpin, dirty tracking and CLOCK eviction for one bound file.
+ * @details The cache holds block images, or with compressed frames the stored form of each block
+ *          in a frame cut to its size. It does no I/O itself, the owning BlockBuffer reads a block
+ *          into a claimed frame on a miss and registers a handler that writes out dirty victims. A single cache may be attached to several
+ *          BlockBuffers on the same file so hot blocks survive the buffers being opened and closed.
+ *          Frames start on a page boundary, so with a sector-multiple block size they can be handed
+ *          to a direct I/O BlockFile as they are.
+ *          The frames live in a CacheManager. A standalone cache owns one sized to capacity frames;
+ *          a cache built on a shared manager draws from that manager's byte budget alongside the
+ *          index pages and any other files.
+ */
+class BlockCache
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 64; // Frames held when no capacity is given
+
+    typedef CacheManager::Stats Stats; // Hit and miss counters used to size the cache for a query mix
+    typedef CacheManager::WriteBackHandler WriteBackHandler; // Writes an evicted dirty block
+
+    /**
+     * @brief Constructor for a standalone cache.
+     * @param capacity Number of frames the cache may hold. Zero disables caching.
+     */
+    explicit BlockCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Constructor for a view on a shared manager.
+     * @param shared Manager holding the frames. Must outlive the cache.
+     * @param priority Eviction resistance of the blocks cached through this view.
+     */
+    explicit BlockCache(CacheManager& shared, CacheManager::Priority priority = CacheManager::Priority::Data);
+
+    /**
+     * @brief Destructor
+     */
+    ~BlockCache();
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /**
+     * @brief Binds the cache to a file and block size.
+     * @details Frames are kept if the file and block size match the current binding. A standalone
+     *          cache drops every frame otherwise. Callers must flush dirty frames before rebinding.
+     * @param filename The file the cached blocks belong to.
+     * @param blockSize The size of each block in bytes.
+     * @param headerSize The size of the file header in bytes.
+     */
+    void bind(const std::string& filename, uint32_t blockSize, size_t headerSize);
+
+    /**
+     * @brief Checks if the cache is bound to the given file layout.
+     * @return True if filename, block size and header size all match the current binding.
+     */
+    bool isBoundTo(const std::string& filename, uint32_t blockSize, size_t headerSize) const;
+
+    /**
+     * @brief Drops every frame of the bound file and the binding.
+     */
+    void clear();
+
+    /**
+     * @brief Sets the handler that writes back dirty blocks evicted to make room.
+     * @details Without a handler dirty frames are only written by the owner's flush.
+     * @param handler The handler, empty to clear it.
+     */
+    void setWriteBackHandler(const WriteBackHandler& handler);
+
+    /**
+     * @brief Looks up a block and pins its frame.
+     * @details Counts a hit or a miss.
+     * @param rbn The RBN of the block.
+     * @return Pointer to the frame data, or nullptr if the block is not resident.
+     */
+    char* pin(uint32_t rbn);
+
+    /**
+     * @brief Checks if a block is resident without touching the counters or reference bits.
+     * @param rbn The RBN of the block.
+     * @return True if the block has a frame.
+     */
+    bool isResident(uint32_t rbn) const;
+
+    /**
+     * @brief Claims a frame for a block that is not resident and pins it.
+     * @details Picks victims with the CLOCK algorithm and writes dirty ones back through the
+     *          write back handler of the file they belong to. The frame contents are undefined.
+     * @param rbn The RBN of the block that will occupy the frame.
+     * @return Pointer to the frame data, or nullptr if every frame is pinned.
+     */
+    char* claim(uint32_t rbn);
+
+    /**
+     * @brief Changes the size of a pinned frame, keeping its leading bytes.
+     * @param rbn The RBN of the pinned block.
+     * @param bytes New frame size.
+     * @return Pointer to the frame data, which may move, or nullptr if the frame could not grow.
+     */
+    char* resize(uint32_t rbn, size_t bytes);
+
+    /**
+     * @brief Unpins a frame.
+     * @param rbn The RBN of the pinned block.
+     * @param dirty True if the frame was modified and must be written back.
+     */
+    void unpin(uint32_t rbn, bool dirty);
+
+    /**
+     * @brief Removes a block from the cache without writing it back.
+     * @param rbn The RBN of the block.
+     */
+    void discard(uint32_t rbn);
+
+    /**
+     * @brief Collects the RBNs of every dirty frame.
+     * @return Dirty RBNs in ascending order.
+     */
+    std::vector<uint32_t> getDirtyRBNs() const;
+
+    /**
+     * @brief Gets read access to a resident frame without pinning it.
+     * @param rbn The RBN of the block.
+     * @return Pointer to the frame data, or nullptr if not resident.
+     */
+    const char* peek(uint32_t rbn) const;
+
+    /**
+     * @brief Clears the dirty bit of a resident frame after it has been written.
+     * @param rbn The RBN of the block.
+     */
+    void markClean(uint32_t rbn);
+
+    /**
+     * @brief Gets the hit/miss counters of the bound file.
+     * @return Copy of the current counters.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Resets the hit/miss counters.
+     */
+    void resetStats();
+
+    /**
+     * @brief Gets the number of frames.
+     * @return The frame capacity. For a shared manager, the blocks of this size its budget holds.
+     */
+    size_t getCapacity() const;
+
+    /**
+     * @brief Gets the block size of the bound file.
+     * @return Bytes per frame, zero if unbound.
+     */
+    uint32_t getBlockSize() const;
+
+    /**
+     * @brief Gets the header size of the bound file.
+     * @return Header size in bytes, zero if unbound.
+     */
+    size_t getHeaderSize() const;
+
+    /**
+     * @brief Changes the number of frames of a standalone cache. Drops every frame, flush dirty
+     *        frames first. A view on a shared manager is sized by the manager's byte budget instead.
+     * @param capacity New frame count. Zero disables caching.
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief Chooses between block image and compressed frames for the bound file.
+     * @details Shared by every view of the file. A change drops its frames, flush dirty frames first.
+     * @param compressed True for frames holding the stored form.
+     */
+    void setCompressedFrames(bool compressed);
+
+    /**
+     * @brief Checks if the frames of the bound file hold the compressed stored form.
+     * @return False if unbound.
+     */
+    bool hasCompressedFrames() const;
+
+    /**
+     * @brief Gets the number of frames currently holding a block.
+     * @return Resident block count.
+     */
+    size_t getResidentCount() const;
+
+    /**
+     * @brief Gets the manager holding the frames.
+     * @return The shared manager, or the cache's own one.
+     */
+    CacheManager& getManager();
+
+private:
+    size_t capacity; // Frame budget of a standalone cache
+    CacheManager ownManager; // Frame store of a standalone cache, unused by a view
+    CacheManager* manager; // Frame store in use, ownManager or a shared one
+    CacheManager::Priority priority; // Eviction resistance of the blocks claimed here
+    uint32_t fileId; // Registration of the bound file, NO_FILE before the first bind
+    bool bound; // False after clear() until the next bind
+};
+
+#endif // BLOCK_CACHE_H
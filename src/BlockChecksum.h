@@ -0,0 +1,82 @@
+#ifndef BLOCK_CHECKSUM_H
+#define BLOCK_CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @file BlockChecksum.h
+ * @author Group 2
+ * @brief CRC32C trailers for sequence set blocks and index pages
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class BlockChecksum
+ * @brief Computes, stamps and checks the CRC32C trailer kept in the last bytes of a block.
+ * @details The trailer covers every byte of the block before it. On x86-64 the SSE4.2 crc32
+ *          instruction is used when the CPU has it, chosen once at run time, so one binary runs
+ *          everywhere; other targets use a table driven version of the same polynomial.
+ */
+class BlockChecksum
+{
+public:
+    static const uint32_t TRAILER_SIZE = 4; // Bytes of CRC at the end of a checksummed block
+
+    /**
+     * @brief When a buffer checks the trailer of a block it reads.
+     */
+    enum class VerifyPolicy : uint8_t
+    {
+        Always, // Every read, cache hits included
+        FirstRead, // Only when the block comes from the file into the buffer pool
+        Never // Trailers are written but not checked
+    };
+
+    /**
+     * @brief Verification counters kept by a buffer.
+     */
+    struct Stats
+    {
+        uint64_t verified = 0; // Trailers checked
+        uint64_t failures = 0; // Trailers that did not match
+    };
+
+    /**
+     * @brief Computes the CRC32C (Castagnoli) of a byte range.
+     * @param data The bytes.
+     * @param length Number of bytes.
+     * @param crc CRC of the bytes before this range, 0 to start.
+     * @return The CRC.
+     */
+    static uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+    /**
+     * @brief Software version of crc32c, for comparison with the hardware path.
+     */
+    static uint32_t crc32cPortable(const void* data, size_t length, uint32_t crc = 0);
+
+    /**
+     * @brief Writes the CRC of the first blockSize - TRAILER_SIZE bytes into the trailer.
+     * @param image The block image.
+     * @param blockSize Bytes in the block, trailer included.
+     */
+    static void stamp(char* image, size_t blockSize);
+
+    /**
+     * @brief Checks a block against its trailer.
+     * @param image The block image.
+     * @param blockSize Bytes in the block, trailer included.
+     * @return True if the trailer matches.
+     */
+    static bool verify(const char* image, size_t blockSize);
+
+    /**
+     * @brief Checks if crc32c runs on the SSE4.2 instruction.
+     * @return True on x86-64 CPUs with SSE4.2.
+     */
+    static bool isHardwareAccelerated();
+};
+
+#endif // BLOCK_CHECKSUM_H
@@ -0,0 +1,290 @@
+#include "BlockCodec.h"
+#include "HeaderRecord.h"
+#include <cstring>
+
+namespace
+{
+    const uint32_t HASH_BITS = 12; // 4096 entry match table
+    const size_t MAX_INPUT = 65535; // Positions and offsets are kept in 16 bits
+    const uint8_t RUN_MASK = 15; // Nibble value that continues in extension bytes
+
+    inline uint32_t read32(const char* bytes)
+    {
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hashOf(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    /**
+     * @brief Writes the extension bytes of a length that overflowed its nibble.
+     * @return False if the output is full.
+     */
+    inline bool writeLength(size_t length, char* dst, size_t& op, size_t capacity)
+    {
+        while (length >= 255)
+        {
+            if (op >= capacity)
+                return false;
+            dst[op++] = static_cast<char>(255);
+            length -= 255;
+        }
+        if (op >= capacity)
+            return false;
+        dst[op++] = static_cast<char>(length);
+        return true;
+    }
+
+    /**
+     * @brief Reads the extension bytes of a length whose nibble was RUN_MASK.
+     * @return False if the input ends inside the length.
+     */
+    inline bool readLength(const unsigned char* src, size_t& ip, size_t length, size_t& value)
+    {
+        unsigned char byte;
+        do
+        {
+            if (ip >= length)
+                return false;
+            byte = src[ip++];
+            value += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    /**
+     * @brief Emits one sequence, literals then an optional match.
+     * @param matchLength Match length, 0 for the last sequence.
+     * @return False if the output is full.
+     */
+    bool writeSequence(const char* literals, size_t literalCount, size_t offset, size_t matchLength,
+                       char* dst, size_t& op, size_t capacity)
+    {
+        size_t matchCode = matchLength > 0 ? matchLength - LZBlockCodec::MIN_MATCH : 0;
+        if (op >= capacity)
+            return false;
+        size_t token = op++;
+        dst[token] = static_cast<char>(((literalCount < RUN_MASK ? literalCount : RUN_MASK) << 4) |
+                                       (matchCode < RUN_MASK ? matchCode : RUN_MASK));
+        if (literalCount >= RUN_MASK && !writeLength(literalCount - RUN_MASK, dst, op, capacity))
+            return false;
+        if (capacity - op < literalCount)
+            return false;
+        memcpy(dst + op, literals, literalCount);
+        op += literalCount;
+        if (matchLength == 0)
+            return true;
+
+        if (capacity - op < 2)
+            return false;
+        dst[op++] = static_cast<char>(offset & 0xFF);
+        dst[op++] = static_cast<char>(offset >> 8);
+        return matchCode < RUN_MASK || writeLength(matchCode - RUN_MASK, dst, op, capacity);
+    }
+}
+
+size_t BlockCodec::getReserveOffset(uint32_t blockSize, uint32_t trailerSize)
+{
+    return blockSize - trailerSize - FRAME_HEADER_SIZE;
+}
+
+size_t BlockCodec::getStoredSize(const char* stored, uint32_t blockSize)
+{
+    uint16_t bodyLength;
+    memcpy(&bodyLength, stored + METADATA_SIZE, sizeof(bodyLength));
+    return bodyLength == 0 ? blockSize : METADATA_SIZE + FRAME_HEADER_SIZE + bodyLength;
+}
+
+size_t BlockCodec::encodeBlock(const char* image, uint32_t blockSize, uint32_t trailerSize, char* stored) const
+{
+    const size_t bodyStart = METADATA_SIZE + FRAME_HEADER_SIZE;
+    const size_t bodyLength = blockSize - METADATA_SIZE;
+    memcpy(stored, image, METADATA_SIZE);
+
+    // Only a body that saves at least a byte, and whose length fits the frame, is kept compressed
+    size_t capacity = blockSize - bodyStart - 1;
+    if (capacity > 65535)
+        capacity = 65535;
+    uint16_t compressed = static_cast<uint16_t>(compress(image + METADATA_SIZE, bodyLength, stored + bodyStart, capacity));
+    memcpy(stored + METADATA_SIZE, &compressed, sizeof(compressed));
+    if (compressed > 0)
+        return bodyStart + compressed;
+
+    // Raw: the payload slides over the reserve, the trailer stays where it is
+    const size_t reserve = getReserveOffset(blockSize, trailerSize);
+    memcpy(stored + bodyStart, image + METADATA_SIZE, reserve - METADATA_SIZE);
+    memcpy(stored + reserve + FRAME_HEADER_SIZE, image + reserve + FRAME_HEADER_SIZE, trailerSize);
+    return blockSize;
+}
+
+bool BlockCodec::decodeBlock(const char* stored, size_t available, uint32_t blockSize, uint32_t trailerSize,
+                             char* image) const
+{
+    const size_t bodyStart = METADATA_SIZE + FRAME_HEADER_SIZE;
+    if (available < bodyStart)
+        return false;
+    const size_t storedSize = getStoredSize(stored, blockSize);
+    if (storedSize > available || storedSize > blockSize)
+        return false;
+
+    if (storedSize < blockSize)
+    {
+        if (!decompress(stored + bodyStart, storedSize - bodyStart, image + METADATA_SIZE, blockSize - METADATA_SIZE))
+            return false;
+        memcpy(image, stored, METADATA_SIZE);
+        return true;
+    }
+
+    const size_t reserve = getReserveOffset(blockSize, trailerSize);
+    memcpy(image, stored, METADATA_SIZE);
+    memcpy(image + METADATA_SIZE, stored + bodyStart, reserve - METADATA_SIZE);
+    memset(image + reserve, 0xFF, FRAME_HEADER_SIZE);
+    memcpy(image + reserve + FRAME_HEADER_SIZE, stored + reserve + FRAME_HEADER_SIZE, trailerSize);
+    return true;
+}
+
+BlockCodec::Type BlockCodec::typeOf(const HeaderRecord& header)
+{
+    return static_cast<Type>(header.getCompressionType());
+}
+
+const BlockCodec* BlockCodec::forType(Type type)
+{
+    static const NoCompressionCodec none;
+    static const LZBlockCodec lz;
+    switch (type)
+    {
+        case Type::None:
+            return &none;
+        case Type::LZ:
+            return &lz;
+        default:
+            return nullptr;
+    }
+}
+
+BlockCodec::Type NoCompressionCodec::getType() const
+{
+    return Type::None;
+}
+
+const char* NoCompressionCodec::getName() const
+{
+    return "none";
+}
+
+size_t NoCompressionCodec::compress(const char* src, size_t length, char* dst, size_t capacity) const
+{
+    if (length > capacity)
+        return 0;
+    memcpy(dst, src, length);
+    return length;
+}
+
+bool NoCompressionCodec::decompress(const char* src, size_t length, char* dst, size_t outLength) const
+{
+    if (length != outLength)
+        return false;
+    memcpy(dst, src, length);
+    return true;
+}
+
+BlockCodec::Type LZBlockCodec::getType() const
+{
+    return Type::LZ;
+}
+
+const char* LZBlockCodec::getName() const
+{
+    return "lz";
+}
+
+size_t LZBlockCodec::compress(const char* src, size_t length, char* dst, size_t capacity) const
+{
+    if (length > MAX_INPUT)
+        return 0;
+
+    uint16_t table[1u << HASH_BITS]; // Position + 1 of the last 4 bytes with each hash, 0 for none
+    memset(table, 0, sizeof(table));
+
+    size_t op = 0;
+    size_t anchor = 0; // First byte not yet emitted
+    size_t ip = 0;
+    size_t misses = 0;
+    while (ip + MIN_MATCH <= length)
+    {
+        uint32_t sequence = read32(src + ip);
+        uint32_t hash = hashOf(sequence);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint16_t>(ip + 1);
+        if (candidate == 0 || read32(src + candidate - 1) != sequence)
+        {
+            ip += 1 + (misses++ >> 6); // Step faster through bytes that keep failing to match
+            continue;
+        }
+        misses = 0;
+
+        size_t match = candidate - 1;
+        size_t matchLength = MIN_MATCH;
+        while (ip + matchLength < length && src[match + matchLength] == src[ip + matchLength])
+            ++matchLength;
+
+        if (!writeSequence(src + anchor, ip - anchor, ip - match, matchLength, dst, op, capacity))
+            return 0;
+        ip += matchLength;
+        anchor = ip;
+    }
+
+    if (anchor < length && !writeSequence(src + anchor, length - anchor, 0, 0, dst, op, capacity))
+        return 0;
+    return op;
+}
+
+bool LZBlockCodec::decompress(const char* src, size_t length, char* dst, size_t outLength) const
+{
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < length)
+    {
+        unsigned char token = in[ip++];
+
+        size_t literalCount = token >> 4;
+        if (literalCount == RUN_MASK && !readLength(in, ip, length, literalCount))
+            return false;
+        if (length - ip < literalCount || outLength - op < literalCount)
+            return false;
+        memcpy(dst + op, src + ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+        if (ip == length)
+            break; // The last sequence has no match
+
+        if (length - ip < 2)
+            return false;
+        size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+        ip += 2;
+        size_t matchLength = token & RUN_MASK;
+        if (matchLength == RUN_MASK && !readLength(in, ip, length, matchLength))
+            return false;
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > op || outLength - op < matchLength)
+            return false;
+
+        // An overlapping match repeats its first offset bytes; each copy doubles the repeated run
+        size_t copied = offset < matchLength ? offset : matchLength;
+        memcpy(dst + op, dst + op - offset, copied);
+        while (copied < matchLength)
+        {
+            size_t chunk = copied < matchLength - copied ? copied : matchLength - copied;
+            memcpy(dst + op + copied, dst + op, chunk);
+            copied += chunk;
+        }
+        op += matchLength;
+    }
+    return op == outLength;
+}
@@ -0,0 +1,177 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+
+class HeaderRecord;
+
+/**
+ * @file BlockCodec.h
+ * @author Group 2
+ * @brief Pluggable compression of sequence set blocks
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class BlockCodec
+ * @brief Turns a block image into the shorter form stored in the file, and back.
+ * @details A stored block keeps its 10 bytes of metadata as they are, so the count and RBN links can
+ *          still be patched in place, followed by a 2 byte body length and the compressed rest of
+ *          the image. A body that does not shrink is stored raw behind a zero length instead, in
+ *          exactly blockSize bytes. The image gives up the 2 bytes in front of its checksum trailer
+ *          for this, so its usable payload is FRAME_HEADER_SIZE smaller; the trailer is compressed
+ *          with the body and still checks the decoded image. Implementations are stateless and
+ *          shared, one per Type.
+ */
+class BlockCodec
+{
+public:
+    static const uint32_t METADATA_SIZE = 10; // Count, preceding and succeeding RBN, never compressed
+    static const uint32_t FRAME_HEADER_SIZE = 2; // Stored body length, 0 for a raw body
+
+    /**
+     * @brief Codec ids, as stored in the file header.
+     */
+    enum class Type : uint8_t
+    {
+        None = 0, // Blocks are stored as they are packed, no frame
+        LZ = 1 // Byte oriented LZ77, literal runs and back references
+    };
+
+    /**
+     * @brief Compression counters kept by a buffer.
+     */
+    struct Stats
+    {
+        uint64_t blocksEncoded = 0; // Blocks compressed on their way to the file or a compressed frame
+        uint64_t rawBlocks = 0; // Of those, blocks that did not shrink and were stored raw
+        uint64_t logicalBytes = 0; // Image bytes of the encoded blocks
+        uint64_t storedBytes = 0; // Stored bytes of the encoded blocks
+        uint64_t blocksDecoded = 0; // Stored blocks expanded back into images
+
+        /**
+         * @brief Stored size as a fraction of the image size.
+         * @return 1.0 when nothing was encoded, lower the better the codec did.
+         */
+        double getRatio() const
+        {
+            return logicalBytes > 0 ? static_cast<double>(storedBytes) / logicalBytes : 1.0;
+        }
+    };
+
+    virtual ~BlockCodec() {}
+
+    /**
+     * @brief Gets the id written to the file header.
+     */
+    virtual Type getType() const = 0;
+
+    /**
+     * @brief Gets the name tools print.
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Compresses a byte range.
+     * @param src The bytes.
+     * @param length Number of bytes, at most 65535.
+     * @param dst Output.
+     * @param capacity Bytes available at dst.
+     * @return Compressed size, 0 if it would not fit in capacity.
+     */
+    virtual size_t compress(const char* src, size_t length, char* dst, size_t capacity) const = 0;
+
+    /**
+     * @brief Expands the output of compress. Never reads or writes out of bounds on bad input.
+     * @param src The compressed bytes.
+     * @param length Number of compressed bytes.
+     * @param dst Output.
+     * @param outLength Exact size compress was given.
+     * @return True if the input decoded to exactly outLength bytes.
+     */
+    virtual bool decompress(const char* src, size_t length, char* dst, size_t outLength) const = 0;
+
+    /**
+     * @brief Builds the stored form of a block image.
+     * @param image The block image, its frame reserve filled with 0xFF.
+     * @param blockSize Bytes in the block, trailer included.
+     * @param trailerSize Bytes of checksum trailer at the end of the block, 0 for none.
+     * @param stored Output, blockSize bytes available.
+     * @return Stored size, blockSize for a raw body.
+     */
+    size_t encodeBlock(const char* image, uint32_t blockSize, uint32_t trailerSize, char* stored) const;
+
+    /**
+     * @brief Rebuilds the block image from its stored form.
+     * @param stored The stored block.
+     * @param available Bytes readable at stored, may be past the stored size.
+     * @param blockSize Bytes in the block, trailer included.
+     * @param trailerSize Bytes of checksum trailer at the end of the block, 0 for none.
+     * @param image Output, blockSize bytes, not overlapping stored.
+     * @return False if the body is cut short or does not decode.
+     */
+    bool decodeBlock(const char* stored, size_t available, uint32_t blockSize, uint32_t trailerSize,
+                     char* image) const;
+
+    /**
+     * @brief Gets the bytes a stored block occupies, from its frame header.
+     * @return METADATA_SIZE + FRAME_HEADER_SIZE + body length, blockSize for a raw body.
+     */
+    static size_t getStoredSize(const char* stored, uint32_t blockSize);
+
+    /**
+     * @brief Gets the offset of the frame reserve inside a block image.
+     * @return First byte after the usable payload.
+     */
+    static size_t getReserveOffset(uint32_t blockSize, uint32_t trailerSize);
+
+    /**
+     * @brief Gets the codec a blocked file declares
+     * @param header The file header
+     * @return The codec named by the compression type, None before HeaderRecord::COMPRESSION_VERSION
+     */
+    static Type typeOf(const HeaderRecord& header);
+
+    /**
+     * @brief Looks up the shared codec of a type.
+     * @return The codec, nullptr for an unknown type.
+     */
+    static const BlockCodec* forType(Type type);
+};
+
+/**
+ * @class NoCompressionCodec
+ * @brief The no-op codec. Copies bytes, so a framed block is always stored raw.
+ */
+class NoCompressionCodec : public BlockCodec
+{
+public:
+    Type getType() const override;
+    const char* getName() const override;
+    size_t compress(const char* src, size_t length, char* dst, size_t capacity) const override;
+    bool decompress(const char* src, size_t length, char* dst, size_t outLength) const override;
+};
+
+/**
+ * @class LZBlockCodec
+ * @brief Greedy LZ77 in the style of LZ4, tuned for blocks of a few KiB.
+ * @details Each sequence is a token byte, holding the literal count and the match length less
+ *          MIN_MATCH in its two nibbles with 255-continued extensions, then the literals, then a
+ *          2 byte offset back into the output. The last sequence has literals only. Matches are
+ *          found through a 4096 entry hash of the next 4 bytes; the 0xFF padding of a block
+ *          collapses into a single overlapping match.
+ */
+class LZBlockCodec : public BlockCodec
+{
+public:
+    static const size_t MIN_MATCH = 4; // Shortest back reference worth a token and an offset
+
+    Type getType() const override;
+    const char* getName() const override;
+    size_t compress(const char* src, size_t length, char* dst, size_t capacity) const override;
+    bool decompress(const char* src, size_t length, char* dst, size_t outLength) const override;
+};
+
+#endif // BLOCK_CODEC_H
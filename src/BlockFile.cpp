@@ -0,0 +1,376 @@
+#include "BlockFile.h"
+#include "Block.h"
+#include <cstring>
+#include <algorithm>
+
+#ifdef BLOCK_FILE_HAS_PREAD
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+bool BlockFile::isDirect() const
+{
+    return direct;
+}
+
+bool BlockFile::isAligned(const uint64_t offset, const void* buffer, const size_t length)
+{
+    return offset % DIRECT_IO_ALIGNMENT == 0 && length % DIRECT_IO_ALIGNMENT == 0
+        && reinterpret_cast<size_t>(buffer) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+size_t BlockFile::roundUpToSector(const size_t size)
+{
+    return (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+}
+
+bool BlockFile::writeBatch(std::vector<WriteSegment>& segments)
+{
+    std::sort(segments.begin(), segments.end(), [](const WriteSegment& a, const WriteSegment& b)
+    {
+        return a.offset < b.offset;
+    });
+
+    bool success = true;
+    size_t first = 0;
+    while (first < segments.size())
+    {
+        size_t last = first + 1;
+        while (last < segments.size() && segments[last - 1].offset + segments[last - 1].length == segments[last].offset)
+            ++last;
+
+#ifdef BLOCK_FILE_HAS_PREAD
+        if (!writeGathered(segments, first, last))
+            success = false;
+#else
+        for (size_t i = first; i < last; ++i)
+        {
+            if (!writeAt(segments[i].offset, segments[i].src, segments[i].length))
+                success = false;
+        }
+#endif
+        first = last;
+    }
+    return success;
+}
+
+#ifdef BLOCK_FILE_HAS_PREAD
+
+BlockFile::BlockFile() : direct(false), fd(-1)
+{
+}
+
+BlockFile::~BlockFile()
+{
+    close();
+}
+
+bool BlockFile::open(const std::string& filename, const bool readOnly, const bool directIO)
+{
+    close();
+    const int flags = readOnly ? O_RDONLY : O_RDWR;
+#ifdef O_DIRECT
+    if (directIO)
+    {
+        fd = ::open(filename.c_str(), flags | O_DIRECT);
+        direct = fd >= 0;
+        if (direct)
+            return true;
+        // tmpfs and some network file systems reject O_DIRECT, stay buffered there
+    }
+#endif
+    fd = ::open(filename.c_str(), flags);
+#ifdef F_NOCACHE
+    if (directIO && fd >= 0)
+        direct = fcntl(fd, F_NOCACHE, 1) == 0;
+#endif
+    return fd >= 0;
+}
+
+bool BlockFile::isOpen() const
+{
+    return fd >= 0;
+}
+
+void BlockFile::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    direct = false;
+}
+
+long long BlockFile::readAt(const uint64_t offset, char* dest, const size_t length) const
+{
+    if (fd < 0)
+        return -1;
+    if (direct && !isAligned(offset, dest, length))
+        return readBounced(offset, dest, length);
+    return readRaw(offset, dest, length);
+}
+
+bool BlockFile::writeAt(const uint64_t offset, const char* src, const size_t length)
+{
+    if (fd < 0)
+        return false;
+    if (direct && !isAligned(offset, src, length))
+        return writeBounced(offset, src, length);
+    return writeRaw(offset, src, length);
+}
+
+bool BlockFile::writeGathered(const std::vector<WriteSegment>& segments, size_t first, size_t last)
+{
+    if (fd < 0)
+        return false;
+
+    // Direct mode can only gather segments that are already aligned
+    bool aligned = true;
+    for (size_t i = first; i < last && direct; ++i)
+        aligned = aligned && isAligned(segments[i].offset, segments[i].src, segments[i].length);
+    if (!aligned || last - first == 1)
+    {
+        bool success = true;
+        for (size_t i = first; i < last; ++i)
+            success = writeAt(segments[i].offset, segments[i].src, segments[i].length) && success;
+        return success;
+    }
+
+    while (first < last)
+    {
+        const size_t count = std::min<size_t>(last - first, IOV_MAX);
+        std::vector<struct iovec> iov(count);
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            iov[i].iov_base = const_cast<char*>(segments[first + i].src);
+            iov[i].iov_len = segments[first + i].length;
+            total += segments[first + i].length;
+        }
+
+        ssize_t put = ::pwritev(fd, iov.data(), static_cast<int>(count), static_cast<off_t>(segments[first].offset));
+        if (put < 0 && errno == EINTR)
+            continue;
+        if (put < 0)
+            return false;
+
+        // Short write, finish the remainder one segment at a time
+        if (static_cast<size_t>(put) < total)
+        {
+            size_t done = static_cast<size_t>(put);
+            for (size_t i = first; i < first + count; ++i)
+            {
+                const WriteSegment& segment = segments[i];
+                if (done >= segment.length)
+                {
+                    done -= segment.length;
+                    continue;
+                }
+                if (!writeRaw(segment.offset + done, segment.src + done, segment.length - done))
+                    return false;
+                done = 0;
+            }
+        }
+        first += count;
+    }
+    return true;
+}
+
+long long BlockFile::readBounced(const uint64_t offset, char* dest, const size_t length) const
+{
+    const uint64_t start = offset / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    const size_t lead = static_cast<size_t>(offset - start);
+    BlockImage bounce(roundUpToSector(lead + length), DIRECT_IO_ALIGNMENT);
+
+    long long got = readRaw(start, bounce.data(), bounce.size());
+    if (got < 0)
+        return -1;
+    if (static_cast<size_t>(got) <= lead)
+        return 0;
+
+    size_t copied = std::min(length, static_cast<size_t>(got) - lead);
+    memcpy(dest, bounce.data() + lead, copied);
+    return static_cast<long long>(copied);
+}
+
+bool BlockFile::writeBounced(const uint64_t offset, const char* src, const size_t length)
+{
+    const uint64_t start = offset / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    const size_t lead = static_cast<size_t>(offset - start);
+    BlockImage bounce(roundUpToSector(lead + length), DIRECT_IO_ALIGNMENT);
+
+    // Keep the bytes around the range, past the end of the file they stay zero
+    const uint64_t oldSize = size();
+    if (readRaw(start, bounce.data(), bounce.size()) < 0)
+        return false;
+    memcpy(bounce.data() + lead, src, length);
+    if (!writeRaw(start, bounce.data(), bounce.size()))
+        return false;
+
+    // The last sector went out whole, trim anything written past the real end of the data
+    const uint64_t newSize = std::max<uint64_t>(oldSize, offset + length);
+    if (start + bounce.size() > newSize)
+        return ftruncate(fd, static_cast<off_t>(newSize)) == 0;
+    return true;
+}
+
+long long BlockFile::readRaw(const uint64_t offset, char* dest, const size_t length) const
+{
+    // pread may return short counts, keep going until EOF or the request is filled
+    size_t total = 0;
+    while (total < length)
+    {
+        ssize_t got = ::pread(fd, dest + total, length - total, static_cast<off_t>(offset + total));
+        if (got < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (got == 0)
+            break; // end of file
+        total += static_cast<size_t>(got);
+    }
+    return static_cast<long long>(total);
+}
+
+bool BlockFile::writeRaw(const uint64_t offset, const char* src, const size_t length)
+{
+    size_t total = 0;
+    while (total < length)
+    {
+        ssize_t put = ::pwrite(fd, src + total, length - total, static_cast<off_t>(offset + total));
+        if (put < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        total += static_cast<size_t>(put);
+    }
+    return true;
+}
+
+bool BlockFile::punchHole(const uint64_t offset, const size_t length)
+{
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (fd < 0 || length == 0)
+        return false;
+    return fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                     static_cast<off_t>(length)) == 0;
+#else
+    (void)offset;
+    (void)length;
+    return false; // The slack stays allocated, it is still never read
+#endif
+}
+
+bool BlockFile::flush()
+{
+    // pwrite goes straight to the kernel, nothing is buffered in user space
+    return fd >= 0;
+}
+
+uint64_t BlockFile::size() const
+{
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+        return 0;
+    return static_cast<uint64_t>(info.st_size);
+}
+
+#else // fstream fallback
+
+BlockFile::BlockFile() : direct(false)
+{
+}
+
+BlockFile::~BlockFile()
+{
+    close();
+}
+
+bool BlockFile::open(const std::string& filename, const bool readOnly, const bool directIO)
+{
+    close();
+    (void)directIO; // No portable way to bypass the cache through a stream, stay buffered
+    std::ios::openmode mode = std::ios::binary | std::ios::in;
+    if (!readOnly)
+        mode |= std::ios::out;
+    stream.open(filename, mode);
+    return stream.is_open();
+}
+
+bool BlockFile::isOpen() const
+{
+    return stream.is_open();
+}
+
+void BlockFile::close()
+{
+    if (stream.is_open())
+        stream.close();
+}
+
+long long BlockFile::readAt(const uint64_t offset, char* dest, const size_t length) const
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!stream.is_open())
+        return -1;
+
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(offset));
+    if (!stream.good())
+        return -1;
+    stream.read(dest, static_cast<std::streamsize>(length));
+    return static_cast<long long>(stream.gcount());
+}
+
+bool BlockFile::writeAt(const uint64_t offset, const char* src, const size_t length)
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!stream.is_open())
+        return false;
+
+    stream.clear();
+    stream.seekp(static_cast<std::streamoff>(offset));
+    if (!stream.good())
+        return false;
+    stream.write(src, static_cast<std::streamsize>(length));
+    return stream.good();
+}
+
+bool BlockFile::punchHole(const uint64_t offset, const size_t length)
+{
+    (void)offset;
+    (void)length;
+    return false; // A stream cannot deallocate part of a file
+}
+
+bool BlockFile::flush()
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!stream.is_open())
+        return false;
+    stream.flush();
+    return stream.good();
+}
+
+uint64_t BlockFile::size() const
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (!stream.is_open())
+        return 0;
+
+    stream.clear();
+    stream.seekg(0, std::ios::end);
+    std::streamoff end = stream.tellg();
+    return end < 0 ? 0 : static_cast<uint64_t>(end);
+}
+
+#endif
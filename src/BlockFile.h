@@ -0,0 +1,192 @@
+#ifndef BLOCK_FILE_H
+#define BLOCK_FILE_H
+
+#include "stdint.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BLOCK_FILE_HAS_PREAD
+#endif
+
+/**
+ * @file BlockFile.h
+ * @author Group 2
+ * @brief Positional file I/O used by the block buffers
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+/**
+ * @class BlockFile
+ * @brief Reads and writes at absolute offsets without a shared file cursor.
+ * @details On POSIX systems this wraps a file descriptor and uses pread/pwrite, so several
+ *          threads may read different blocks of the same open file at the same time. Elsewhere
+ *          it falls back to an fstream with every seek + transfer done under a mutex.
+ *
+ *          Opened in direct mode the file bypasses the kernel page cache (O_DIRECT, or F_NOCACHE
+ *          on macOS), leaving the application block cache as the only copy of hot blocks. Direct
+ *          transfers need the offset, length and buffer address aligned to DIRECT_IO_ALIGNMENT;
+ *          anything else is bounced through an aligned buffer, which is correct but slow.
+ */
+class BlockFile
+{
+public:
+    static const size_t DIRECT_IO_ALIGNMENT = 4096; // Covers both 512 byte and 4K sector devices
+
+    /**
+     * @brief One buffer of a batched write.
+     */
+    struct WriteSegment
+    {
+        uint64_t offset; // Absolute file offset
+        const char* src; // Source buffer of at least length bytes
+        size_t length; // Bytes to write
+    };
+
+    /**
+     * @brief Default constructor, starts closed.
+     */
+    BlockFile();
+
+    /**
+     * @brief Destructor, closes the file if open.
+     */
+    ~BlockFile();
+
+    BlockFile(const BlockFile&) = delete;
+    BlockFile& operator=(const BlockFile&) = delete;
+
+    /**
+     * @brief Opens an existing file.
+     * @param filename Path to the file.
+     * @param readOnly True to open without write access.
+     * @param directIO True to bypass the kernel page cache. Falls back to buffered I/O when the
+     *                 file system or platform does not support it, check isDirect afterwards.
+     * @return True if the file was opened.
+     */
+    bool open(const std::string& filename, const bool readOnly = false, const bool directIO = false);
+
+    /**
+     * @brief Checks if the open file bypasses the kernel page cache.
+     * @return True if in direct mode.
+     */
+    bool isDirect() const;
+
+    /**
+     * @brief Checks if a transfer can go to the device without bouncing.
+     * @param offset Byte offset from the start of the file.
+     * @param buffer Start of the caller buffer.
+     * @param length Number of bytes.
+     * @return True if all three are multiples of DIRECT_IO_ALIGNMENT.
+     */
+    static bool isAligned(const uint64_t offset, const void* buffer, const size_t length);
+
+    /**
+     * @brief Rounds a size up to the next multiple of DIRECT_IO_ALIGNMENT.
+     * @param size Size in bytes.
+     * @return The rounded size.
+     */
+    static size_t roundUpToSector(const size_t size);
+
+    /**
+     * @brief Checks if a file is open.
+     * @return True if open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Reads up to length bytes at an absolute offset. Safe to call from several threads.
+     * @param offset Byte offset from the start of the file.
+     * @param dest Destination buffer of at least length bytes.
+     * @param length Number of bytes to read.
+     * @return Bytes actually read, less than length at end of file, -1 on error.
+     */
+    long long readAt(const uint64_t offset, char* dest, const size_t length) const;
+
+    /**
+     * @brief Writes length bytes at an absolute offset.
+     * @param offset Byte offset from the start of the file.
+     * @param src Source buffer of at least length bytes.
+     * @param length Number of bytes to write.
+     * @return True if every byte was written.
+     */
+    bool writeAt(const uint64_t offset, const char* src, const size_t length);
+
+    /**
+     * @brief Writes several buffers, gathering file-adjacent ones into a single call.
+     * @details Segments are sorted by offset and every run of back to back segments goes out with
+     *          one pwritev, so a split that touches neighbouring blocks costs one system call.
+     *          Segments must not overlap.
+     * @param segments The buffers to write, reordered by offset.
+     * @return True if every byte was written.
+     */
+    bool writeBatch(std::vector<WriteSegment>& segments);
+
+    /**
+     * @brief Gives the disk space under a byte range back to the file system. The range reads as zeros.
+     * @details Only whole file system blocks inside the range are freed and the file size does not
+     *          change. Used behind compressed blocks whose stored form ends early in their slot.
+     * @param offset Byte offset from the start of the file.
+     * @param length Number of bytes.
+     * @return True if the space was released, false where the platform or file system can't.
+     */
+    bool punchHole(const uint64_t offset, const size_t length);
+
+    /**
+     * @brief Pushes buffered writes to the operating system.
+     * @return True if successful.
+     */
+    bool flush();
+
+    /**
+     * @brief Gets the current size of the file.
+     * @return File size in bytes, 0 if not open.
+     */
+    uint64_t size() const;
+
+private:
+    bool direct; // Kernel page cache bypassed
+
+#ifdef BLOCK_FILE_HAS_PREAD
+    int fd; // Descriptor used with pread/pwrite, -1 when closed
+
+    /**
+     * @brief Reads an unaligned range in direct mode through an aligned bounce buffer.
+     */
+    long long readBounced(const uint64_t offset, char* dest, const size_t length) const;
+
+    /**
+     * @brief Writes an unaligned range in direct mode by read-modify-write of the covering sectors.
+     */
+    bool writeBounced(const uint64_t offset, const char* src, const size_t length);
+
+    /**
+     * @brief pread loop without any alignment handling.
+     */
+    long long readRaw(const uint64_t offset, char* dest, const size_t length) const;
+
+    /**
+     * @brief pwrite loop without any alignment handling.
+     */
+    bool writeRaw(const uint64_t offset, const char* src, const size_t length);
+
+    /**
+     * @brief Writes segments [first, last), which are back to back in the file, with pwritev.
+     */
+    bool writeGathered(const std::vector<WriteSegment>& segments, size_t first, size_t last);
+#else
+    mutable std::fstream stream; // Fallback stream
+    mutable std::mutex streamMutex; // Serialises seek + transfer on the fallback stream
+#endif
+};
+
+#endif // BLOCK_FILE_H
@@ -1,4 +1,6 @@
 #include "BlockIndexFile.h"
+#include "SequenceSetIterator.h"
+#include "RecordView.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -15,34 +17,40 @@ BlockIndexFile::~BlockIndexFile(){
 bool BlockIndexFile::createIndexFromBlockedFile(const std::string& zcbFilePath,
                                                uint32_t blockSize,
                                                size_t headerSize,
-                                               uint32_t sequenceSetHead)
+                                               uint32_t sequenceSetHead,
+                                               bool checksums,
+                                               RecordEncoding encoding,
+                                               BlockCodec::Type compression,
+                                               CoordinateFormat coordinates)
 {
     indexEntries.clear();  // Clear any existing entries
     
     BlockBuffer blockBuffer;
-    RecordBuffer recordBuffer;
+    blockBuffer.setChecksums(checksums);
+    blockBuffer.setCompression(compression);
     
     if (!blockBuffer.openFile(zcbFilePath, headerSize)) {
         return false;
     }
     
-    uint32_t currentRBN = sequenceSetHead;
-    while(currentRBN != 0)
+    SequenceSetIterator chain(blockBuffer, sequenceSetHead, blockSize, headerSize);
+    ActiveBlock block;
+    RecordView record;
+    while(chain.next(block))
     {
-        ActiveBlock block = blockBuffer.loadActiveBlockAtRBN(currentRBN, blockSize, headerSize);
+        uint32_t currentRBN = chain.getCurrentRBN();
+        BlockRecordIterator records(block.data, encoding, coordinates);
+        bool hasRecords = false;
+        while (records.next(record))
+            hasRecords = true;
         
-        std::vector<ZipCodeRecord> records;
-        recordBuffer.unpackBlock(block.data, records);
-        
-        if (!records.empty()) 
+        if (hasRecords) 
         {
             IndexEntry entry;
             entry.recordRBN = currentRBN;
-            entry.key = records.back().getZipCode();  // Highest zip in block
+            entry.key = record.getZipCode();  // Highest zip in block
             indexEntries.push_back(entry);
         }
-        
-        currentRBN = block.succeedingRBN;
     }
     
     // Sort by key (should already be sorted if blocks are, but safe)
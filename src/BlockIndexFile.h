@@ -58,11 +58,19 @@ public:
      * @param blockSize The size of the blocks within the file in bytes.
      * @param headerSize The size of the file header in bytes.
      * @param sequenceSetHead The head of the ActiveBlock linked list.
+     * @param checksums True if the blocks end in a CRC32C trailer.
+     * @param encoding How the blocks encode their records.
+     * @param compression The codec the blocks are stored with.
+     * @param coordinates How binary records store their coordinates.
      */
     bool createIndexFromBlockedFile(const std::string& zcbFilePath,
                                                uint32_t blockSize,
                                                size_t headerSize,
-                                               uint32_t sequenceSetHead);
+                                               uint32_t sequenceSetHead,
+                                               bool checksums = false,
+                                               RecordEncoding encoding = RecordEncoding::Text,
+                                               BlockCodec::Type compression = BlockCodec::Type::None,
+                                               CoordinateFormat coordinates = CoordinateFormat::Degrees);
 
     /**
      * @brief Find RBN for block containing the given zip code
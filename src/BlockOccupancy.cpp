@@ -0,0 +1,208 @@
+#include "BlockOccupancy.h"
+#include <algorithm>
+
+namespace
+{
+    /**
+     * @brief Bytes of one dictionary entry, its length byte and the string
+     */
+    inline uint32_t entrySize(const std::string& value)
+    {
+        return 1 + static_cast<uint32_t>(value.size());
+    }
+}
+
+BlockOccupancy::BlockOccupancy(const RecordBuffer& recordBuffer)
+    : recordBuffer(recordBuffer), recordSizes(), recordBytes(0), entryUses(), sharedBytes(0), zipCodes()
+{
+}
+
+BlockOccupancy::BlockOccupancy(const RecordBuffer& recordBuffer, const std::vector<ZipCodeRecord>& records)
+    : recordBuffer(recordBuffer), recordSizes(), recordBytes(0), entryUses(), sharedBytes(0), zipCodes()
+{
+    assign(records);
+}
+
+void BlockOccupancy::assign(const std::vector<ZipCodeRecord>& records)
+{
+    clear();
+    recordSizes.reserve(records.size());
+    for (const auto& record : records)
+        insert(recordSizes.size(), record, measure(record));
+}
+
+void BlockOccupancy::clear()
+{
+    recordSizes.clear();
+    recordBytes = 0;
+    entryUses.clear();
+    sharedBytes = 0;
+    zipCodes.clear();
+}
+
+uint32_t BlockOccupancy::measure(const ZipCodeRecord& record) const
+{
+    return recordBuffer.getEncodedSize(record);
+}
+
+uint32_t BlockOccupancy::getAddedSize(const ZipCodeRecord& record, const uint32_t recordSize) const
+{
+    if (usesDeltaSlots() && !zipCodes.empty() &&
+        !canSpan(std::min(zipCodes.front(), record.getZipCode()), std::max(zipCodes.back(), record.getZipCode())))
+        return NEVER_FITS;
+    if (!usesDictionary())
+        return recordSize;
+
+    std::string state(record.getState(), 2);
+    std::string county = record.getCounty();
+    bool hasState = entryUses.count(state) > 0;
+    bool hasCounty = entryUses.count(county) > 0 || county == state;
+    size_t newEntries = (hasState ? 0 : 1) + (hasCounty ? 0 : 1);
+    if (entryUses.size() + newEntries > RecordBuffer::MAX_DICTIONARY_ENTRIES)
+        return NEVER_FITS;
+    return recordSize - (hasState ? entrySize(state) : 0) - (hasCounty ? entrySize(county) : 0);
+}
+
+uint32_t BlockOccupancy::getReleasedSize(const size_t index, const ZipCodeRecord& record) const
+{
+    uint32_t recordSize = recordSizes[index];
+    if (!usesDictionary())
+        return recordSize;
+
+    // An entry leaves the dictionary with its last user
+    std::string state(record.getState(), 2);
+    std::string county = record.getCounty();
+    std::map<std::string, uint32_t>::const_iterator stateUses = entryUses.find(state);
+    if (county == state)
+    {
+        // The record names one entry twice and counts it twice, the dictionary holds it once
+        bool othersUseIt = stateUses != entryUses.end() && stateUses->second > 2;
+        return recordSize - entrySize(state) * (othersUseIt ? 2 : 1);
+    }
+    std::map<std::string, uint32_t>::const_iterator countyUses = entryUses.find(county);
+    if (stateUses != entryUses.end() && stateUses->second > 1)
+        recordSize -= entrySize(state);
+    if (countyUses != entryUses.end() && countyUses->second > 1)
+        recordSize -= entrySize(county);
+    return recordSize;
+}
+
+void BlockOccupancy::insert(const size_t index, const ZipCodeRecord& record, const uint32_t recordSize)
+{
+    recordSizes.insert(recordSizes.begin() + index, recordSize);
+    recordBytes += recordSize;
+    if (usesDictionary())
+        addEntries(record);
+    if (usesDeltaSlots())
+        zipCodes.insert(zipCodes.begin() + index, record.getZipCode());
+}
+
+uint32_t BlockOccupancy::erase(const size_t index, const ZipCodeRecord& record)
+{
+    uint32_t recordSize = recordSizes[index];
+    recordSizes.erase(recordSizes.begin() + index);
+    recordBytes -= recordSize;
+    if (usesDictionary())
+        removeEntries(record);
+    if (usesDeltaSlots())
+        zipCodes.erase(zipCodes.begin() + index);
+    return recordSize;
+}
+
+bool BlockOccupancy::canSpan(const uint32_t low, const uint32_t high) const
+{
+    return !usesDeltaSlots() || high - low <= RecordBuffer::MAX_SLOT_KEY_SPAN;
+}
+
+bool BlockOccupancy::canSpanWith(const BlockOccupancy& other) const
+{
+    if (zipCodes.empty() || other.zipCodes.empty())
+        return true;
+    return canSpan(std::min(zipCodes.front(), other.zipCodes.front()), std::max(zipCodes.back(), other.zipCodes.back()));
+}
+
+uint32_t BlockOccupancy::getRecordSize(const size_t index) const
+{
+    return recordSizes[index];
+}
+
+size_t BlockOccupancy::getRecordCount() const
+{
+    return recordSizes.size();
+}
+
+size_t BlockOccupancy::getRecordBytes() const
+{
+    return recordBytes;
+}
+
+size_t BlockOccupancy::getUsedSize() const
+{
+    if (recordSizes.empty())
+        return METADATA_SIZE; // An empty block packs to no data at all
+
+    // Slotted data opens with the slot count and any base zip, Dictionary data with the entry count
+    size_t countSize = 0;
+    if (RecordBuffer::isSlotted(recordBuffer.getEncoding()))
+        countSize = RecordBuffer::slotDirectoryOffset(recordBuffer.getEncoding());
+    else if (usesDictionary())
+        countSize = RecordBuffer::DICTIONARY_ENTRIES_OFFSET;
+    return METADATA_SIZE + countSize + recordBytes - sharedBytes;
+}
+
+size_t BlockOccupancy::getMergedSize(const BlockOccupancy& other) const
+{
+    if (recordSizes.empty())
+        return other.getUsedSize();
+    if (other.recordSizes.empty())
+        return getUsedSize();
+
+    // Entries in both dictionaries are stored once
+    size_t crossShared = 0;
+    size_t entries = entryUses.size();
+    for (const auto& entry : other.entryUses)
+    {
+        if (entryUses.count(entry.first) > 0)
+            crossShared += entrySize(entry.first);
+        else
+            ++entries;
+    }
+    if (entries > RecordBuffer::MAX_DICTIONARY_ENTRIES)
+        return METADATA_SIZE + NEVER_FITS;
+    return getUsedSize() + other.recordBytes - other.sharedBytes - crossShared;
+}
+
+bool BlockOccupancy::usesDictionary() const
+{
+    return recordBuffer.getEncoding() == RecordEncoding::Dictionary;
+}
+
+bool BlockOccupancy::usesDeltaSlots() const
+{
+    return recordBuffer.getEncoding() == RecordEncoding::SlottedDelta;
+}
+
+void BlockOccupancy::addEntries(const ZipCodeRecord& record)
+{
+    std::string strings[2] = {std::string(record.getState(), 2), record.getCounty()};
+    for (const auto& value : strings)
+    {
+        if (entryUses[value]++ > 0)
+            sharedBytes += entrySize(value);
+    }
+}
+
+void BlockOccupancy::removeEntries(const ZipCodeRecord& record)
+{
+    std::string strings[2] = {std::string(record.getState(), 2), record.getCounty()};
+    for (const auto& value : strings)
+    {
+        std::map<std::string, uint32_t>::iterator uses = entryUses.find(value);
+        if (uses == entryUses.end())
+            continue;
+        if (--uses->second > 0)
+            sharedBytes -= entrySize(value);
+        else
+            entryUses.erase(uses);
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef BLOCK_OCCUPANCY_H
+#define BLOCK_OCCUPANCY_H
+
+#include "stdint.h"
+#include "RecordBuffer.h"
+#include "ZipCodeRecord.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @file BlockOccupancy.h
+ * @author Group 2
+ * @brief Running byte count of the records in one active block
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class BlockOccupancy
+ * @brief Keeps the encoded size of every record of a block, in record order, and their total.
+ * @details Each record is measured once, when it joins the tracker. Moving a record to or from a
+ *          neighbour carries its size along, so fit, borrow, split and merge checks are O(1)
+ *          per record. Nothing is re-serialized and the block data is not scanned for padding.
+ *          The index of a size matches the index of its record in the vector the block packs.
+ *          Under the Dictionary encoding a record's size counts its own state and county entries;
+ *          the tracker also reference counts the entries so the strings records share are only
+ *          counted once in the used size. Under SlottedDelta it also keeps the zip of each record,
+ *          since a block can only hold zips within MAX_SLOT_KEY_SPAN of each other.
+ */
+class BlockOccupancy
+{
+public:
+    static const size_t METADATA_SIZE = 10; // Count, preceding and succeeding RBN ahead of the data
+    static const uint32_t NEVER_FITS = UINT32_MAX / 2; // Added size of a record the dictionary or slot directory has no room for
+
+    /**
+     * @brief Constructor, no records
+     * @param recordBuffer Buffer whose encoding sizes the records. Must outlive the tracker.
+     */
+    explicit BlockOccupancy(const RecordBuffer& recordBuffer);
+
+    /**
+     * @brief Constructor, measures each record once
+     * @param recordBuffer Buffer whose encoding sizes the records. Must outlive the tracker.
+     * @param records Records of the block, in packing order
+     */
+    BlockOccupancy(const RecordBuffer& recordBuffer, const std::vector<ZipCodeRecord>& records);
+
+    /**
+     * @brief Replaces the tracked records
+     * @param records Records of the block, in packing order
+     */
+    void assign(const std::vector<ZipCodeRecord>& records);
+
+    /**
+     * @brief Stops tracking every record
+     */
+    void clear();
+
+    /**
+     * @brief Measures a record under the buffer's encoding
+     * @return Encoded size in bytes
+     */
+    uint32_t measure(const ZipCodeRecord& record) const;
+
+    /**
+     * @brief Bytes the used size grows by if a record joins the block
+     * @param record The record
+     * @param recordSize Its encoded size, from measure() or another tracker
+     * @return recordSize, less the dictionary entries the block already has. NEVER_FITS if the
+     *         dictionary is out of ids or the zip is out of the delta slot directory's reach.
+     */
+    uint32_t getAddedSize(const ZipCodeRecord& record, const uint32_t recordSize) const;
+
+    /**
+     * @brief Bytes the used size shrinks by if the record at index leaves the block
+     * @param index Position of the record
+     * @param record The record at index
+     * @return Its size, less the dictionary entries other records still use
+     */
+    uint32_t getReleasedSize(const size_t index, const ZipCodeRecord& record) const;
+
+    /**
+     * @brief Tracks a record inserted at index
+     * @param index Position the record was inserted at
+     * @param record The record
+     * @param recordSize Its encoded size, from measure() or another tracker
+     */
+    void insert(const size_t index, const ZipCodeRecord& record, const uint32_t recordSize);
+
+    /**
+     * @brief Stops tracking the record at index
+     * @param index Position the record was removed from
+     * @param record The record
+     * @return Its encoded size, to hand to the tracker of the block it moves to
+     */
+    uint32_t erase(const size_t index, const ZipCodeRecord& record);
+
+    /**
+     * @brief Checks if one block can hold zips from low to high
+     * @return False only under SlottedDelta, for a span wider than MAX_SLOT_KEY_SPAN
+     */
+    bool canSpan(const uint32_t low, const uint32_t high) const;
+
+    /**
+     * @brief Checks if the records of two trackers can share one block's key span
+     * @param other Tracker of the block to merge with, in either order
+     * @return True unless their zips together span too far for SlottedDelta
+     */
+    bool canSpanWith(const BlockOccupancy& other) const;
+
+    /**
+     * @brief Gets the encoded size of the record at index
+     */
+    uint32_t getRecordSize(const size_t index) const;
+
+    /**
+     * @brief Gets the records tracked
+     */
+    size_t getRecordCount() const;
+
+    /**
+     * @brief Gets the bytes of every record, without block overhead
+     * @details Shared dictionary entries are counted per record, so this is an upper bound
+     *          under the Dictionary encoding.
+     */
+    size_t getRecordBytes() const;
+
+    /**
+     * @brief Gets the bytes of the block once packed, metadata included
+     * @return What ActiveBlock::getTotalSize reads from the packed block
+     */
+    size_t getUsedSize() const;
+
+    /**
+     * @brief Gets the used size of one block holding the records of both trackers
+     * @details One block's metadata and slot or entry count, dictionary entries both blocks
+     *          use counted once.
+     * @param other Tracker of the block to merge with, in either order
+     * @return The merged getUsedSize, past any payload if the dictionary would run out of ids
+     */
+    size_t getMergedSize(const BlockOccupancy& other) const;
+
+private:
+    const RecordBuffer& recordBuffer; // Encoding the sizes are measured under
+    std::vector<uint32_t> recordSizes; // Encoded size of each record, in record order
+    size_t recordBytes; // Sum of recordSizes
+    std::map<std::string, uint32_t> entryUses; // Records naming each dictionary entry, Dictionary only
+    size_t sharedBytes; // Entry bytes counted in recordBytes more than once
+    std::vector<uint32_t> zipCodes; // Zip of each record, in record order, SlottedDelta only
+
+    bool usesDictionary() const;
+    bool usesDeltaSlots() const;
+    void addEntries(const ZipCodeRecord& record);
+    void removeEntries(const ZipCodeRecord& record);
+};
+
+#endif // BLOCK_OCCUPANCY_H
@@ -0,0 +1,109 @@
+#include "BlockReadEngine.h"
+
+BlockReadEngine::BlockReadEngine(size_t threadCount) : stopping(false)
+{
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        workers.push_back(std::thread(&BlockReadEngine::workerLoop, this));
+    }
+}
+
+BlockReadEngine::~BlockReadEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+BlockReadEngine& BlockReadEngine::shared()
+{
+    static BlockReadEngine engine;
+    return engine;
+}
+
+size_t BlockReadEngine::getThreadCount() const
+{
+    return workers.size();
+}
+
+bool BlockReadEngine::submitAndWait(const BlockFile& file, std::vector<Request>& requests,
+                                    const CompletionHandler& onComplete)
+{
+    bool success = true;
+
+    // Nothing to overlap, skip the hand-off
+    if (workers.empty() || requests.size() < 2)
+    {
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            Request& request = requests[i];
+            request.result = file.readAt(request.offset, request.dest, request.length);
+            if (request.result != static_cast<long long>(request.length))
+                success = false;
+            if (onComplete)
+                onComplete(i);
+        }
+        return success;
+    }
+
+    Batch batch;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            Job job = { &file, &requests[i], i, &batch };
+            jobs.push_back(job);
+        }
+    }
+    jobReady.notify_all();
+
+    // Report completions as they arrive so unpacking overlaps the remaining reads
+    size_t reported = 0;
+    while (reported < requests.size())
+    {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(batch.mutex);
+            batch.done.wait(lock, [&batch]() { return !batch.completed.empty(); });
+            index = batch.completed.front();
+            batch.completed.pop_front();
+        }
+
+        if (requests[index].result != static_cast<long long>(requests[index].length))
+            success = false;
+        if (onComplete)
+            onComplete(index);
+        ++reported;
+    }
+    return success;
+}
+
+void BlockReadEngine::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty())
+                return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        Request& request = *job.request;
+        request.result = job.file->readAt(request.offset, request.dest, request.length);
+
+        // Notify under the lock, the submitter may destroy the batch as soon as it sees the last index
+        std::lock_guard<std::mutex> lock(job.batch->mutex);
+        job.batch->completed.push_back(job.index);
+        job.batch->done.notify_one();
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef BLOCK_READ_ENGINE_H
+#define BLOCK_READ_ENGINE_H
+
+#include "stdint.h"
+#include "BlockFile.h"
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @file BlockReadEngine.h
+ * @author Group 2
+ * @brief Batched, parallel block reads
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+/**
+ * @class BlockReadEngine
+ * @brief Submits a whole batch of positional reads at once and reports them as they complete.
+ * @details A fixed pool of worker threads issues BlockFile::readAt calls in parallel, so a batch of
+ *          N cold blocks costs roughly N / threads device round trips instead of N. Completions are
+ *          handed back to the submitting thread, which can unpack each block while the rest are
+ *          still in flight.
+ */
+class BlockReadEngine
+{
+public:
+    static const size_t DEFAULT_THREAD_COUNT = 8; // Reads kept in flight at once
+
+    /**
+     * @brief A single read in a batch.
+     */
+    struct Request
+    {
+        uint64_t offset = 0; // Absolute file offset
+        char* dest = nullptr; // Destination buffer of at least length bytes
+        size_t length = 0; // Bytes to read
+        long long result = 0; // Bytes read, -1 on error. Set on completion.
+    };
+
+    /**
+     * @brief Called on the submitting thread for each completed request.
+     * @param index Position of the request in the submitted batch.
+     */
+    typedef std::function<void(size_t index)> CompletionHandler;
+
+    /**
+     * @brief Constructor, starts the worker threads.
+     * @param threadCount Number of workers. Zero reads every batch on the calling thread.
+     */
+    explicit BlockReadEngine(size_t threadCount = DEFAULT_THREAD_COUNT);
+
+    /**
+     * @brief Destructor, stops and joins the worker threads.
+     */
+    ~BlockReadEngine();
+
+    BlockReadEngine(const BlockReadEngine&) = delete;
+    BlockReadEngine& operator=(const BlockReadEngine&) = delete;
+
+    /**
+     * @brief Gets the engine shared by every BlockBuffer in the process.
+     * @return The shared engine.
+     */
+    static BlockReadEngine& shared();
+
+    /**
+     * @brief Submits every request at once and waits for all of them.
+     * @details onComplete runs on the calling thread in completion order, not submission order.
+     *          Batches from different threads may be submitted concurrently.
+     * @param file The open file to read from.
+     * @param requests The batch. Each result field is filled in.
+     * @param onComplete Handler for each completed request, may be empty.
+     * @return True if every request read its full length.
+     */
+    bool submitAndWait(const BlockFile& file, std::vector<Request>& requests,
+                       const CompletionHandler& onComplete);
+
+    /**
+     * @brief Gets the number of worker threads.
+     * @return Worker count.
+     */
+    size_t getThreadCount() const;
+
+private:
+    /**
+     * @brief Completion queue of one submitted batch.
+     */
+    struct Batch
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::deque<size_t> completed; // Finished request indexes not yet reported
+    };
+
+    /**
+     * @brief A queued read.
+     */
+    struct Job
+    {
+        const BlockFile* file;
+        Request* request;
+        size_t index;
+        Batch* batch;
+    };
+
+    std::vector<std::thread> workers; // Reader threads
+    std::deque<Job> jobs; // Pending reads from every batch
+    std::mutex jobMutex; // Guards jobs and stopping
+    std::condition_variable jobReady; // Signals workers that jobs are queued
+    bool stopping; // Set to shut the workers down
+
+    /**
+     * @brief Worker loop, runs reads until stopped.
+     */
+    void workerLoop();
+};
+
+#endif // BLOCK_READ_ENGINE_H
@@ -8,6 +8,7 @@
 
 #include "CSVBuffer.h"
 #include "ZipCodeRecord.h"
+#include "RecordParser.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -86,19 +87,10 @@ bool CSVBuffer::getNextRecord(ZipCodeRecord& record)
     if (!currentLine.empty()) 
     {
         ++lineNumber; // Use the stored line
-        std::string lineToProcess = currentLine;
+        bool parsed = parseLine(currentLine, record);
         currentLine.clear(); // Clear it so we don't use it again
-        
-        std::vector<std::string> fields;
-        if (!parseLine(lineToProcess, fields)) // Parse this line
-        {
-            setError("Failed to parse line " + std::to_string(lineNumber));
-            return false;
-        }
-        
-        if (!fieldsToRecord(fields, record)) // Convert fields to record
+        if (!parsed)
         {
-            setError("Failed to convert fields to record on line " + std::to_string(lineNumber));
             return false;
         }
         
@@ -123,16 +115,8 @@ bool CSVBuffer::getNextRecord(ZipCodeRecord& record)
         return getNextRecord(record);  // Recursively try next line
     }
     
-    std::vector<std::string> fields;
-    if (!parseLine(currentLine, fields)) // Parse the line into fields
-    {
-        setError("Failed to parse line " + std::to_string(lineNumber));
-        return false;
-    }
-    
-    if (!fieldsToRecord(fields, record))  // Convert fields to record
+    if (!parseLine(currentLine, record)) // Parse the line into the record
     {
-        setError("Failed to convert fields to record on line " + std::to_string(lineNumber));
         return false;
     }
     
@@ -222,74 +206,18 @@ bool CSVBuffer::skipHeader()
     return false;
 }
 
-bool CSVBuffer::parseLine(const std::string& line, std::vector<std::string>& fields)
-{
-    fields.clear();
-    std::stringstream ss(line);
-    std::string field;
-    
-    while (std::getline(ss, field, ',')) 
-    {
-        trimString(field);
-        fields.push_back(field);
-    }
-    
-    if (fields.size() != EXPECTED_FIELD_COUNT) // Validate field count
-    {
-        return false;
-    }
-    
-    return true;
-}
-
 /**
- * @brief Convert string fields to ZipCodeRecord
- * @details Validates and converts each field type
+ * @brief Parse one CSV line into a record
+ * @details Single pass, in place, see RecordParser
  */
-bool CSVBuffer::fieldsToRecord(const std::vector<std::string>& fields, ZipCodeRecord& record)
+bool CSVBuffer::parseLine(const std::string& line, ZipCodeRecord& record)
 {
-    if (fields.size() != EXPECTED_FIELD_COUNT) 
-        return false;
-    
-    // Validate and convert each field
-    // Field 0: Zip Code (integer)
-    if (!isValidUInt32(fields[0])) 
-    {
-        return false;
-    }
-    uint32_t zipCode = static_cast<uint32_t>(std::stoul(fields[0]));
-    
-    // Field 4: Latitude (double)
-    if (!isValidDouble(fields[4])) 
+    RecordParser::Error error = RecordParser::parse(line.data(), line.size(), record);
+    if (error != RecordParser::Error::None)
     {
+        setError("Failed to parse line " + std::to_string(lineNumber) + ": " + RecordParser::describe(error));
         return false;
     }
-    double latitude = std::stod(fields[4]);
-    
-    // Field 5: Longitude (double)  
-    if (!isValidDouble(fields[5])) 
-    {
-        return false;
-    }
-    double longitude = std::stod(fields[5]);
-    
-    // Field 1: Place Name (string)
-    std::string placeName = fields[1];
-    
-    // Field 2: State (string, must be 2 chars)
-    std::string state = fields[2];
-    if (state.length() != 2)
-    {
-        return false;
-    }
-    
-    // Field 3: County (string)
-    std::string county = fields[3];
-    
-    // Create the record
-    ZipCodeRecord tempRecord(zipCode, latitude, longitude, placeName, state, county);
-    record = tempRecord;
-    
     return true;
 }
 
@@ -311,43 +239,6 @@ void CSVBuffer::trimString(std::string& str)
     }).base(), str.end());
 }
 
-/**
- * @brief Validate that string represents valid integer
- */
-bool CSVBuffer::isValidUInt32(const std::string& str) const
-{
-    if (str.empty()) return false;
-    
-    try 
-    {
-        long val = std::stol(str);
-        if (val < 0 || val > 4294967295) return false;
-        return true;
-    } 
-    catch (const std::exception&) 
-    {
-        return false;
-    }
-}
-
-/**
- * @brief Validate that string represents valid double
- */
-bool CSVBuffer::isValidDouble(const std::string& str) const
-{
-    if (str.empty()) return false;
-    
-    try 
-    {
-        std::stod(str);
-        return true;
-    } 
-    catch (const std::exception&) 
-    {
-        return false;
-    }
-}
-
 /**
  * @brief Set error state with message
  */
@@ -409,10 +300,10 @@ bool CSVBuffer::getNextLengthIndicatedRecord(ZipCodeRecord& record)
         return false;
     }
     
-    // Read CSV string
-    std::string csvRecord(recordLen, '\0');
+    // Read CSV string into the reused buffer
+    recordText.resize(recordLen);
 
-    csvFile.read(&csvRecord[0], recordLen);
+    csvFile.read(&recordText[0], recordLen);
 
     if (csvFile.gcount() != recordLen) 
     {
@@ -421,16 +312,10 @@ bool CSVBuffer::getNextLengthIndicatedRecord(ZipCodeRecord& record)
     }
 
     // Parse CSV string
-    std::vector<std::string> fields;
-    if (!parseLine(csvRecord, fields)) 
+    RecordParser::Error error = RecordParser::parse(recordText.data(), recordText.size(), record);
+    if (error != RecordParser::Error::None) 
     {
-        setError("Failed to parse record");
-        return false;
-    }
-
-    if (!fieldsToRecord(fields, record)) 
-    {
-        setError("Failed to convert fields to record");
+        setError(std::string("Failed to parse record: ") + RecordParser::describe(error));
         return false;
     }
     
@@ -472,9 +357,9 @@ bool CSVBuffer::readRecordAtMemoryAddress(const size_t address, ZipCodeRecord& r
         return false;
     }
     
-    // Read CSV string
-    std::string csvRecord(recordLen, '\0');
-    csvFile.read(&csvRecord[0], recordLen);
+    // Read CSV string into the reused buffer
+    recordText.resize(recordLen);
+    csvFile.read(&recordText[0], recordLen);
     
     if (csvFile.gcount() != recordLen) 
     {
@@ -483,16 +368,10 @@ bool CSVBuffer::readRecordAtMemoryAddress(const size_t address, ZipCodeRecord& r
     }
     
     // Parse CSV string
-    std::vector<std::string> fields;
-    if (!parseLine(csvRecord, fields)) 
-    {
-        setError("Failed to parse record");
-        return false;
-    }
-    
-    if (!fieldsToRecord(fields, record)) 
+    RecordParser::Error error = RecordParser::parse(recordText.data(), recordText.size(), record);
+    if (error != RecordParser::Error::None) 
     {
-        setError("Failed to convert fields to record");
+        setError(std::string("Failed to parse record: ") + RecordParser::describe(error));
         return false;
     }
     
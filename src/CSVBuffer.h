@@ -143,6 +143,7 @@ public:
 private:
     std::ifstream csvFile; // Input file stream
     std::string currentLine; // Current line buffer
+    std::string recordText; // Reused buffer for length-indicated records
     uint32_t lineNumber; // Current line number (1-based)
     uint32_t recordsProcessed; // Count of successfully processed records
     bool errorState; // Error flag
@@ -158,23 +159,14 @@ private:
     bool skipHeader();
     
     /**
-     * @brief Parse comma-separated line into individual fields
+     * @brief Parse one comma-separated line into a record
      * @param line [IN] CSV line to parse
-     * @param fields [OUT] Vector to store parsed fields
-     * @return true if parsing successful
-     * @details Handles quoted fields and comma separation
-     */
-    bool parseLine(const std::string& line, std::vector<std::string>& fields);
-    
-    /**
-     * @brief Convert string fields to ZipCodeRecord
-     * @param fields [IN] Vector of string fields from CSV
      * @param record [OUT] ZipCodeRecord to populate
-     * @return true if conversion successful
-     * @pre fields must contain exactly 6 valid elements
-     * @post record is populated with converted data
+     * @return true if parsing successful
+     * @details Single pass over the line with RecordParser, no field strings or exceptions.
+     *          Sets the error with the line number and the reason on failure.
      */
-    bool fieldsToRecord(const std::vector<std::string>& fields, ZipCodeRecord& record);
+    bool parseLine(const std::string& line, ZipCodeRecord& record);
     
     /**
      * @brief Trim whitespace from string
@@ -183,20 +175,6 @@ private:
      */
     void trimString(std::string& str);
     
-    /**
-     * @brief Validate that a string represents a valid integer
-     * @param str [IN] String to validate
-     * @return true if string is a valid integer
-     */
-    bool isValidUInt32(const std::string& str) const;
-    
-    /**
-     * @brief Validate that a string represents a valid double
-     * @param str [IN] String to validate  
-     * @return true if string is a valid double
-     */
-    bool isValidDouble(const std::string& str) const;
-    
     /**
      * @brief Set error state with message
      * @param message [IN] Error description
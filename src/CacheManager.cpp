@@ -0,0 +1,409 @@
+#include "CacheManager.h"
+#include <algorithm>
+
+CacheManager::CacheManager(uint64_t byteBudget)
+    : byteBudget(byteBudget), usedBytes(0), clockHand(0)
+{
+}
+
+CacheManager::~CacheManager()
+{
+}
+
+uint64_t CacheManager::makeKey(uint32_t fileId, uint32_t rbn)
+{
+    return (static_cast<uint64_t>(fileId) << 32) | rbn;
+}
+
+uint8_t CacheManager::weightOf(Priority priority)
+{
+    switch (priority)
+    {
+        case Priority::IndexInner:
+            return 4;
+        case Priority::IndexLeaf:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+uint32_t CacheManager::registerFile(const std::string& filename, uint32_t blockSize, size_t headerSize)
+{
+    for (uint32_t id = 0; id < files.size(); ++id)
+    {
+        FileEntry& file = files[id];
+        if (file.fileName != filename)
+            continue;
+        if (file.blockSize != blockSize || file.headerSize != headerSize)
+        {
+            // Same path, new layout, the frames no longer line up with the blocks
+            dropFile(id);
+            file.blockSize = blockSize;
+            file.headerSize = headerSize;
+        }
+        return id;
+    }
+
+    FileEntry file;
+    file.fileName = filename;
+    file.blockSize = blockSize;
+    file.headerSize = headerSize;
+    files.push_back(file);
+    return static_cast<uint32_t>(files.size() - 1);
+}
+
+bool CacheManager::isRegisteredAs(uint32_t fileId, const std::string& filename, uint32_t blockSize,
+                                  size_t headerSize) const
+{
+    return fileId < files.size() && files[fileId].fileName == filename &&
+           files[fileId].blockSize == blockSize && files[fileId].headerSize == headerSize;
+}
+
+void CacheManager::setWriteBackHandler(uint32_t fileId, const WriteBackHandler& handler)
+{
+    if (fileId < files.size())
+        files[fileId].writeBack = handler;
+}
+
+void CacheManager::setCompressedFrames(uint32_t fileId, bool compressed)
+{
+    if (fileId >= files.size() || files[fileId].compressedFrames == compressed)
+        return;
+    dropFile(fileId); // Frames of the old form can't be read as the new one
+    files[fileId].compressedFrames = compressed;
+}
+
+bool CacheManager::hasCompressedFrames(uint32_t fileId) const
+{
+    return fileId < files.size() && files[fileId].compressedFrames;
+}
+
+void CacheManager::dropFile(uint32_t fileId)
+{
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        if (frames[i].fileId == fileId)
+            release(i, false);
+    }
+}
+
+size_t CacheManager::findFrame(uint32_t fileId, uint32_t rbn) const
+{
+    auto it = frameTable.find(makeKey(fileId, rbn));
+    return it == frameTable.end() ? frames.size() : it->second;
+}
+
+char* CacheManager::pin(uint32_t fileId, uint32_t rbn)
+{
+    if (fileId >= files.size())
+        return nullptr;
+
+    size_t index = findFrame(fileId, rbn);
+    if (index == frames.size())
+    {
+        files[fileId].stats.misses++;
+        return nullptr;
+    }
+
+    Frame& frame = frames[index];
+    frame.pinCount++;
+    frame.clockCount = std::max(frame.clockCount, weightOf(frame.priority));
+    files[fileId].stats.hits++;
+    return frame.image.data();
+}
+
+bool CacheManager::isResident(uint32_t fileId, uint32_t rbn) const
+{
+    return findFrame(fileId, rbn) != frames.size();
+}
+
+char* CacheManager::claim(uint32_t fileId, uint32_t rbn, Priority priority)
+{
+    if (fileId >= files.size())
+        return nullptr;
+
+    const uint32_t blockSize = files[fileId].blockSize;
+    if (blockSize == 0 || blockSize > byteBudget)
+        return nullptr;
+
+    size_t index = findFrame(fileId, rbn);
+    if (index != frames.size())
+    {
+        frames[index].pinCount++;
+        return frames[index].image.data();
+    }
+
+    // Make room, preferring to reuse a victim's memory when it is the right size
+    index = frames.size();
+    while (usedBytes + blockSize > byteBudget)
+    {
+        size_t victim = evictOne();
+        if (victim == frames.size())
+            return nullptr; // Everything left is pinned or cannot be written back
+        if (index == frames.size() && frames[victim].image.size() == blockSize)
+            index = victim;
+        else
+            frames[victim].image = BlockImage(0, 1);
+    }
+
+    if (index == frames.size() && !freeFrames.empty())
+    {
+        auto sameSize = std::find_if(freeFrames.begin(), freeFrames.end(),
+                                     [this, blockSize](size_t free) { return frames[free].image.size() == blockSize; });
+        index = (sameSize != freeFrames.end()) ? *sameSize : freeFrames.back();
+    }
+    if (index == frames.size())
+        frames.push_back(Frame());
+    else
+        freeFrames.erase(std::find(freeFrames.begin(), freeFrames.end(), index));
+
+    Frame& frame = frames[index];
+    if (frame.image.size() != blockSize)
+        frame.image = BlockImage(blockSize);
+    frame.fileId = fileId;
+    frame.rbn = rbn;
+    frame.pinCount = 1;
+    frame.dirty = false;
+    frame.priority = priority;
+    frame.clockCount = weightOf(priority);
+    frameTable[makeKey(fileId, rbn)] = index;
+    usedBytes += blockSize;
+    files[fileId].residentBlocks++;
+    return frame.image.data();
+}
+
+char* CacheManager::resize(uint32_t fileId, uint32_t rbn, size_t bytes)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index == frames.size() || bytes == 0)
+        return nullptr;
+
+    const size_t current = frames[index].image.size();
+    if (bytes == current)
+        return frames[index].image.data();
+    while (bytes > current && usedBytes + (bytes - current) > byteBudget)
+    {
+        size_t victim = evictOne(); // Never this frame, it is pinned
+        if (victim == frames.size())
+            return nullptr;
+        frames[victim].image = BlockImage(0, 1);
+    }
+
+    // A fresh allocation, shrinking in place would keep the block sized memory
+    Frame& frame = frames[index];
+    BlockImage resized(bytes, RESIZED_ALIGNMENT);
+    std::copy(frame.image.data(), frame.image.data() + std::min(bytes, current), resized.data());
+    frame.image = std::move(resized);
+    usedBytes = usedBytes - current + bytes;
+    return frame.image.data();
+}
+
+void CacheManager::unpin(uint32_t fileId, uint32_t rbn, bool dirty)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index == frames.size())
+        return;
+
+    Frame& frame = frames[index];
+    if (frame.pinCount > 0)
+        frame.pinCount--;
+    if (dirty)
+        frame.dirty = true;
+}
+
+void CacheManager::refresh(uint32_t fileId, uint32_t rbn, const char* image)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index != frames.size())
+        std::copy(image, image + frames[index].image.size(), frames[index].image.data());
+}
+
+void CacheManager::setPriority(uint32_t fileId, uint32_t rbn, Priority priority)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index == frames.size())
+        return;
+
+    Frame& frame = frames[index];
+    frame.priority = priority;
+    frame.clockCount = std::max(frame.clockCount, weightOf(priority));
+}
+
+void CacheManager::discard(uint32_t fileId, uint32_t rbn)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index != frames.size())
+        release(index, false);
+}
+
+std::vector<uint32_t> CacheManager::getDirtyRBNs(uint32_t fileId) const
+{
+    std::vector<uint32_t> dirtyRBNs;
+    for (const auto& frame : frames)
+    {
+        if (frame.fileId == fileId && frame.dirty)
+            dirtyRBNs.push_back(frame.rbn);
+    }
+    std::sort(dirtyRBNs.begin(), dirtyRBNs.end());
+    return dirtyRBNs;
+}
+
+const char* CacheManager::peek(uint32_t fileId, uint32_t rbn) const
+{
+    size_t index = findFrame(fileId, rbn);
+    return index == frames.size() ? nullptr : frames[index].image.data();
+}
+
+void CacheManager::markClean(uint32_t fileId, uint32_t rbn)
+{
+    size_t index = findFrame(fileId, rbn);
+    if (index != frames.size())
+        frames[index].dirty = false;
+}
+
+CacheManager::Stats CacheManager::getStats(uint32_t fileId) const
+{
+    return fileId < files.size() ? files[fileId].stats : Stats();
+}
+
+void CacheManager::resetStats(uint32_t fileId)
+{
+    if (fileId < files.size())
+        files[fileId].stats = Stats();
+}
+
+size_t CacheManager::getResidentCount(uint32_t fileId) const
+{
+    return fileId < files.size() ? files[fileId].residentBlocks : 0;
+}
+
+uint32_t CacheManager::getBlockSize(uint32_t fileId) const
+{
+    return fileId < files.size() ? files[fileId].blockSize : 0;
+}
+
+size_t CacheManager::getHeaderSize(uint32_t fileId) const
+{
+    return fileId < files.size() ? files[fileId].headerSize : 0;
+}
+
+void CacheManager::setByteBudget(uint64_t byteBudget)
+{
+    this->byteBudget = byteBudget;
+    while (usedBytes > this->byteBudget)
+    {
+        size_t victim = evictOne();
+        if (victim == frames.size())
+            break; // Pinned frames stay until they are released
+        frames[victim].image = BlockImage(0, 1);
+    }
+}
+
+uint64_t CacheManager::getByteBudget() const
+{
+    return byteBudget;
+}
+
+uint64_t CacheManager::getUsedBytes() const
+{
+    return usedBytes;
+}
+
+std::vector<CacheManager::Occupancy> CacheManager::getOccupancy() const
+{
+    std::vector<Occupancy> occupancy(files.size());
+    for (size_t id = 0; id < files.size(); ++id)
+    {
+        occupancy[id].fileName = files[id].fileName;
+        occupancy[id].blockSize = files[id].blockSize;
+        occupancy[id].compressed = files[id].compressedFrames;
+        occupancy[id].stats = files[id].stats;
+    }
+    for (const auto& frame : frames)
+    {
+        if (frame.fileId == NO_FILE)
+            continue;
+        Occupancy& entry = occupancy[frame.fileId];
+        entry.residentBlocks++;
+        entry.residentBytes += frame.image.size();
+        if (frame.priority == Priority::IndexInner)
+            entry.innerBlocks++;
+        if (frame.dirty)
+            entry.dirtyBlocks++;
+    }
+    return occupancy;
+}
+
+void CacheManager::printOccupancy(std::ostream& out) const
+{
+    out << "Cache budget: " << usedBytes << "/" << byteBudget << " bytes in use" << std::endl;
+    for (const auto& entry : getOccupancy())
+    {
+        uint64_t lookups = entry.stats.hits + entry.stats.misses;
+        out << "  " << entry.fileName << ": " << entry.residentBlocks << " blocks ("
+            << entry.innerBlocks << " inner, " << entry.dirtyBlocks << " dirty), "
+            << entry.residentBytes << (entry.compressed ? " bytes compressed, " : " bytes, ")
+            << entry.stats.hits << " hits, " << entry.stats.misses << " misses";
+        if (lookups > 0)
+            out << " (" << (100.0 * entry.stats.hits / lookups) << "% hit rate)";
+        out << ", " << entry.stats.evictions << " evictions (" << entry.stats.dirtyEvictions << " dirty)" << std::endl;
+    }
+}
+
+size_t CacheManager::evictOne()
+{
+    if (frames.empty())
+        return frames.size();
+
+    // Every pass takes one off each count it meets, so this many steps reach a zero count
+    const size_t maxSteps = (static_cast<size_t>(weightOf(Priority::IndexInner)) + 1) * frames.size();
+    for (size_t step = 0; step < maxSteps; ++step)
+    {
+        size_t index = clockHand;
+        clockHand = (clockHand + 1) % frames.size();
+
+        Frame& frame = frames[index];
+        if (frame.fileId == NO_FILE || frame.pinCount > 0)
+            continue;
+        FileEntry& file = files[frame.fileId];
+        if (frame.dirty && !file.writeBack)
+            continue; // Nobody can write it, leave it for the owner's flush
+        if (frame.clockCount > 0)
+        {
+            frame.clockCount--;
+            continue;
+        }
+        if (frame.dirty)
+        {
+            if (!file.writeBack(frame.rbn, frame.image.data()))
+                continue;
+            file.stats.dirtyEvictions++;
+        }
+        file.stats.evictions++;
+        release(index, true);
+        return index;
+    }
+    return frames.size();
+}
+
+void CacheManager::release(size_t index, bool keepImage)
+{
+    Frame& frame = frames[index];
+    if (frame.fileId == NO_FILE)
+        return;
+
+    frameTable.erase(makeKey(frame.fileId, frame.rbn));
+    usedBytes -= frame.image.size();
+    files[frame.fileId].residentBlocks--;
+
+    frame.fileId = NO_FILE;
+    frame.rbn = 0;
+    frame.pinCount = 0;
+    frame.dirty = false;
+    frame.priority = Priority::Data;
+    frame.clockCount = 0;
+    if (!keepImage)
+        frame.image = BlockImage(0, 1);
+    freeFrames.push_back(index);
+}
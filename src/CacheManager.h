@@ -0,0 +1,350 @@
+#ifndef CACHE_MANAGER_H
+#define CACHE_MANAGER_H
+
+#include "stdint.h"
+#include "Block.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <ostream>
+#include <cstddef>
+
+/**
+ * @file CacheManager.h
+ * @author Group 2
+ * @brief Single byte budget shared by index pages and sequence set blocks
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class CacheManager
+ * @brief Memory-budgeted frame store for every file the process has open.
+ * @details Frames are keyed by (file, RBN) and sized to their file's block size, so index pages and
+ *          data blocks compete for one byte budget instead of each buffer holding its own pool.
+ *          Eviction is a weighted CLOCK: every access refills a frame's count from its priority and
+ *          each sweep takes one off, so an inner index node survives several sweeps that would
+ *          evict a data block. Dirty victims are written back through the handler their file
+ *          registered, which lets an index read evict a dirty data block safely. A file may keep its
+ *          blocks compressed, in frames cut down to each block's stored size, so the same budget
+ *          holds more of them. Like BlockCache the manager does no I/O of its own and is not thread
+ *          safe.
+ */
+class CacheManager
+{
+public:
+    static const uint64_t DEFAULT_BYTE_BUDGET = 1024 * 1024; // 256 frames of 4 KiB
+    static const uint32_t NO_FILE = 0xFFFFFFFF; // Marks an unused frame / unknown file
+    static const size_t RESIZED_ALIGNMENT = 16; // Alignment of frames cut to a compressed block
+
+    /**
+     * @brief How hard a frame resists eviction, in increasing order.
+     */
+    enum class Priority : uint8_t
+    {
+        Data = 0, // Sequence set block
+        IndexLeaf = 1, // B+ tree leaf page
+        IndexInner = 2 // B+ tree inner page, touched by every search
+    };
+
+    /**
+     * @brief Hit and miss counters, kept per file.
+     */
+    struct Stats
+    {
+        uint64_t hits = 0; // Lookups served from a frame
+        uint64_t misses = 0; // Lookups that had to go to the file
+        uint64_t evictions = 0; // Frames of this file reused for another block
+        uint64_t dirtyEvictions = 0; // Evicted frames that had to be written back first
+    };
+
+    /**
+     * @brief Memory held for one file, for operators sizing the budget.
+     */
+    struct Occupancy
+    {
+        std::string fileName; // File the frames belong to
+        uint32_t blockSize = 0; // Bytes per block, and per frame unless compressed
+        bool compressed = false; // Frames hold the stored form of each block
+        size_t residentBlocks = 0; // Frames holding a block of this file
+        size_t innerBlocks = 0; // Of those, frames at IndexInner priority
+        size_t dirtyBlocks = 0; // Of those, frames not yet written back
+        uint64_t residentBytes = 0; // Bytes of those frames, residentBlocks * blockSize unless compressed
+        Stats stats; // Counters for this file
+    };
+
+    /**
+     * @brief Writes one evicted dirty block back to its file.
+     * @param rbn The RBN of the block.
+     * @param image The frame bytes, blockSize long, or the stored form for a file with compressed frames.
+     * @return True if the block reached the file.
+     */
+    typedef std::function<bool(uint32_t rbn, const char* image)> WriteBackHandler;
+
+    /**
+     * @brief Constructor
+     * @param byteBudget Bytes of frame data the manager may hold. Zero disables caching.
+     */
+    explicit CacheManager(uint64_t byteBudget = DEFAULT_BYTE_BUDGET);
+
+    /**
+     * @brief Destructor
+     */
+    ~CacheManager();
+
+    CacheManager(const CacheManager&) = delete;
+    CacheManager& operator=(const CacheManager&) = delete;
+
+    /**
+     * @brief Registers a file or looks up an existing registration.
+     * @details A file already registered with the same layout keeps its warm frames. A changed
+     *          block or header size drops them. Callers must flush dirty frames before re-registering
+     *          with a new layout.
+     * @param filename The file the cached blocks belong to.
+     * @param blockSize The size of each block in bytes.
+     * @param headerSize The size of the file header in bytes.
+     * @return The file id used by every other call.
+     */
+    uint32_t registerFile(const std::string& filename, uint32_t blockSize, size_t headerSize);
+
+    /**
+     * @brief Checks if a file id is registered with the given layout.
+     * @return True if filename, block size and header size all match.
+     */
+    bool isRegisteredAs(uint32_t fileId, const std::string& filename, uint32_t blockSize, size_t headerSize) const;
+
+    /**
+     * @brief Sets the handler used to write back dirty blocks of a file when they are evicted.
+     * @details Without a handler dirty frames of the file are never chosen as victims.
+     * @param fileId The registered file.
+     * @param handler The handler, empty to clear it.
+     */
+    void setWriteBackHandler(uint32_t fileId, const WriteBackHandler& handler);
+
+    /**
+     * @brief Chooses whether the frames of a file hold block images or their compressed stored form.
+     * @details The form belongs to the file rather than to a view, so every buffer sharing the
+     *          registration reads the frames the same way. A change drops the file's frames, flush
+     *          dirty frames first.
+     * @param fileId The registered file.
+     * @param compressed True for stored form frames sized with resize().
+     */
+    void setCompressedFrames(uint32_t fileId, bool compressed);
+
+    /**
+     * @brief Checks if the frames of a file hold the compressed stored form.
+     * @return False for an unknown id.
+     */
+    bool hasCompressedFrames(uint32_t fileId) const;
+
+    /**
+     * @brief Drops every frame of a file without writing it back. The registration stays.
+     * @param fileId The registered file.
+     */
+    void dropFile(uint32_t fileId);
+
+    /**
+     * @brief Looks up a block and pins its frame.
+     * @details Counts a hit or a miss for the file and refreshes the frame's CLOCK count.
+     * @param fileId The registered file.
+     * @param rbn The RBN of the block.
+     * @return Pointer to the frame data, or nullptr if the block is not resident.
+     */
+    char* pin(uint32_t fileId, uint32_t rbn);
+
+    /**
+     * @brief Checks if a block is resident without touching the counters or CLOCK counts.
+     * @return True if the block has a frame.
+     */
+    bool isResident(uint32_t fileId, uint32_t rbn) const;
+
+    /**
+     * @brief Claims a frame for a block that is not resident and pins it.
+     * @details Evicts with the weighted CLOCK until the block fits the budget, writing back dirty
+     *          victims through their file's handler. The frame contents are undefined.
+     * @param fileId The registered file.
+     * @param rbn The RBN of the block that will occupy the frame.
+     * @param priority Eviction resistance of the new frame.
+     * @return Pointer to the frame data, or nullptr if nothing could be evicted.
+     */
+    char* claim(uint32_t fileId, uint32_t rbn, Priority priority = Priority::Data);
+
+    /**
+     * @brief Changes the size of a pinned frame, keeping its leading bytes.
+     * @details A compressed block is claimed at the block size, read or encoded into the frame, then
+     *          cut down to its stored size. Growing evicts other frames until the budget holds the
+     *          new size.
+     * @param fileId The registered file.
+     * @param rbn The RBN of the pinned block.
+     * @param bytes New frame size.
+     * @return Pointer to the frame data, which may move, or nullptr if the frame could not grow.
+     */
+    char* resize(uint32_t fileId, uint32_t rbn, size_t bytes);
+
+    /**
+     * @brief Unpins a frame.
+     * @param fileId The registered file.
+     * @param rbn The RBN of the pinned block.
+     * @param dirty True if the frame was modified and must be written back.
+     */
+    void unpin(uint32_t fileId, uint32_t rbn, bool dirty);
+
+    /**
+     * @brief Overwrites a resident frame with a newer image, without counting an access.
+     * @details For owners that keep their own write-back copy and only need the frame to stay
+     *          current. Does nothing if the block is not resident.
+     * @param image The new block bytes, blockSize long.
+     */
+    void refresh(uint32_t fileId, uint32_t rbn, const char* image);
+
+    /**
+     * @brief Changes the eviction resistance of a resident frame.
+     * @details Used when the kind of page is only known after it has been read, e.g. a B+ tree
+     *          node turns out to be an inner node.
+     */
+    void setPriority(uint32_t fileId, uint32_t rbn, Priority priority);
+
+    /**
+     * @brief Removes a block from the cache without writing it back.
+     */
+    void discard(uint32_t fileId, uint32_t rbn);
+
+    /**
+     * @brief Collects the RBNs of every dirty frame of a file.
+     * @return Dirty RBNs in ascending order.
+     */
+    std::vector<uint32_t> getDirtyRBNs(uint32_t fileId) const;
+
+    /**
+     * @brief Gets read access to a resident frame without pinning it.
+     * @return Pointer to the frame data, or nullptr if not resident.
+     */
+    const char* peek(uint32_t fileId, uint32_t rbn) const;
+
+    /**
+     * @brief Clears the dirty bit of a resident frame after it has been written.
+     */
+    void markClean(uint32_t fileId, uint32_t rbn);
+
+    /**
+     * @brief Gets the counters of one file.
+     * @return Copy of the counters, zeroed for an unknown id.
+     */
+    Stats getStats(uint32_t fileId) const;
+
+    /**
+     * @brief Resets the counters of one file.
+     */
+    void resetStats(uint32_t fileId);
+
+    /**
+     * @brief Gets the number of frames holding a block of one file.
+     * @return Resident block count.
+     */
+    size_t getResidentCount(uint32_t fileId) const;
+
+    /**
+     * @brief Gets the block size a file was registered with.
+     * @return Bytes per frame, zero for an unknown id.
+     */
+    uint32_t getBlockSize(uint32_t fileId) const;
+
+    /**
+     * @brief Gets the header size a file was registered with.
+     * @return Header size in bytes, zero for an unknown id.
+     */
+    size_t getHeaderSize(uint32_t fileId) const;
+
+    /**
+     * @brief Changes the budget, evicting clean and written back frames until it fits.
+     * @param byteBudget New budget in bytes. Zero disables caching.
+     */
+    void setByteBudget(uint64_t byteBudget);
+
+    /**
+     * @brief Gets the budget.
+     * @return Bytes of frame data the manager may hold.
+     */
+    uint64_t getByteBudget() const;
+
+    /**
+     * @brief Gets the bytes currently held by resident frames.
+     * @return Resident bytes, never more than the budget.
+     */
+    uint64_t getUsedBytes() const;
+
+    /**
+     * @brief Gets the memory held for every registered file.
+     * @return One entry per registered file, in registration order.
+     */
+    std::vector<Occupancy> getOccupancy() const;
+
+    /**
+     * @brief Prints the budget and a per-file occupancy table.
+     * @param out Stream to print to.
+     */
+    void printOccupancy(std::ostream& out) const;
+
+private:
+    struct Frame
+    {
+        uint32_t fileId = NO_FILE; // File of the block held, NO_FILE if unused
+        uint32_t rbn = 0; // Block held by this frame
+        uint16_t pinCount = 0; // Outstanding pins, pinned frames are never evicted
+        bool dirty = false; // Frame differs from the file
+        Priority priority = Priority::Data; // Eviction resistance
+        uint8_t clockCount = 0; // Sweeps left before the frame may be evicted
+        BlockImage image; // Frame data, page aligned unless resized
+    };
+
+    struct FileEntry
+    {
+        std::string fileName; // Path the file was registered under
+        uint32_t blockSize = 0; // Bytes per block
+        size_t headerSize = 0; // Bytes before RBN 0
+        WriteBackHandler writeBack; // Writes evicted dirty blocks, may be empty
+        bool compressedFrames = false; // Frames hold the stored form, sized per block
+        size_t residentBlocks = 0; // Frames holding a block of this file
+        Stats stats; // Counters
+    };
+
+    uint64_t byteBudget; // Bytes of frame data allowed
+    uint64_t usedBytes; // Bytes of frame data held by resident blocks
+    size_t clockHand; // Next frame the CLOCK sweep inspects
+    std::vector<Frame> frames; // Every frame, resident or free
+    std::vector<size_t> freeFrames; // Indexes of unused frames
+    std::vector<FileEntry> files; // Registered files, indexed by file id
+    std::unordered_map<uint64_t, size_t> frameTable; // (file id, RBN) -> frame index
+
+    /**
+     * @brief Builds the frame table key of a block.
+     */
+    static uint64_t makeKey(uint32_t fileId, uint32_t rbn);
+
+    /**
+     * @brief Gets the CLOCK count an access grants at a priority.
+     */
+    static uint8_t weightOf(Priority priority);
+
+    /**
+     * @brief Finds the frame index of a resident block.
+     * @return Frame index, or frames.size() if not resident.
+     */
+    size_t findFrame(uint32_t fileId, uint32_t rbn) const;
+
+    /**
+     * @brief Evicts one frame with the weighted CLOCK algorithm.
+     * @return Index of the freed frame, or frames.size() if every frame is pinned or unwritable.
+     */
+    size_t evictOne();
+
+    /**
+     * @brief Returns a resident frame to the free list.
+     * @param index The frame.
+     * @param keepImage True to keep the frame memory for the next claim of the same size.
+     */
+    void release(size_t index, bool keepImage);
+};
+
+#endif // CACHE_MANAGER_H
@@ -1,25 +1,100 @@
 // DataManager.cpp
 #include "DataManager.h"
 #include "ZipCodeRecord.h"
+#include "SequenceSetIterator.h"
 #include <sstream>
 #include <map>
 #include <iostream>
 
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define DATA_MANAGER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const unsigned int EAST = 1, WEST = 2, NORTH = 4, SOUTH = 8; // Bits of the bounds a record beats
+
+    /**
+     * @brief Compares a record's coordinates with all four bounds of a state at once
+     * @param bounds East, -west, north, -south, see DataManager::Extremes
+     * @return One bit per bound the record beats, 0 for the usual record that sets no extreme
+     */
+    unsigned int beatenBounds(const int32_t* bounds, int32_t latitude, int32_t longitude)
+    {
+        // Coordinates are at most 180e6 in size, negating them cannot overflow
+#ifdef DATA_MANAGER_HAS_SSE2
+        __m128i values = _mm_set_epi32(-latitude, latitude, -longitude, longitude);
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bounds));
+        return static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(values, current))));
+#else
+        return (longitude > bounds[0] ? EAST : 0) | (-longitude > bounds[1] ? WEST : 0) |
+               (latitude > bounds[2] ? NORTH : 0) | (-latitude > bounds[3] ? SOUTH : 0);
+#endif
+    }
+
+    /**
+     * @brief Stores a record as the extremes it beats and moves those bounds to it
+     */
+    void replaceExtremes(DataManager::Extremes& ex, const ZipCodeRecord& rec, unsigned int beaten)
+    {
+        if (beaten & EAST)
+        {
+            ex.easternmost = rec;
+            ex.bounds[0] = rec.getLongitudeMicro();
+        }
+        if (beaten & WEST)
+        {
+            ex.westernmost = rec;
+            ex.bounds[1] = -rec.getLongitudeMicro();
+        }
+        if (beaten & NORTH)
+        {
+            ex.northernmost = rec;
+            ex.bounds[2] = rec.getLatitudeMicro();
+        }
+        if (beaten & SOUTH)
+        {
+            ex.southernmost = rec;
+            ex.bounds[3] = -rec.getLatitudeMicro();
+        }
+    }
+}
+
 void DataManager::updateExtremes(Extremes& ex, const ZipCodeRecord& rec) 
 {
     if (!ex.initialized) 
     {
-        ex.easternmost = rec;
-        ex.westernmost = rec;
-        ex.northernmost = rec;
-        ex.southernmost = rec;
+        replaceExtremes(ex, rec, EAST | WEST | NORTH | SOUTH);
         ex.initialized = true;
         return;
     }
-    if (rec.isEastOf(ex.easternmost))   ex.easternmost = rec;
-    if (rec.isWestOf(ex.westernmost))   ex.westernmost = rec;
-    if (rec.isNorthOf(ex.northernmost)) ex.northernmost = rec;
-    if (rec.isSouthOf(ex.southernmost)) ex.southernmost = rec;
+    unsigned int beaten = beatenBounds(ex.bounds, rec.getLatitudeMicro(), rec.getLongitudeMicro());
+    if (beaten != 0)
+        replaceExtremes(ex, rec, beaten);
+}
+
+void DataManager::updateExtremes(Extremes& ex, const RecordView& rec) 
+{
+    if (!ex.initialized) 
+    {
+        updateExtremes(ex, rec.toRecord());
+        return;
+    }
+    // Only a record that sets an extreme is copied out of the block
+    unsigned int beaten = beatenBounds(ex.bounds, rec.getLatitudeMicro(), rec.getLongitudeMicro());
+    if (beaten != 0)
+        replaceExtremes(ex, rec.toRecord(), beaten);
+}
+
+void DataManager::processRecord(const RecordView& rec) 
+{
+    FieldView st = rec.getState();
+    if (st.size() != 2) return;
+
+    // Two characters stay in the small string buffer, the lookup does not allocate
+    Extremes& ex = stateExtremes_[st.str()];
+    updateExtremes(ex, rec);
 }
 
 void DataManager::processRecord(const ZipCodeRecord& rec) 
@@ -232,6 +307,11 @@ bool DataManager::verifyIdenticalResults(const std::string& fileA,
     return sigA == sigB;
 }
 
+SequenceScanStats DataManager::getLastScanStats() const
+{
+    return lastScanStats_;
+}
+
 std::size_t DataManager::processFromBlockedSequence(const std::string& inFile)
 {
     stateExtremes_.clear();
@@ -245,34 +325,36 @@ std::size_t DataManager::processFromBlockedSequence(const std::string& inFile)
     }
 
     BlockBuffer blockBuffer;
-    if (!blockBuffer.openFile(inFile, header.getHeaderSize())) 
+    blockBuffer.setChecksums(header.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C);
+    blockBuffer.setCompression(BlockCodec::typeOf(header));
+    if (!blockBuffer.openFileMapped(inFile, header.getHeaderSize(), BlockBuffer::AccessPattern::Sequential)) 
     {
         throw std::runtime_error("Failed to open blocked file");
     }
 
     std::size_t processed = 0;
 
-    uint32_t currentRBN = header.getSequenceSetListRBN();
+    SequenceSetIterator chain(blockBuffer, header.getSequenceSetListRBN(),
+                              header.getBlockSize(), header.getHeaderSize());
+
+    // Reused for every block so the walk does no per-block allocation for the block itself
+    ActiveBlock block;
+    RecordView rec;
+    const RecordEncoding encoding = RecordBuffer::encodingOf(header);
+    const CoordinateFormat coordinates = RecordBuffer::coordinateFormatOf(header);
 
-     while (currentRBN != 0) 
+     while (chain.next(block)) 
      {
-        ActiveBlock block = blockBuffer.loadActiveBlockAtRBN(currentRBN, header.getBlockSize(), header.getHeaderSize());
         
-        // Unpack records from block
-        std::vector<ZipCodeRecord> records;
-        RecordBuffer recBuf;
-        recBuf.unpackBlock(block.data, records);
-        
-        // Process each record
-        for (const auto& rec : records) 
+        // View records in place, only new extremes are copied out
+        BlockRecordIterator records(block.data, encoding, coordinates);
+        while (records.next(rec)) 
         {
             processRecord(rec);
             ++processed;
         }
-        
-        // Move to next block
-        currentRBN = block.succeedingRBN;
     }
+    lastScanStats_ = chain.getStats();
     
     blockBuffer.closeFile();
     return processed;
@@ -10,6 +10,7 @@
 #include "BlockBuffer.h"
 #include "HeaderBuffer.h"
 #include "HeaderRecord.h"
+#include "RecordView.h"
 
 
 /**
@@ -29,6 +30,7 @@ public:
         ZipCodeRecord northernmost;
         ZipCodeRecord southernmost;
         bool initialized = false;
+        int32_t bounds[4] = {0, 0, 0, 0}; // East, -west, north, -south in micro-degrees; a greater value is a new extreme
     };
 
     DataManager() = default;
@@ -51,6 +53,12 @@ public:
 
     std::size_t processFromBlockedSequence(const std::string& inFile);
 
+    /**
+     * @brief Readahead and physical order statistics of the last blocked sequence walk.
+     * @return Copy of the scan statistics.
+     */
+    SequenceScanStats getLastScanStats() const;
+
     /**
      * @brief Print header + per-state rows to the provided stream.
      * @param os output stream (e.g., std::cout)
@@ -93,12 +101,19 @@ public:
 
 private:
     std::unordered_map<std::string, Extremes> stateExtremes_; // Map containing the most extreme zips in each state.
+    SequenceScanStats lastScanStats_; // Statistics of the last processFromBlockedSequence walk
     
     /**
      * @brief Process a single record into the extremes map
      * @param rec ZipCodeRecord being processed
      */
     void processRecord(const ZipCodeRecord& rec);
+
+    /**
+     * @brief Process a record viewed in its block, copying it only when it is a new extreme
+     * @param rec View of the record being processed
+     */
+    void processRecord(const RecordView& rec);
     
     /**
      * @brief Updates the extremes for a state
@@ -106,5 +121,12 @@ private:
      * @param rec ZipCodeRecord being processed
      */
     static void updateExtremes(Extremes& ex, const ZipCodeRecord& rec);
+
+    /**
+     * @brief Updates the extremes for a state from a viewed record
+     * @param ex the extremes being updated
+     * @param rec View of the record being processed
+     */
+    static void updateExtremes(Extremes& ex, const RecordView& rec);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "FileSession.h"
+#include "HeaderBuffer.h"
+#include "BPlusTreeHeaderAlt.h"
+#include <fstream>
+
+FileSession::FileSession()
+    : blockCache(cacheManager), sessionOpen(false), modified(false), errorState(false)
+{
+    tree.attachCache(&cacheManager);
+    blockBuffer.attachCache(&blockCache);
+}
+
+FileSession::~FileSession()
+{
+    close();
+}
+
+bool FileSession::open(const std::string& filename)
+{
+    close();
+    errorState = false;
+    lastError.clear();
+
+    HeaderBuffer headerBuffer;
+    if (!headerBuffer.readHeader(filename, header))
+    {
+        setError("Failed to read header from " + filename);
+        return false;
+    }
+    fileName = filename;
+    savedHeader = header.serialize();
+    modified = false;
+
+    blockBuffer.setLayoutAlignment(header.getLayoutAlignment());
+    blockBuffer.setChecksums(header.getChecksumType() == HeaderRecord::CHECKSUM_CRC32C);
+    blockBuffer.setRecordEncoding(RecordBuffer::encodingOf(header));
+    blockBuffer.setCoordinateFormat(RecordBuffer::coordinateFormatOf(header));
+    blockBuffer.setCompression(BlockCodec::typeOf(header));
+    blockBuffer.setCacheForm(BlockBuffer::CacheForm::Auto,
+                             static_cast<uint64_t>(header.getBlockCount()) * header.getBlockSize());
+    if (!blockBuffer.openFile(fileName, header.getHeaderSize()))
+    {
+        setError("Failed to open block buffer: " + blockBuffer.getLastError());
+        return false;
+    }
+
+    if (header.getStaleFlag())
+    {
+        if (!createIndex())
+        {
+            blockBuffer.closeFile();
+            return false;
+        }
+        // The index now matches the sequence set, close records that on disk
+        header.setStaleFlag(0);
+    }
+    else if (!tree.open(header.getIndexFileName(), fileName))
+    {
+        setError("Failed To Open B+ Tree: " + tree.getLastError());
+        blockBuffer.closeFile();
+        return false;
+    }
+
+    sessionOpen = true;
+    return true;
+}
+
+bool FileSession::close()
+{
+    if (!sessionOpen)
+        return true;
+
+    bool result = flush();
+    blockBuffer.closeFile();
+    tree.close();
+
+    // Only a fully written session may clear the stale flag
+    if (result)
+        header.setStaleFlag(0);
+    result = writeHeaderIfChanged() && result;
+
+    sessionOpen = false;
+    modified = false;
+    return result;
+}
+
+bool FileSession::isOpen() const
+{
+    return sessionOpen;
+}
+
+bool FileSession::flush()
+{
+    if (!sessionOpen)
+        return false;
+
+    if (!blockBuffer.flush())
+    {
+        setError("Failed to flush blocks: " + blockBuffer.getLastError());
+        return false;
+    }
+    if (!tree.sync())
+    {
+        setError("Failed to sync index: " + tree.getLastError());
+        return false;
+    }
+    return true;
+}
+
+bool FileSession::markModified()
+{
+    if (!sessionOpen)
+        return false;
+    if (modified)
+        return true;
+
+    header.setStaleFlag(1);
+    if (!writeHeaderIfChanged())
+        return false;
+    modified = true;
+    return true;
+}
+
+bool FileSession::rebuildIndex()
+{
+    if (!sessionOpen)
+        return false;
+
+    // The build reads the sequence set and its head from disk
+    if (!flush() || !writeHeaderIfChanged())
+        return false;
+    tree.close();
+
+    if (!createIndex())
+    {
+        sessionOpen = false;
+        blockBuffer.closeFile();
+        return false;
+    }
+    return true;
+}
+
+void FileSession::setVerifyPolicy(BlockChecksum::VerifyPolicy policy)
+{
+    blockBuffer.setVerifyPolicy(policy);
+    tree.setVerifyPolicy(policy);
+}
+
+HeaderRecord& FileSession::getHeader()
+{
+    return header;
+}
+
+BPlusTreeAlt& FileSession::getTree()
+{
+    return tree;
+}
+
+BlockBuffer& FileSession::getBlockBuffer()
+{
+    return blockBuffer;
+}
+
+BlockCache& FileSession::getBlockCache()
+{
+    return blockCache;
+}
+
+CacheManager& FileSession::getCacheManager()
+{
+    return cacheManager;
+}
+
+const std::string& FileSession::getFileName() const
+{
+    return fileName;
+}
+
+bool FileSession::hasError() const
+{
+    return errorState;
+}
+
+const std::string& FileSession::getLastError() const
+{
+    return lastError;
+}
+
+bool FileSession::createIndex()
+{
+    const std::string indexFileName = header.getIndexFileName();
+
+    BPlusTreeHeaderAlt treeHeader;
+    treeHeader.setBlockedFileName(fileName);
+    treeHeader.setBlockSize(header.getBlockSize());
+    treeHeader.setHeight(0);
+    treeHeader.setRootIndexRBN(0);
+    treeHeader.setHeaderAlignment(header.getLayoutAlignment()); // Index pages follow the data layout
+
+    std::ofstream out(indexFileName, std::ios::binary);
+    if (!out.is_open())
+    {
+        setError("Cannot create index file: " + indexFileName);
+        return false;
+    }
+
+    auto headerData = treeHeader.serialize();
+    treeHeader.setHeaderSize(headerData.size());
+
+    out.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
+    out.close();
+
+    if (!tree.open(indexFileName, fileName))
+    {
+        setError("Failed To Open B+ Tree: " + tree.getLastError());
+        return false;
+    }
+    if (!tree.buildFromSequenceSet())
+    {
+        setError("Failed To Build B+ Tree From Sequence Set: " + tree.getLastError());
+        tree.close();
+        return false;
+    }
+    return true;
+}
+
+bool FileSession::writeHeaderIfChanged()
+{
+    std::vector<uint8_t> headerData = header.serialize();
+    if (headerData == savedHeader)
+        return true;
+
+    HeaderBuffer headerBuffer;
+    if (!headerBuffer.rewriteHeader(fileName, header))
+    {
+        setError("Failed to write header: " + headerBuffer.getLastError());
+        return false;
+    }
+    savedHeader = headerData;
+    return true;
+}
+
+void FileSession::setError(const std::string& message)
+{
+    errorState = true;
+    lastError = message;
+}
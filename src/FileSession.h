@@ -0,0 +1,178 @@
+#ifndef FILE_SESSION_H
+#define FILE_SESSION_H
+
+#include "HeaderRecord.h"
+#include "BlockBuffer.h"
+#include "BlockCache.h"
+#include "CacheManager.h"
+#include "BPlusTreeAlt.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @file FileSession.h
+ * @author Group 2
+ * @brief One open blocked file and its index, shared by every operation of a process
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class FileSession
+ * @brief Owns the handles of one blocked file for as long as the process works on it.
+ * @details open reads the header once, opens the sequence set through a single BlockBuffer and
+ *          opens (or rebuilds, if stale) the B+ tree index. Operations then share those handles and
+ *          the in-memory header instead of reopening the files per call. The header goes back to
+ *          disk once, on close, and only if it changed. The first modification also marks the
+ *          file stale on disk so a process that dies mid-session leaves an index that is rebuilt
+ *          on the next open instead of trusted.
+ */
+class FileSession
+{
+public:
+    /**
+     * @brief Constructor
+     * @details Creates a closed session whose index pages and data blocks share one cache budget.
+     */
+    FileSession();
+
+    /**
+     * @brief Destructor
+     * @details Closes the session, writing back pending blocks, index pages and the header.
+     */
+    ~FileSession();
+
+    FileSession(const FileSession&) = delete;
+    FileSession& operator=(const FileSession&) = delete;
+
+    /**
+     * @brief Opens a blocked file and its index.
+     * @details Closes the current session first. A stale index is rebuilt from the sequence set.
+     * @param filename The blocked file to open.
+     * @return True if the header, the sequence set and the index were all opened.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Closes the session.
+     * @details Flushes dirty blocks and index pages, then rewrites the header if it changed.
+     * @return True if everything reached the disk, or the session was not open.
+     */
+    bool close();
+
+    /**
+     * @brief Checks if a file is open.
+     * @return True between a successful open and close.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Writes dirty data blocks and index pages. The header stays in memory.
+     * @return True if both reached the disk.
+     */
+    bool flush();
+
+    /**
+     * @brief Marks the file stale on disk before its first modification in this session.
+     * @details Writes the header once per session; later calls do nothing. close clears the flag
+     *          again once the index is known to match the sequence set.
+     * @return True if the flag is on disk, or was already.
+     */
+    bool markModified();
+
+    /**
+     * @brief Discards the index and builds it again from the sequence set.
+     * @details The sequence set and header are written first so the build sees every change.
+     * @return True if the new index was built.
+     */
+    bool rebuildIndex();
+
+    /**
+     * @brief Chooses which reads of a checksummed file check the block trailers.
+     * @details Applies to data blocks and index pages and is kept across open calls.
+     * @param policy The verify policy, FirstRead by default.
+     */
+    void setVerifyPolicy(BlockChecksum::VerifyPolicy policy);
+
+    /**
+     * @brief Gets the in-memory header. Changes are written back on close.
+     * @return Reference to the header.
+     */
+    HeaderRecord& getHeader();
+
+    /**
+     * @brief Gets the index of the open file.
+     * @return Reference to the tree.
+     */
+    BPlusTreeAlt& getTree();
+
+    /**
+     * @brief Gets the buffer holding the open sequence set.
+     * @return Reference to the buffer.
+     */
+    BlockBuffer& getBlockBuffer();
+
+    /**
+     * @brief Gets the view of the shared cache used for data blocks.
+     * @return Reference to the view.
+     */
+    BlockCache& getBlockCache();
+
+    /**
+     * @brief Gets the cache shared by data blocks and index pages.
+     * @return Reference to the manager.
+     */
+    CacheManager& getCacheManager();
+
+    /**
+     * @brief Gets the name of the open file.
+     * @return The file name, empty if no file was opened.
+     */
+    const std::string& getFileName() const;
+
+    /**
+     * @brief Checks if the last operation failed.
+     * @return True if an error was recorded.
+     */
+    bool hasError() const;
+
+    /**
+     * @brief Gets the last error message.
+     * @return The message.
+     */
+    const std::string& getLastError() const;
+
+private:
+    CacheManager cacheManager; // One memory budget for index pages and data blocks, outlives both users
+    BlockCache blockCache; // View of cacheManager used by blockBuffer
+    BPlusTreeAlt tree; // Index of the open file
+    BlockBuffer blockBuffer; // The open sequence set
+    HeaderRecord header; // In-memory header, the copy every operation reads and updates
+    std::vector<uint8_t> savedHeader; // Header bytes as last read or written
+    std::string fileName; // Open blocked file
+    bool sessionOpen; // Is a file open
+    bool modified; // Has markModified put the stale flag on disk
+    std::string lastError; // Last Error Message
+    bool errorState; // Has the session encountered an error
+
+    /**
+     * @brief Writes an empty index header and builds the tree from the sequence set.
+     * @return True if the tree was opened and built.
+     */
+    bool createIndex();
+
+    /**
+     * @brief Rewrites the header in place if it differs from the bytes on disk.
+     * @return True if the header on disk matches the one in memory.
+     */
+    bool writeHeaderIfChanged();
+
+    /**
+     * @brief Sets the error state and message.
+     * @param message The error message.
+     */
+    void setError(const std::string& message);
+};
+
+#endif // FILE_SESSION_H
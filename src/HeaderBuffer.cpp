@@ -52,6 +52,51 @@ bool HeaderBuffer::readHeader(const std::string& filename, HeaderRecord& header)
 
     // Deserialize header
     header = HeaderRecord::deserialize(buffer.data());
+
+    // An aligned file that breaks its own layout would put blocks across page boundaries
+    if (!header.hasValidLayout())
+    {
+        setError("Header breaks its page aligned layout: " + filename);
+        std::cerr << getLastError() << std::endl;
+        return false;
+    }
+
+    // Guessing the trailer of an unknown checksum would misplace every record
+    if (header.getChecksumType() > HeaderRecord::CHECKSUM_CRC32C)
+    {
+        setError("Unsupported block checksum type in " + filename);
+        std::cerr << getLastError() << std::endl;
+        return false;
+    }
+
+    // Decoding with the wrong codec would hand back garbage blocks
+    if (header.getCompressionType() > HeaderRecord::COMPRESSION_LZ)
+    {
+        setError("Unsupported block compression type in " + filename);
+        std::cerr << getLastError() << std::endl;
+        return false;
+    }
+
+    // Reading the wrong coordinate width would shift every field after it
+    if (header.getCoordinateFormat() > HeaderRecord::COORDINATES_MICRODEGREES)
+    {
+        setError("Unsupported coordinate format in " + filename);
+        std::cerr << getLastError() << std::endl;
+        return false;
+    }
+
+    uint8_t lastSizeFormat = HeaderRecord::SIZE_FORMAT_SLOTTED;
+    if (header.getVersion() >= HeaderRecord::SLOTTED_DELTA_VERSION)
+        lastSizeFormat = HeaderRecord::SIZE_FORMAT_SLOTTED_DELTA;
+    else if (header.getVersion() >= HeaderRecord::DICTIONARY_VERSION)
+        lastSizeFormat = HeaderRecord::SIZE_FORMAT_DICTIONARY;
+    if (header.getVersion() >= HeaderRecord::BINARY_RECORD_VERSION &&
+        header.getSizeFormatType() > lastSizeFormat)
+    {
+        setError("Unsupported record encoding in " + filename);
+        std::cerr << getLastError() << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -71,6 +116,29 @@ bool HeaderBuffer::writeHeader(const std::string& filename, const HeaderRecord&
     return true;
 }
 
+bool HeaderBuffer::rewriteHeader(const std::string& filename, const HeaderRecord& header)
+{
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open())
+    {
+        setError("Cannot open file: " + filename);
+        return false;
+    }
+
+    // A different size would shift every block, only a full conversion may do that
+    auto headerData = header.serialize();
+    if (headerData.size() != header.getHeaderSize())
+    {
+        setError("Header size changed, cannot rewrite in place: " + filename);
+        return false;
+    }
+
+    file.seekp(0, std::ios::beg);
+    file.write(reinterpret_cast<char*>(headerData.data()), headerData.size());
+    file.close();
+    return !file.fail();
+}
+
 bool HeaderBuffer::hasError() const 
 {
     return errorState;
@@ -46,6 +46,14 @@ public:
      * @returns true or false depending on if the header was write was successfully or not
      */
     bool writeHeader(const std::string& filename, const HeaderRecord& header);
+    /**
+     * @brief rewrite header
+     * @details Overwrites the header of an existing file in place, leaving the blocks after it untouched
+     * @param filename name of file being written too
+     * @param header the header being written, must serialize to the size already on disk
+     * @returns true if the header was rewritten, false if the file could not be opened or the size changed
+     */
+    bool rewriteHeader(const std::string& filename, const HeaderRecord& header);
     
     /**
      * @brief has error
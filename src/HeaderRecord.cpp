@@ -1,7 +1,9 @@
 #include "HeaderRecord.h"
+#include <algorithm>
 
 
-HeaderRecord::HeaderRecord()
+HeaderRecord::HeaderRecord() : headerAlignment(1), layoutAlignment(0), checksumType(CHECKSUM_NONE),
+      compressionType(COMPRESSION_NONE), coordinateFormat(COORDINATES_DEGREES)
 {
 }
 
@@ -128,9 +130,18 @@ std::vector<uint8_t> HeaderRecord::serialize() const
     // Index File Schema Info
     data.insert(data.end(), indexFileSchemaInfo.begin(), indexFileSchemaInfo.end());
 
-    // Record Count
-    data.insert(data.end(), reinterpret_cast<const uint8_t*>(&recordCount),
-                reinterpret_cast<const uint8_t*>(&recordCount) + sizeof(recordCount));
+    // Record Count, widened to 64 bits in the large file version
+    if (version >= LARGE_FILE_VERSION)
+    {
+        data.insert(data.end(), reinterpret_cast<const uint8_t*>(&recordCount),
+                    reinterpret_cast<const uint8_t*>(&recordCount) + sizeof(recordCount));
+    }
+    else
+    {
+        uint32_t narrowCount = static_cast<uint32_t>(recordCount);
+        data.insert(data.end(), reinterpret_cast<const uint8_t*>(&narrowCount),
+                    reinterpret_cast<const uint8_t*>(&narrowCount) + sizeof(narrowCount));
+    }
 
     // Block Count
     data.insert(data.end(), reinterpret_cast<const uint8_t*>(&blockCount),
@@ -169,6 +180,29 @@ std::vector<uint8_t> HeaderRecord::serialize() const
     // Stale Flag
     data.push_back(staleFlag);
 
+    // Layout Alignment, after the stale flag so every earlier offset stays put
+    if (version >= ALIGNED_LAYOUT_VERSION)
+    {
+        data.insert(data.end(), reinterpret_cast<const uint8_t*>(&layoutAlignment),
+                    reinterpret_cast<const uint8_t*>(&layoutAlignment) + sizeof(layoutAlignment));
+    }
+
+    // Checksum Type
+    if (version >= CHECKSUM_VERSION)
+        data.push_back(checksumType);
+
+    // Compression Type
+    if (version >= COMPRESSION_VERSION)
+        data.push_back(compressionType);
+
+    // Coordinate Format
+    if (version >= FIXED_POINT_VERSION)
+        data.push_back(coordinateFormat);
+
+    // Pad so the first block starts on an aligned offset
+    uint32_t padTo = std::max(headerAlignment, layoutAlignment);
+    data.resize((data.size() + padTo - 1) / padTo * padTo, 0);
+
     // Calculate Header Size
     uint32_t trueHeaderSize = data.size();
     memcpy(&data[headerSizePos], &trueHeaderSize, sizeof(trueHeaderSize));
@@ -223,8 +257,18 @@ HeaderRecord HeaderRecord::deserialize(const uint8_t* data)
     offset += schemaInfoSize;
 
     // Read Record Count
-    memcpy(&header.recordCount, data + offset, sizeof(uint32_t));
-    offset += sizeof(uint32_t);
+    if (header.version >= LARGE_FILE_VERSION)
+    {
+        memcpy(&header.recordCount, data + offset, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+    }
+    else
+    {
+        uint32_t narrowCount = 0;
+        memcpy(&narrowCount, data + offset, sizeof(uint32_t));
+        header.recordCount = narrowCount;
+        offset += sizeof(uint32_t);
+    }
 
     // Read Block Count
     memcpy(&header.blockCount, data + offset, sizeof(uint32_t));
@@ -269,6 +313,29 @@ HeaderRecord HeaderRecord::deserialize(const uint8_t* data)
     // Read Has Valid Index File
     header.staleFlag = data[offset++];
 
+    // Read Layout Alignment
+    if (header.version >= ALIGNED_LAYOUT_VERSION)
+    {
+        memcpy(&header.layoutAlignment, data + offset, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+    }
+
+    // Read Checksum Type
+    if (header.version >= CHECKSUM_VERSION)
+        header.checksumType = data[offset++];
+
+    // Read Compression Type
+    if (header.version >= COMPRESSION_VERSION)
+        header.compressionType = data[offset++];
+
+    // Read Coordinate Format
+    if (header.version >= FIXED_POINT_VERSION)
+        header.coordinateFormat = data[offset++];
+
+    // Anything past the fields is padding, keep it so a rewrite doesn't move the blocks
+    if (header.headerSize > offset)
+        header.headerAlignment = header.headerSize;
+
     return header;
 }
 
@@ -288,6 +355,82 @@ uint32_t HeaderRecord::getHeaderSize() const
     return headerSize;
 }
 
+uint32_t HeaderRecord::getHeaderAlignment() const
+{
+    return headerAlignment;
+}
+
+uint32_t HeaderRecord::getLayoutAlignment() const
+{
+    return layoutAlignment;
+}
+
+bool HeaderRecord::isAlignedLayout() const
+{
+    return layoutAlignment > 1;
+}
+
+bool HeaderRecord::hasValidLayout() const
+{
+    if (!isAlignedLayout())
+        return true;
+    // A power of two block either fills whole pages or packs evenly into one
+    return isPowerOfTwo(layoutAlignment) && isPowerOfTwo(blockSize) && headerSize % layoutAlignment == 0;
+}
+
+bool HeaderRecord::hasBinaryRecords() const
+{
+    if (version >= DICTIONARY_VERSION && sizeFormatType == SIZE_FORMAT_DICTIONARY)
+        return true;
+    if (version >= SLOTTED_DELTA_VERSION && sizeFormatType == SIZE_FORMAT_SLOTTED_DELTA)
+        return true;
+    return version >= BINARY_RECORD_VERSION &&
+           (sizeFormatType == SIZE_FORMAT_BINARY || sizeFormatType == SIZE_FORMAT_SLOTTED);
+}
+
+bool HeaderRecord::isPowerOfTwo(uint32_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+uint8_t HeaderRecord::getChecksumType() const
+{
+    return checksumType;
+}
+
+uint8_t HeaderRecord::getCompressionType() const
+{
+    return compressionType;
+}
+
+uint8_t HeaderRecord::getCoordinateFormat() const
+{
+    return coordinateFormat;
+}
+
+size_t HeaderRecord::getRecordCountOffset() const
+{
+    // fileStructureType, version, headerSize, sizeFormatType, blockSize, minBlockSize, then the two strings
+    return 4 + sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint16_t)
+         + sizeof(uint16_t) + indexFileName.length() + sizeof(uint16_t) + indexFileSchemaInfo.length();
+}
+
+size_t HeaderRecord::getBlockCountOffset() const
+{
+    return getRecordCountOffset() + (version >= LARGE_FILE_VERSION ? sizeof(uint64_t) : sizeof(uint32_t));
+}
+
+size_t HeaderRecord::getStaleFlagOffset() const
+{
+    size_t offset = getBlockCountOffset() + sizeof(uint32_t) + sizeof(uint16_t);
+    for (const auto& field : fields)
+    {
+        offset += sizeof(uint16_t) + field.name.length() + sizeof(uint8_t);
+    }
+    // primaryKeyField, availableListRBN, sequenceSetListRBN
+    return offset + sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+}
+
 uint8_t HeaderRecord::getSizeFormatType() const
 {
     return sizeFormatType;
@@ -313,7 +456,7 @@ const std::string& HeaderRecord::getIndexFileSchemaInfo() const
     return indexFileSchemaInfo;
 }
 
-uint32_t HeaderRecord::getRecordCount() const
+uint64_t HeaderRecord::getRecordCount() const
 {
     return recordCount;
 }
@@ -369,6 +512,31 @@ void HeaderRecord::setHeaderSize(uint32_t size)
     this->headerSize = size;
 }
 
+void HeaderRecord::setHeaderAlignment(uint32_t alignment)
+{
+    this->headerAlignment = alignment == 0 ? 1 : alignment;
+}
+
+void HeaderRecord::setLayoutAlignment(uint32_t alignment)
+{
+    this->layoutAlignment = alignment <= 1 ? 0 : alignment;
+}
+
+void HeaderRecord::setChecksumType(uint8_t type)
+{
+    this->checksumType = type;
+}
+
+void HeaderRecord::setCompressionType(uint8_t type)
+{
+    this->compressionType = type;
+}
+
+void HeaderRecord::setCoordinateFormat(uint8_t format)
+{
+    this->coordinateFormat = format;
+}
+
 void HeaderRecord::setSizeFormatType(uint8_t type)
 {
     this->sizeFormatType = type;
@@ -394,7 +562,7 @@ void HeaderRecord::setIndexFileSchemaInfo(const std::string& schemaInfo)
     this->indexFileSchemaInfo = schemaInfo;
 }
 
-void HeaderRecord::setRecordCount(uint32_t count)
+void HeaderRecord::setRecordCount(uint64_t count)
 {
     this->recordCount = count;
 }
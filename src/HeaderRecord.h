@@ -31,6 +31,27 @@ struct FieldDef
 class HeaderRecord
 {
 public:
+    static const uint16_t LARGE_FILE_VERSION = 3; // First version storing recordCount in 64 bits
+    static const uint16_t ALIGNED_LAYOUT_VERSION = 4; // First version storing the layout alignment
+    static const uint32_t PAGE_ALIGNMENT = 4096; // Typical OS page, the usual layout alignment
+    static const uint16_t CHECKSUM_VERSION = 5; // First version storing the block checksum type
+    static const uint8_t CHECKSUM_NONE = 0; // Blocks carry no trailer
+    static const uint8_t CHECKSUM_CRC32C = 1; // Blocks and index pages end in a CRC32C trailer
+    static const uint16_t BINARY_RECORD_VERSION = 6; // First version where sizeFormatType selects the record encoding
+    static const uint8_t SIZE_FORMAT_ASCII = 0; // Records are length prefixed CSV text
+    static const uint8_t SIZE_FORMAT_BINARY = 1; // Records use the binary encoding of RecordBuffer
+    static const uint8_t SIZE_FORMAT_SLOTTED = 2; // Binary records behind a sorted slot directory
+    static const uint16_t DICTIONARY_VERSION = 7; // First version accepting SIZE_FORMAT_DICTIONARY
+    static const uint8_t SIZE_FORMAT_DICTIONARY = 3; // Binary records naming state and county from a per block dictionary
+    static const uint16_t COMPRESSION_VERSION = 8; // First version storing the block compression type
+    static const uint8_t COMPRESSION_NONE = 0; // Blocks are stored as they are packed
+    static const uint8_t COMPRESSION_LZ = 1; // Block bodies go through BlockCodec's LZ codec
+    static const uint16_t FIXED_POINT_VERSION = 9; // First version storing the coordinate format
+    static const uint8_t COORDINATES_DEGREES = 0; // Binary records store coordinates as two doubles
+    static const uint8_t COORDINATES_MICRODEGREES = 1; // Binary records store coordinates as two int32 micro-degrees
+    static const uint16_t SLOTTED_DELTA_VERSION = 10; // First version accepting SIZE_FORMAT_SLOTTED_DELTA
+    static const uint8_t SIZE_FORMAT_SLOTTED_DELTA = 4; // Slotted records keyed by 16 bit deltas from a per block base zip
+
     /**
      * @brief Default constructor
      * @details Initializes all fields to default values
@@ -81,7 +102,7 @@ public:
      * @brief Record Count Getter
      * @returns recordCount
      */
-    uint32_t getRecordCount() const;
+    uint64_t getRecordCount() const;
 
     uint32_t getBlockCount() const;
     /**
@@ -147,6 +168,117 @@ public:
      * @param size new headerSize value
      */
     void setHeaderSize(uint32_t size);
+    /**
+     * @brief Header Alignment Setter
+     * @details serialize pads the header with zeros up to a multiple of alignment, so block 0
+     *          starts on an aligned offset as direct I/O requires. Not stored in the file, a
+     *          padded header read back keeps its size when written again.
+     * @param alignment New alignment in bytes, 0 or 1 for no padding
+     */
+    void setHeaderAlignment(uint32_t alignment);
+    /**
+     * @brief Header Alignment Getter
+     * @returns headerAlignment
+     */
+    uint32_t getHeaderAlignment() const;
+    /**
+     * @brief Layout Alignment Setter
+     * @details Selects the page aligned layout: the header is padded to a multiple of alignment and
+     *          block sizes must be powers of two, so no block straddles an alignment boundary and
+     *          each block read touches exactly one page. Stored from ALIGNED_LAYOUT_VERSION on so
+     *          readers can enforce it.
+     * @param alignment Page or sector size in bytes, a power of two. 0 or 1 for the packed layout
+     */
+    void setLayoutAlignment(uint32_t alignment);
+    /**
+     * @brief Layout Alignment Getter
+     * @returns layoutAlignment, 0 for the packed layout
+     */
+    uint32_t getLayoutAlignment() const;
+    /**
+     * @brief Checks if the header selects the page aligned layout
+     * @returns true if a layout alignment is set
+     */
+    bool isAlignedLayout() const;
+    /**
+     * @brief Checks the header against its layout
+     * @details The packed layout accepts any block size. The aligned layout needs a power of two
+     *          alignment and block size and a header size that is a multiple of the alignment.
+     * @returns true if blocks can be placed as the layout promises
+     */
+    bool hasValidLayout() const;
+    /**
+     * @brief Checks if a size is a power of two
+     * @param value The size
+     * @returns true for 1, 2, 4, ...
+     */
+    static bool isPowerOfTwo(uint32_t value);
+    /**
+     * @brief Checksum Type Setter
+     * @details Stored from CHECKSUM_VERSION on. With CHECKSUM_CRC32C the last
+     *          BlockChecksum::TRAILER_SIZE bytes of every block and index page hold the CRC of the
+     *          rest, so the usable block size shrinks by that much.
+     * @param type CHECKSUM_NONE or CHECKSUM_CRC32C
+     */
+    void setChecksumType(uint8_t type);
+    /**
+     * @brief Checksum Type Getter
+     * @returns checksumType, CHECKSUM_NONE before CHECKSUM_VERSION
+     */
+    uint8_t getChecksumType() const;
+    /**
+     * @brief Compression Type Setter
+     * @details Stored from COMPRESSION_VERSION on. With COMPRESSION_LZ every sequence set block keeps
+     *          BlockCodec::FRAME_HEADER_SIZE bytes for the stored body length, so the usable block size
+     *          shrinks by that much. Index pages are never compressed.
+     * @param type COMPRESSION_NONE or COMPRESSION_LZ
+     */
+    void setCompressionType(uint8_t type);
+    /**
+     * @brief Compression Type Getter
+     * @returns compressionType, COMPRESSION_NONE before COMPRESSION_VERSION
+     */
+    uint8_t getCompressionType() const;
+    /**
+     * @brief Coordinate Format Setter
+     * @details Stored from FIXED_POINT_VERSION on. Only binary record encodings store coordinates as
+     *          numbers, text records always hold six decimal text.
+     * @param format COORDINATES_DEGREES or COORDINATES_MICRODEGREES
+     */
+    void setCoordinateFormat(uint8_t format);
+    /**
+     * @brief Coordinate Format Getter
+     * @returns coordinateFormat, COORDINATES_DEGREES before FIXED_POINT_VERSION
+     */
+    uint8_t getCoordinateFormat() const;
+    /**
+     * @brief Checks if blocks hold binary encoded records
+     * @details Older versions always wrote SIZE_FORMAT_ASCII, so the size format is only trusted from
+     *          BINARY_RECORD_VERSION on.
+     * @returns True for a BINARY_RECORD_VERSION file with SIZE_FORMAT_BINARY or SIZE_FORMAT_SLOTTED,
+     *          a DICTIONARY_VERSION file with SIZE_FORMAT_DICTIONARY, or a SLOTTED_DELTA_VERSION file
+     *          with SIZE_FORMAT_SLOTTED_DELTA
+     */
+    bool hasBinaryRecords() const;
+    /**
+     * @brief Record Count Offset Getter
+     * @details Byte position of recordCount in the serialized header, for patching it in place
+     * @returns offset from the start of the file
+     */
+    size_t getRecordCountOffset() const;
+    /**
+     * @brief Block Count Offset Getter
+     * @details Byte position of blockCount in the serialized header, for patching it in place
+     * @returns offset from the start of the file
+     */
+    size_t getBlockCountOffset() const;
+    /**
+     * @brief Stale Flag Offset Getter
+     * @details Byte position of staleFlag in the serialized header. Not headerSize - 1 once the
+     *          header is padded.
+     * @returns offset from the start of the file
+     */
+    size_t getStaleFlagOffset() const;
     /**
      * @brief Size Format Type Setter
      * @details sets sizeFormatType to type
@@ -167,10 +299,10 @@ public:
     void setIndexFileSchemaInfo(const std::string& schemaInfo);
     /**
      * @brief Record Count Setter
-     * @details sets recordCount to count
+     * @details sets recordCount to count. Versions before LARGE_FILE_VERSION store only 32 bits.
      * @param count new recordCount value
      */
-    void setRecordCount(uint32_t count);
+    void setRecordCount(uint64_t count);
 
     void setBlockCount(uint32_t count);
     /**
@@ -245,7 +377,7 @@ private:
 
     std::string indexFileSchemaInfo; // Schema information for the index file
 
-    uint32_t recordCount; // Total number of records
+    uint64_t recordCount; // Total number of records, 32 bits on disk before LARGE_FILE_VERSION
 
     uint32_t blockCount; // Total number of blocks in the file
 
@@ -260,6 +392,16 @@ private:
     uint32_t sequenceSetListRBN; // RBN of the sequence set list
    
     uint8_t staleFlag; // Boolean flag that determines if the index file is valid
+
+    uint32_t headerAlignment; // Serialized size is padded to a multiple of this, not stored
+
+    uint32_t layoutAlignment; // Page aligned layout boundary, 0 for packed. Stored from ALIGNED_LAYOUT_VERSION
+
+    uint8_t checksumType; // Block trailer kind, CHECKSUM_NONE or CHECKSUM_CRC32C. Stored from CHECKSUM_VERSION
+
+    uint8_t compressionType; // Block codec, COMPRESSION_NONE or COMPRESSION_LZ. Stored from COMPRESSION_VERSION
+
+    uint8_t coordinateFormat; // COORDINATES_DEGREES or COORDINATES_MICRODEGREES. Stored from FIXED_POINT_VERSION
 };
 
 #endif
\ No newline at end of file
@@ -1,10 +1,34 @@
 #include "NodeAlt.h"
 
-NodeAlt::NodeAlt(bool isLeaf, size_t blockSize)
+namespace
+{
+    const size_t NODE_HEADER_SIZE = 1 + 4 + 4; // type + count + parent
+    const size_t LEAF_LINKS_SIZE = 8; // prev + next RBNs
+
+    inline void appendUint32(std::vector<uint8_t>& data, uint32_t value)
+    {
+        data.insert(data.end(), reinterpret_cast<const uint8_t*>(&value),
+                    reinterpret_cast<const uint8_t*>(&value) + sizeof(value));
+    }
+
+    /**
+     * @brief Reads a key offset of width bytes, least significant byte first.
+     */
+    inline uint32_t readOffset(const uint8_t* in, uint8_t width)
+    {
+        uint32_t offset = 0;
+        for (uint8_t i = 0; i < width; ++i)
+            offset |= static_cast<uint32_t>(in[i]) << (8 * i);
+        return offset;
+    }
+}
+
+NodeAlt::NodeAlt(bool isLeaf, size_t blockSize, KeyEncoding keyEncoding)
 {
     this->isLeaf = isLeaf;
     this->blockSize = blockSize;
     this->maxKeys = calculateMaxKeys(blockSize, isLeaf);
+    this->keyEncoding = keyEncoding;
     this->parentRBN = 0;
     this->prevLeafRBN = 0;
     this->nextLeafRBN = 0;
@@ -35,7 +59,7 @@ bool NodeAlt::setKeyAt(size_t index, uint32_t key)
 
 bool NodeAlt::insertKeyAt(size_t index, uint32_t key)
 {
-    if(index > keys.size() || isFull())
+    if(index > keys.size() || !hasRoomFor(key))
     {
         setError("Out of bounds or full in setKeyAt");
         return false;
@@ -59,7 +83,7 @@ bool NodeAlt::removeKeyAt(size_t index)
 
 bool NodeAlt::insertChildRBN(size_t index, uint32_t rbn)
 {
-    if (index > childRBNs.size() || (!isLeaf && childRBNs.size() >= maxKeys + 1))
+    if (index > childRBNs.size() || (!isLeaf && childRBNs.size() >= getMaxKeys() + 1))
     {
         setError("Index out of bounds or too many children in insertChildRBN");
         return false;
@@ -83,12 +107,51 @@ bool NodeAlt::removeChildRBN(size_t index)
 
 bool NodeAlt::isFull() const
 {
-    return getKeyCount() >= maxKeys;
+    return getKeyCount() >= getMaxKeys();
+}
+
+bool NodeAlt::hasRoomFor(uint32_t key) const
+{
+    if (keyEncoding == KeyEncoding::Full || keys.empty())
+        return !isFull();
+    return getKeyCount() + 1 <= getCapacityFor(std::min(keys.front(), key), std::max(keys.back(), key));
+}
+
+size_t NodeAlt::getCapacityFor(uint32_t lowKey, uint32_t highKey) const
+{
+    if (keyEncoding == KeyEncoding::Full)
+        return maxKeys;
+    return calculateMaxKeys(blockSize, isLeaf == 1, keyEncoding, highKey - lowKey);
+}
+
+bool NodeAlt::canMergeWith(const NodeAlt& sibling, size_t separatorKeys, uint32_t separatorKey) const
+{
+    size_t total = getKeyCount() + sibling.getKeyCount() + separatorKeys;
+    if (keyEncoding == KeyEncoding::Full)
+        return total <= maxKeys;
+
+    // The merged keys range over both nodes and the separator
+    std::vector<uint32_t> bounds;
+    if (separatorKeys > 0)
+        bounds.push_back(separatorKey);
+    for (const NodeAlt* node : {this, &sibling})
+    {
+        if (!node->keys.empty())
+        {
+            bounds.push_back(node->keys.front());
+            bounds.push_back(node->keys.back());
+        }
+    }
+    if (bounds.empty())
+        return true;
+    std::pair<std::vector<uint32_t>::iterator, std::vector<uint32_t>::iterator> range =
+        std::minmax_element(bounds.begin(), bounds.end());
+    return total <= getCapacityFor(*range.first, *range.second);
 }
 
 bool NodeAlt::isUnderfull() const
 {
-    size_t minKeys = (maxKeys + 1) / 2;
+    size_t minKeys = (getMaxKeys() + 1) / 2;
     return getKeyCount() < minKeys;
 }
 
@@ -106,7 +169,8 @@ bool NodeAlt::setValueAt(size_t index, uint32_t value)
 
 bool NodeAlt::insertValueAt(size_t index, uint32_t value)
 {
-    if(index > values.size() || isFull())
+    // Callers insert the key first, so the node is checked against its values, not its keys
+    if(index > values.size() || values.size() >= getMaxKeys())
     {
         setError("Out of bounds or full in insertValueAt");
         return false;
@@ -136,12 +200,24 @@ bool NodeAlt::unpack(const std::vector<uint8_t>& data)
         return false;
     }
 
+    // A loaded node keeps the block size it was created with
+    size_t pageSize = blockSize;
     clear();
+    blockSize = pageSize;
+
+    NodePage page(data);
+    if(!page.isValid())
+    {
+        setError("Node page entries run past the block in node unpack function.");
+        return false;
+    }
 
     size_t offset = 0;
 
-    // Read Leaf Type
-    isLeaf = (data[offset++]);
+    // Read Leaf Type and key layout
+    uint8_t type = data[offset++];
+    isLeaf = type & 1;
+    keyEncoding = (type & FRAME_OF_REFERENCE_FLAG) ? KeyEncoding::FrameOfReference : KeyEncoding::Full;
 
     // Read Key Count
     uint32_t keyCount;
@@ -161,7 +237,35 @@ bool NodeAlt::unpack(const std::vector<uint8_t>& data)
         // Read Next Leaf
         memcpy(&nextLeafRBN, data.data() + offset, sizeof(uint32_t));
         offset += sizeof(uint32_t);
+    }
 
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+    {
+        // The view already checked the page, decode every key and copy the values or children
+        keys.resize(keyCount);
+        for(uint32_t i = 0; i < keyCount; ++i)
+        {
+            keys[i] = page.getKeyAt(i);
+        }
+        if(isLeaf == 1)
+        {
+            values.resize(keyCount);
+            for(uint32_t i = 0; i < keyCount; ++i)
+            {
+                values[i] = page.getValueAt(i);
+            }
+        }
+        else
+        {
+            childRBNs.resize(keyCount + 1);
+            for(uint32_t i = 0; i < keyCount + 1; ++i)
+            {
+                childRBNs[i] = page.getChildRBN(i);
+            }
+        }
+    }
+    else if(isLeaf == 1)
+    {
         // Read keys and values
         keys.resize(keyCount);
         values.resize(keyCount);
@@ -215,7 +319,21 @@ size_t NodeAlt::getBlockSize() const
 
 size_t NodeAlt::getMaxKeys() const
 {
-    return maxKeys;
+    if (keyEncoding == KeyEncoding::Full)
+        return maxKeys;
+    if (keys.empty())
+        return calculateMaxKeys(blockSize, isLeaf == 1, keyEncoding, 0);
+    return getCapacityFor(keys.front(), keys.back());
+}
+
+KeyEncoding NodeAlt::getKeyEncoding() const
+{
+    return keyEncoding;
+}
+
+void NodeAlt::setKeyEncoding(KeyEncoding encoding)
+{
+    keyEncoding = encoding;
 }
 
 size_t NodeAlt::getChildCount() const
@@ -276,6 +394,28 @@ size_t NodeAlt::calculateMaxKeys(size_t blockSize, bool isLeaf)
     }
 }
 
+size_t NodeAlt::calculateMaxKeys(size_t blockSize, bool isLeaf, KeyEncoding encoding, uint32_t keySpan)
+{
+    if (encoding == KeyEncoding::Full)
+        return calculateMaxKeys(blockSize, isLeaf);
+
+    // Base key and width after the usual header, then the offsets, then the values or children
+    size_t headerSize = NODE_HEADER_SIZE + FRAME_OF_REFERENCE_SIZE + (isLeaf ? LEAF_LINKS_SIZE : 4);
+    size_t entrySize = keyWidthFor(keySpan) + 4;
+    if (blockSize < headerSize + entrySize)
+        return isLeaf ? 0 : 1;
+    return (blockSize - headerSize) / entrySize;
+}
+
+uint8_t NodeAlt::keyWidthFor(uint32_t keySpan)
+{
+    if (keySpan <= 0xFF)
+        return 1;
+    if (keySpan <= 0xFFFF)
+        return 2;
+    return keySpan <= 0xFFFFFF ? 3 : 4;
+}
+
 uint32_t NodeAlt::getKeyAt(size_t index) const
 {
     if(index >= keys.size())
@@ -381,8 +521,38 @@ void NodeAlt::pack(std::vector<uint8_t>& data) const
     data.insert(data.end(), reinterpret_cast<const uint8_t*>(&parentRBN),
                 reinterpret_cast<const uint8_t*>(&parentRBN) + sizeof(parentRBN));
 
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+    {
+        data[0] |= FRAME_OF_REFERENCE_FLAG;
+        if(isLeaf == 1)
+        {
+            appendUint32(data, prevLeafRBN);
+            appendUint32(data, nextLeafRBN);
+        }
+
+        // Base key and width, then each key as its offset from the base
+        uint32_t base = keys.empty() ? 0 : keys.front();
+        uint8_t width = keyWidthFor(keys.empty() ? 0 : keys.back() - base);
+        appendUint32(data, base);
+        data.push_back(width);
+        for(uint32_t key : keys)
+        {
+            uint32_t offset = key - base;
+            for(uint8_t i = 0; i < width; ++i)
+            {
+                data.push_back(static_cast<uint8_t>(offset >> (8 * i)));
+            }
+        }
+
+        // Values or children stay full width after the keys
+        const std::vector<uint32_t>& entries = isLeaf == 1 ? values : childRBNs;
+        for(uint32_t entry : entries)
+        {
+            appendUint32(data, entry);
+        }
+    }
     // If leaf node write prev and next rbn
-    if(isLeaf == 1)
+    else if(isLeaf == 1)
     {
         // Prev Leaf RBN
         data.insert(data.end(), reinterpret_cast<const uint8_t*>(&prevLeafRBN),
@@ -438,4 +608,159 @@ void NodeAlt::setError(const std::string& message)
 std::string NodeAlt::getErrorMessage() const
 {
     return errorMessage;
+}
+
+NodePage::NodePage(const std::vector<uint8_t>& data)
+    : page(data.data()), valid(false), leaf(false), keyEncoding(KeyEncoding::Full), keyCount(0),
+      keysOffset(0), keyStride(sizeof(uint32_t)), keyWidth(sizeof(uint32_t)), baseKey(0), entriesOffset(0),
+      entryStride(sizeof(uint32_t))
+{
+    if(data.size() < NODE_HEADER_SIZE)
+        return;
+
+    leaf = (page[0] & 1) != 0;
+    keyEncoding = (page[0] & NodeAlt::FRAME_OF_REFERENCE_FLAG) ? KeyEncoding::FrameOfReference : KeyEncoding::Full;
+    uint32_t count;
+    memcpy(&count, page + 1, sizeof(count));
+    if(count > data.size())
+        return;
+    keyCount = count;
+
+    size_t offset = NODE_HEADER_SIZE + (leaf ? LEAF_LINKS_SIZE : 0);
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+    {
+        if(offset + NodeAlt::FRAME_OF_REFERENCE_SIZE > data.size())
+            return;
+        memcpy(&baseKey, page + offset, sizeof(baseKey));
+        keyWidth = page[offset + sizeof(baseKey)];
+        if(keyWidth < 1 || keyWidth > sizeof(uint32_t))
+            return;
+        keysOffset = offset + NodeAlt::FRAME_OF_REFERENCE_SIZE;
+        keyStride = keyWidth;
+        entriesOffset = keysOffset + keyCount * keyWidth;
+    }
+    else if(leaf)
+    {
+        // Key and value pairs
+        keysOffset = offset;
+        keyStride = 2 * sizeof(uint32_t);
+        entriesOffset = offset + sizeof(uint32_t);
+        entryStride = 2 * sizeof(uint32_t);
+    }
+    else
+    {
+        keysOffset = offset;
+        entriesOffset = offset + keyCount * sizeof(uint32_t);
+    }
+
+    size_t entryCount = leaf ? keyCount : keyCount + 1;
+    size_t end = entryCount == 0 ? entriesOffset : entriesOffset + (entryCount - 1) * entryStride + sizeof(uint32_t);
+    valid = end <= data.size();
+}
+
+bool NodePage::isValid() const
+{
+    return valid;
+}
+
+bool NodePage::isLeaf() const
+{
+    return leaf;
+}
+
+KeyEncoding NodePage::getKeyEncoding() const
+{
+    return keyEncoding;
+}
+
+size_t NodePage::getKeyCount() const
+{
+    return valid ? keyCount : 0;
+}
+
+uint32_t NodePage::getKeyAt(size_t index) const
+{
+    if(!valid || index >= keyCount)
+        return 0;
+    uint32_t stored = storedKeyAt(index);
+    return keyEncoding == KeyEncoding::FrameOfReference ? baseKey + stored : stored;
+}
+
+uint32_t NodePage::getValueAt(size_t index) const
+{
+    if(!valid || !leaf || index >= keyCount)
+        return 0;
+    uint32_t value;
+    memcpy(&value, page + entriesOffset + index * entryStride, sizeof(value));
+    return value;
+}
+
+uint32_t NodePage::getChildRBN(size_t index) const
+{
+    if(!valid || leaf || index > keyCount)
+        return 0;
+    uint32_t rbn;
+    memcpy(&rbn, page + entriesOffset + index * entryStride, sizeof(rbn));
+    return rbn;
+}
+
+size_t NodePage::lowerBound(uint32_t key) const
+{
+    if(!valid)
+        return 0;
+    // Every offset is counted from the smallest key, compare offsets instead of decoding keys
+    uint32_t target = key;
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+    {
+        if(key <= baseKey)
+            return 0;
+        target = key - baseKey;
+    }
+
+    size_t low = 0;
+    size_t high = keyCount;
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if(storedKeyAt(middle) < target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+size_t NodePage::upperBound(uint32_t key) const
+{
+    if(!valid)
+        return 0;
+    uint32_t target = key;
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+    {
+        if(key < baseKey)
+            return 0;
+        target = key - baseKey;
+    }
+
+    size_t low = 0;
+    size_t high = keyCount;
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if(storedKeyAt(middle) <= target)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+uint32_t NodePage::storedKeyAt(size_t index) const
+{
+    const uint8_t* stored = page + keysOffset + index * keyStride;
+    if(keyEncoding == KeyEncoding::FrameOfReference)
+        return readOffset(stored, keyWidth);
+    uint32_t key;
+    memcpy(&key, stored, sizeof(key));
+    return key;
 }
\ No newline at end of file
@@ -7,6 +7,21 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+
+/**
+ * @brief How a node page stores its keys.
+ * @details Full is the original layout, every key a uint32. FrameOfReference stores the smallest
+ *          key of the node as a uint32 base, then every key as its offset from the base in the
+ *          fewest bytes (1 to 4) that hold the largest offset. Keys of one node are sorted and
+ *          usually close, so most pages need 1 or 2 bytes a key and hold more entries. The page
+ *          type byte says which layout a page uses, so both can be read from any tree.
+ */
+enum class KeyEncoding : uint8_t
+{
+    Full,
+    FrameOfReference
+};
+
 /**
  * @class NodeAlt
  * @brief Node class used for building a B+ tree. Used for both index and leaf nodes.
@@ -20,8 +35,9 @@ public:
      * @details Initializes a node based with it's status as leaf or index and it's block size.
      * @param isLeaf Is the node a leaf or index.
      * @param blockSize What is the standard block size used by nodes.
+     * @param keyEncoding How pack stores the keys, Full by default.
      */
-    NodeAlt(bool isLeaf, size_t blockSize);
+    NodeAlt(bool isLeaf, size_t blockSize, KeyEncoding keyEncoding = KeyEncoding::Full);
     
     /**
      * @brief Default Destructor
@@ -80,6 +96,30 @@ public:
      */
     bool isFull() const;
 
+    /**
+     * @brief Checks if one more key fits the page.
+     * @details Under FrameOfReference a key outside the current key range can widen every stored key,
+     *          so a node that is not full may still have no room for a particular key.
+     * @param key The key that would be inserted.
+     * @return True if the node can take the key and its value or child.
+     */
+    bool hasRoomFor(uint32_t key) const;
+
+    /**
+     * @brief Gets the most keys a node of this kind holds when they range from lowKey to highKey.
+     * @details Used to check a merge fits before moving anything. The same as getMaxKeys under Full.
+     */
+    size_t getCapacityFor(uint32_t lowKey, uint32_t highKey) const;
+
+    /**
+     * @brief Checks if the keys of this node and a sibling fit one node.
+     * @param sibling The node that would be merged with this one.
+     * @param separatorKeys 1 when the parent separator comes down too, as in an index merge.
+     * @param separatorKey The parent separator.
+     * @return True if the merged node would not overflow its page.
+     */
+    bool canMergeWith(const NodeAlt& sibling, size_t separatorKeys = 0, uint32_t separatorKey = 0) const;
+
     /**
      * @brief Checks if the node is underfull (has fewer than the minimum required keys).
      * @return True if the node is underfull. False otherwise.
@@ -139,10 +179,21 @@ public:
 
     /**
      * @brief Gets the maximum number of keys this node can hold.
+     * @details Under FrameOfReference this is the capacity at the width the current keys need.
      * @return The maximum key capacity.
      */
     size_t getMaxKeys() const;
 
+    /**
+     * @brief Gets how pack stores the keys.
+     */
+    KeyEncoding getKeyEncoding() const;
+
+    /**
+     * @brief Sets how pack stores the keys. Any node converts when it is next written.
+     */
+    void setKeyEncoding(KeyEncoding encoding);
+
     /**
      * @brief Gets the current number of child pointers in the node.
      * @details Only applicable for index nodes. Typically equals key count + 1.
@@ -166,6 +217,23 @@ public:
      */
     static size_t calculateMaxKeys(size_t blockSize, bool isLeaf);
 
+    /**
+     * @brief Calculates the maximum number of keys that fit a node under a key encoding.
+     * @param blockSize The size of the block in bytes.
+     * @param isLeaf Whether the node is a leaf.
+     * @param encoding The key encoding.
+     * @param keySpan Largest key less the smallest, only used by FrameOfReference.
+     * @return The maximum number of keys that can be stored.
+     */
+    static size_t calculateMaxKeys(size_t blockSize, bool isLeaf, KeyEncoding encoding, uint32_t keySpan);
+
+    /**
+     * @brief Bytes a FrameOfReference page stores each key offset in.
+     * @param keySpan Largest key less the smallest.
+     * @return 1, 2, 3 or 4.
+     */
+    static uint8_t keyWidthFor(uint32_t keySpan);
+
     /**
      * @brief Gets the key at the specified index.
      * @param index The index of the key to retrieve.
@@ -274,13 +342,17 @@ public:
      */
     std::string getErrorMessage() const;
 
+    static const uint8_t FRAME_OF_REFERENCE_FLAG = 0x02; // Set in the page type byte of a FrameOfReference page
+    static const size_t FRAME_OF_REFERENCE_SIZE = 5; // Base key and key width ahead of the keys
+
 private:
     // Common Node Data
     uint8_t isLeaf;                    // Flag indicating if this is a leaf (1) or index (0) node
     size_t blockSize;                  // Size of the block in bytes
     std::vector<uint32_t> keys;        // Sorted array of keys in the node
     uint32_t parentRBN;                // RBN of the parent node
-    size_t maxKeys;                    // Maximum number of keys this node can hold
+    size_t maxKeys;                    // Maximum number of keys this node can hold, Full only
+    KeyEncoding keyEncoding;           // Layout pack writes the keys in
 
     // Leaf Node Data
     std::vector<uint32_t> values;      // Values corresponding to keys (leaf nodes only)
@@ -300,4 +372,86 @@ private:
      */
     void setError(const std::string& message);
 };
+
+/**
+ * @class NodePage
+ * @brief Reads a packed node page in place, without unpacking it into a NodeAlt.
+ * @details Searches binary search the stored keys, decoding only the keys they probe, so a descent
+ *          through the tree copies nothing but the one child RBN it follows. Reads pages in either
+ *          key encoding. The page must outlive the view.
+ */
+class NodePage
+{
+public:
+    /**
+     * @brief Parameterized Constructor
+     * @param data A page as NodeAlt::pack writes it.
+     */
+    explicit NodePage(const std::vector<uint8_t>& data);
+
+    /**
+     * @brief Checks the page header and that its entries lie inside the page.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Returns whether the page holds a leaf node.
+     */
+    bool isLeaf() const;
+
+    /**
+     * @brief Gets the key encoding the page was written with.
+     */
+    KeyEncoding getKeyEncoding() const;
+
+    /**
+     * @brief Gets the number of keys stored in the page.
+     */
+    size_t getKeyCount() const;
+
+    /**
+     * @brief Decodes the key at index, 0 if out of range.
+     */
+    uint32_t getKeyAt(size_t index) const;
+
+    /**
+     * @brief Gets the value at index of a leaf page, 0 if out of range.
+     */
+    uint32_t getValueAt(size_t index) const;
+
+    /**
+     * @brief Gets the child RBN at index of an index page, 0 if out of range.
+     */
+    uint32_t getChildRBN(size_t index) const;
+
+    /**
+     * @brief Finds the first key not less than key.
+     * @return Its index, getKeyCount if every key is smaller.
+     */
+    size_t lowerBound(uint32_t key) const;
+
+    /**
+     * @brief Finds the first key greater than key, the child NodeAlt::findChildIndex picks.
+     * @return Its index, getKeyCount if no key is greater.
+     */
+    size_t upperBound(uint32_t key) const;
+
+private:
+    const uint8_t* page;               // The packed page
+    bool valid;                        // Header read and entries inside the page
+    bool leaf;                         // Leaf or index page
+    KeyEncoding keyEncoding;           // Layout of the keys
+    size_t keyCount;                   // Keys stored
+    size_t keysOffset;                 // First key
+    size_t keyStride;                  // Bytes from one key to the next
+    uint8_t keyWidth;                  // Bytes of one stored key
+    uint32_t baseKey;                  // Key the stored offsets count from, FrameOfReference
+    size_t entriesOffset;              // First value or child RBN
+    size_t entryStride;                // Bytes from one value or child RBN to the next
+
+    /**
+     * @brief Reads the stored form of the key at index, the key itself or its offset from the base.
+     */
+    uint32_t storedKeyAt(size_t index) const;
+};
 #endif // NODE_ALT_H
\ No newline at end of file
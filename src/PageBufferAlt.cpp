@@ -1,6 +1,12 @@
 #include "PageBufferAlt.h"
+#include "Block.h"
+#include "HeaderRecord.h"
 
-PageBufferAlt::PageBufferAlt() : isOpen(false), errorState(false), lastError("") 
+PageBufferAlt::PageBufferAlt() : cache(nullptr), cacheFileId(CacheManager::NO_FILE),
+                                 dirtyPageLimit(DEFAULT_DIRTY_PAGE_LIMIT), physicalWrites(0),
+                                 layoutAlignment(0), trailerSize(0),
+                                 verifyPolicy(BlockChecksum::VerifyPolicy::FirstRead), checksumStats(),
+                                 isOpen(false), errorState(false), lastError("") 
 {
 }
 
@@ -8,7 +14,7 @@ PageBufferAlt::~PageBufferAlt()
 {
     if (isOpen) 
     {
-        file.close();
+        closeFile();
     }
 }
 
@@ -17,21 +23,103 @@ std::string PageBufferAlt::getFileName() const
     return fileName;
 }
 
-bool PageBufferAlt::open(const std::string& filename, size_t blockSize, size_t headerSize) 
+bool PageBufferAlt::open(const std::string& filename, size_t blockSize, size_t headerSize, bool directIO) 
 {
+    if (isOpen)
+    {
+        closeFile(); // don't lose dirty pages or leave the old streams open
+    }
+    if (directIO && (headerSize % BlockFile::DIRECT_IO_ALIGNMENT != 0 || blockSize % BlockFile::DIRECT_IO_ALIGNMENT != 0))
+    {
+        setError("Direct I/O needs a sector aligned header and block size: " + filename);
+        return false;
+    }
+    if (layoutAlignment > 1 && (headerSize % layoutAlignment != 0 || !HeaderRecord::isPowerOfTwo(static_cast<uint32_t>(blockSize))))
+    {
+        setError("Page aligned layout needs a padded header and a power of two block size: " + filename);
+        return false;
+    }
     this->blockSize = blockSize;
     this->headerSize = headerSize;
     setFileName(filename);
     file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
-    if (!file.is_open()) 
+    if (!file.is_open() || !blockIO.open(filename, false, directIO)) 
     {
+        file.close();
         setError("Failed to open file: " + filename);
         return false;
     }
     isOpen = true;
+    if (cache != nullptr)
+    {
+        cacheFileId = cache->registerFile(filename, blockSize, headerSize);
+        cache->dropFile(cacheFileId);
+    }
     return true;
 }
 
+void PageBufferAlt::setLayoutAlignment(uint32_t alignment)
+{
+    layoutAlignment = alignment <= 1 ? 0 : alignment;
+}
+
+uint32_t PageBufferAlt::getLayoutAlignment() const
+{
+    return layoutAlignment;
+}
+
+void PageBufferAlt::setChecksums(bool enabled)
+{
+    trailerSize = enabled ? BlockChecksum::TRAILER_SIZE : 0;
+}
+
+bool PageBufferAlt::hasChecksums() const
+{
+    return trailerSize > 0;
+}
+
+void PageBufferAlt::setVerifyPolicy(BlockChecksum::VerifyPolicy policy)
+{
+    verifyPolicy = policy;
+}
+
+BlockChecksum::Stats PageBufferAlt::getChecksumStats() const
+{
+    return checksumStats;
+}
+
+bool PageBufferAlt::verifyPage(uint32_t rbn, const char* page)
+{
+    checksumStats.verified++;
+    if (BlockChecksum::verify(page, blockSize))
+        return true;
+    checksumStats.failures++;
+    setError("Checksum mismatch at index RBN: " + std::to_string(rbn));
+    return false;
+}
+
+void PageBufferAlt::attachCache(CacheManager* manager)
+{
+    if (manager == cache)
+        return;
+    if (cache != nullptr && cacheFileId != CacheManager::NO_FILE)
+        cache->dropFile(cacheFileId);
+
+    cache = manager;
+    cacheFileId = CacheManager::NO_FILE;
+    if (cache != nullptr && isOpen)
+    {
+        cacheFileId = cache->registerFile(fileName, blockSize, headerSize);
+        cache->dropFile(cacheFileId);
+    }
+}
+
+void PageBufferAlt::setPagePriority(uint32_t rbn, CacheManager::Priority priority)
+{
+    if (cache != nullptr && cacheFileId != CacheManager::NO_FILE)
+        cache->setPriority(cacheFileId, rbn, priority);
+}
+
 void PageBufferAlt::setFileName(const std::string& filename)
 {
     this->fileName = filename;
@@ -42,6 +130,11 @@ bool PageBufferAlt::getIsOpen() const
     return isOpen;
 }
 
+bool PageBufferAlt::isDirectIO() const
+{
+    return blockIO.isDirect();
+}
+
 bool PageBufferAlt::readBlock(uint32_t rbn, std::vector<uint8_t>& data)
 {
     if (!isOpen) 
@@ -50,15 +143,70 @@ bool PageBufferAlt::readBlock(uint32_t rbn, std::vector<uint8_t>& data)
         return false;
     }
 
+    auto dirty = dirtyPages.find(rbn);
+    if (dirty != dirtyPages.end())
+    {
+        data = dirty->second; // newest copy has not reached the file yet
+        return true;
+    }
+
+    const bool checkFileReads = trailerSize > 0 && verifyPolicy != BlockChecksum::VerifyPolicy::Never;
+    if (cache != nullptr && cacheFileId != CacheManager::NO_FILE)
+    {
+        char* frame = cache->pin(cacheFileId, rbn);
+        bool loaded = frame != nullptr;
+        bool verified = loaded && (trailerSize == 0 || verifyPolicy != BlockChecksum::VerifyPolicy::Always ||
+                                   verifyPage(rbn, frame));
+        if (!loaded)
+        {
+            frame = cache->claim(cacheFileId, rbn, CacheManager::Priority::IndexLeaf);
+            if (frame != nullptr && !readBlockInto(rbn, frame))
+            {
+                cache->discard(cacheFileId, rbn);
+                setError("Failed to read full block at RBN: " + std::to_string(rbn));
+                return false;
+            }
+            loaded = frame != nullptr;
+            verified = loaded && (!checkFileReads || verifyPage(rbn, frame));
+        }
+        if (loaded && !verified)
+        {
+            // Drop the bad copy so the next read goes back to the file
+            cache->unpin(cacheFileId, rbn, false);
+            cache->discard(cacheFileId, rbn);
+            return false;
+        }
+        if (loaded)
+        {
+            data.assign(frame, frame + blockSize);
+            cache->unpin(cacheFileId, rbn, false);
+            return true;
+        }
+    }
+
     data.resize(blockSize);
-    file.seekg(headerSize + rbn * blockSize, std::ios::beg);
-    file.read(reinterpret_cast<char*>(data.data()), blockSize);
-    if (file.gcount() < static_cast<std::streamsize>(blockSize)) 
+    if (!readBlockInto(rbn, reinterpret_cast<char*>(data.data()))) 
     {
         setError("Failed to read full block at RBN: " + std::to_string(rbn));
         return false;
     }
-    return true;
+    return !checkFileReads || verifyPage(rbn, reinterpret_cast<const char*>(data.data()));
+}
+
+bool PageBufferAlt::readBlockInto(uint32_t rbn, char* dest) const
+{
+    if (!isOpen) 
+        return false;
+
+    auto dirty = dirtyPages.find(rbn);
+    if (dirty != dirtyPages.end())
+    {
+        std::copy(dirty->second.begin(), dirty->second.end(), dest);
+        return true;
+    }
+
+    uint64_t offset = headerSize + static_cast<uint64_t>(rbn) * blockSize;
+    return blockIO.readAt(offset, dest, blockSize) == static_cast<long long>(blockSize);
 }
 
 bool PageBufferAlt::writeBlock(uint32_t rbn, const std::vector<uint8_t>& data)
@@ -74,19 +222,111 @@ bool PageBufferAlt::writeBlock(uint32_t rbn, const std::vector<uint8_t>& data)
         return false;
     }
 
-    file.seekp(headerSize + rbn * blockSize, std::ios::beg);
-    file.write(reinterpret_cast<const char*>(data.data()), blockSize);
-    if (!file) 
+    // The trailer goes on a copy, the caller's page stays as it was
+    const std::vector<uint8_t>* page = &data;
+    std::vector<uint8_t> stamped;
+    if (trailerSize > 0)
+    {
+        stamped = data;
+        BlockChecksum::stamp(reinterpret_cast<char*>(stamped.data()), blockSize);
+        page = &stamped;
+    }
+
+    // Cached copy stays clean, the dirty page or the write below is what reaches the file
+    if (cache != nullptr && cacheFileId != CacheManager::NO_FILE)
+        cache->refresh(cacheFileId, rbn, reinterpret_cast<const char*>(page->data()));
+
+    if (dirtyPageLimit > 0)
+    {
+        // Write-back: the same node written several times in one operation costs one write
+        dirtyPages[rbn] = *page;
+        if (dirtyPages.size() >= dirtyPageLimit)
+        {
+            return sync();
+        }
+        return true;
+    }
+
+    uint64_t offset = headerSize + static_cast<uint64_t>(rbn) * blockSize;
+    if (!blockIO.writeAt(offset, reinterpret_cast<const char*>(page->data()), blockSize)) 
     {
         setError("Failed to write full block at RBN: " + std::to_string(rbn));
         return false;
     }
-    
-    file.flush();
+    ++physicalWrites;
 
     return true;
 }
 
+bool PageBufferAlt::sync()
+{
+    if (!isOpen)
+    {
+        return dirtyPages.empty();
+    }
+
+    bool success = true;
+    BlockImage run(dirtyPages.size() * blockSize); // aligned so direct mode writes it as is
+    size_t runLength = 0;
+    uint32_t runStart = 0;
+    uint32_t nextRBN = 0;
+
+    auto writeRun = [&]()
+    {
+        if (runLength == 0)
+            return;
+        uint64_t offset = headerSize + static_cast<uint64_t>(runStart) * blockSize;
+        if (!blockIO.writeAt(offset, run.data(), runLength))
+        {
+            setError("Failed to write dirty pages starting at RBN: " + std::to_string(runStart));
+            success = false;
+        }
+        ++physicalWrites;
+        runLength = 0;
+    };
+
+    for (const auto& page : dirtyPages)
+    {
+        if (runLength == 0 || page.first != nextRBN)
+        {
+            writeRun();
+            runStart = page.first;
+        }
+        std::copy(page.second.begin(), page.second.end(), run.data() + runLength);
+        runLength += page.second.size();
+        nextRBN = page.first + 1;
+    }
+    writeRun();
+
+    dirtyPages.clear();
+    file.flush();
+    return success;
+}
+
+void PageBufferAlt::setDirtyPageLimit(size_t limit)
+{
+    dirtyPageLimit = limit;
+    if (dirtyPageLimit == 0 || dirtyPages.size() >= dirtyPageLimit)
+    {
+        sync();
+    }
+}
+
+size_t PageBufferAlt::getDirtyPageLimit() const
+{
+    return dirtyPageLimit;
+}
+
+size_t PageBufferAlt::getDirtyPageCount() const
+{
+    return dirtyPages.size();
+}
+
+uint64_t PageBufferAlt::getPhysicalWriteCount() const
+{
+    return physicalWrites;
+}
+
 bool PageBufferAlt::hasError() const 
 {
     return errorState;
@@ -99,7 +339,13 @@ std::string PageBufferAlt::getLastError() const
 
 void PageBufferAlt::closeFile()
 {
+    sync();
     file.close();
+    blockIO.close();
+    if (cache != nullptr && cacheFileId != CacheManager::NO_FILE)
+        cache->dropFile(cacheFileId); // hand the budget back, the next open could not trust the pages anyway
+    cacheFileId = CacheManager::NO_FILE;
+    isOpen = false;
 }
 
 void PageBufferAlt::setError(const std::string& message)
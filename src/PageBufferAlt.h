@@ -6,16 +6,31 @@
 #include <fstream>
 #include <algorithm>
 #include <string>
+#include <map>
+#include "BlockFile.h"
+#include "CacheManager.h"
+#include "BlockChecksum.h"
 
 /**
  * @class PageBufferAlt
  * @brief Manages block-based file I/O operations with buffering support.
  * @details Provides an interface for reading and writing fixed-size blocks to a file,
  *          with support for a header region. Uses Relative Block Numbers (RBN) for addressing.
+ *          Blocks go through positional reads/writes so readBlock may be called from several
+ *          threads at once; the header region stays on the fstream returned by getFileStream.
+ *          In write-back mode (the default) written blocks are held as dirty pages and written
+ *          on sync(), closeFile() or when the dirty page limit is reached, with runs of adjacent
+ *          RBNs coalesced into a single write.
+ *          Opened in direct mode the block transfers bypass the kernel page cache; the caller's
+ *          node cache and the dirty pages are then the only in-memory copies.
+ *          With a CacheManager attached, readBlock keeps clean pages in the manager's shared budget
+ *          and is then no longer safe to call from several threads; readBlockInto always is.
  */
 class PageBufferAlt 
 {
 public:
+    static const size_t DEFAULT_DIRTY_PAGE_LIMIT = 256; // Dirty pages held before a forced sync
+
     /**
      * @brief Default Constructor
      * @details Initializes a PageBufferAlt object in a closed state.
@@ -33,16 +48,82 @@ public:
      * @param filename The path to the file to open or create.
      * @param blockSize The size of each block in bytes.
      * @param headerSize The size of the header region in bytes (precedes block data).
+     * @param directIO True to bypass the kernel page cache. Needs headerSize and blockSize to be
+     *                 multiples of BlockFile::DIRECT_IO_ALIGNMENT.
      * @return True if the file was successfully opened. False otherwise.
      */
-    bool open(const std::string& filename, size_t blockSize, size_t headerSize);
+    bool open(const std::string& filename, size_t blockSize, size_t headerSize, bool directIO = false);
+
+    /**
+     * @brief Checks if block transfers bypass the kernel page cache.
+     * @return True if opened in direct mode and the file system supports it.
+     */
+    bool isDirectIO() const;
+
+    /**
+     * @brief Requires the page aligned layout of HeaderRecord::ALIGNED_LAYOUT_VERSION files.
+     * @details open then fails unless headerSize is a multiple of the alignment and blockSize is a
+     *          power of two, so every page transfer stays within one OS page. Call before open.
+     * @param alignment Page or sector size in bytes, 0 to accept any layout.
+     */
+    void setLayoutAlignment(uint32_t alignment);
+
+    /**
+     * @brief Gets the required layout alignment.
+     * @return Alignment in bytes, 0 if any layout is accepted.
+     */
+    uint32_t getLayoutAlignment() const;
     
+    /**
+     * @brief Reserves a CRC32C trailer at the end of every page.
+     * @details writeBlock stamps the last BlockChecksum::TRAILER_SIZE bytes of each page, callers
+     *          must leave them unused. Reads check them as the verify policy says.
+     * @param enabled True for files whose header has HeaderRecord::CHECKSUM_CRC32C.
+     */
+    void setChecksums(bool enabled);
+
+    /**
+     * @brief Checks if pages carry a checksum trailer.
+     * @return True if setChecksums(true) was called.
+     */
+    bool hasChecksums() const;
+
+    /**
+     * @brief Chooses which reads check the trailer.
+     * @details FirstRead, the default, checks a page when it comes from the file and trusts the
+     *          cached copy afterwards. Without a cache every read comes from the file.
+     * @param policy The verify policy.
+     */
+    void setVerifyPolicy(BlockChecksum::VerifyPolicy policy);
+
+    /**
+     * @brief Gets the checksum counters.
+     * @return Copy of the counters.
+     */
+    BlockChecksum::Stats getChecksumStats() const;
+
     /**
      * @brief Checks if a file is currently open.
      * @return True if a file is open. False otherwise.
      */
     bool getIsOpen() const;
     
+    /**
+     * @brief Caches clean pages in a shared manager.
+     * @details Pages are registered under this buffer's file name and start at IndexLeaf priority.
+     *          They are dropped when the file is closed, it may be rewritten before the next open.
+     * @param manager The manager, owned by the caller and outliving this buffer. nullptr stops caching.
+     */
+    void attachCache(CacheManager* manager);
+
+    /**
+     * @brief Changes the eviction priority of a cached page.
+     * @details Used once the caller knows what the page holds, e.g. an inner B+ tree node.
+     * @param rbn The Relative Block Number of the page.
+     * @param priority The new priority.
+     */
+    void setPagePriority(uint32_t rbn, CacheManager::Priority priority);
+
     /**
      * @brief Reads a block of data from the file at the specified RBN.
      * @param rbn The Relative Block Number to read from.
@@ -50,6 +131,14 @@ public:
      * @return True if the block was successfully read. False on error.
      */
     bool readBlock(uint32_t rbn, std::vector<uint8_t>& data);
+
+    /**
+     * @brief Reads a block of data into a caller buffer. Safe to call from several threads.
+     * @param rbn The Relative Block Number to read from.
+     * @param dest Buffer of at least blockSize bytes.
+     * @return True if the full block was read. Does not touch the error state.
+     */
+    bool readBlockInto(uint32_t rbn, char* dest) const;
     
     /**
      * @brief Writes a block of data to the file at the specified RBN.
@@ -59,6 +148,37 @@ public:
      */
     bool writeBlock(uint32_t rbn, const std::vector<uint8_t>& data);
     
+    /**
+     * @brief Writes every dirty page to the file and flushes the header stream.
+     * @details Adjacent dirty RBNs are written with one call.
+     * @return True if every dirty page was written.
+     */
+    bool sync();
+
+    /**
+     * @brief Sets how many dirty pages may be held before they are written.
+     * @param limit Page limit. Zero makes every writeBlock write through immediately.
+     */
+    void setDirtyPageLimit(size_t limit);
+
+    /**
+     * @brief Gets the dirty page limit.
+     * @return Page limit, zero for write-through.
+     */
+    size_t getDirtyPageLimit() const;
+
+    /**
+     * @brief Gets the number of pages waiting to be written.
+     * @return Dirty page count.
+     */
+    size_t getDirtyPageCount() const;
+
+    /**
+     * @brief Gets the number of block write calls issued to the file since open.
+     * @return Physical write count, each covering one run of adjacent pages.
+     */
+    uint64_t getPhysicalWriteCount() const;
+
     /**
      * @brief Checks if the buffer is in an error state.
      * @return True if an error has occurred. False otherwise.
@@ -73,7 +193,7 @@ public:
     
     /**
      * @brief Closes the currently open file.
-     * @details Flushes any pending writes and closes the file stream.
+     * @details Writes any dirty pages, then closes the file stream.
      */
     void closeFile();
 
@@ -97,14 +217,31 @@ public:
     std::fstream& getFileStream();
    
 private:
-    std::fstream file;        // File stream for reading and writing blocks
+    std::fstream file;        // File stream used for the header region
+    BlockFile blockIO;        // Positional handle used for block reads and writes
+    std::map<uint32_t, std::vector<uint8_t>> dirtyPages; // Written but not yet flushed pages, ordered by RBN
+    CacheManager* cache;      // Shared page cache, nullptr when not caching
+    uint32_t cacheFileId;     // Registration of the open file in the cache
+    size_t dirtyPageLimit;    // Dirty pages held before a forced sync, zero for write-through
+    uint64_t physicalWrites;  // Block write calls issued to the file
     size_t blockSize;         // Size of each block in bytes
     size_t headerSize;        // Size of the header region preceding block data
+    uint32_t layoutAlignment; // Page boundary pages must not straddle, 0 for any layout
+    uint32_t trailerSize;     // Checksum bytes at the end of each page, 0 without checksums
+    BlockChecksum::VerifyPolicy verifyPolicy; // Which reads check the trailer
+    BlockChecksum::Stats checksumStats; // Trailers checked and failed
     bool isOpen;              // Flag indicating if a file is currently open
     bool errorState;          // Flag indicating if an error has occurred
     std::string lastError;    // Description of the most recent error
     std::string fileName;     // Path to the currently associated file
 
+    /**
+     * @brief Checks a page against its trailer, counting the result.
+     * @details Sets the error on a mismatch.
+     * @return True if the trailer matches.
+     */
+    bool verifyPage(uint32_t rbn, const char* page);
+
     /**
      * @brief Sets the buffer into an error state with a descriptive message.
      * @param message The error message to store.
@@ -1,9 +1,86 @@
 #include "RecordBuffer.h"
 #include "ZipCodeRecord.h"
+#include "HeaderRecord.h"
+#include "RecordView.h"
+#include "RecordParser.h"
 #include <cstring>
 
+namespace
+{
+    const size_t BLOCK_METADATA_SIZE = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint32_t); // Ahead of the data in a block
+    void readSlot(const std::vector<char>& blockData, RecordEncoding encoding, uint16_t index, uint32_t& zipCode, uint16_t& offset)
+    {
+        const char* slot = blockData.data() + RecordBuffer::slotDirectoryOffset(encoding) + index * RecordBuffer::slotSize(encoding);
+        if (encoding == RecordEncoding::SlottedDelta)
+        {
+            uint32_t base;
+            uint16_t delta;
+            std::memcpy(&base, blockData.data() + RecordBuffer::SLOT_DIRECTORY_OFFSET, sizeof(base));
+            std::memcpy(&delta, slot, sizeof(delta));
+            zipCode = base + delta;
+            std::memcpy(&offset, slot + sizeof(delta), sizeof(offset));
+            return;
+        }
+        std::memcpy(&zipCode, slot, sizeof(zipCode));
+        std::memcpy(&offset, slot + sizeof(zipCode), sizeof(offset));
+    }
 
-RecordBuffer::RecordBuffer(){
+    // Under SlottedDelta the zip must lie within MAX_SLOT_KEY_SPAN above the base already written
+    void writeSlot(std::vector<char>& blockData, RecordEncoding encoding, uint16_t index, uint32_t zipCode, uint16_t offset)
+    {
+        char* slot = &blockData[RecordBuffer::slotDirectoryOffset(encoding) + index * RecordBuffer::slotSize(encoding)];
+        if (encoding == RecordEncoding::SlottedDelta)
+        {
+            uint32_t base;
+            std::memcpy(&base, &blockData[RecordBuffer::SLOT_DIRECTORY_OFFSET], sizeof(base));
+            uint16_t delta = static_cast<uint16_t>(zipCode - base);
+            std::memcpy(slot, &delta, sizeof(delta));
+            std::memcpy(slot + sizeof(delta), &offset, sizeof(offset));
+            return;
+        }
+        std::memcpy(slot, &zipCode, sizeof(zipCode));
+        std::memcpy(slot + sizeof(zipCode), &offset, sizeof(offset));
+    }
+
+    void writeBaseZip(std::vector<char>& blockData, uint32_t base)
+    {
+        std::memcpy(&blockData[RecordBuffer::SLOT_DIRECTORY_OFFSET], &base, sizeof(base));
+    }
+
+    /**
+     * @brief Moves the base of a SlottedDelta directory, re-encoding each slot against it
+     */
+    void rebaseSlots(std::vector<char>& blockData, uint16_t count, uint32_t base)
+    {
+        std::vector<uint32_t> zipCodes(count);
+        std::vector<uint16_t> offsets(count);
+        for (uint16_t i = 0; i < count; ++i)
+            readSlot(blockData, RecordEncoding::SlottedDelta, i, zipCodes[i], offsets[i]);
+        writeBaseZip(blockData, base);
+        for (uint16_t i = 0; i < count; ++i)
+            writeSlot(blockData, RecordEncoding::SlottedDelta, i, zipCodes[i], offsets[i]);
+    }
+
+    void writeSlotCount(std::vector<char>& blockData, uint16_t count)
+    {
+        std::memcpy(&blockData[0], &count, sizeof(count));
+    }
+
+    // The Text record without its length prefix
+    std::string textOf(const ZipCodeRecord& record)
+    {
+        return std::to_string(record.getZipCode()) + "," +
+               record.getLocationName() + "," +
+               std::string(record.getState()) + "," +
+               record.getCounty() + "," +
+               std::to_string(record.getLatitude()) + "," +
+               std::to_string(record.getLongitude());
+    }
+}
+
+
+RecordBuffer::RecordBuffer()
+    : errorState(false), lastError(), encoding(RecordEncoding::Text), coordinateFormat(CoordinateFormat::Degrees){
     // :)
 }
 
@@ -16,6 +93,10 @@ bool RecordBuffer::unpackBlock(const std::vector<char>& blockData, std::vector<Z
 {
     records.clear();
     if (blockData.empty()) return false;
+    if (encoding == RecordEncoding::Binary || encoding == RecordEncoding::Dictionary)
+        return unpackBinaryBlock(blockData, records);
+    if (isSlotted(encoding))
+        return unpackSlottedBlock(blockData, records);
 
     size_t offset = 0;
     int recordNum = 0;
@@ -39,11 +120,10 @@ bool RecordBuffer::unpackBlock(const std::vector<char>& blockData, std::vector<Z
             break;
         }
 
-        std::string recordStr(blockData.begin() + offset, blockData.begin() + offset + lengthPrefix);
-        offset += lengthPrefix;
-        
         ZipCodeRecord record;
-        if(!parseZipCodeRecord(recordStr, record)) 
+        RecordParser::Error parseError = RecordParser::parse(&blockData[offset], lengthPrefix, record);
+        offset += lengthPrefix;
+        if (parseError != RecordParser::Error::None)
         {
             std::cout << "  Parse failed!\n";
             setError("Error Parsing ZipCodeRecord within Unpack Block. Block Skipped.");
@@ -59,6 +139,12 @@ bool RecordBuffer::packBlock(const std::vector<ZipCodeRecord>& records, std::vec
 {
     blockData.clear();
     if (records.empty()) return false;
+    if (encoding == RecordEncoding::Binary)
+        return packBinaryBlock(records, blockData, blockSize);
+    if (isSlotted(encoding))
+        return packSlottedBlock(records, blockData, blockSize);
+    if (encoding == RecordEncoding::Dictionary)
+        return packDictionaryBlock(records, blockData, blockSize);
 
     blockData.reserve(blockSize);
     for(const auto& record : records)
@@ -66,12 +152,7 @@ bool RecordBuffer::packBlock(const std::vector<ZipCodeRecord>& records, std::vec
         size_t oldSize = blockData.size();
         blockData.resize(oldSize + sizeof(uint32_t));
 
-        std::string recordStr = std::to_string(record.getZipCode()) + "," +
-                               record.getLocationName() + "," +
-                               std::string(record.getState()) + "," +
-                               record.getCounty() + "," +
-                               std::to_string(record.getLatitude()) + "," +
-                               std::to_string(record.getLongitude());
+        std::string recordStr = textOf(record);
 
         uint32_t lengthPrefix = recordStr.length();
 
@@ -90,122 +171,626 @@ bool RecordBuffer::packBlock(const std::vector<ZipCodeRecord>& records, std::vec
     return true;
 }
 
-bool RecordBuffer::parseZipCodeRecord(const std::string& recordStr, ZipCodeRecord& record)
+bool RecordBuffer::unpackBinaryBlock(const std::vector<char>& blockData, std::vector<ZipCodeRecord>& records)
 {
-    std::vector<std::string> fields;
-    std::stringstream ss(recordStr);
-    std::string field;
+    BlockRecordIterator views(blockData, encoding, coordinateFormat);
+    RecordView view;
+    while (views.next(view))
+        records.push_back(view.toRecord());
+    if (views.hasError())
+    {
+        setError("Bad record in block data. Block Skipped.");
+        return false;
+    }
+    return true;
+}
 
-    while(std::getline(ss, field, ','))
+bool RecordBuffer::packBinaryBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize)
+{
+    blockData.reserve(blockSize);
+    for (const auto& record : records)
     {
-        trimString(field);
-        fields.push_back(field);
+        std::string location = record.getLocationName();
+        std::string county = record.getCounty();
+        if (location.size() > UINT8_MAX || county.size() > UINT8_MAX)
+        {
+            setError("Field too long for the binary record encoding");
+            return false;
+        }
+
+        size_t offset = blockData.size();
+        blockData.resize(offset + binaryFixedSize(coordinateFormat) + location.size() + county.size());
+        writeRecord(record, &blockData[offset]);
+
+        if (BLOCK_METADATA_SIZE + blockData.size() > blockSize)
+        {
+            setError("Block size exceeded during packing");
+            return false;
+        }
     }
-    return fieldsToRecord(fields, record);
+    return true;
 }
 
-bool RecordBuffer::fieldsToRecord(const std::vector<std::string>& fields, ZipCodeRecord& record)
+bool RecordBuffer::packDictionaryBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize)
 {
-    if (fields.size() != EXPECTED_FIELD_COUNT) 
+    // Distinct strings in order of first use, a block holds few enough for a linear search
+    std::vector<std::string> entries;
+    std::vector<uint8_t> ids;
+    ids.reserve(records.size() * 2);
+    for (const auto& record : records)
+    {
+        std::string strings[2] = {std::string(record.getState(), 2), record.getCounty()};
+        for (const auto& value : strings)
+        {
+            size_t id = std::find(entries.begin(), entries.end(), value) - entries.begin();
+            if (id == entries.size())
+            {
+                if (entries.size() == MAX_DICTIONARY_ENTRIES || value.size() > UINT8_MAX)
+                {
+                    setError("Too many or too long strings for the dictionary record encoding");
+                    return false;
+                }
+                entries.push_back(value);
+            }
+            ids.push_back(static_cast<uint8_t>(id));
+        }
+    }
+
+    blockData.reserve(blockSize);
+    blockData.push_back(static_cast<char>(entries.size()));
+    for (const auto& entry : entries)
+    {
+        blockData.push_back(static_cast<char>(entry.size()));
+        blockData.insert(blockData.end(), entry.begin(), entry.end());
+    }
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        const ZipCodeRecord& record = records[i];
+        std::string location = record.getLocationName();
+        if (location.size() > UINT8_MAX)
+        {
+            setError("Field too long for the dictionary record encoding");
+            return false;
+        }
+
+        size_t offset = blockData.size();
+        blockData.resize(offset + dictionaryFixedSize(coordinateFormat) + location.size());
+        char* out = &blockData[offset];
+
+        uint32_t zipCode = record.getZipCode();
+        std::memcpy(out, &zipCode, sizeof(zipCode));
+        out += sizeof(zipCode);
+        out = writeCoordinates(record, coordinateFormat, out);
+        *out++ = static_cast<char>(ids[2 * i]); // State
+        *out++ = static_cast<char>(ids[2 * i + 1]); // County
+        *out++ = static_cast<char>(location.size());
+        std::memcpy(out, location.data(), location.size());
+    }
+
+    if (BLOCK_METADATA_SIZE + blockData.size() > blockSize)
+    {
+        setError("Block size exceeded during packing");
         return false;
-    
-    // Validate and convert each field
-    // Field 0: Zip Code (integer)
-    if (!isValidUInt32(fields[0])) 
+    }
+    return true;
+}
+
+bool RecordBuffer::unpackSlottedBlock(const std::vector<char>& blockData, std::vector<ZipCodeRecord>& records)
+{
+    uint16_t count = slotCount(blockData);
+    records.reserve(count);
+    ZipCodeRecord record;
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        if (!readSlottedRecord(blockData, i, record))
+        {
+            setError("Slotted record runs past the block. Block Skipped.");
+            return false;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
+
+bool RecordBuffer::packSlottedBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize)
+{
+    // The directory has to be sorted for the binary search, callers normally pass sorted records already
+    std::vector<size_t> order(records.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&records](size_t a, size_t b)
+    {
+        return records[a].getZipCode() < records[b].getZipCode();
+    });
+
+    const uint32_t slotBytes = slotSize(encoding);
+    const uint32_t directoryOffset = slotDirectoryOffset(encoding);
+    size_t used = directoryOffset + records.size() * slotBytes;
+    for (const auto& record : records)
     {
+        if (record.getLocationName().size() > UINT8_MAX || record.getCounty().size() > UINT8_MAX)
+        {
+            setError("Field too long for the binary record encoding");
+            return false;
+        }
+        used += getEncodedSize(record) - slotBytes;
+    }
+    if (BLOCK_METADATA_SIZE + used > blockSize || used > UINT16_MAX)
+    {
+        setError("Block size exceeded during packing");
         return false;
     }
-    uint32_t zipCode = static_cast<uint32_t>(std::stoul(fields[0]));
-    
-    // Field 4: Latitude (double)
-    if (!isValidDouble(fields[4])) 
+    uint32_t base = records.empty() ? 0 : records[order.front()].getZipCode();
+    if (encoding == RecordEncoding::SlottedDelta && !records.empty() &&
+        records[order.back()].getZipCode() - base > MAX_SLOT_KEY_SPAN)
     {
+        setError("Zip codes of the block span too far for a delta slot directory");
         return false;
     }
-    double latitude = std::stod(fields[4]);
-    
-    // Field 5: Longitude (double)  
-    if (!isValidDouble(fields[5])) 
+
+    blockData.assign(used, 0);
+    writeSlotCount(blockData, static_cast<uint16_t>(records.size()));
+    if (encoding == RecordEncoding::SlottedDelta)
+        writeBaseZip(blockData, base);
+    size_t offset = directoryOffset + records.size() * slotBytes;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const ZipCodeRecord& record = records[order[i]];
+        writeSlot(blockData, encoding, static_cast<uint16_t>(i), record.getZipCode(), static_cast<uint16_t>(offset));
+        writeSlottedBody(record, &blockData[offset]);
+        offset += getEncodedSize(record) - slotBytes;
+    }
+    return true;
+}
+
+bool RecordBuffer::insertRecord(std::vector<char>& blockData, const ZipCodeRecord& record, const uint32_t blockSize)
+{
+    if (encoding == RecordEncoding::Dictionary)
+        return false;
+    if (!isSlotted(encoding))
+        return insertSequentialRecord(blockData, record, blockSize);
+    if (record.getLocationName().size() > UINT8_MAX || record.getCounty().size() > UINT8_MAX)
     {
+        setError("Field too long for the binary record encoding");
         return false;
     }
-    double longitude = std::stod(fields[5]);
-    
-    // Field 1: Place Name (string)
-    std::string placeName = fields[1];
-    
-    // Field 2: State (string, must be 2 chars)
-    std::string state = fields[2];
-    if (state.length() != 2)
+    const uint32_t slotBytes = slotSize(encoding);
+    const uint32_t directoryOffset = slotDirectoryOffset(encoding);
+    if (blockData.size() < directoryOffset)
+        blockData.resize(directoryOffset, '\xFF');
+
+    uint16_t count = slotCount(blockData);
+    size_t used = slottedUsedSize(blockData, count);
+    size_t bodySize = getEncodedSize(record) - slotBytes;
+    size_t newUsed = used + slotBytes + bodySize;
+    if (BLOCK_METADATA_SIZE + newUsed > blockSize || newUsed > UINT16_MAX)
+        return false;
+
+    uint32_t zipCode = record.getZipCode();
+    if (encoding == RecordEncoding::SlottedDelta)
+    {
+        if (count == 0)
+            writeBaseZip(blockData, zipCode);
+        else
+        {
+            uint32_t first;
+            uint32_t last;
+            uint16_t offset;
+            readSlot(blockData, encoding, 0, first, offset);
+            readSlot(blockData, encoding, count - 1, last, offset);
+            if (std::max(last, zipCode) - std::min(first, zipCode) > MAX_SLOT_KEY_SPAN)
+                return false;
+            if (zipCode < first)
+                rebaseSlots(blockData, count, zipCode);
+        }
+    }
+    if (blockData.size() < newUsed)
+        blockData.resize(newUsed, '\xFF');
+
+    // After any equal keys, the way a stable sort would place it
+    uint16_t position = lowerBoundSlot(blockData, count, zipCode + 1);
+    if (zipCode == UINT32_MAX)
+        position = count;
+
+    // Open a slot: everything from the new slot to the end of the bodies moves up by one slot
+    size_t slotOffset = directoryOffset + position * slotBytes;
+    std::memmove(&blockData[slotOffset + slotBytes], &blockData[slotOffset], used - slotOffset);
+    for (uint16_t i = 0; i <= count; ++i)
     {
+        if (i == position)
+            continue;
+        uint32_t slotZip;
+        uint16_t offset;
+        readSlot(blockData, encoding, i, slotZip, offset);
+        writeSlot(blockData, encoding, i, slotZip, static_cast<uint16_t>(offset + slotBytes));
+    }
+
+    size_t bodyOffset = used + slotBytes;
+    writeSlot(blockData, encoding, position, zipCode, static_cast<uint16_t>(bodyOffset));
+    writeSlottedBody(record, &blockData[bodyOffset]);
+    writeSlotCount(blockData, static_cast<uint16_t>(count + 1));
+    return true;
+}
+
+bool RecordBuffer::removeRecord(std::vector<char>& blockData, const uint32_t zipCode)
+{
+    if (encoding == RecordEncoding::Dictionary)
+        return false;
+    if (!isSlotted(encoding))
+        return removeSequentialRecord(blockData, zipCode);
+    const uint32_t slotBytes = slotSize(encoding);
+    uint16_t count = slotCount(blockData);
+    uint16_t position = lowerBoundSlot(blockData, count, zipCode);
+    if (position == count)
         return false;
+    uint32_t slotZip;
+    uint16_t bodyOffset;
+    readSlot(blockData, encoding, position, slotZip, bodyOffset);
+    if (slotZip != zipCode)
+        return false;
+
+    size_t used = slottedUsedSize(blockData, count);
+    size_t bodySize = slottedBodySize(blockData, bodyOffset);
+    if (bodySize == 0)
+        return false;
+
+    // Close the body gap, then the slot gap
+    std::memmove(&blockData[bodyOffset], &blockData[bodyOffset + bodySize], used - bodyOffset - bodySize);
+    size_t slotOffset = slotDirectoryOffset(encoding) + position * slotBytes;
+    std::memmove(&blockData[slotOffset], &blockData[slotOffset + slotBytes], used - bodySize - slotOffset - slotBytes);
+    std::fill(blockData.begin() + (used - bodySize - slotBytes), blockData.begin() + used, '\xFF');
+
+    for (uint16_t i = 0; i + 1 < count; ++i)
+    {
+        uint16_t offset;
+        readSlot(blockData, encoding, i, slotZip, offset);
+        if (offset > bodyOffset)
+            offset -= bodySize;
+        writeSlot(blockData, encoding, i, slotZip, static_cast<uint16_t>(offset - slotBytes));
+    }
+    writeSlotCount(blockData, static_cast<uint16_t>(count - 1));
+
+    // The base follows the first slot, so the span left for inserts stays as wide as it can be
+    if (encoding == RecordEncoding::SlottedDelta && position == 0 && count > 1)
+    {
+        uint16_t offset;
+        readSlot(blockData, encoding, 0, slotZip, offset);
+        rebaseSlots(blockData, count - 1, slotZip);
     }
-    
-    // Field 3: County (string)
-    std::string county = fields[3];
-    
-    // Create the record
-    ZipCodeRecord tempRecord(zipCode, latitude, longitude, placeName, state, county);
-    record = tempRecord;
-    
     return true;
 }
 
-bool RecordBuffer::isValidUInt32(const std::string& str) const
+bool RecordBuffer::insertSequentialRecord(std::vector<char>& blockData, const ZipCodeRecord& record, const uint32_t blockSize)
 {
-    if (str.empty()) return false;
-    
-    try 
+    if (encoding == RecordEncoding::Binary &&
+        (record.getLocationName().size() > UINT8_MAX || record.getCounty().size() > UINT8_MAX))
     {
-        long val = std::stol(str);
-        if (val < 0 || val > 4294967295) return false;
-        return true;
-    } 
-    catch (const std::exception&) 
+        setError("Field too long for the binary record encoding");
+        return false;
+    }
+
+    // One walk finds the first record with a greater zip and the end of the used bytes
+    uint32_t zipCode = record.getZipCode();
+    BlockRecordIterator views(blockData, encoding, coordinateFormat);
+    RecordView view;
+    size_t position = SIZE_MAX;
+    size_t offset = views.getOffset();
+    while (views.next(view))
     {
+        if (position == SIZE_MAX && view.getZipCode() > zipCode)
+            position = offset;
+        offset = views.getOffset();
+    }
+    if (views.hasError())
         return false;
+    size_t used = offset;
+    if (position == SIZE_MAX)
+        position = used;
+
+    size_t recordSize = getEncodedSize(record);
+    if (BLOCK_METADATA_SIZE + used + recordSize > blockSize)
+        return false;
+    if (blockData.size() < used + recordSize)
+        blockData.resize(used + recordSize, '\xFF');
+
+    std::memmove(&blockData[position + recordSize], &blockData[position], used - position);
+    writeRecord(record, &blockData[position]);
+    return true;
+}
+
+bool RecordBuffer::removeSequentialRecord(std::vector<char>& blockData, const uint32_t zipCode)
+{
+    BlockRecordIterator views(blockData, encoding, coordinateFormat);
+    RecordView view;
+    size_t position = SIZE_MAX;
+    size_t recordSize = 0;
+    size_t offset = views.getOffset();
+    while (views.next(view))
+    {
+        if (position == SIZE_MAX && view.getZipCode() == zipCode)
+        {
+            position = offset;
+            recordSize = views.getOffset() - offset;
+        }
+        offset = views.getOffset();
     }
+    if (views.hasError() || position == SIZE_MAX)
+        return false;
+
+    // Close the gap, the freed tail becomes padding
+    size_t used = offset;
+    std::memmove(&blockData[position], &blockData[position + recordSize], used - position - recordSize);
+    std::fill(blockData.begin() + (used - recordSize), blockData.begin() + used, '\xFF');
+    return true;
 }
 
-bool RecordBuffer::isValidDouble(const std::string& str) const
+void RecordBuffer::writeRecord(const ZipCodeRecord& record, char* out) const
 {
-    if (str.empty()) return false;
-    
-    try 
+    if (encoding == RecordEncoding::Text)
     {
-        std::stod(str);
-        return true;
-    } 
-    catch (const std::exception&) 
+        std::string text = textOf(record);
+        uint32_t lengthPrefix = static_cast<uint32_t>(text.size());
+        std::memcpy(out, &lengthPrefix, sizeof(lengthPrefix));
+        std::memcpy(out + sizeof(lengthPrefix), text.data(), text.size());
+        return;
+    }
+    uint32_t zipCode = record.getZipCode();
+    std::memcpy(out, &zipCode, sizeof(zipCode));
+    writeSlottedBody(record, out + sizeof(zipCode));
+}
+
+uint16_t RecordBuffer::slotCount(const std::vector<char>& blockData) const
+{
+    if (blockData.size() < slotDirectoryOffset(encoding))
+        return 0;
+    uint16_t count;
+    std::memcpy(&count, blockData.data(), sizeof(count));
+    if (count == UINT16_MAX || slotDirectoryOffset(encoding) + count * slotSize(encoding) > blockData.size())
+        return 0; // Padding, or not a directory
+    return count;
+}
+
+uint16_t RecordBuffer::lowerBoundSlot(const std::vector<char>& blockData, const uint16_t count, const uint32_t zipCode) const
+{
+    uint16_t low = 0;
+    uint16_t high = count;
+    while (low < high)
     {
+        uint16_t middle = low + (high - low) / 2;
+        uint32_t slotZip;
+        uint16_t offset;
+        readSlot(blockData, encoding, middle, slotZip, offset);
+        if (slotZip < zipCode)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+size_t RecordBuffer::slottedBodySize(const std::vector<char>& blockData, const size_t offset) const
+{
+    const size_t fixedSize = binaryFixedSize(coordinateFormat) - sizeof(uint32_t); // The zip lives in the slot
+    if (offset + fixedSize > blockData.size())
+        return 0;
+    const size_t locationOffset = offset + coordinateSize(coordinateFormat) + 2;
+    uint8_t locationLength = static_cast<uint8_t>(blockData[locationOffset]);
+    if (locationOffset + 1 + locationLength >= blockData.size())
+        return 0;
+    uint8_t countyLength = static_cast<uint8_t>(blockData[locationOffset + 1 + locationLength]);
+    size_t bodySize = fixedSize + locationLength + countyLength;
+    return offset + bodySize <= blockData.size() ? bodySize : 0;
+}
+
+size_t RecordBuffer::slottedUsedSize(const std::vector<char>& blockData, const uint16_t count) const
+{
+    // Bodies are contiguous, the used bytes end with the body furthest in
+    size_t end = slotDirectoryOffset(encoding) + count * slotSize(encoding);
+    uint16_t lastOffset = 0;
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        uint32_t slotZip;
+        uint16_t offset;
+        readSlot(blockData, encoding, i, slotZip, offset);
+        lastOffset = std::max(lastOffset, offset);
+    }
+    if (count > 0)
+        end = lastOffset + slottedBodySize(blockData, lastOffset);
+    return end;
+}
+
+bool RecordBuffer::readSlottedRecord(const std::vector<char>& blockData, const uint16_t index, ZipCodeRecord& record) const
+{
+    uint32_t zipCode;
+    uint16_t offset;
+    readSlot(blockData, encoding, index, zipCode, offset);
+    if (slottedBodySize(blockData, offset) == 0)
         return false;
+
+    const char* in = blockData.data() + offset;
+    int32_t latitude;
+    int32_t longitude;
+    readCoordinates(in, coordinateFormat, latitude, longitude);
+    const char* state = in + coordinateSize(coordinateFormat);
+    uint8_t locationLength = static_cast<uint8_t>(state[2]);
+    const char* location = state + 3;
+    uint8_t countyLength = static_cast<uint8_t>(location[locationLength]);
+    record = ZipCodeRecord(zipCode, 0.0, 0.0, std::string(location, locationLength),
+                           std::string(state, 2), std::string(location + locationLength + 1, countyLength));
+    record.setLatitudeMicro(latitude);
+    record.setLongitudeMicro(longitude);
+    return true;
+}
+
+void RecordBuffer::writeSlottedBody(const ZipCodeRecord& record, char* out) const
+{
+    std::string location = record.getLocationName();
+    std::string county = record.getCounty();
+    out = writeCoordinates(record, coordinateFormat, out);
+    std::memcpy(out, record.getState(), 2);
+    out += 2;
+    *out++ = static_cast<char>(location.size());
+    std::memcpy(out, location.data(), location.size());
+    out += location.size();
+    *out++ = static_cast<char>(county.size());
+    std::memcpy(out, county.data(), county.size());
+}
+
+bool RecordBuffer::findRecord(const std::vector<char>& blockData, const uint32_t zipCode, ZipCodeRecord& record)
+{
+    if (isSlotted(encoding))
+    {
+        // Binary search the directory, decode one body
+        uint16_t count = slotCount(blockData);
+        uint16_t position = lowerBoundSlot(blockData, count, zipCode);
+        if (position == count)
+            return false;
+        uint32_t slotZip;
+        uint16_t offset;
+        readSlot(blockData, encoding, position, slotZip, offset);
+        return slotZip == zipCode && readSlottedRecord(blockData, position, record);
     }
+
+    // Walk the views, copy out only the match
+    BlockRecordIterator views(blockData, encoding, coordinateFormat);
+    RecordView view;
+    while (views.next(view))
+    {
+        if (view.getZipCode() == zipCode)
+        {
+            record = view.toRecord();
+            return true;
+        }
+    }
+    return false;
 }
 
-bool RecordBuffer::hasError() const
+void RecordBuffer::setEncoding(const RecordEncoding encoding)
 {
-    return errorState;
+    this->encoding = encoding;
 }
 
-void RecordBuffer::setError(const std::string& message)
+RecordEncoding RecordBuffer::getEncoding() const
 {
-    errorState = true;
-    lastError = message;
+    return encoding;
+}
+
+void RecordBuffer::setCoordinateFormat(const CoordinateFormat coordinates)
+{
+    coordinateFormat = coordinates;
+}
+
+CoordinateFormat RecordBuffer::getCoordinateFormat() const
+{
+    return coordinateFormat;
+}
+
+uint32_t RecordBuffer::getEncodedSize(const ZipCodeRecord& record) const
+{
+    if (encoding == RecordEncoding::Text)
+        return record.getRecordSize();
+    if (encoding == RecordEncoding::Dictionary) // The record plus state and county entries of its own
+        return dictionaryFixedSize(coordinateFormat) + record.getLocationName().size() + (1 + 2) + (1 + record.getCounty().size());
+    uint32_t binarySize = binaryFixedSize(coordinateFormat) + record.getLocationName().size() + record.getCounty().size();
+    return isSlotted(encoding) ? binarySize - sizeof(uint32_t) + slotSize(encoding) : binarySize;
+}
+
+RecordEncoding RecordBuffer::encodingOf(const HeaderRecord& header)
+{
+    if (!header.hasBinaryRecords())
+        return RecordEncoding::Text;
+    if (header.getSizeFormatType() == HeaderRecord::SIZE_FORMAT_DICTIONARY)
+        return RecordEncoding::Dictionary;
+    if (header.getSizeFormatType() == HeaderRecord::SIZE_FORMAT_SLOTTED_DELTA)
+        return RecordEncoding::SlottedDelta;
+    return header.getSizeFormatType() == HeaderRecord::SIZE_FORMAT_SLOTTED ? RecordEncoding::Slotted : RecordEncoding::Binary;
+}
+
+bool RecordBuffer::isSlotted(const RecordEncoding encoding)
+{
+    return encoding == RecordEncoding::Slotted || encoding == RecordEncoding::SlottedDelta;
+}
+
+uint32_t RecordBuffer::slotSize(const RecordEncoding encoding)
+{
+    return encoding == RecordEncoding::SlottedDelta ? DELTA_SLOT_SIZE : SLOT_SIZE;
+}
+
+uint32_t RecordBuffer::slotDirectoryOffset(const RecordEncoding encoding)
+{
+    return encoding == RecordEncoding::SlottedDelta ? DELTA_SLOT_DIRECTORY_OFFSET : SLOT_DIRECTORY_OFFSET;
+}
+
+CoordinateFormat RecordBuffer::coordinateFormatOf(const HeaderRecord& header)
+{
+    if (!header.hasBinaryRecords() || header.getVersion() < HeaderRecord::FIXED_POINT_VERSION)
+        return CoordinateFormat::Degrees;
+    return header.getCoordinateFormat() == HeaderRecord::COORDINATES_MICRODEGREES ? CoordinateFormat::MicroDegrees
+                                                                                   : CoordinateFormat::Degrees;
+}
+
+uint32_t RecordBuffer::coordinateSize(const CoordinateFormat coordinates)
+{
+    return coordinates == CoordinateFormat::MicroDegrees ? 2 * sizeof(int32_t) : 2 * sizeof(double);
+}
+
+uint32_t RecordBuffer::binaryFixedSize(const CoordinateFormat coordinates)
+{
+    return BINARY_FIXED_SIZE - coordinateSize(CoordinateFormat::Degrees) + coordinateSize(coordinates);
+}
+
+uint32_t RecordBuffer::dictionaryFixedSize(const CoordinateFormat coordinates)
+{
+    return DICTIONARY_FIXED_SIZE - coordinateSize(CoordinateFormat::Degrees) + coordinateSize(coordinates);
 }
 
-void RecordBuffer::trimString(std::string& str)
+char* RecordBuffer::writeCoordinates(const ZipCodeRecord& record, const CoordinateFormat coordinates, char* out)
 {
-    // Remove leading whitespace
-    str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) 
+    if (coordinates == CoordinateFormat::MicroDegrees)
     {
-        return !std::isspace(ch);
-    }));
-    
-    // Remove trailing whitespace  
-    str.erase(std::find_if(str.rbegin(), str.rend(), [](unsigned char ch) 
+        int32_t latitude = record.getLatitudeMicro();
+        int32_t longitude = record.getLongitudeMicro();
+        std::memcpy(out, &latitude, sizeof(latitude));
+        std::memcpy(out + sizeof(latitude), &longitude, sizeof(longitude));
+        return out + sizeof(latitude) + sizeof(longitude);
+    }
+    double latitude = record.getLatitude();
+    double longitude = record.getLongitude();
+    std::memcpy(out, &latitude, sizeof(latitude));
+    std::memcpy(out + sizeof(latitude), &longitude, sizeof(longitude));
+    return out + sizeof(latitude) + sizeof(longitude);
+}
+
+void RecordBuffer::readCoordinates(const char* in, const CoordinateFormat coordinates, int32_t& latitude, int32_t& longitude)
+{
+    if (coordinates == CoordinateFormat::MicroDegrees)
     {
-        return !std::isspace(ch);
-    }).base(), str.end());
+        std::memcpy(&latitude, in, sizeof(latitude));
+        std::memcpy(&longitude, in + sizeof(latitude), sizeof(longitude));
+        return;
+    }
+    double degrees;
+    std::memcpy(&degrees, in, sizeof(degrees));
+    latitude = ZipCodeRecord::toMicroDegrees(degrees);
+    std::memcpy(&degrees, in + sizeof(degrees), sizeof(degrees));
+    longitude = ZipCodeRecord::toMicroDegrees(degrees);
+}
+
+bool RecordBuffer::parseZipCodeRecord(const std::string& recordStr, ZipCodeRecord& record)
+{
+    return RecordParser::parse(recordStr.data(), recordStr.size(), record) == RecordParser::Error::None;
+}
+
+bool RecordBuffer::hasError() const
+{
+    return errorState;
+}
+
+void RecordBuffer::setError(const std::string& message)
+{
+    errorState = true;
+    lastError = message;
 }
 
 std::string RecordBuffer::getLastError() const
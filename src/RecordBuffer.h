@@ -9,11 +9,60 @@
 #include <sstream>
 #include <algorithm>
 
+class HeaderRecord;
+
+/**
+ * @brief How records are laid out inside the data of an active block.
+ * @details Text is the original length prefixed CSV line. Binary is, per record, a
+ *          fixed width zip (uint32) and coordinates in the file's CoordinateFormat, the two state letters,
+ *          then location and county as a uint8 length followed by the bytes. The strings
+ *          go last so a record never ends in the 0xFF block padding.
+ *          Slotted starts with a uint16 slot count and a directory of (uint32 zip, uint16 offset)
+ *          slots sorted by zip, followed by the record bodies: the Binary record without its zip.
+ *          Lookups binary search the directory and decode one body, inserts and deletes move
+ *          slots and bodies in place.
+ *          SlottedDelta is Slotted with a uint32 base zip after the count and (uint16 zip - base,
+ *          uint16 offset) slots, 2 bytes a record smaller. The base is always the zip of the first
+ *          slot, so the zips of one block can span at most MAX_SLOT_KEY_SPAN.
+ *          Dictionary starts with a uint8 entry count and the distinct state and county strings of
+ *          the block, each a uint8 length and the bytes. Records follow as in Binary, except that
+ *          state and county are one byte ids into that dictionary.
+ */
+enum class RecordEncoding : uint8_t
+{
+    Text,
+    Binary,
+    Slotted,
+    Dictionary,
+    SlottedDelta
+};
+
+/**
+ * @brief How Binary, Slotted and Dictionary records store their coordinates.
+ * @details Degrees is two doubles. MicroDegrees is two int32 counts of millionths of a degree,
+ *          exact for the six decimals the text encoding keeps and 8 bytes smaller per record.
+ *          Text records always hold the decimal strings.
+ */
+enum class CoordinateFormat : uint8_t
+{
+    Degrees,
+    MicroDegrees
+};
+
 class RecordBuffer
 {
 public:
     static const int EXPECTED_FIELD_COUNT = 6;
     static const char* const EXPECTED_HEADERS[EXPECTED_FIELD_COUNT];
+    static const uint32_t BINARY_FIXED_SIZE = 24; // zip, latitude, longitude, state and the two string lengths, in Degrees
+    static const uint32_t SLOT_SIZE = 6; // zip and body offset of one slotted record
+    static const uint32_t SLOT_DIRECTORY_OFFSET = 2; // Slots follow the slot count
+    static const uint32_t DELTA_SLOT_SIZE = 4; // zip less the base and body offset of one SlottedDelta record
+    static const uint32_t DELTA_SLOT_DIRECTORY_OFFSET = 6; // SlottedDelta slots follow the count and the base zip
+    static const uint32_t MAX_SLOT_KEY_SPAN = UINT16_MAX; // Widest zip range of one SlottedDelta block
+    static const uint32_t DICTIONARY_FIXED_SIZE = 23; // zip, latitude, longitude, state and county ids, location length, in Degrees
+    static const uint32_t DICTIONARY_ENTRIES_OFFSET = 1; // Entries follow the entry count
+    static const uint32_t MAX_DICTIONARY_ENTRIES = 254; // A count of 0xFF would read as padding
     /**
      * @brief Default constructor
      */
@@ -40,6 +89,137 @@ public:
      * @return True if packing was successful
      */
     bool packBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize);
+
+    /**
+     * @brief Finds one record in block data without keeping the others
+     * @details Records before the match are only viewed, never copied; slotted blocks binary
+     *          search their directory instead.
+     * @param blockData [IN] Raw block data
+     * @param zipCode [IN] Zip code to find
+     * @param record [OUT] The record, if found
+     * @return True if the block holds the zip code
+     */
+    bool findRecord(const std::vector<char>& blockData, const uint32_t zipCode, ZipCodeRecord& record);
+
+    /**
+     * @brief Inserts a record into block data in key order without repacking
+     * @details Slotted: shifts the slots after the new one and the bodies by one slot, then
+     *          appends the body. Under SlottedDelta a zip below the base rebases the directory first.
+     *          Text and Binary: moves the records after it up by its size and writes it in the gap.
+     *          Padding past the used bytes is kept.
+     * @param blockData [IN,OUT] Block data
+     * @param record [IN] Record to insert, after any equal keys
+     * @param blockSize The constant size of the blocks in the file in bytes.
+     * @return False if the block has no room, the zip would stretch a SlottedDelta block past
+     *         MAX_SLOT_KEY_SPAN, or the encoding is Dictionary, whose new strings move every record
+     */
+    bool insertRecord(std::vector<char>& blockData, const ZipCodeRecord& record, const uint32_t blockSize);
+
+    /**
+     * @brief Removes a record from block data without repacking
+     * @details Closes the gap left by the record, or by its body and its slot, the freed tail
+     *          becomes padding. Removing the first slot of a SlottedDelta block rebases the
+     *          directory on the next.
+     * @param blockData [IN,OUT] Block data
+     * @param zipCode [IN] Zip code to remove, the first one if repeated
+     * @return False if the zip code is not there or the encoding is Dictionary
+     */
+    bool removeRecord(std::vector<char>& blockData, const uint32_t zipCode);
+
+    /**
+     * @brief Selects the encoding used by packBlock, unpackBlock and findRecord
+     * @param encoding Any RecordEncoding, Text by default
+     */
+    void setEncoding(const RecordEncoding encoding);
+
+    /**
+     * @brief Gets the encoding in use
+     * @return The record encoding
+     */
+    RecordEncoding getEncoding() const;
+
+    /**
+     * @brief Selects how packBlock writes coordinates and how block data is read back
+     * @param coordinates Degrees by default, ignored by the Text encoding
+     */
+    void setCoordinateFormat(const CoordinateFormat coordinates);
+
+    /**
+     * @brief Gets the coordinate format in use
+     * @return The coordinate format
+     */
+    CoordinateFormat getCoordinateFormat() const;
+
+    /**
+     * @brief Bytes one record takes in block data under the current encoding, length prefix included
+     * @details Under Dictionary this counts the record's state and county entries as well, the most
+     *          the record can add to a block. BlockOccupancy knows which entries a block already has.
+     * @param record The record
+     * @return Encoded size in bytes
+     */
+    uint32_t getEncodedSize(const ZipCodeRecord& record) const;
+
+    /**
+     * @brief Gets the record encoding a blocked file declares
+     * @param header The file header
+     * @return The encoding named by the size format of a version 6 or later file, Text otherwise
+     */
+    static RecordEncoding encodingOf(const HeaderRecord& header);
+
+    /**
+     * @brief Gets the coordinate format a blocked file declares
+     * @param header The file header
+     * @return MicroDegrees for a version 9 or later file of binary records that says so, Degrees otherwise
+     */
+    static CoordinateFormat coordinateFormatOf(const HeaderRecord& header);
+
+    /**
+     * @brief Checks if an encoding keeps a slot directory, Slotted or SlottedDelta
+     */
+    static bool isSlotted(const RecordEncoding encoding);
+
+    /**
+     * @brief Bytes of one slot of a slotted encoding
+     * @return SLOT_SIZE, or DELTA_SLOT_SIZE for SlottedDelta
+     */
+    static uint32_t slotSize(const RecordEncoding encoding);
+
+    /**
+     * @brief Offset of the first slot of a slotted encoding
+     * @return SLOT_DIRECTORY_OFFSET, or DELTA_SLOT_DIRECTORY_OFFSET for SlottedDelta
+     */
+    static uint32_t slotDirectoryOffset(const RecordEncoding encoding);
+
+    /**
+     * @brief Bytes the latitude and longitude of one record take
+     * @return 16 for Degrees, 8 for MicroDegrees
+     */
+    static uint32_t coordinateSize(const CoordinateFormat coordinates);
+
+    /**
+     * @brief Fixed part of a Binary record, BINARY_FIXED_SIZE less any coordinate savings
+     */
+    static uint32_t binaryFixedSize(const CoordinateFormat coordinates);
+
+    /**
+     * @brief Fixed part of a Dictionary record, DICTIONARY_FIXED_SIZE less any coordinate savings
+     */
+    static uint32_t dictionaryFixedSize(const CoordinateFormat coordinates);
+
+    /**
+     * @brief Encodes the latitude then the longitude of a record
+     * @param out Output, coordinateSize bytes
+     * @return The byte after the coordinates
+     */
+    static char* writeCoordinates(const ZipCodeRecord& record, const CoordinateFormat coordinates, char* out);
+
+    /**
+     * @brief Decodes the latitude then the longitude written by writeCoordinates
+     * @param in The coordinates, coordinateSize bytes
+     * @param latitude [OUT] Latitude in micro-degrees
+     * @param longitude [OUT] Longitude in micro-degrees
+     */
+    static void readCoordinates(const char* in, const CoordinateFormat coordinates, int32_t& latitude, int32_t& longitude);
     
     /**
      * @brief Checks if the buffer is in an error state
@@ -54,7 +234,7 @@ public:
     std::string getLastError() const;
 
     /**
-     * @brief Parses comma seperated ZipCodeRecord.
+     * @brief Parses comma seperated ZipCodeRecord in one pass, see RecordParser.
      * @param recordStr The incoming ZipCode data as a string
      * @param record The incoming record object to be modified
      * @return True if parsing was successful
@@ -64,43 +244,88 @@ public:
 private:
     bool errorState; // Has the RecordBuffer encountered a critical error
     std::string lastError; // Last error message thrown by the error record
+    RecordEncoding encoding; // Layout of the records in block data
+    CoordinateFormat coordinateFormat; // Coordinates of Binary, Slotted and Dictionary records
+
+    /**
+     * @brief Unpacks binary or dictionary encoded block data
+     */
+    bool unpackBinaryBlock(const std::vector<char>& blockData, std::vector<ZipCodeRecord>& records);
 
     /**
-     * @brief Convert string fields
-     * @param fields [IN] Vector of string fields from data file
-     * @param record [OUT] ZipCodeRecord to populate
-     * @return true if conversion successful
-     * @pre fields must contain exactly 6 valid elements
-     * @post record is populated with converted data
+     * @brief Packs records with the binary encoding
      */
-     bool fieldsToRecord(const std::vector<std::string>& fields, ZipCodeRecord& record);
-        
-     /**
-     * @brief Validate that a string represents a valid integer
-     * @param str [IN] String to validate
-     * @return true if string is a valid integer
+    bool packBinaryBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize);
+
+    /**
+     * @brief Packs records with the dictionary encoding, state and county stored once per block
      */
-     bool isValidUInt32(const std::string& str) const;
-        
+    bool packDictionaryBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize);
+
     /**
-     * @brief Validate that a string represents a valid double
-     * @param str [IN] String to validate  
-     * @return true if string is a valid double
+     * @brief Unpacks slotted block data in slot order
      */
-     bool isValidDouble(const std::string& str) const;
+    bool unpackSlottedBlock(const std::vector<char>& blockData, std::vector<ZipCodeRecord>& records);
 
     /**
-     * @brief Set error state and message
-     * @param message [IN] Error message to set
+     * @brief Packs sorted records into slotted block data
      */
-     void setError(const std::string& message);
+    bool packSlottedBlock(const std::vector<ZipCodeRecord>& records, std::vector<char>& blockData, const uint32_t blockSize);
+
+    /**
+     * @brief insertRecord for Text and Binary data, whose records lie back to back in key order
+     */
+    bool insertSequentialRecord(std::vector<char>& blockData, const ZipCodeRecord& record, const uint32_t blockSize);
 
     /**
-     * @brief Trim whitespace from string
-     * @param str [IN,OUT] String to trim
-     * @details Removes leading and trailing whitespace
+     * @brief removeRecord for Text and Binary data
      */
-    void trimString(std::string& str);
+    bool removeSequentialRecord(std::vector<char>& blockData, const uint32_t zipCode);
+
+    /**
+     * @brief Encodes one Text or Binary record, getEncodedSize bytes
+     */
+    void writeRecord(const ZipCodeRecord& record, char* out) const;
+
+    /**
+     * @brief Reads the slot count of slotted block data
+     * @return The number of slots, 0 for padding or a directory running past the data
+     */
+    uint16_t slotCount(const std::vector<char>& blockData) const;
+
+    /**
+     * @brief Finds the first slot whose zip is not less than zipCode
+     * @return Slot index, slotCount if every zip is smaller
+     */
+    uint16_t lowerBoundSlot(const std::vector<char>& blockData, const uint16_t count, const uint32_t zipCode) const;
+
+    /**
+     * @brief Gets the bytes of the body at offset
+     * @return Body size, 0 if it runs past the data
+     */
+    size_t slottedBodySize(const std::vector<char>& blockData, const size_t offset) const;
+
+    /**
+     * @brief Bytes of slotted block data in use, directory and bodies
+     */
+    size_t slottedUsedSize(const std::vector<char>& blockData, const uint16_t count) const;
+
+    /**
+     * @brief Decodes the body of slot index
+     * @return False if the body runs past the data
+     */
+    bool readSlottedRecord(const std::vector<char>& blockData, const uint16_t index, ZipCodeRecord& record) const;
+
+    /**
+     * @brief Encodes the body of a record, the slotted record without its zip
+     */
+    void writeSlottedBody(const ZipCodeRecord& record, char* out) const;
+
+    /**
+     * @brief Set error state and message
+     * @param message [IN] Error message to set
+     */
+     void setError(const std::string& message);
 };
 
 #endif // RECORD_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "RecordParser.h"
+#include <cstring>
+#include <cstdlib>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define RECORD_PARSER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const size_t MAX_NUMBER_LENGTH = 63; // Longest number handed to strtod, std::to_string writes far less
+    const int MAX_EXACT_DIGITS = 19; // Decimal digits that always fit a uint64_t
+    const uint64_t MAX_EXACT_MANTISSA = 1ULL << 53; // Integers a double holds exactly
+    const int MAX_EXACT_POWER = 22; // Largest power of ten a double holds exactly
+    const double POWERS_OF_TEN[MAX_EXACT_POWER + 1] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    /**
+     * @brief Whitespace as std::isspace sees it in the C locale
+     */
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    /**
+     * @brief Drops leading and trailing whitespace from a field
+     */
+    inline FieldView trim(const char* begin, const char* end)
+    {
+        while (begin < end && isSpace(*begin))
+            ++begin;
+        while (end > begin && isSpace(end[-1]))
+            --end;
+        return FieldView(begin, end - begin);
+    }
+
+    /**
+     * @brief Ends the field at comma, false once a seventh field would start
+     */
+    inline bool endField(FieldView* fields, int& count, const char*& fieldStart, const char* comma)
+    {
+        if (count == RecordParser::FIELD_COUNT - 1)
+            return false;
+        fields[count++] = trim(fieldStart, comma);
+        fieldStart = comma + 1;
+        return true;
+    }
+
+    /**
+     * @brief Converts through strtod on a terminated stack copy, the text is not terminated
+     */
+    bool parseDoubleSlow(const FieldView& field, double& value)
+    {
+        if (field.size() > MAX_NUMBER_LENGTH)
+            return false;
+        char text[MAX_NUMBER_LENGTH + 1];
+        std::memcpy(text, field.data(), field.size());
+        text[field.size()] = '\0';
+        char* end = nullptr;
+        value = std::strtod(text, &end);
+        return end == text + field.size();
+    }
+}
+
+RecordParser::Error RecordParser::parse(const char* text, size_t length, RecordView& view)
+{
+    // zip,location,state,county,latitude,longitude
+    FieldView fields[FIELD_COUNT];
+    if (!split(text, length, fields))
+        return Error::FieldCount;
+    if (!parseUInt32(fields[0], view.zipCode))
+        return Error::ZipCode;
+    double latitude;
+    double longitude;
+    if (!parseDouble(fields[4], latitude))
+        return Error::Latitude;
+    if (!parseDouble(fields[5], longitude))
+        return Error::Longitude;
+    view.latitude = ZipCodeRecord::toMicroDegrees(latitude);
+    view.longitude = ZipCodeRecord::toMicroDegrees(longitude);
+    if (fields[2].size() != 2)
+        return Error::State;
+    view.locationName = fields[1];
+    view.state = fields[2];
+    view.county = fields[3];
+    return Error::None;
+}
+
+RecordParser::Error RecordParser::parse(const char* text, size_t length, ZipCodeRecord& record)
+{
+    RecordView view;
+    Error error = parse(text, length, view);
+    if (error == Error::None)
+        record = view.toRecord();
+    return error;
+}
+
+bool RecordParser::split(const char* text, size_t length, FieldView* fields)
+{
+    if (length > 0 && text[length - 1] == ',')
+        --length; // A trailing comma closes the last field rather than opening another, as std::getline splits
+    const char* p = text;
+    const char* end = text + length;
+    const char* fieldStart = text;
+    int count = 0;
+
+#ifdef RECORD_PARSER_HAS_SSE2
+    const __m128i commas = _mm_set1_epi8(',');
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, commas)));
+        while (mask != 0)
+        {
+            if (!endField(fields, count, fieldStart, p + __builtin_ctz(mask)))
+                return false;
+            mask &= mask - 1; // Next comma in the chunk
+        }
+    }
+#endif
+
+    while (p < end)
+    {
+        const char* comma = static_cast<const char*>(std::memchr(p, ',', end - p));
+        if (comma == nullptr)
+            break;
+        if (!endField(fields, count, fieldStart, comma))
+            return false;
+        p = comma + 1;
+    }
+
+    if (count != FIELD_COUNT - 1)
+        return false;
+    fields[count] = trim(fieldStart, end);
+    return true;
+}
+
+bool RecordParser::parseUInt32(const FieldView& field, uint32_t& value)
+{
+    if (field.empty() || field.size() > 10) // 4294967295 has ten digits
+        return false;
+    uint64_t result = 0;
+    for (size_t i = 0; i < field.size(); ++i)
+    {
+        char c = field.data()[i];
+        if (!isDigit(c))
+            return false;
+        result = result * 10 + (c - '0');
+    }
+    if (result > UINT32_MAX)
+        return false;
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+bool RecordParser::parseDouble(const FieldView& field, double& value)
+{
+    if (field.empty())
+        return false;
+
+    // Plain [sign]digits[.digits]: the digits as one integer over a power of ten. Both are exact
+    // doubles when small enough, so the one division rounds the same way strtod does.
+    const char* p = field.data();
+    const char* end = p + field.size();
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        ++p;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    for (; p < end && isDigit(*p) && digits < MAX_EXACT_DIGITS; ++p, ++digits)
+        mantissa = mantissa * 10 + (*p - '0');
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && isDigit(*p) && digits < MAX_EXACT_DIGITS; ++p, ++digits, ++fractionDigits)
+            mantissa = mantissa * 10 + (*p - '0');
+    }
+
+    if (p != end || digits == 0 || mantissa > MAX_EXACT_MANTISSA || fractionDigits > MAX_EXACT_POWER)
+        return parseDoubleSlow(field, value); // Exponent, long digit string, or not a number
+    value = static_cast<double>(mantissa) / POWERS_OF_TEN[fractionDigits];
+    if (negative)
+        value = -value;
+    return true;
+}
+
+const char* RecordParser::describe(Error error)
+{
+    switch (error)
+    {
+        case Error::None:
+            return "no error";
+        case Error::FieldCount:
+            return "expected 6 comma separated fields";
+        case Error::ZipCode:
+            return "zip code is not an unsigned integer";
+        case Error::Latitude:
+            return "latitude is not a number";
+        case Error::Longitude:
+            return "longitude is not a number";
+        case Error::State:
+            return "state is not two characters";
+    }
+    return "unknown error";
+}
+
+bool RecordParser::isVectorized()
+{
+#ifdef RECORD_PARSER_HAS_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef RECORD_PARSER_H
+#define RECORD_PARSER_H
+
+#include "stdint.h"
+#include "RecordView.h"
+#include "ZipCodeRecord.h"
+#include <cstddef>
+
+/**
+ * @file RecordParser.h
+ * @author Group 2
+ * @brief Single pass parser for comma separated zip code records
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class RecordParser
+ * @brief Parses "zip,location,state,county,latitude,longitude" text in one pass, in place.
+ * @details Shared by CSVBuffer lines, length indicated records and text block records. Commas
+ *          are found 16 bytes at a time with SSE2 on x86-64 and with memchr elsewhere; fields
+ *          are trimmed and converted where they lie, without copies, allocations or exceptions.
+ *          Coordinates written as plain decimals convert exactly without strtod; anything else,
+ *          exponents included, goes through strtod on a stack copy.
+ */
+class RecordParser
+{
+public:
+    static const int FIELD_COUNT = 6; // Fields in every record
+
+    /**
+     * @brief Why a record did not parse.
+     */
+    enum class Error : uint8_t
+    {
+        None, // Parsed
+        FieldCount, // Not exactly six fields
+        ZipCode, // Zip is not an unsigned 32 bit decimal
+        Latitude, // Latitude is not a number
+        Longitude, // Longitude is not a number
+        State // State is not two characters
+    };
+
+    /**
+     * @brief Parses one record into a view of the text
+     * @param text First character of the record, need not be terminated
+     * @param length Characters in the record
+     * @param view [OUT] The record, its strings pointing into text
+     * @return Error::None, or the first problem found
+     */
+    static Error parse(const char* text, size_t length, RecordView& view);
+
+    /**
+     * @brief Parses one record into an owning ZipCodeRecord
+     * @param text First character of the record, need not be terminated
+     * @param length Characters in the record
+     * @param record [OUT] The record, unchanged on error
+     * @return Error::None, or the first problem found
+     */
+    static Error parse(const char* text, size_t length, ZipCodeRecord& record);
+
+    /**
+     * @brief Splits a record at its commas and trims each field
+     * @param text First character of the record
+     * @param length Characters in the record
+     * @param fields [OUT] FIELD_COUNT fields
+     * @return False if the record does not have exactly FIELD_COUNT fields
+     */
+    static bool split(const char* text, size_t length, FieldView* fields);
+
+    /**
+     * @brief Converts an unsigned decimal that fits 32 bits, digits only
+     * @return False on any other character, an empty field or overflow
+     */
+    static bool parseUInt32(const FieldView& field, uint32_t& value);
+
+    /**
+     * @brief Converts a decimal number, the whole field has to be the number
+     * @return False if the field is not a number
+     */
+    static bool parseDouble(const FieldView& field, double& value);
+
+    /**
+     * @brief Describes a parse error for messages
+     * @return Static text
+     */
+    static const char* describe(Error error);
+
+    /**
+     * @brief Checks which comma scan is compiled in
+     * @return True for the SSE2 scan, false for memchr
+     */
+    static bool isVectorized();
+};
+
+#endif // RECORD_PARSER_H
@@ -0,0 +1,261 @@
+#include "RecordView.h"
+#include "RecordParser.h"
+#include <cstring>
+
+bool FieldView::operator==(const FieldView& other) const
+{
+    return length == other.length && (length == 0 || std::memcmp(begin, other.begin, length) == 0);
+}
+
+bool FieldView::operator==(const char* other) const
+{
+    return other && std::strlen(other) == length && std::memcmp(begin, other, length) == 0;
+}
+
+bool FieldView::operator==(const std::string& other) const
+{
+    return other.size() == length && std::memcmp(begin, other.data(), length) == 0;
+}
+
+RecordView::RecordView()
+    : zipCode(0), latitude(0), longitude(0), state(), locationName(), county()
+{
+}
+
+uint32_t RecordView::getZipCode() const
+{
+    return zipCode;
+}
+
+double RecordView::getLatitude() const
+{
+    return ZipCodeRecord::toDegrees(latitude);
+}
+
+double RecordView::getLongitude() const
+{
+    return ZipCodeRecord::toDegrees(longitude);
+}
+
+int32_t RecordView::getLatitudeMicro() const
+{
+    return latitude;
+}
+
+int32_t RecordView::getLongitudeMicro() const
+{
+    return longitude;
+}
+
+FieldView RecordView::getState() const
+{
+    return state;
+}
+
+FieldView RecordView::getLocationName() const
+{
+    return locationName;
+}
+
+FieldView RecordView::getCounty() const
+{
+    return county;
+}
+
+ZipCodeRecord RecordView::toRecord() const
+{
+    ZipCodeRecord record(zipCode, 0.0, 0.0, locationName.str(), state.str(), county.str());
+    record.setLatitudeMicro(latitude);
+    record.setLongitudeMicro(longitude);
+    return record;
+}
+
+BlockRecordIterator::BlockRecordIterator(const std::vector<char>& blockData, const RecordEncoding encoding,
+                                         const CoordinateFormat coordinates)
+    : blockData(blockData), encoding(encoding), coordinateSize(RecordBuffer::coordinateSize(coordinates)),
+      coordinates(coordinates), offset(0), slot(0), slotCount(0), slotBase(0), errorState(false), dictionarySize(0)
+{
+    if (encoding == RecordEncoding::Dictionary)
+        readDictionary();
+    if (RecordBuffer::isSlotted(encoding) && blockData.size() >= RecordBuffer::slotDirectoryOffset(encoding))
+    {
+        std::memcpy(&slotCount, blockData.data(), sizeof(slotCount));
+        if (slotCount == UINT16_MAX ||
+            RecordBuffer::slotDirectoryOffset(encoding) + slotCount * RecordBuffer::slotSize(encoding) > blockData.size())
+            slotCount = 0; // Padding, or not a directory
+        if (encoding == RecordEncoding::SlottedDelta)
+            std::memcpy(&slotBase, blockData.data() + RecordBuffer::SLOT_DIRECTORY_OFFSET, sizeof(slotBase));
+    }
+}
+
+bool BlockRecordIterator::next(RecordView& view)
+{
+    if (errorState)
+        return false;
+    switch (encoding)
+    {
+        case RecordEncoding::Binary:
+            return nextBinary(view);
+        case RecordEncoding::Slotted:
+        case RecordEncoding::SlottedDelta:
+            return nextSlotted(view);
+        case RecordEncoding::Dictionary:
+            return nextDictionary(view);
+        default:
+            return nextText(view);
+    }
+}
+
+bool BlockRecordIterator::hasError() const
+{
+    return errorState;
+}
+
+size_t BlockRecordIterator::getOffset() const
+{
+    return offset;
+}
+
+bool BlockRecordIterator::nextText(RecordView& view)
+{
+    if (offset + sizeof(uint32_t) > blockData.size() || blockData[offset] == '\xFF')
+        return false; // End of data or padding
+
+    uint32_t length;
+    std::memcpy(&length, &blockData[offset], sizeof(length));
+    if (length == 0 || offset + sizeof(uint32_t) + length > blockData.size())
+        return false;
+
+    const char* text = blockData.data() + offset + sizeof(uint32_t);
+    offset += sizeof(uint32_t) + length;
+    if (RecordParser::parse(text, length, view) != RecordParser::Error::None)
+    {
+        errorState = true;
+        return false;
+    }
+    return true;
+}
+
+bool BlockRecordIterator::nextBinary(RecordView& view)
+{
+    if (offset + RecordBuffer::binaryFixedSize(coordinates) > blockData.size())
+        return false;
+    uint32_t zipCode;
+    std::memcpy(&zipCode, &blockData[offset], sizeof(zipCode));
+    if (zipCode == UINT32_MAX)
+        return false; // Padding
+
+    size_t bodySize = readBody(offset + sizeof(uint32_t), view);
+    if (bodySize == 0)
+        return false;
+    view.zipCode = zipCode;
+    offset += sizeof(uint32_t) + bodySize;
+    return true;
+}
+
+bool BlockRecordIterator::nextSlotted(RecordView& view)
+{
+    if (slot >= slotCount)
+        return false;
+    const char* entry = blockData.data() + RecordBuffer::slotDirectoryOffset(encoding) + slot * RecordBuffer::slotSize(encoding);
+    uint16_t bodyOffset;
+    if (encoding == RecordEncoding::SlottedDelta)
+    {
+        uint16_t delta;
+        std::memcpy(&delta, entry, sizeof(delta));
+        view.zipCode = slotBase + delta;
+        std::memcpy(&bodyOffset, entry + sizeof(delta), sizeof(bodyOffset));
+    }
+    else
+    {
+        std::memcpy(&view.zipCode, entry, sizeof(uint32_t));
+        std::memcpy(&bodyOffset, entry + sizeof(uint32_t), sizeof(bodyOffset));
+    }
+    if (readBody(bodyOffset, view) == 0)
+    {
+        errorState = true;
+        return false;
+    }
+    ++slot;
+    return true;
+}
+
+bool BlockRecordIterator::nextDictionary(RecordView& view)
+{
+    const size_t fixedSize = RecordBuffer::dictionaryFixedSize(coordinates);
+    if (offset + fixedSize > blockData.size())
+        return false;
+    uint32_t zipCode;
+    std::memcpy(&zipCode, &blockData[offset], sizeof(zipCode));
+    if (zipCode == UINT32_MAX)
+        return false; // Padding
+
+    // latitude, longitude, state id, county id, location length, location
+    const char* in = blockData.data() + offset + sizeof(uint32_t);
+    uint8_t stateId = static_cast<uint8_t>(in[coordinateSize]);
+    uint8_t countyId = static_cast<uint8_t>(in[coordinateSize + 1]);
+    uint8_t locationLength = static_cast<uint8_t>(in[coordinateSize + 2]);
+    size_t recordSize = fixedSize + locationLength;
+    if (stateId >= dictionarySize || countyId >= dictionarySize || offset + recordSize > blockData.size())
+    {
+        errorState = true;
+        return false;
+    }
+
+    view.zipCode = zipCode;
+    RecordBuffer::readCoordinates(in, coordinates, view.latitude, view.longitude);
+    view.state = dictionaryEntry(stateId);
+    view.county = dictionaryEntry(countyId);
+    view.locationName = FieldView(in + coordinateSize + 3, locationLength);
+    offset += recordSize;
+    return true;
+}
+
+void BlockRecordIterator::readDictionary()
+{
+    if (blockData.empty() || blockData[0] == '\xFF')
+        return; // Empty block, padding only
+    uint8_t count = static_cast<uint8_t>(blockData[0]);
+    size_t position = RecordBuffer::DICTIONARY_ENTRIES_OFFSET;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if (position >= blockData.size() ||
+            position + 1 + static_cast<uint8_t>(blockData[position]) > blockData.size())
+        {
+            errorState = true;
+            return;
+        }
+        dictionary[i] = static_cast<uint32_t>(position);
+        position += 1 + static_cast<uint8_t>(blockData[position]);
+    }
+    dictionarySize = count;
+    offset = position;
+}
+
+FieldView BlockRecordIterator::dictionaryEntry(uint8_t id) const
+{
+    const char* entry = blockData.data() + dictionary[id];
+    return FieldView(entry + 1, static_cast<uint8_t>(entry[0]));
+}
+
+size_t BlockRecordIterator::readBody(const size_t bodyOffset, RecordView& view) const
+{
+    // latitude, longitude, state[2], location length, location, county length, county
+    const size_t fixedSize = RecordBuffer::binaryFixedSize(coordinates) - sizeof(uint32_t);
+    if (bodyOffset + fixedSize > blockData.size())
+        return 0;
+    const char* in = blockData.data() + bodyOffset;
+    uint8_t locationLength = static_cast<uint8_t>(in[coordinateSize + 2]);
+    if (bodyOffset + fixedSize + locationLength > blockData.size())
+        return 0;
+    uint8_t countyLength = static_cast<uint8_t>(in[coordinateSize + 3 + locationLength]);
+    size_t bodySize = fixedSize + locationLength + countyLength;
+    if (bodyOffset + bodySize > blockData.size())
+        return 0;
+
+    RecordBuffer::readCoordinates(in, coordinates, view.latitude, view.longitude);
+    view.state = FieldView(in + coordinateSize, 2);
+    view.locationName = FieldView(in + coordinateSize + 3, locationLength);
+    view.county = FieldView(in + coordinateSize + 4 + locationLength, countyLength);
+    return bodySize;
+}
@@ -0,0 +1,159 @@
+#ifndef RECORD_VIEW_H
+#define RECORD_VIEW_H
+
+#include "stdint.h"
+#include "RecordBuffer.h"
+#include "ZipCodeRecord.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @file RecordView.h
+ * @author Group 2
+ * @brief Read-only views of the records inside block data
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+/**
+ * @class FieldView
+ * @brief Characters of one string field, left where they are in the block.
+ * @details The C++11 stand-in for std::string_view. Valid while the block data it points into is.
+ */
+class FieldView
+{
+public:
+    FieldView() : begin(nullptr), length(0) {}
+    FieldView(const char* data, size_t size) : begin(data), length(size) {}
+
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    /**
+     * @brief Copies the field out, allocating if it does not fit the small string buffer
+     * @return The field as a string
+     */
+    std::string str() const { return std::string(begin, length); }
+
+    bool operator==(const FieldView& other) const;
+    bool operator!=(const FieldView& other) const { return !(*this == other); }
+    bool operator==(const char* other) const;
+    bool operator==(const std::string& other) const;
+
+private:
+    const char* begin; // First character, inside the block
+    size_t length; // Characters in the field
+};
+
+/**
+ * @class RecordView
+ * @brief One record read straight from block bytes, nothing copied or allocated.
+ * @details The zip and coordinates are decoded when the view is filled, the coordinates to
+ *          micro-degrees whatever their stored format; the strings stay in the block. Valid while the block data it came from is unchanged. toRecord() makes an owning
+ *          ZipCodeRecord for the records a caller keeps.
+ */
+class RecordView
+{
+public:
+    RecordView();
+
+    uint32_t getZipCode() const;
+    double getLatitude() const;
+    double getLongitude() const;
+    int32_t getLatitudeMicro() const;
+    int32_t getLongitudeMicro() const;
+    FieldView getState() const;
+    FieldView getLocationName() const;
+    FieldView getCounty() const;
+
+    /**
+     * @brief Copies the viewed record into an owning ZipCodeRecord
+     * @return The record
+     */
+    ZipCodeRecord toRecord() const;
+
+private:
+    friend class BlockRecordIterator;
+    friend class RecordParser;
+
+    uint32_t zipCode; // Decoded zip
+    int32_t latitude; // Decoded latitude, micro-degrees
+    int32_t longitude; // Decoded longitude, micro-degrees
+    FieldView state; // Two letter state
+    FieldView locationName; // Town name
+    FieldView county; // County name
+};
+
+/**
+ * @class BlockRecordIterator
+ * @brief Walks the records of one block's data as RecordViews, in stored key order.
+ * @details Understands every RecordEncoding. Text records are parsed in place by RecordParser.
+ *          A record that does not parse ends the walk and sets the error state.
+ */
+class BlockRecordIterator
+{
+public:
+    /**
+     * @brief Constructor
+     * @param blockData Data of an active block. Must outlive the iterator and the views.
+     * @param encoding How the block encodes its records.
+     * @param coordinates How Binary, Slotted and Dictionary records store coordinates.
+     */
+    BlockRecordIterator(const std::vector<char>& blockData, const RecordEncoding encoding,
+                        const CoordinateFormat coordinates = CoordinateFormat::Degrees);
+
+    /**
+     * @brief Views the next record.
+     * @param view [OUT] The record.
+     * @return False at the end of the records or on a record that does not parse.
+     */
+    bool next(RecordView& view);
+
+    /**
+     * @brief Checks if the walk stopped on a bad record
+     * @return True if a record did not parse
+     */
+    bool hasError() const;
+
+    /**
+     * @brief Gets where the next record starts, Text, Binary and Dictionary
+     * @return Offset into the block data, the end of the used bytes once the walk is over
+     */
+    size_t getOffset() const;
+
+private:
+    const std::vector<char>& blockData; // Data being walked
+    RecordEncoding encoding; // Layout of the records
+    uint32_t coordinateSize; // Bytes of the two coordinates, Binary, Slotted and Dictionary
+    CoordinateFormat coordinates; // Format of the coordinates
+    size_t offset; // Next record, Text, Binary and Dictionary
+    uint16_t slot; // Next slot, Slotted
+    uint16_t slotCount; // Slots in the block, Slotted
+    uint32_t slotBase; // Zip the slots are deltas from, SlottedDelta
+    bool errorState; // Has a record failed to parse
+    uint8_t dictionarySize; // Entries in the block, Dictionary
+    uint32_t dictionary[RecordBuffer::MAX_DICTIONARY_ENTRIES]; // Offset of each entry's length byte, Dictionary
+
+    bool nextText(RecordView& view);
+    bool nextBinary(RecordView& view);
+    bool nextSlotted(RecordView& view);
+    bool nextDictionary(RecordView& view);
+    FieldView dictionaryEntry(uint8_t id) const;
+
+    /**
+     * @brief Reads the dictionary at the start of the block and moves offset past it
+     */
+    void readDictionary();
+
+    /**
+     * @brief Reads the body shared by Binary records and Slotted bodies
+     * @param bodyOffset Start of the latitude
+     * @param view [OUT] Coordinates and strings of the record
+     * @return Bytes of the body, 0 if it runs past the data
+     */
+    size_t readBody(const size_t bodyOffset, RecordView& view) const;
+};
+
+#endif // RECORD_VIEW_H
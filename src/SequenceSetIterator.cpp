@@ -0,0 +1,61 @@
+#include "SequenceSetIterator.h"
+
+SequenceSetIterator::SequenceSetIterator(BlockBuffer& buffer, const uint32_t headRBN, const uint32_t blockSize,
+                                         const size_t headerSize, const uint32_t readAhead)
+    : buffer(buffer), blockSize(blockSize), headerSize(headerSize),
+      readAhead(readAhead == 0 ? 1 : readAhead), currentRBN(0), nextRBN(headRBN),
+      windowStart(0), windowCount(0), window(), stats()
+{
+}
+
+bool SequenceSetIterator::next(ActiveBlock& block)
+{
+    if (nextRBN == 0)
+        return false;
+
+    const char* image = nullptr;
+    if (buffer.isMapped())
+    {
+        // The mapping is already one big readahead window, but checked blocks go through the buffer
+        if (!buffer.hasChecksums() || buffer.getVerifyPolicy() == BlockChecksum::VerifyPolicy::Never)
+            image = buffer.mapBlockAtRBN(nextRBN, blockSize, headerSize);
+        if (image == nullptr && !buffer.loadActiveBlockAtRBN(nextRBN, blockSize, headerSize, block))
+            return false;
+    }
+    else if (windowCount > 0 && nextRBN >= windowStart && nextRBN - windowStart < windowCount)
+    {
+        image = window.data() + static_cast<size_t>(nextRBN - windowStart) * blockSize;
+        stats.prefetchHits++;
+    }
+    else
+    {
+        window.resize(static_cast<size_t>(readAhead) * blockSize);
+        windowCount = buffer.readBlockRunAtRBN(nextRBN, readAhead, blockSize, headerSize, window.data());
+        windowStart = nextRBN;
+        stats.physicalReads++;
+        if (windowCount == 0)
+            return false;
+        image = window.data();
+    }
+
+    if (image != nullptr)
+        buffer.imageToActiveBlock(image, blockSize, block);
+
+    if (currentRBN != 0 && nextRBN == currentRBN + 1)
+        stats.inPhysicalOrder++;
+    stats.blocksVisited++;
+
+    currentRBN = nextRBN;
+    nextRBN = block.succeedingRBN;
+    return true;
+}
+
+uint32_t SequenceSetIterator::getCurrentRBN() const
+{
+    return currentRBN;
+}
+
+SequenceScanStats SequenceSetIterator::getStats() const
+{
+    return stats;
+}
@@ -0,0 +1,74 @@
+#ifndef SEQUENCE_SET_ITERATOR_H
+#define SEQUENCE_SET_ITERATOR_H
+
+#include "stdint.h"
+#include "Block.h"
+#include "BlockBuffer.h"
+#include <vector>
+
+/**
+ * @file SequenceSetIterator.h
+ * @author Group 2
+ * @brief Prefetching walk of the sequence set chain
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+/**
+ * @class SequenceSetIterator
+ * @brief Follows succeedingRBN from the list head, reading ahead in physically adjacent runs.
+ * @details When the next block in the chain is not in the current window, the iterator reads it
+ *          together with the following readAhead - 1 physical blocks in a single read. After a
+ *          conversion the chain is laid out in physical order, so the whole scan becomes a series
+ *          of large sequential reads. As splits scatter the chain, more steps miss the window and
+ *          the statistics show how far the logical order has drifted from the physical one.
+ */
+class SequenceSetIterator
+{
+public:
+    static const uint32_t DEFAULT_READAHEAD = 16; // Blocks read per window
+
+    /**
+     * @brief Constructor
+     * @param buffer Open BlockBuffer to read through. Must outlive the iterator.
+     * @param headRBN First block of the chain, usually the sequence set list head.
+     * @param blockSize The size of blocks in the file.
+     * @param headerSize The size of the file header.
+     * @param readAhead Blocks per readahead window, at least 1.
+     */
+    SequenceSetIterator(BlockBuffer& buffer, const uint32_t headRBN, const uint32_t blockSize,
+                        const size_t headerSize, const uint32_t readAhead = DEFAULT_READAHEAD);
+
+    /**
+     * @brief Loads the next block of the chain.
+     * @param block [OUT] The block, its data capacity is reused.
+     * @return False at the end of the chain or on a read error.
+     */
+    bool next(ActiveBlock& block);
+
+    /**
+     * @brief Gets the RBN of the block returned by the last call to next.
+     * @return The current RBN, 0 before the first call.
+     */
+    uint32_t getCurrentRBN() const;
+
+    /**
+     * @brief Gets the readahead and physical order statistics so far.
+     * @return Copy of the statistics.
+     */
+    SequenceScanStats getStats() const;
+
+private:
+    BlockBuffer& buffer; // Source of the blocks
+    uint32_t blockSize; // Bytes per block
+    size_t headerSize; // Bytes before RBN 0
+    uint32_t readAhead; // Blocks per window
+    uint32_t currentRBN; // Block returned last
+    uint32_t nextRBN; // Block to return next, 0 at the end of the chain
+    uint32_t windowStart; // RBN of the first block in the window
+    uint32_t windowCount; // Blocks held in the window
+    BlockImage window; // Readahead window, readAhead * blockSize bytes
+    SequenceScanStats stats; // Running statistics
+};
+
+#endif // SEQUENCE_SET_ITERATOR_H
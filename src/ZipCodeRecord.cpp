@@ -7,16 +7,35 @@
  */
 
 #include "ZipCodeRecord.h"
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <cmath>
+
+namespace
+{
+    /**
+     * @brief Length of the "%f" form of a micro-degree value, which is its six decimals exactly
+     * @param microDegrees [IN] Coordinate in micro-degrees
+     * @return Sign, integer digits, point and six decimals
+     */
+    int fixedPointLength(int32_t microDegrees)
+    {
+        int64_t whole = static_cast<int64_t>(microDegrees) / ZipCodeRecord::MICRO_DEGREES;
+        int length = microDegrees < 0 ? 9 : 8; // Sign, one digit, point, six decimals
+        for (whole = whole < 0 ? -whole : whole; whole >= 10; whole /= 10)
+            ++length;
+        return length;
+    }
+}
 
 /**
  * @brief Default constructor
  * @details Initializes all fields to default values
  */
 ZipCodeRecord::ZipCodeRecord() 
-    : zipCode(0), latitude(0.0), longitude(0.0), locationName(""), county("")
+    : zipCode(0), latitude(0), longitude(0), locationName(""), county("")
 {
     state[0] = '\0';  // Initialize state as empty string
 }
@@ -28,7 +47,7 @@ ZipCodeRecord::ZipCodeRecord()
 ZipCodeRecord::ZipCodeRecord(const int inZipCode, const double inLatitude, 
                             const double inLongitude, const std::string& inLocationName, 
                             const std::string& inState, const std::string& inCounty)
-    : zipCode(0), latitude(0.0), longitude(0.0), locationName(""), county("")
+    : zipCode(0), latitude(0), longitude(0), locationName(""), county("")
 {
     state[0] = '\0';
     
@@ -92,6 +111,20 @@ bool ZipCodeRecord::setZipCode(const uint32_t inZipCode)
 bool ZipCodeRecord::setLatitude(const double inLatitude)
 {
     if (inLatitude >= -90.0 && inLatitude <= 90.0) 
+        return setLatitudeMicro(toMicroDegrees(inLatitude));
+    return false;
+}
+
+bool ZipCodeRecord::setLongitude(const double inLongitude)
+{
+    if (inLongitude >= -180.0 && inLongitude <= 180.0) 
+        return setLongitudeMicro(toMicroDegrees(inLongitude));
+    return false;
+}
+
+bool ZipCodeRecord::setLatitudeMicro(const int32_t inLatitude)
+{
+    if (inLatitude >= -90 * MICRO_DEGREES && inLatitude <= 90 * MICRO_DEGREES)
     {
         latitude = inLatitude;
         return true;
@@ -99,9 +132,9 @@ bool ZipCodeRecord::setLatitude(const double inLatitude)
     return false;
 }
 
-bool ZipCodeRecord::setLongitude(const double inLongitude)
+bool ZipCodeRecord::setLongitudeMicro(const int32_t inLongitude)
 {
-    if (inLongitude >= -180.0 && inLongitude <= 180.0) 
+    if (inLongitude >= -180 * MICRO_DEGREES && inLongitude <= 180 * MICRO_DEGREES)
     {
         longitude = inLongitude;
         return true;
@@ -149,14 +182,39 @@ uint32_t ZipCodeRecord::getZipCode() const
 
 double ZipCodeRecord::getLatitude() const
 {
-    return latitude;
+    return toDegrees(latitude);
 }
 
 double ZipCodeRecord::getLongitude() const
+{
+    return toDegrees(longitude);
+}
+
+int32_t ZipCodeRecord::getLatitudeMicro() const
+{
+    return latitude;
+}
+
+int32_t ZipCodeRecord::getLongitudeMicro() const
 {
     return longitude;
 }
 
+int32_t ZipCodeRecord::toMicroDegrees(const double degrees)
+{
+    double scaled = std::round(degrees * MICRO_DEGREES);
+    if (!(scaled > INT32_MIN)) // NaN too
+        return scaled > 0 ? INT32_MAX : INT32_MIN;
+    if (scaled > INT32_MAX)
+        return INT32_MAX;
+    return static_cast<int32_t>(scaled);
+}
+
+double ZipCodeRecord::toDegrees(const int32_t microDegrees)
+{
+    return static_cast<double>(microDegrees) / MICRO_DEGREES;
+}
+
 std::string ZipCodeRecord::getLocationName() const
 {
     return locationName;
@@ -201,7 +259,7 @@ std::ostream& operator<<(std::ostream& outputStream, const ZipCodeRecord& record
        << ", " << record.locationName
        << ", " << record.state 
        << ", " << record.county
-       << " (" << record.latitude << ", " << record.longitude << ")";
+       << " (" << record.getLatitude() << ", " << record.getLongitude() << ")";
     return outputStream;
 }
 
@@ -230,13 +288,15 @@ std::ostream& operator<<(std::ostream& outputStream, const ZipCodeRecord& record
     // State
     data.insert(data.end(), state, state + 3);
 
-    // Latitude
-    data.insert(data.end(), reinterpret_cast<const uint8_t*>(&latitude),
-                reinterpret_cast<const uint8_t*>(&latitude) + sizeof(latitude));
+    // Latitude, the format keeps doubles
+    double latitudeDegrees = getLatitude();
+    data.insert(data.end(), reinterpret_cast<const uint8_t*>(&latitudeDegrees),
+                reinterpret_cast<const uint8_t*>(&latitudeDegrees) + sizeof(latitudeDegrees));
 
     // Longitude
-    data.insert(data.end(), reinterpret_cast<const uint8_t*>(&longitude),
-                reinterpret_cast<const uint8_t*>(&longitude) + sizeof(longitude));
+    double longitudeDegrees = getLongitude();
+    data.insert(data.end(), reinterpret_cast<const uint8_t*>(&longitudeDegrees),
+                reinterpret_cast<const uint8_t*>(&longitudeDegrees) + sizeof(longitudeDegrees));
 
     return data;
  }
@@ -273,11 +333,14 @@ std::ostream& operator<<(std::ostream& outputStream, const ZipCodeRecord& record
     offset += 3;
 
     // Read Latitude
-    memcpy(&record.latitude, data + offset, sizeof(double));
+    double degrees;
+    memcpy(&degrees, data + offset, sizeof(double));
+    record.latitude = toMicroDegrees(degrees);
     offset += sizeof(double);
 
     // Read Longitude
-    memcpy(&record.longitude, data + offset, sizeof(double));
+    memcpy(&degrees, data + offset, sizeof(double));
+    record.longitude = toMicroDegrees(degrees);
     offset += sizeof(double);
 
     return record;
@@ -285,11 +348,11 @@ std::ostream& operator<<(std::ostream& outputStream, const ZipCodeRecord& record
 
 uint32_t ZipCodeRecord::getRecordSize() const
 {
-    std::string recordStr = std::to_string(zipCode) + "," +
-                            locationName + "," +
-                            std::string(state) + "," +
-                            county + "," +
-                            std::to_string(latitude) + "," +
-                            std::to_string(longitude);
-    return 4 + recordStr.length(); // 4 bytes for length prefix + actual string length
-}
\ No newline at end of file
+    // Lengths of the to_string forms ("%u", "%f"), counted by snprintf without building the string
+    int zipLength = std::snprintf(nullptr, 0, "%u", static_cast<unsigned int>(zipCode));
+    int latitudeLength = fixedPointLength(latitude);
+    int longitudeLength = fixedPointLength(longitude);
+    uint32_t recordLength = zipLength + locationName.length() + std::strlen(state) + county.length() +
+                            latitudeLength + longitudeLength + 5; // Five commas
+    return 4 + recordLength; // 4 bytes for length prefix + actual string length
+}
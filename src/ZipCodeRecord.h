@@ -17,11 +17,15 @@
 /**
  * @class ZipCodeRecord
  * @brief Represents a single zip code record with geographic data
- * @details Stores zip code, coordinates, and location information.
+ * @details Stores zip code, coordinates, and location information. Coordinates are held as int32
+ *          micro-degrees, exact for the six decimals the text encoding writes; the double accessors
+ *          convert on the way in and out.
  */
 class ZipCodeRecord
 {
 public:
+    static const int32_t MICRO_DEGREES = 1000000; // Fixed point units in one degree
+
     /**
      * @brief Default constructor
      * @details Initializes all fields to default values
@@ -86,6 +90,22 @@ public:
      * @post longitude is updated if valid
      */
     bool setLongitude(const double inLongitude);
+    /**
+     * @brief Set latitude in micro-degrees
+     * @param inLatitude [IN] new latitude, degrees times MICRO_DEGREES
+     * @return true if valid latitude, false otherwise
+     * @pre inLatitude must be in the range -90000000-90000000
+     * @post latitude is updated if valid
+     */
+    bool setLatitudeMicro(const int32_t inLatitude);
+    /**
+     * @brief Set longitude in micro-degrees
+     * @param inLongitude [IN] new longitude, degrees times MICRO_DEGREES
+     * @return true if valid longitude, false otherwise
+     * @pre inLongitude must be in the range -180000000-180000000
+     * @post longitude is updated if valid
+     */
+    bool setLongitudeMicro(const int32_t inLongitude);
     /**
      * @brief Set Location name value
      * @param inLocationName [STR] new location name
@@ -127,6 +147,16 @@ public:
      * @return longitude
      */
     double getLongitude() const;
+    /**
+     * @brief Latitude Getter, fixed point
+     * @return latitude in micro-degrees
+     */
+    int32_t getLatitudeMicro() const;
+    /**
+     * @brief Longitude Getter, fixed point
+     * @return longitude in micro-degrees
+     */
+    int32_t getLongitudeMicro() const;
     /**
      * @brief Location Name Getter
      * @return locationName
@@ -198,13 +228,27 @@ public:
      */
     uint32_t getRecordSize() const;
 
+    /**
+     * @brief Converts degrees to the nearest micro-degree
+     * @param degrees [IN] Coordinate in degrees
+     * @return Micro-degrees, saturated to the int32 range for values far outside any coordinate
+     */
+    static int32_t toMicroDegrees(const double degrees);
+
+    /**
+     * @brief Converts micro-degrees back to degrees
+     * @param microDegrees [IN] Coordinate in micro-degrees
+     * @return Degrees, the closest double to the six decimal value
+     */
+    static double toDegrees(const int32_t microDegrees);
+
 private:
     uint32_t zipCode; // 5-digit zip code
     std::string locationName; // Town name
     std::string county; // County name
     char state[3]; // Two-character state code + null terminator
-    double latitude; // Latitude coordinate
-    double longitude; // Longitude coordinate  
+    int32_t latitude; // Latitude coordinate, micro-degrees
+    int32_t longitude; // Longitude coordinate, micro-degrees
 };
 
 #endif // ZIP_CODE_RECORD_H
\ No newline at end of file